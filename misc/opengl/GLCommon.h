@@ -49,6 +49,7 @@ typedef cc_uintptr GLpointer;
 #define GL_ONE_MINUS_SRC_ALPHA   0x0303
 
 #define GL_UNSIGNED_BYTE         0x1401
+#define GL_SHORT                 0x1402
 #define GL_UNSIGNED_SHORT        0x1403
 #define GL_UNSIGNED_INT          0x1405
 #define GL_FLOAT                 0x1406
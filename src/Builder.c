@@ -13,6 +13,12 @@
 #include "TexturePack.h"
 #include "Game.h"
 #include "Options.h"
+#include "Event.h"
+#include "Stream.h"
+#include "Utils.h"
+#include "Logger.h"
+#include "Errors.h"
+#include "String.h"
 
 int Builder_SidesLevel, Builder_EdgeLevel;
 /* Packs an index into the 16x16x16 count array. Coordinates range from 0 to 15. */
@@ -20,23 +26,8 @@ int Builder_SidesLevel, Builder_EdgeLevel;
 /* Packs an index into the 18x18x18 chunk array. Coordinates range from -1 to 16. */
 #define Builder_PackChunk(xx, yy, zz) (((yy) + 1) * EXTCHUNK_SIZE_2 + ((zz) + 1) * EXTCHUNK_SIZE + ((xx) + 1))
 
-static BlockID* Builder_Chunk;
-static cc_uint8* Builder_Counts;
-static int* Builder_BitFlags;
-static int Builder_X, Builder_Y, Builder_Z;
-static BlockID Builder_Block;
-static int Builder_ChunkIndex;
-static cc_bool Builder_FullBright;
-static int Builder_ChunkEndX, Builder_ChunkEndZ;
 static int Builder_Offsets[FACE_COUNT] = { -1,1, -EXTCHUNK_SIZE,EXTCHUNK_SIZE, -EXTCHUNK_SIZE_2,EXTCHUNK_SIZE_2 };
 
-static int (*Builder_StretchXLiquid)(int countIndex, int x, int y, int z, int chunkIndex, BlockID block);
-static int (*Builder_StretchX)(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
-static int (*Builder_StretchZ)(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
-static void (*Builder_RenderBlock)(int countsIndex, int x, int y, int z);
-static void (*Builder_PrePrepareChunk)(void);
-static void (*Builder_PostPrepareChunk)(void);
-
 /* Contains state for vertices for a portion of a chunk mesh (vertices that are in a 1D atlas) */
 struct Builder1DPart {
 	/* Union to save on memory, since chunk building is divided into counting then building phases */
@@ -47,10 +38,77 @@ struct Builder1DPart {
 	int sCount, sOffset;
 };
 
-/* Part builder data, for both normal and translucent parts.
-The first ATLAS1D_MAX_ATLASES parts are for normal parts, remainder are for translucent parts. */
-static CC_BIG_VAR struct Builder1DPart Builder_Parts[ATLAS1D_MAX_ATLASES * 2];
-static struct VertexTextured* Builder_Vertices;
+/* Light colours of the blocks in and bordering a chunk, copied on the main thread */
+/* Non-classic lighting modes lazily calculate lighting when it is read, so background threads */
+/*  building chunk meshes instead read lighting from a copy made beforehand */
+/* NOTE: Those modes use the same colour for sprites and the tops of blocks */
+struct LightSnapshot {
+	int x, y, z; /* Minimum coordinates of the 18x18x18 region that was copied */
+	PackedCol top[EXTCHUNK_SIZE_3], bottom[EXTCHUNK_SIZE_3];
+	PackedCol xSide[EXTCHUNK_SIZE_3], zSide[EXTCHUNK_SIZE_3];
+};
+#define LightSnapshot_Index(s, xx, yy, zz) ((((yy) - (s)->y) * EXTCHUNK_SIZE + ((zz) - (s)->z)) * EXTCHUNK_SIZE + ((xx) - (s)->x))
+
+/* All the state used while building a single chunk mesh */
+/* Each thread that builds chunk meshes has its own context */
+struct BuilderContext {
+	BlockID* chunk;
+	cc_uint8* counts;
+	int* bitFlags;
+	/* Coordinates, chunk index and ID of the block currently being processed */
+	int x, y, z;
+	BlockID block;
+	int chunkIndex;
+	cc_bool fullBright;
+	int chunkEndX, chunkEndZ;
+	struct VertexTextured* vertices;
+	/* Number of vertices the mesh would have if no faces were merged together */
+	int unmergedVerts;
+#ifdef CC_BUILD_PACKEDTERRAIN
+	/* Number of rows of faces each run of faces was merged with in the V direction */
+	cc_uint8 rows[CHUNK_SIZE_3 * FACE_COUNT];
+#endif
+	RNGState spriteRng;
+	struct _DrawerData drawer;
+	/* Light colours around the chunk, or NULL to read light colours from the lighting engine */
+	struct LightSnapshot* light;
+	/* Flood fill state for calculating chunk connectivity */
+	cc_uint8 visited[CHUNK_SIZE_3];
+	cc_uint16 fillStack[CHUNK_SIZE_3];
+#ifdef CC_BUILD_ADVLIGHTING
+	Vec3 minBB, maxBB;
+	int initBitFlags, baseOffset;
+	float x1, y1, z1, x2, y2, z2;
+	PackedCol lerp[5], lerpX[5], lerpZ[5], lerpY[5];
+	cc_bool tinted;
+#endif
+	/* Part builder data, for both normal and translucent parts.
+	The first ATLAS1D_MAX_ATLASES parts are for normal parts, remainder are for translucent parts. */
+	struct Builder1DPart parts[ATLAS1D_MAX_ATLASES * 2];
+};
+/* Returns the light colour at the given coordinates, from the context's light snapshot if it has one */
+#define Builder_Light(ctx, arr, func, xx, yy, zz) ((ctx)->light ? \
+	(ctx)->light->arr[LightSnapshot_Index((ctx)->light, xx, yy, zz)] : Lighting.func(xx, yy, zz))
+#define Builder_LightSprite(ctx, xx, yy, zz) Builder_Light(ctx, top,    Color_Sprite_Fast, xx, yy, zz)
+#define Builder_LightYMax(ctx, xx, yy, zz)   Builder_Light(ctx, top,    Color_YMax_Fast,   xx, yy, zz)
+#define Builder_LightYMin(ctx, xx, yy, zz)   Builder_Light(ctx, bottom, Color_YMin_Fast,   xx, yy, zz)
+#define Builder_LightXSide(ctx, xx, yy, zz)  Builder_Light(ctx, xSide,  Color_XSide_Fast,  xx, yy, zz)
+#define Builder_LightZSide(ctx, xx, yy, zz)  Builder_Light(ctx, zSide,  Color_ZSide_Fast,  xx, yy, zz)
+#define Builder_LightColor(ctx, xx, yy, zz)  Builder_Light(ctx, top,    Color,             xx, yy, zz)
+
+/* Context used when building chunk meshes on the main thread */
+static CC_BIG_VAR struct BuilderContext mainCtx;
+
+static int (*Builder_StretchXLiquid)(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block);
+static int (*Builder_StretchX)(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
+static int (*Builder_StretchZ)(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face);
+static void (*Builder_RenderBlock)(struct BuilderContext* ctx, int countsIndex, int x, int y, int z);
+static void (*Builder_PrePrepareChunk)(struct BuilderContext* ctx);
+static void (*Builder_PostPrepareChunk)(struct BuilderContext* ctx);
+/* Further merges the runs of faces calculated by PrepareChunk, or NULL if the active builder doesn't */
+static void (*Builder_MergeFaces)(struct BuilderContext* ctx, int x1, int y1, int z1);
+/* Whether lighting has to be copied before chunk meshes can be built on background threads */
+static cc_bool Builder_CopyLighting;
 
 static int Builder1DPart_VerticesCount(struct Builder1DPart* part) {
 	int i, count = part->sCount;
@@ -58,7 +116,7 @@ static int Builder1DPart_VerticesCount(struct Builder1DPart* part) {
 	return count;
 }
 
-static int Builder1DPart_CalcOffsets(struct Builder1DPart* part, int offset) {
+static int Builder1DPart_CalcOffsets(struct BuilderContext* ctx, struct Builder1DPart* part, int offset) {
 	int i, counts[FACE_COUNT];
 	part->sOffset = offset;
 
@@ -71,16 +129,16 @@ static int Builder1DPart_CalcOffsets(struct Builder1DPart* part, int offset) {
 	offset += part->sCount;
 	for (i = 0; i < FACE_COUNT; i++) 
 	{
-		part->faces.vertices[i] = &Builder_Vertices[offset];
+		part->faces.vertices[i] = &ctx->vertices[offset];
 		offset += counts[i];
 	}
 	return offset;
 }
 
-static int Builder_TotalVerticesCount(void) {
+static int Builder_TotalVerticesCount(struct BuilderContext* ctx) {
 	int i, count = 0;
 	for (i = 0; i < ATLAS1D_MAX_ATLASES * 2; i++) {
-		count += Builder1DPart_VerticesCount(&Builder_Parts[i]);
+		count += Builder1DPart_VerticesCount(&ctx->parts[i]);
 	}
 	return count;
 }
@@ -89,28 +147,28 @@ static int Builder_TotalVerticesCount(void) {
 /*########################################################################################################################*
 *----------------------------------------------------Base mesh builder----------------------------------------------------*
 *#########################################################################################################################*/
-static void AddSpriteVertices(BlockID block) {
+static void AddSpriteVertices(struct BuilderContext* ctx, BlockID block) {
 	int i = Atlas1D_Index(Block_Tex(block, FACE_XMAX));
-	struct Builder1DPart* part = &Builder_Parts[i];
+	struct Builder1DPart* part = &ctx->parts[i];
 	part->sCount += 4 * 4;
 }
 
-static void AddVertices(BlockID block, Face face) {
+static void AddVertices(struct BuilderContext* ctx, BlockID block, Face face) {
 	int baseOffset = (Blocks.Draw[block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
 	int i = Atlas1D_Index(Block_Tex(block, face));
-	struct Builder1DPart* part = &Builder_Parts[baseOffset + i];
+	struct Builder1DPart* part = &ctx->parts[baseOffset + i];
 	part->faces.count[face] += 4;
 }
 
 #if CC_GFX_BACKEND == CC_GFX_BACKEND_GL11
-static void BuildPartVbs(struct ChunkPartInfo* info) {
+static void BuildPartVbs(struct VertexTextured* vertices, struct ChunkPartInfo* info) {
 	/* Sprites vertices are stored before chunk face sides */
 	int i, count, offset = info->offset + info->spriteCount;
 	for (i = 0; i < FACE_COUNT; i++) {
 		count = info->counts[i];
 
 		if (count) {
-			info->vbs[i] = Gfx_CreateVb2(&Builder_Vertices[offset], VERTEX_FORMAT_TEXTURED, count);
+			info->vbs[i] = Gfx_CreateVb2(&vertices[offset], VERTEX_FORMAT_TEXTURED, count);
 			offset += count;
 		} else {
 			info->vbs[i] = 0;
@@ -120,130 +178,130 @@ static void BuildPartVbs(struct ChunkPartInfo* info) {
 	count  = info->spriteCount;
 	offset = info->offset;
 	if (count) {
-		info->vbs[i] = Gfx_CreateVb2(&Builder_Vertices[offset], VERTEX_FORMAT_TEXTURED, count);
+		info->vbs[i] = Gfx_CreateVb2(&vertices[offset], VERTEX_FORMAT_TEXTURED, count);
 	} else {
 		info->vbs[i] = 0;
 	}
 }
 #endif
 
-static cc_bool SetPartInfo(struct Builder1DPart* part, int* offset, struct ChunkPartInfo* info) {
+/* Layout of a part of a chunk's mesh, which is later copied into the chunk's ChunkPartInfo */
+/* Kept separately so that it can be calculated on background threads */
+struct ChunkPartMeta { cc_int32 offset, spriteCount; cc_uint16 counts[FACE_COUNT]; };
+/* Layout of the parts of the chunk mesh most recently built on the main thread */
+static struct ChunkPartMeta mainPartsMeta[ATLAS1D_MAX_ATLASES * 2];
+
+static void SetPartMeta(struct Builder1DPart* part, int* offset, struct ChunkPartMeta* meta) {
 	int vCount = Builder1DPart_VerticesCount(part);
-	info->offset = -1;
-	if (!vCount) return false;
+	meta->offset = -1;
+	if (!vCount) return;
 
-	info->offset = *offset;
+	meta->offset = *offset;
 	*offset += vCount;
 
-	info->counts[FACE_XMIN] = part->faces.count[FACE_XMIN];
-	info->counts[FACE_XMAX] = part->faces.count[FACE_XMAX];
-	info->counts[FACE_ZMIN] = part->faces.count[FACE_ZMIN];
-	info->counts[FACE_ZMAX] = part->faces.count[FACE_ZMAX];
-	info->counts[FACE_YMIN] = part->faces.count[FACE_YMIN];
-	info->counts[FACE_YMAX] = part->faces.count[FACE_YMAX];
-	info->spriteCount       = part->sCount;
-	return true;
+	meta->counts[FACE_XMIN] = part->faces.count[FACE_XMIN];
+	meta->counts[FACE_XMAX] = part->faces.count[FACE_XMAX];
+	meta->counts[FACE_ZMIN] = part->faces.count[FACE_ZMIN];
+	meta->counts[FACE_ZMAX] = part->faces.count[FACE_ZMAX];
+	meta->counts[FACE_YMIN] = part->faces.count[FACE_YMIN];
+	meta->counts[FACE_YMAX] = part->faces.count[FACE_YMAX];
+	meta->spriteCount       = part->sCount;
 }
 
 
-static void PrepareChunk(int x1, int y1, int z1) {
+/* Calculates which faces of the blocks in the given layer of a chunk are visible */
+static void PrepareLayer(struct BuilderContext* ctx, int x1, int y, int z1) {
 	int xMax = min(World.Width,  x1 + CHUNK_SIZE);
-	int yMax = min(World.Height, y1 + CHUNK_SIZE);
 	int zMax = min(World.Length, z1 + CHUNK_SIZE);
+	int yy   = y & CHUNK_MASK;
 
 	int cIndex, index, tileIdx;
 	BlockID b;
-	int x, y, z, xx, yy, zz;
-
-#ifdef OCCLUSION
-	int flags = ComputeOcclusion();
-#endif
-#ifdef DEBUG_OCCLUSION
-	FastColour col = new FastColour(60, 60, 60, 255);
-	if (flags & 1) col.R = 255; /* x */
-	if (flags & 4) col.G = 255; /* y */
-	if (flags & 2) col.B = 255; /* z */
-	map.Sunlight = map.Shadowlight = col;
-	map.SunlightXSide = map.ShadowlightXSide = col;
-	map.SunlightZSide = map.ShadowlightZSide = col;
-	map.SunlightYBottom = map.ShadowlightYBottom = col;
-#endif
+	int x, z, xx, zz;
 	
-	for (y = y1, yy = 0; y < yMax; y++, yy++) {
-		for (z = z1, zz = 0; z < zMax; z++, zz++) {
-			cIndex = Builder_PackChunk(0, yy, zz);
-
-			for (x = x1, xx = 0; x < xMax; x++, xx++, cIndex++) {
-				b = Builder_Chunk[cIndex];
-				if (Blocks.Draw[b] == DRAW_GAS) continue;
-				index = Builder_PackCount(xx, yy, zz);
-
-				/* Sprites can't be stretched, nor can then be they hidden by other blocks. */
-				/* Note sprites are drawn using DrawSprite and not with any of the DrawXFace. */
-				if (Blocks.Draw[b] == DRAW_SPRITE) { AddSpriteVertices(b); continue; }
-
-				Builder_X = x; Builder_Y = y; Builder_Z = z;
-				Builder_FullBright = Blocks.Brightness[b];
-				tileIdx = b * BLOCK_COUNT;
-				/* All of these function calls are inlined as they can be called tens of millions to hundreds of millions of times. */
-
-				if (Builder_Counts[index] == 0 ||
-					(x == 0 && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(x != 0 && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex - 1]] & FACE_BIT_XMIN) != 0)) {
-					Builder_Counts[index] = 0;
-				} else {
-					Builder_Counts[index] = Builder_StretchZ(index, x, y, z, cIndex, b, FACE_XMIN);
-				}
-
-				index++;
-				if (Builder_Counts[index] == 0 ||
-					(x == World.MaxX && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(x != World.MaxX && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex + 1]] & FACE_BIT_XMAX) != 0)) {
-					Builder_Counts[index] = 0;
-				} else {
-					Builder_Counts[index] = Builder_StretchZ(index, x, y, z, cIndex, b, FACE_XMAX);
-				}
-
-				index++;
-				if (Builder_Counts[index] == 0 ||
-					(z == 0 && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(z != 0 && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex - EXTCHUNK_SIZE]] & FACE_BIT_ZMIN) != 0)) {
-					Builder_Counts[index] = 0;
-				} else {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_ZMIN);
-				}
-
-				index++;
-				if (Builder_Counts[index] == 0 ||
-					(z == World.MaxZ && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
-					(z != World.MaxZ && (Blocks.Hidden[tileIdx + Builder_Chunk[cIndex + EXTCHUNK_SIZE]] & FACE_BIT_ZMAX) != 0)) {
-					Builder_Counts[index] = 0;
-				} else {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_ZMAX);
-				}
-
-				index++;
-				if (Builder_Counts[index] == 0 || y == 0 ||
-					(Blocks.Hidden[tileIdx + Builder_Chunk[cIndex - EXTCHUNK_SIZE_2]] & FACE_BIT_YMIN) != 0) {
-					Builder_Counts[index] = 0;
-				} else {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_YMIN);
-				}
-
-				index++;
-				if (Builder_Counts[index] == 0 ||
-					(Blocks.Hidden[tileIdx + Builder_Chunk[cIndex + EXTCHUNK_SIZE_2]] & FACE_BIT_YMAX) != 0) {
-					Builder_Counts[index] = 0;
-				} else if (b < BLOCK_WATER || b > BLOCK_STILL_LAVA) {
-					Builder_Counts[index] = Builder_StretchX(index, x, y, z, cIndex, b, FACE_YMAX);
-				} else {
-					Builder_Counts[index] = Builder_StretchXLiquid(index, x, y, z, cIndex, b);
-				}
+	for (z = z1, zz = 0; z < zMax; z++, zz++) {
+		cIndex = Builder_PackChunk(0, yy, zz);
+
+		for (x = x1, xx = 0; x < xMax; x++, xx++, cIndex++) {
+			b = ctx->chunk[cIndex];
+			if (Blocks.Draw[b] == DRAW_GAS) continue;
+			index = Builder_PackCount(xx, yy, zz);
+
+			/* Sprites can't be stretched, nor can then be they hidden by other blocks. */
+			/* Note sprites are drawn using DrawSprite and not with any of the DrawXFace. */
+			if (Blocks.Draw[b] == DRAW_SPRITE) { AddSpriteVertices(ctx, b); continue; }
+
+			ctx->x = x; ctx->y = y; ctx->z = z;
+			ctx->fullBright = Blocks.Brightness[b];
+			tileIdx = b * BLOCK_COUNT;
+			/* All of these function calls are inlined as they can be called tens of millions to hundreds of millions of times. */
+
+			if (ctx->counts[index] == 0 ||
+				(x == 0 && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
+				(x != 0 && (Blocks.Hidden[tileIdx + ctx->chunk[cIndex - 1]] & FACE_BIT_XMIN) != 0)) {
+				ctx->counts[index] = 0;
+			} else {
+				ctx->counts[index] = Builder_StretchZ(ctx, index, x, y, z, cIndex, b, FACE_XMIN);
+			}
+
+			index++;
+			if (ctx->counts[index] == 0 ||
+				(x == World.MaxX && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
+				(x != World.MaxX && (Blocks.Hidden[tileIdx + ctx->chunk[cIndex + 1]] & FACE_BIT_XMAX) != 0)) {
+				ctx->counts[index] = 0;
+			} else {
+				ctx->counts[index] = Builder_StretchZ(ctx, index, x, y, z, cIndex, b, FACE_XMAX);
+			}
+
+			index++;
+			if (ctx->counts[index] == 0 ||
+				(z == 0 && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
+				(z != 0 && (Blocks.Hidden[tileIdx + ctx->chunk[cIndex - EXTCHUNK_SIZE]] & FACE_BIT_ZMIN) != 0)) {
+				ctx->counts[index] = 0;
+			} else {
+				ctx->counts[index] = Builder_StretchX(ctx, index, x, y, z, cIndex, b, FACE_ZMIN);
+			}
+
+			index++;
+			if (ctx->counts[index] == 0 ||
+				(z == World.MaxZ && (y < Builder_SidesLevel || (b >= BLOCK_WATER && b <= BLOCK_STILL_LAVA && y < Builder_EdgeLevel))) ||
+				(z != World.MaxZ && (Blocks.Hidden[tileIdx + ctx->chunk[cIndex + EXTCHUNK_SIZE]] & FACE_BIT_ZMAX) != 0)) {
+				ctx->counts[index] = 0;
+			} else {
+				ctx->counts[index] = Builder_StretchX(ctx, index, x, y, z, cIndex, b, FACE_ZMAX);
+			}
+
+			index++;
+			if (ctx->counts[index] == 0 || y == 0 ||
+				(Blocks.Hidden[tileIdx + ctx->chunk[cIndex - EXTCHUNK_SIZE_2]] & FACE_BIT_YMIN) != 0) {
+				ctx->counts[index] = 0;
+			} else {
+				ctx->counts[index] = Builder_StretchX(ctx, index, x, y, z, cIndex, b, FACE_YMIN);
+			}
+
+			index++;
+			if (ctx->counts[index] == 0 ||
+				(Blocks.Hidden[tileIdx + ctx->chunk[cIndex + EXTCHUNK_SIZE_2]] & FACE_BIT_YMAX) != 0) {
+				ctx->counts[index] = 0;
+			} else if (b < BLOCK_WATER || b > BLOCK_STILL_LAVA) {
+				ctx->counts[index] = Builder_StretchX(ctx, index, x, y, z, cIndex, b, FACE_YMAX);
+			} else {
+				ctx->counts[index] = Builder_StretchXLiquid(ctx, index, x, y, z, cIndex, b);
 			}
 		}
 	}
 }
 
+static void PrepareChunk(struct BuilderContext* ctx, int x1, int y1, int z1) {
+	int yMax = min(World.Height, y1 + CHUNK_SIZE);
+	int y;
+
+	for (y = y1; y < yMax; y++) 
+	{
+		PrepareLayer(ctx, x1, y, z1);
+	}
+}
+
 #define ReadChunkBody(get_block)\
 for (yy = -1; yy < 17; ++yy) {\
 	y = yy + y1;\
@@ -256,12 +314,12 @@ for (yy = -1; yy < 17; ++yy) {\
 			block    = get_block;\
 			allAir   = allAir   && Blocks.Draw[block] == DRAW_GAS;\
 			allSolid = allSolid && Blocks.FullOpaque[block];\
-			Builder_Chunk[cIndex] = block;\
+			ctx->chunk[cIndex] = block;\
 		}\
 	}\
 }
 
-static cc_bool ReadChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
+static cc_bool ReadChunkData(struct BuilderContext* ctx, int x1, int y1, int z1, cc_bool* outAllAir) {
 	BlockRaw* blocks = World.Blocks;
 	cc_bool allAir = true, allSolid = true;
 	int index, cIndex;
@@ -306,12 +364,12 @@ for (yy = -1; yy < 17; ++yy) {\
 \
 			block  = get_block;\
 			allAir = allAir && Blocks.Draw[block] == DRAW_GAS;\
-			Builder_Chunk[cIndex] = block;\
+			ctx->chunk[cIndex] = block;\
 		}\
 	}\
 }
 
-static cc_bool ReadBorderChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
+static cc_bool ReadBorderChunkData(struct BuilderContext* ctx, int x1, int y1, int z1, cc_bool* outAllAir) {
 	BlockRaw* blocks = World.Blocks;
 	BlockRaw* blocks2;
 	cc_bool allAir = true;
@@ -334,161 +392,994 @@ static cc_bool ReadBorderChunkData(int x1, int y1, int z1, cc_bool* outAllAir) {
 	return false;
 }
 
-static void OutputChunkPartsMeta(int x, int y, int z, struct ChunkInfo* info) {
-	cc_bool hasNorm, hasTran;
-	int partsIndex;
-	int i, j, curIdx, offset;
-	
-	partsIndex = World_ChunkPack(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
-	offset  = 0;
-	hasNorm = false;
-	hasTran = false;
+/* Calculates the layout of the parts of the chunk mesh counted by CountChunk */
+/* Parts are interleaved, with the normal part for each 1D atlas followed by its translucent part */
+static void CalcPartsMeta(struct BuilderContext* ctx, struct ChunkPartMeta* parts, int count) {
+	int i, offset = 0;
 
-	for (i = 0; i < MapRenderer_1DUsedCount; i++) {
-		j = i + ATLAS1D_MAX_ATLASES;
-		curIdx = partsIndex + i * World.ChunksCount;
-
-		hasNorm |= SetPartInfo(&Builder_Parts[i], &offset, &MapRenderer_PartsNormal[curIdx]);
-		hasTran |= SetPartInfo(&Builder_Parts[j], &offset, &MapRenderer_PartsTranslucent[curIdx]);
+	for (i = 0; i < count; i++) 
+	{
+		SetPartMeta(&ctx->parts[(i & 1) * ATLAS1D_MAX_ATLASES + (i >> 1)], &offset, &parts[i]);
 	}
+}
 
-	if (hasNorm) {
-		info->normalParts      = &MapRenderer_PartsNormal[partsIndex];
-	}
-	if (hasTran) {
-		info->translucentParts = &MapRenderer_PartsTranslucent[partsIndex];
+/* Copies the layout of the parts of a chunk's mesh into the chunk's ChunkPartInfos */
+static void ApplyPartsMeta(const struct ChunkPartMeta* parts, int count, struct ChunkInfo* info) {
+	int partsIndex = World_ChunkPack(info->centreX >> CHUNK_SHIFT, info->centreY >> CHUNK_SHIFT, info->centreZ >> CHUNK_SHIFT);
+	struct ChunkPartInfo* part;
+	cc_bool hasNorm = false, hasTran = false;
+	int i, j;
+
+	for (i = 0; i < count; i++) 
+	{
+		part = (i & 1) ? MapRenderer_PartsTranslucent : MapRenderer_PartsNormal;
+		part = &part[partsIndex + (i >> 1) * World.ChunksCount];
+
+		part->offset      = parts[i].offset;
+		part->spriteCount = parts[i].spriteCount;
+		for (j = 0; j < FACE_COUNT; j++) part->counts[j] = parts[i].counts[j];
+
+		if (part->offset < 0) continue;
+		if (i & 1) { hasTran = true; } else { hasNorm = true; }
 	}
+
+	if (hasNorm) info->normalParts      = &MapRenderer_PartsNormal[partsIndex];
+	if (hasTran) info->translucentParts = &MapRenderer_PartsTranslucent[partsIndex];
 }
 
-void Builder_MakeChunk(struct ChunkInfo* info) {
-#if CC_BUILD_MAXSTACK <= (32 * 1024)
-	void* mem        = TempMem_Alloc((EXTCHUNK_SIZE_3 * sizeof(BlockID)) + (CHUNK_SIZE_3 * FACE_COUNT));
-	BlockID* chunk   = (BlockID*)mem;
-	cc_uint8* counts = (cc_uint8*)(chunk + EXTCHUNK_SIZE_3);
-#else
-	BlockID chunk[EXTCHUNK_SIZE_3]; 
-	cc_uint8 counts[CHUNK_SIZE_3 * FACE_COUNT]; 
-#endif
+static void OutputChunkPartsMeta(struct BuilderContext* ctx, struct ChunkInfo* info) {
+	int count = MapRenderer_1DUsedCount * 2;
+	CalcPartsMeta(ctx, mainPartsMeta, count);
+	ApplyPartsMeta(mainPartsMeta, count, info);
+}
 
-#ifdef CC_BUILD_ADVLIGHTING
-	int bitFlags[EXTCHUNK_SIZE_3];
-#else
-	int bitFlags[1];
-#endif
+/* Returns whether the given chunk or any chunk around it is rendered at a reduced level of detail */
+static cc_bool Lod_Needed(struct ChunkInfo* info) {
+	int cx = info->centreX >> CHUNK_SHIFT, cy = info->centreY >> CHUNK_SHIFT, cz = info->centreZ >> CHUNK_SHIFT;
+	int x, y, z;
 
-	cc_bool allAir, allSolid, onBorder;
-	int xMax, yMax, zMax, totalVerts;
-	int cIndex, index;
-	int x, y, z, xx, yy, zz;
+	for (y = cy - 1; y <= cy + 1; y++)
+		for (z = cz - 1; z <= cz + 1; z++)
+			for (x = cx - 1; x <= cx + 1; x++)
+	{
+		if (MapRenderer_GetChunkLod(x, y, z)) return true;
+	}
+	return false;
+}
+
+/* Reads the blocks of the given chunk (and the blocks bordering it) */
+/* Returns whether the chunk might need a mesh (i.e. whether it is not entirely air or entirely solid) */
+/* NOTE: Solid chunks next to reduced level of detail chunks may still have faces along the border */
+static cc_bool ReadChunk(struct BuilderContext* ctx, struct ChunkInfo* info, cc_bool* allAir) {
 	int x1 = info->centreX - 8, y1 = info->centreY - 8, z1 = info->centreZ - 8;
+	cc_bool allSolid, onBorder;
 
-	Builder_Chunk  = chunk;
-	Builder_Counts = counts;
-	Builder_BitFlags = bitFlags;
-	Builder_PrePrepareChunk();
-	
 	onBorder = 
 		x1 == 0 || y1 == 0 || z1 == 0   || x1 + CHUNK_SIZE >= World.Width ||
 		y1 + CHUNK_SIZE >= World.Height || z1 + CHUNK_SIZE >= World.Length;
 
 	if (onBorder) {
 		/* less optimal case here */
-		Mem_Set(chunk, BLOCK_AIR, EXTCHUNK_SIZE_3 * sizeof(BlockID));
-		allSolid = ReadBorderChunkData(x1, y1, z1, &allAir);
+		Mem_Set(ctx->chunk, BLOCK_AIR, EXTCHUNK_SIZE_3 * sizeof(BlockID));
+		allSolid = ReadBorderChunkData(ctx, x1, y1, z1, allAir);
 	} else {
-		allSolid = ReadChunkData(x1, y1, z1, &allAir);
+		allSolid = ReadChunkData(ctx, x1, y1, z1, allAir);
 	}
+	return !(*allAir || (allSolid && !Lod_Needed(info)));
+}
 
-	info->allAir = allAir;
-	if (allAir || allSolid) return;
-	Lighting.LightHint(x1 - 1, y1 - 1, z1 - 1);
 
-	Mem_Set(counts, 1, CHUNK_SIZE_3 * FACE_COUNT);
-	xMax = min(World.Width,  x1 + CHUNK_SIZE);
-	yMax = min(World.Height, y1 + CHUNK_SIZE);
-	zMax = min(World.Length, z1 + CHUNK_SIZE);
+/*########################################################################################################################*
+*-------------------------------------------------Level of detail meshes--------------------------------------------------*
+*#########################################################################################################################*/
+/* Max number of blocks in a single cell (4x4x4 at MAPRENDERER_MAX_LOD) */
+#define LOD_MAX_CELL_BLOCKS 64
+
+/* Tracks how many times each block occurs in a cell of blocks */
+struct LodCell {
+	int total, empty, distinct;
+	BlockID blocks[LOD_MAX_CELL_BLOCKS];
+	cc_uint8 counts[LOD_MAX_CELL_BLOCKS];
+};
 
-	Builder_ChunkEndX = xMax; Builder_ChunkEndZ = zMax;
-	PrepareChunk(x1, y1, z1);
+static void LodCell_Add(struct LodCell* cell, BlockID block) {
+	int i, draw = Blocks.Draw[block];
+	cell->total++;
+	/* Sprites are too small to be seen from far away anyways */
+	if (draw == DRAW_GAS || draw == DRAW_SPRITE) { cell->empty++; return; }
 
-	totalVerts = Builder_TotalVerticesCount();
-	if (!totalVerts) return;
-	
-	OutputChunkPartsMeta(x1, y1, z1, info);
-#ifdef OCCLUSION
-	if (info.NormalParts != null || info.TranslucentParts != null)
-		info.occlusionFlags = (cc_uint8)ComputeOcclusion();
+	for (i = 0; i < cell->distinct; i++) 
+	{
+		if (cell->blocks[i] == block) { cell->counts[i]++; return; }
+	}
+	cell->blocks[i] = block;
+	cell->counts[i] = 1;
+	cell->distinct++;
+}
+
+/* Returns the most common block in the cell, or air if most of the cell is empty */
+static BlockID LodCell_Majority(struct LodCell* cell) {
+	int i, best = 0;
+	if (cell->empty * 2 >= cell->total) return BLOCK_AIR;
+
+	for (i = 1; i < cell->distinct; i++) 
+	{
+		if (cell->counts[i] > cell->counts[best]) best = i;
+	}
+	return cell->blocks[best];
+}
+
+/* Calculates the block that the cell containing the given world coordinates is downsampled to */
+static BlockID Lod_WorldCell(int x, int y, int z, int size) {
+	struct LodCell cell;
+	int x1 = x & ~(size - 1), y1 = y & ~(size - 1), z1 = z & ~(size - 1);
+	cell.total = 0; cell.empty = 0; cell.distinct = 0;
+
+	for (y = y1; y < y1 + size; y++)
+		for (z = z1; z < z1 + size; z++)
+			for (x = x1; x < x1 + size; x++)
+	{
+		LodCell_Add(&cell, World_Contains(x, y, z) ? World_GetBlock(x, y, z) : BLOCK_AIR);
+	}
+	return LodCell_Majority(&cell);
+}
+
+/* Downsamples the blocks of the chunk into cells of the chunk's level of detail, */
+/*  with every block in a cell being replaced by the most common block in that cell */
+/* Border blocks are replaced with how the neighbouring chunks at their level of detail render them */
+/* NOTE: Cells are aligned to the world, so neighbouring chunks at the same level of detail */
+/*  downsample the blocks along their shared border identically */
+static void DownsampleChunk(struct BuilderContext* ctx, struct ChunkInfo* info) {
+	int x1 = info->centreX - 8, y1 = info->centreY - 8, z1 = info->centreZ - 8;
+	int size = 1 << info->lod, lastCell = -1, lastSize = 0, cellIndex;
+	int x, y, z, xx, yy, zz;
+	struct LodCell cell;
+	BlockID block = BLOCK_AIR;
+
+	for (y = 0; y < CHUNK_SIZE && size > 1; y += size)
+		for (z = 0; z < CHUNK_SIZE; z += size)
+			for (x = 0; x < CHUNK_SIZE; x += size)
+	{
+		cell.total = 0; cell.empty = 0; cell.distinct = 0;
+		for (yy = y; yy < y + size; yy++)
+			for (zz = z; zz < z + size; zz++)
+				for (xx = x; xx < x + size; xx++)
+		{
+			LodCell_Add(&cell, ctx->chunk[Builder_PackChunk(xx, yy, zz)]);
+		}
+
+		block = LodCell_Majority(&cell);
+		for (yy = y; yy < y + size; yy++)
+			for (zz = z; zz < z + size; zz++)
+				for (xx = x; xx < x + size; xx++)
+		{
+			ctx->chunk[Builder_PackChunk(xx, yy, zz)] = block;
+		}
+	}
+
+	/* Border blocks must be what the neighbouring chunk actually renders there, otherwise faces */
+	/*  along the border might be hidden by blocks the neighbour renders as air (leaving holes) */
+	for (yy = -1; yy <= CHUNK_SIZE; yy++)
+		for (zz = -1; zz <= CHUNK_SIZE; zz++)
+			for (xx = -1; xx <= CHUNK_SIZE; xx++)
+	{
+		if (xx >= 0 && xx < CHUNK_SIZE && yy >= 0 && yy < CHUNK_SIZE && zz >= 0 && zz < CHUNK_SIZE) {
+			xx = CHUNK_SIZE - 1; continue;
+		}
+		x = x1 + xx; y = y1 + yy; z = z1 + zz;
+		/* Full detail neighbours (and outside the map) render the blocks already read */
+		size = 1 << MapRenderer_GetChunkLod(x >> CHUNK_SHIFT, y >> CHUNK_SHIFT, z >> CHUNK_SHIFT);
+		if (size == 1) continue;
+
+		/* Border blocks are in cells that are mostly in neighbouring chunks, so have to be read from the world */
+		cellIndex = World_Pack(x & ~(size - 1), y & ~(size - 1), z & ~(size - 1));
+		if (cellIndex != lastCell || size != lastSize) block = Lod_WorldCell(x, y, z, size);
+
+		lastCell = cellIndex; lastSize = size;
+		ctx->chunk[Builder_PackChunk(xx, yy, zz)] = block;
+	}
+}
+
+#define Builder_CellToChunk(cell) Builder_PackChunk((cell) & 0x0F, (cell) >> 8, ((cell) >> 4) & 0x0F)
+
+/* Calculates which faces of the given chunk can be seen from which other faces, */
+/*  by flood filling through the blocks in the chunk that aren't fully opaque */
+static cc_uint32 CalcConnectivity(struct BuilderContext* ctx) {
+	cc_uint32 connectivity = 0;
+	int i, cur, count, cIndex, faces;
+	int x, y, z, a, b;
+	Mem_Set(ctx->visited, 0, CHUNK_SIZE_3);
+
+	for (i = 0; i < CHUNK_SIZE_3; i++)
+	{
+		if (ctx->visited[i] || Blocks.FullOpaque[ctx->chunk[Builder_CellToChunk(i)]]) continue;
+		ctx->visited[i]   = true;
+		ctx->fillStack[0] = i;
+		count = 1; faces = 0;
+
+		while (count)
+		{
+			cur = ctx->fillStack[--count];
+			x   = cur & 0x0F; z = (cur >> 4) & 0x0F; y = cur >> 8;
+			cIndex = Builder_PackChunk(x, y, z);
+
+			if (x == 0) faces |= FACE_BIT_XMIN;
+			if (x == 15) faces |= FACE_BIT_XMAX;
+			if (z == 0) faces |= FACE_BIT_ZMIN;
+			if (z == 15) faces |= FACE_BIT_ZMAX;
+			if (y == 0) faces |= FACE_BIT_YMIN;
+			if (y == 15) faces |= FACE_BIT_YMAX;
+
+			/* NOTE: Offsets in the 18x18x18 chunk array differ from offsets in the 16x16x16 cell array */
+			if (x > 0  && !ctx->visited[cur - 1]   && !Blocks.FullOpaque[ctx->chunk[cIndex - 1]]) {
+				ctx->visited[cur - 1] = true;   ctx->fillStack[count++] = cur - 1;
+			}
+			if (x < 15 && !ctx->visited[cur + 1]   && !Blocks.FullOpaque[ctx->chunk[cIndex + 1]]) {
+				ctx->visited[cur + 1] = true;   ctx->fillStack[count++] = cur + 1;
+			}
+			if (z > 0  && !ctx->visited[cur - 16]  && !Blocks.FullOpaque[ctx->chunk[cIndex - EXTCHUNK_SIZE]]) {
+				ctx->visited[cur - 16] = true;  ctx->fillStack[count++] = cur - 16;
+			}
+			if (z < 15 && !ctx->visited[cur + 16]  && !Blocks.FullOpaque[ctx->chunk[cIndex + EXTCHUNK_SIZE]]) {
+				ctx->visited[cur + 16] = true;  ctx->fillStack[count++] = cur + 16;
+			}
+			if (y > 0  && !ctx->visited[cur - 256] && !Blocks.FullOpaque[ctx->chunk[cIndex - EXTCHUNK_SIZE_2]]) {
+				ctx->visited[cur - 256] = true; ctx->fillStack[count++] = cur - 256;
+			}
+			if (y < 15 && !ctx->visited[cur + 256] && !Blocks.FullOpaque[ctx->chunk[cIndex + EXTCHUNK_SIZE_2]]) {
+				ctx->visited[cur + 256] = true; ctx->fillStack[count++] = cur + 256;
+			}
+		}
+
+		for (a = 0; a < FACE_COUNT; a++) {
+			if (!(faces & (1 << a))) continue;
+			for (b = a + 1; b < FACE_COUNT; b++) {
+				if (faces & (1 << b)) connectivity |= ChunkInfo_FacesBit(a, b);
+			}
+		}
+		if (connectivity == CHUNK_CONNECTED_ALL) break;
+	}
+	return connectivity;
+}
+
+/* Calculates which faces of the given chunk are visible */
+/* Returns total number of vertices in the chunk's mesh */
+static int CountChunk(struct BuilderContext* ctx, struct ChunkInfo* info) {
+	int x1 = info->centreX - 8, y1 = info->centreY - 8, z1 = info->centreZ - 8;
+	int totalVerts, i, faces, quads;
+
+	Mem_Set(ctx->counts, 1, CHUNK_SIZE_3 * FACE_COUNT);
+	ctx->chunkEndX = min(World.Width,  x1 + CHUNK_SIZE);
+	ctx->chunkEndZ = min(World.Length, z1 + CHUNK_SIZE);
+	ctx->unmergedVerts = 0;
+	PrepareChunk(ctx, x1, y1, z1);
+	if (Builder_MergeFaces) Builder_MergeFaces(ctx, x1, y1, z1);
+
+	totalVerts = Builder_TotalVerticesCount(ctx);
+	if (!totalVerts) return 0;
+
+	/* Each merged face is counted once in the length of the run it was merged into */
+	for (i = 0, faces = 0, quads = 0; i < CHUNK_SIZE_3 * FACE_COUNT; i++)
+	{
+		if (!ctx->counts[i]) continue;
+		faces += ctx->counts[i]; quads++;
+	}
+	ctx->unmergedVerts += totalVerts + (faces - quads) * 4;
+	return totalVerts;
+}
+
+/* Writes the vertices of the blocks in the given layer of a chunk */
+static void RenderLayer(struct BuilderContext* ctx, int x1, int y, int z1) {
+	int xMax = min(World.Width,  x1 + CHUNK_SIZE);
+	int zMax = min(World.Length, z1 + CHUNK_SIZE);
+	int yy   = y & CHUNK_MASK;
+	int cIndex, index;
+	int x, z, xx, zz;
+
+	for (z = z1, zz = 0; z < zMax; z++, zz++) {
+		cIndex = Builder_PackChunk(0, yy, zz);
+
+		for (x = x1, xx = 0; x < xMax; x++, xx++, cIndex++) {
+			ctx->block = ctx->chunk[cIndex];
+			if (Blocks.Draw[ctx->block] == DRAW_GAS) continue;
+
+			index = Builder_PackCount(xx, yy, zz);
+			ctx->chunkIndex = cIndex;
+			Builder_RenderBlock(ctx, index, x, y, z);
+		}
+	}
+}
+
+/* Writes the vertices of the given chunk's mesh into ctx->vertices */
+static void RenderChunk(struct BuilderContext* ctx, struct ChunkInfo* info) {
+	int x1 = info->centreX - 8, y1 = info->centreY - 8, z1 = info->centreZ - 8;
+	int yMax = min(World.Height, y1 + CHUNK_SIZE);
+	int y;
+	Builder_PostPrepareChunk(ctx);
+
+	for (y = y1; y < yMax; y++) 
+	{
+		RenderLayer(ctx, x1, y, z1);
+	}
+}
+
+#if CC_GFX_BACKEND == CC_GFX_BACKEND_GL11
+static void BuildChunkVbs(struct VertexTextured* vertices, struct ChunkInfo* info) {
+	int cIndex = World_ChunkPack(info->centreX >> CHUNK_SHIFT, info->centreY >> CHUNK_SHIFT, info->centreZ >> CHUNK_SHIFT);
+	int i, curIdx;
+
+	for (i = 0; i < MapRenderer_1DUsedCount; i++) {
+		curIdx = cIndex + i * World.ChunksCount;
+
+		BuildPartVbs(vertices, &MapRenderer_PartsNormal[curIdx]);
+		BuildPartVbs(vertices, &MapRenderer_PartsTranslucent[curIdx]);
+	}
+}
+#else
+#ifdef CC_BUILD_PACKEDTERRAIN
+/* Converts vertices into VERTEX_FORMAT_TERRAIN, with positions relative to the origin of the chunk's region */
+/* V is made relative to the tile row of each quad, so that faces merged in the V direction repeat within it */
+static void PackVertices(struct VertexTerrain* dst, const struct VertexTextured* src, int count, struct ChunkInfo* info) {
+	float x = (float)TerrainRegion_Origin(info->centreX);
+	float y = (float)TerrainRegion_Origin(info->centreY);
+	float z = (float)TerrainRegion_Origin(info->centreZ);
+	float tiles = (float)Atlas1D.TilesPerAtlas, row = 0.0f, v;
+	int i;
+
+	for (i = 0; i < count; i++, src++, dst++)
+	{
+		/* The smallest V of a quad is always inside the tile row the quad's texture is in */
+		if ((i & 3) == 0) {
+			v   = min(min(src[0].V, src[1].V), min(src[2].V, src[3].V));
+			row = (float)Math_Floor(v * tiles + 0.001f);
+		}
+
+		dst->x   = (cc_int16)Math_Floor((src->x - x) * 64.0f + 0.5f);
+		dst->y   = (cc_int16)Math_Floor((src->y - y) * 64.0f + 0.5f);
+		dst->z   = (cc_int16)Math_Floor((src->z - z) * 64.0f + 0.5f);
+		dst->U   = (cc_int16)Math_Floor(src->U * 1024.0f + 0.5f);
+		dst->V   = row * 32.0f + (src->V * tiles - row);
+		dst->Col = src->Col;
+	}
+}
 #endif
 
-#if CC_GFX_BACKEND != CC_GFX_BACKEND_GL11
+/* Allocates space for the chunk's mesh, then returns memory for filling in its vertices */
+static void* LockChunkVb(struct ChunkInfo* info, int count) {
+#ifdef CC_BUILD_CHUNKARENA
+	void* data = MapRenderer_LockChunkVb(info, count);
+	if (data) return data;
+#endif
 	/* add an extra element to fix crashing on some GPUs */
-	info->vb = Gfx_CreateVb(VERTEX_FORMAT_TEXTURED, totalVerts + 1);
-	Builder_Vertices = (struct VertexTextured*)Gfx_LockVb(info->vb,
-													VERTEX_FORMAT_TEXTURED, totalVerts + 1);
+	info->vb = Gfx_CreateVb(CHUNK_VERTEX_FORMAT, count + 1);
+	return Gfx_LockVb(info->vb, CHUNK_VERTEX_FORMAT, count + 1);
+}
+
+static void UnlockChunkVb(struct ChunkInfo* info) {
+#ifdef CC_BUILD_CHUNKARENA
+	if (info->arenaIndex >= 0) { MapRenderer_UnlockChunkVb(info); return; }
+#endif
+	Gfx_UnlockVb(info->vb);
+}
+
+/* Creates the chunk's vertex buffer from the given built vertices */
+static void UploadChunkVb(struct ChunkInfo* info, const struct VertexTextured* vertices, int count) {
+	void* data = LockChunkVb(info, count);
+
+#ifdef CC_BUILD_PACKEDTERRAIN
+	PackVertices((struct VertexTerrain*)data, vertices, count, info);
 #else
-	/* NOTE: Relies on assumption vb is ignored by GL11 Gfx_LockVb implementation */
-	Builder_Vertices = (struct VertexTextured*)Gfx_LockVb(0, 
-													VERTEX_FORMAT_TEXTURED, totalVerts + 1);
+	Mem_Copy(data, vertices, count * sizeof(struct VertexTextured));
 #endif
-	Builder_PostPrepareChunk();
-	/* now render the chunk */
+	UnlockChunkVb(info);
+}
+#endif
+
+/*########################################################################################################################*
+*--------------------------------------------------------Mesh cache-------------------------------------------------------*
+*#########################################################################################################################*/
+/* Built chunk meshes are saved to disk, so that when the same map is loaded again, */
+/*  chunks whose blocks haven't changed can be uploaded straight from the cache instead of being rebuilt */
+/* Each mesh is stored under a key hashed from the blocks and lighting heightmap the mesh was built from, */
+/*  combined with a hash of all the other state that affects meshes (e.g. block definitions, terrain atlas) */
+/* As keys only depend on what the meshes were built from, all maps share the same cache file, */
+/*  which is started again from scratch whenever it reaches the configured size limit */
+/* Records are written to the cache file on a background thread, so that disk latency doesn't affect frame times */
+/* NOTE: Cache files store data in native byte order, so cannot be shared between different machines */
+int Builder_CachedChunks;
+#if !defined CC_BUILD_COOPTHREADED && !defined CC_BUILD_LOWMEM
+#define MESHCACHE_MAGIC   0x4843534Du /* "MSCH" */
+#define MESHCACHE_VERSION 1
+#define MESHCACHE_PATH "meshcache/meshes.bin"
+/* Records aren't cached when more than this many bytes are still waiting to be written */
+#define MESHCACHE_MAX_QUEUED (16 * 1024 * 1024)
+
+struct MeshCacheHeader { cc_uint32 magic, version, vertexSize, reserved; };
+struct MeshCacheRecord { cc_uint32 keyLo, keyHi, chunkIndex, vertsCount, partsCount; };
+struct MeshCacheEntry  { cc_uint64 key; cc_uint32 offset; };
+/* A record waiting to be written by the writer thread (record data follows this struct) */
+struct MeshCacheWrite  { struct MeshCacheWrite* next; cc_uint32 offset, size; };
+
+static struct Stream cacheStream;
+/* Whether the cache file is open, and whether meshes can currently be cached */
+static cc_bool cacheOpen, cacheActive;
+/* Whether opening the cache file has already been attempted */
+static cc_bool cacheOpened;
+/* Whether cacheState needs to be recalculated */
+static cc_bool cacheDirty = true;
+/* Hash of all the state besides blocks and lighting that affects the built meshes */
+static cc_uint64 cacheState;
+static cc_uint32 cacheEnd, cacheLimit;
+/* Hash table of the offsets of records in the cache file, indexed by key */
+static struct MeshCacheEntry* cacheEntries;
+static int cacheCount, cacheCapacity;
+static struct ChunkPartMeta cacheParts[ATLAS1D_MAX_ATLASES * 2];
+
+/* Guards cacheEntries (as chunk builder threads look up meshes), and the writer state below */
+static void* cacheMutex;
+/* Guards the position of cacheStream, which is used by both the writer thread and main thread */
+static void* cacheFileMutex;
+static void* cacheWriter;
+static void* cacheWriterWaitable;
+static struct MeshCacheWrite* cacheQueueHead;
+static struct MeshCacheWrite* cacheQueueTail;
+/* Bytes of records queued but not yet written, and end of the last record written */
+static cc_uint32 cacheQueued, cacheWritten;
+static cc_result cacheWriteResult;
+static cc_bool cacheWriterStop;
+
+#define MeshCache_Seed() (((cc_uint64)0xCBF29CE4 << 32) | 0x84222325)
+/* Hashes the given data using 64 bit FNV-1a */
+static cc_uint64 MeshCache_Hash(cc_uint64 hash, const void* data, cc_uint32 length) {
+	const cc_uint8* src = (const cc_uint8*)data;
+	cc_uint64 prime     = ((cc_uint64)0x100 << 32) | 0x1B3;
+	cc_uint32 i;
+
+	for (i = 0; i < length; i++) 
+	{
+		hash ^= src[i];
+		hash *= prime;
+	}
+	return hash;
+}
 
-	for (y = y1, yy = 0; y < yMax; y++, yy++) {
-		for (z = z1, zz = 0; z < zMax; z++, zz++) {
-			cIndex = Builder_PackChunk(0, yy, zz);
+static void MeshCache_CalcState(void) {
+	cc_uint64 hash = MeshCache_Seed();
+	PackedCol cols[8];
+	int values[12];
+
+	values[0]  = World.Width;   values[1] = World.Height; values[2] = World.Length;
+	values[3]  = Builder_SidesLevel;     values[4] = Builder_EdgeLevel;
+	values[5]  = Builder_SmoothLighting; values[6] = Builder_GreedyMeshing;
+	values[7]  = MapRenderer_1DUsedCount;
+	values[8]  = Atlas1D.Count; values[9] = Atlas1D.TilesPerAtlas;
+	values[10] = Atlas1D.Shift; values[11] = Gfx.Mipmaps;
+
+	cols[0] = Env.SunCol;    cols[1] = Env.SunXSide;    cols[2] = Env.SunZSide;    cols[3] = Env.SunYMin;
+	cols[4] = Env.ShadowCol; cols[5] = Env.ShadowXSide; cols[6] = Env.ShadowZSide; cols[7] = Env.ShadowYMin;
+
+	hash = MeshCache_Hash(hash, values, sizeof(values));
+	hash = MeshCache_Hash(hash, cols,   sizeof(cols));
+
+	/* Only the block properties that are used when building meshes, as servers may change */
+	/*  the other properties (e.g. CanPlace/CanDelete) at any time without affecting meshes */
+	/* Hidden isn't included, as that is calculated from these properties anyways */
+#define MeshCache_HashBlocks(prop) hash = MeshCache_Hash(hash, Blocks.prop, sizeof(Blocks.prop))
+	MeshCache_HashBlocks(BlocksLight); MeshCache_HashBlocks(Brightness);
+	MeshCache_HashBlocks(FogCol);      MeshCache_HashBlocks(Tinted);
+	MeshCache_HashBlocks(LightOffset); MeshCache_HashBlocks(Draw);
+	MeshCache_HashBlocks(FullOpaque);  MeshCache_HashBlocks(SpriteOffset);
+	MeshCache_HashBlocks(MinBB);       MeshCache_HashBlocks(MaxBB);
+	MeshCache_HashBlocks(RenderMinBB); MeshCache_HashBlocks(RenderMaxBB);
+	MeshCache_HashBlocks(Textures);    MeshCache_HashBlocks(CanStretch);
+	cacheState = hash;
+}
 
-			for (x = x1, xx = 0; x < xMax; x++, xx++, cIndex++) {
-				Builder_Block = chunk[cIndex];
-				if (Blocks.Draw[Builder_Block] == DRAW_GAS) continue;
+static void MeshCache_Fail(cc_result res, const char* action);
+/* Recalculates whether meshes can be cached, and if needed, the state hash */
+static cc_bool MeshCache_Update(void) {
+	cc_result res;
+	if (cacheDirty) { MeshCache_CalcState(); cacheDirty = false; }
 
-				index = Builder_PackCount(xx, yy, zz);
-				Builder_ChunkIndex = cIndex;
-				Builder_RenderBlock(index, x, y, z);
-			}
+	Mutex_Lock(cacheMutex);
+	res = cacheWriteResult;
+	Mutex_Unlock(cacheMutex);
+	if (res) MeshCache_Fail(res, "writing mesh cache");
+
+	/* With classic lighting, meshes only depend on the blocks and heightmap around the chunk */
+	cacheActive = cacheOpen && Lighting_Mode == LIGHTING_MODE_CLASSIC;
+	return cacheActive;
+}
+
+/* Marks the state hash as needing to be recalculated (e.g. because block definitions changed) */
+/* NOTE: Meshes cached with the old state are left in the cache, as e.g. the same */
+/*  block definitions and terrain atlas are usually sent again when rejoining a server */
+static void MeshCache_Invalidate(void* obj) { cacheDirty = true; }
+static void MeshCache_EnvVarChanged(void* obj, int envVar) { cacheDirty = true; }
+
+static void MeshCache_Init(void) {
+	cacheMutex     = Mutex_Create("Mesh cache");
+	cacheFileMutex = Mutex_Create("Mesh cache file");
+	Event_Register_(&BlockEvents.BlockDefChanged, NULL, MeshCache_Invalidate);
+	Event_Register_(&TextureEvents.AtlasChanged,  NULL, MeshCache_Invalidate);
+	Event_Register_(&WorldEvents.EnvVarChanged,   NULL, MeshCache_EnvVarChanged);
+}
+
+/* Calculates the key that the mesh for the blocks read into the given context is cached under */
+static cc_uint64 MeshCache_CalcKey(struct BuilderContext* ctx, struct ChunkInfo* info) {
+	int x1 = info->centreX - 8, y1 = info->centreY - 8, z1 = info->centreZ - 8;
+	cc_uint32 chunkIndex = World_ChunkPack(x1 >> CHUNK_SHIFT, y1 >> CHUNK_SHIFT, z1 >> CHUNK_SHIFT);
+	int heights[EXTCHUNK_SIZE];
+	int x, z, i, height;
+	cc_uint64 hash;
+
+	hash = MeshCache_Hash(cacheState, &chunkIndex, sizeof(chunkIndex));
+	hash = MeshCache_Hash(hash, ctx->chunk, EXTCHUNK_SIZE_3 * sizeof(BlockID));
+
+	for (z = z1 - 1; z <= z1 + CHUNK_SIZE; z++) 
+	{
+		for (x = x1 - 1, i = 0; x <= x1 + CHUNK_SIZE; x++, i++) 
+		{
+			height = World_ContainsXZ(x, z) ? ClassicLighting_GetLightHeight(x, z) : 0;
+			/* Only whether blocks in or next to the chunk are lit matters */
+			Math_Clamp(height, y1 - 2, y1 + CHUNK_SIZE);
+			heights[i] = height;
+		}
+		hash = MeshCache_Hash(hash, heights, sizeof(heights));
+	}
+	return hash;
+}
+
+/* Returns offset of the cached mesh with the given key in the cache file, or 0 if not cached */
+static cc_uint32 MeshCache_Find(cc_uint64 key) {
+	cc_uint32 offset = 0;
+	int i;
+	Mutex_Lock(cacheMutex);
+
+	if (cacheCapacity) {
+		for (i = (int)(key ^ (key >> 32)) & (cacheCapacity - 1); cacheEntries[i].offset; i = (i + 1) & (cacheCapacity - 1))
+		{
+			if (cacheEntries[i].key == key) { offset = cacheEntries[i].offset; break; }
 		}
 	}
 
+	Mutex_Unlock(cacheMutex);
+	return offset;
+}
+
+static void MeshCache_Insert(cc_uint64 key, cc_uint32 offset);
+static void MeshCache_Expand(void) {
+	struct MeshCacheEntry* entries = cacheEntries;
+	int i, capacity = cacheCapacity;
+
+	cacheCapacity = capacity ? capacity * 2 : 1024;
+	cacheEntries  = (struct MeshCacheEntry*)Mem_AllocCleared(cacheCapacity, sizeof(struct MeshCacheEntry), "mesh cache");
+	cacheCount    = 0;
+
+	for (i = 0; i < capacity; i++) 
+	{
+		if (entries[i].offset) MeshCache_Insert(entries[i].key, entries[i].offset);
+	}
+	Mem_Free(entries);
+}
+
+static void MeshCache_Insert(cc_uint64 key, cc_uint32 offset) {
+	int i;
+	if (cacheCount * 2 >= cacheCapacity) MeshCache_Expand();
+
+	for (i = (int)(key ^ (key >> 32)) & (cacheCapacity - 1); cacheEntries[i].offset; i = (i + 1) & (cacheCapacity - 1))
+	{
+		/* Newer meshes replace older meshes with the same key */
+		if (cacheEntries[i].key == key) { cacheEntries[i].offset = offset; return; }
+	}
+	cacheEntries[i].key    = key;
+	cacheEntries[i].offset = offset;
+	cacheCount++;
+}
+
+static void MeshCache_WriterLoop(void) {
+	struct MeshCacheWrite* w;
+	cc_result res;
+	cc_bool stop;
+
+	for (;;)
+	{
+		Mutex_Lock(cacheMutex);
+		stop = cacheWriterStop;
+		w    = stop ? NULL : cacheQueueHead;
+		if (w && !(cacheQueueHead = w->next)) cacheQueueTail = NULL;
+		res  = cacheWriteResult;
+		Mutex_Unlock(cacheMutex);
+
+		if (!w) {
+			if (stop) return;
+			/* Waitable_Wait may return spuriously, so always recheck */
+			Waitable_Wait(cacheWriterWaitable); continue;
+		}
+
+		/* Records after a failed write are just discarded */
+		if (!res) {
+			Mutex_Lock(cacheFileMutex);
+			res = cacheStream.Seek(&cacheStream, w->offset);
+			if (!res) res = Stream_Write(&cacheStream, (cc_uint8*)(w + 1), w->size);
+			Mutex_Unlock(cacheFileMutex);
+		}
+
+		Mutex_Lock(cacheMutex);
+		cacheQueued -= w->size;
+		if (res) { cacheWriteResult = res; } else { cacheWritten = w->offset + w->size; }
+		Mutex_Unlock(cacheMutex);
+		Mem_Free(w);
+	}
+}
+
+static void MeshCache_StartWriter(void) {
+	cacheQueued      = 0;
+	cacheWritten     = cacheEnd;
+	cacheWriteResult = 0;
+	cacheWriterStop  = false;
+
+	cacheWriterWaitable = Waitable_Create("Mesh cache writer");
+	Thread_Run(&cacheWriter, MeshCache_WriterLoop, 64 * 1024, "Mesh cache writer");
+}
+
+/* NOTE: Records still waiting to be written are discarded */
+static void MeshCache_StopWriter(void) {
+	struct MeshCacheWrite* w;
+	if (!cacheWriter) return;
+
+	Mutex_Lock(cacheMutex);
+	cacheWriterStop = true;
+	Mutex_Unlock(cacheMutex);
+
+	Waitable_Signal(cacheWriterWaitable);
+	Thread_Join(cacheWriter);
+	Waitable_Free(cacheWriterWaitable);
+	cacheWriter = NULL;
+
+	while ((w = cacheQueueHead)) 
+	{
+		cacheQueueHead = w->next;
+		Mem_Free(w);
+	}
+	cacheQueueTail = NULL;
+}
+
+static void MeshCache_Close(void) {
+	MeshCache_StopWriter();
+	if (cacheOpen) cacheStream.Close(&cacheStream);
+
+	Mutex_Lock(cacheMutex);
+	Mem_Free(cacheEntries);
+	cacheEntries  = NULL;
+	cacheCount    = 0;
+	cacheCapacity = 0;
+	Mutex_Unlock(cacheMutex);
+
+	cacheOpen   = false;
+	cacheActive = false;
+}
+
+static void MeshCache_Free(void) {
+	MeshCache_Close();
+	Mutex_Free(cacheMutex);
+	Mutex_Free(cacheFileMutex);
+}
+
+static void MeshCache_Fail(cc_result res, const char* action) {
+	Logger_SysWarn(res, action);
+	MeshCache_Close();
+}
+
+/* Finds the records of all the meshes in the cache file */
+static cc_result MeshCache_Scan(cc_uint32 length) {
+	struct MeshCacheHeader header;
+	struct MeshCacheRecord rec;
+	cc_uint32 pos, size;
+	cc_result res;
+
+	if ((res = Stream_Read(&cacheStream, (cc_uint8*)&header, sizeof(header)))) return res;
+	if (header.magic != MESHCACHE_MAGIC || header.version != MESHCACHE_VERSION) return ERR_INVALID_ARGUMENT;
+	if (header.vertexSize != sizeof(struct VertexTextured)) return ERR_INVALID_ARGUMENT;
+
+	for (pos = sizeof(header); pos + sizeof(rec) <= length; pos += size)
+	{
+		if ((res = cacheStream.Seek(&cacheStream, pos)))                          return res;
+		if ((res = Stream_Read(&cacheStream, (cc_uint8*)&rec, sizeof(rec)))) return res;
+
+		/* Record might be only partially written if the game closed while writing it */
+		if (rec.partsCount > ATLAS1D_MAX_ATLASES * 2) break;
+		if (rec.vertsCount > (length - pos) / sizeof(struct VertexTextured)) break;
+
+		size = sizeof(rec) + rec.partsCount * sizeof(struct ChunkPartMeta) + rec.vertsCount * sizeof(struct VertexTextured);
+		if (size > length - pos) break;
+		MeshCache_Insert(((cc_uint64)rec.keyHi << 32) | rec.keyLo, pos);
+	}
+	cacheEnd = pos;
+	return 0;
+}
+
+/* Discards all cached meshes, and starts again with an empty cache file */
+static void MeshCache_Clear(void) {
+	static const cc_string path = String_FromConst(MESHCACHE_PATH);
+	struct MeshCacheHeader header;
+	cc_result res;
+	MeshCache_Close();
+
+	res = Stream_CreateFile(&cacheStream, &path);
+	if (res) { Logger_SysWarn2(res, "creating", &path); return; }
+
+	header.magic      = MESHCACHE_MAGIC;
+	header.version    = MESHCACHE_VERSION;
+	header.vertexSize = sizeof(struct VertexTextured);
+	header.reserved   = 0;
+
+	res = Stream_Write(&cacheStream, (cc_uint8*)&header, sizeof(header));
+	if (res) { Logger_SysWarn2(res, "writing", &path); cacheStream.Close(&cacheStream); return; }
+
+	cacheOpen = true;
+	cacheEnd  = sizeof(header);
+	MeshCache_StartWriter();
+}
+
+static void MeshCache_Open(void) {
+	static const cc_string path = String_FromConst(MESHCACHE_PATH);
+	cc_uint32 length = 0;
+	cc_result res;
+	int limit;
+
+	/* The same cache file is kept open for all maps */
+	if (cacheOpened) return;
+	cacheOpened = true;
+
+	limit = Options_GetInt(OPT_MESH_CACHE_SIZE, 0, 4000, 0);
+	if (!limit || Platform_ReadonlyFilesystem) return;
+	if (!Utils_EnsureDirectory("meshcache"))   return;
+	cacheLimit = (cc_uint32)limit << 20;
+
+	res = Stream_AppendFile(&cacheStream, &path);
+	if (res) { Logger_SysWarn2(res, "opening", &path); return; }
+	cacheOpen = true;
+
+	res = cacheStream.Length(&cacheStream, &length);
+	if (!res) res = cacheStream.Seek(&cacheStream, 0);
+	/* Once over the size limit, the cache is just started again from scratch */
+	if (!res && length >= sizeof(struct MeshCacheHeader) && length <= cacheLimit) {
+		res = MeshCache_Scan(length);
+		if (!res) { MeshCache_StartWriter(); return; }
+	}
+	MeshCache_Clear();
+}
+
+/* Queues the given built mesh of the given chunk to be written to the cache */
+static void MeshCache_Store(cc_uint64 key, struct ChunkInfo* info, const struct ChunkPartMeta* parts,
+							const struct VertexTextured* vertices, int count) {
+	int partsIndex = World_ChunkPack(info->centreX >> CHUNK_SHIFT, info->centreY >> CHUNK_SHIFT, info->centreZ >> CHUNK_SHIFT);
+	struct MeshCacheRecord rec;
+	struct MeshCacheWrite* w;
+	cc_uint8* data;
+	cc_uint32 size, queued;
+	if (!cacheActive) return;
+
+	rec.keyLo      = (cc_uint32)key;
+	rec.keyHi      = (cc_uint32)(key >> 32);
+	rec.chunkIndex = partsIndex;
+	rec.vertsCount = count;
+	rec.partsCount = MapRenderer_1DUsedCount * 2;
+
+	size = sizeof(rec) + rec.partsCount * sizeof(struct ChunkPartMeta) + count * sizeof(struct VertexTextured);
+	if (size > cacheLimit - sizeof(struct MeshCacheHeader)) return;
+
+	/* Disk can't keep up, so just don't cache this mesh */
+	Mutex_Lock(cacheMutex);
+	queued = cacheQueued;
+	Mutex_Unlock(cacheMutex);
+	if (queued + size > MESHCACHE_MAX_QUEUED) return;
+
+	/* Cache is full, so start again from scratch */
+	if (size > cacheLimit - cacheEnd) {
+		MeshCache_Clear();
+		cacheActive = cacheOpen;
+		if (!cacheActive) return;
+	}
+
+	w = (struct MeshCacheWrite*)Mem_TryAlloc(1, sizeof(struct MeshCacheWrite) + size);
+	if (!w) return;
+	w->next   = NULL;
+	w->offset = cacheEnd;
+	w->size   = size;
+	data      = (cc_uint8*)(w + 1);
+
+	Mem_Copy(data, &rec, sizeof(rec));
+	data += sizeof(rec);
+	Mem_Copy(data, parts, rec.partsCount * sizeof(struct ChunkPartMeta));
+	data += rec.partsCount * sizeof(struct ChunkPartMeta);
+	Mem_Copy(data, vertices, count * sizeof(struct VertexTextured));
+
+	/* Mesh is only loaded from the cache once the writer thread has written it */
+	Mutex_Lock(cacheMutex);
+	MeshCache_Insert(key, cacheEnd);
+	if (cacheQueueTail) { cacheQueueTail->next = w; } else { cacheQueueHead = w; }
+	cacheQueueTail = w;
+	cacheQueued   += size;
+	Mutex_Unlock(cacheMutex);
+
+	Waitable_Signal(cacheWriterWaitable);
+	cacheEnd += size;
+}
+
+/* Reads the record at the given offset in the cache file, if it's the mesh of the given chunk */
+/* NOTE: vertices is left NULL if the record is a different mesh, or out of memory */
+static cc_result MeshCache_Read(cc_uint32 offset, cc_uint64 key, int partsIndex, 
+								struct MeshCacheRecord* rec, struct VertexTextured** vertices) {
+	cc_result res;
+	*vertices = NULL;
+	if ((res = cacheStream.Seek(&cacheStream, offset)))                  return res;
+	if ((res = Stream_Read(&cacheStream, (cc_uint8*)rec, sizeof(*rec)))) return res;
+
+	if (rec->keyLo != (cc_uint32)key || rec->keyHi != (cc_uint32)(key >> 32))            return 0;
+	if (rec->chunkIndex != partsIndex || rec->partsCount != MapRenderer_1DUsedCount * 2) return 0;
+
+	*vertices = (struct VertexTextured*)Mem_TryAlloc(rec->vertsCount, sizeof(struct VertexTextured));
+	if (!*vertices) return 0;
+
+	if ((res = Stream_Read(&cacheStream, (cc_uint8*)cacheParts, rec->partsCount * sizeof(struct ChunkPartMeta)))) return res;
+	return Stream_Read(&cacheStream, (cc_uint8*)*vertices, rec->vertsCount * sizeof(struct VertexTextured));
+}
+
+/* Uploads the cached mesh of the given chunk at the given offset in the cache file */
+/* Returns false if the cached mesh couldn't be used (caller should build the mesh instead) */
+static cc_bool MeshCache_Load(cc_uint32 offset, cc_uint64 key, struct ChunkInfo* info) {
+	int partsIndex = World_ChunkPack(info->centreX >> CHUNK_SHIFT, info->centreY >> CHUNK_SHIFT, info->centreZ >> CHUNK_SHIFT);
+	struct VertexTextured* vertices;
+	struct MeshCacheRecord rec;
+	cc_uint32 written;
+	cc_result res;
+	if (!cacheActive) return false;
+
+	Mutex_Lock(cacheMutex);
+	written = cacheWritten;
+	Mutex_Unlock(cacheMutex);
+	/* Cache may have been cleared since the mesh was found, or the mesh not written yet */
+	if (offset >= cacheEnd || offset >= written) return false;
+
+	Mutex_Lock(cacheFileMutex);
+	res = MeshCache_Read(offset, key, partsIndex, &rec, &vertices);
+	Mutex_Unlock(cacheFileMutex);
+
+	if (res) {
+		Mem_Free(vertices);
+		MeshCache_Fail(res, "reading mesh cache"); return false;
+	}
+	if (!vertices) return false;
+
+	ApplyPartsMeta(cacheParts, rec.partsCount, info);
+
 #if CC_GFX_BACKEND == CC_GFX_BACKEND_GL11
-	cIndex = World_ChunkPack(x1 >> CHUNK_SHIFT, y1 >> CHUNK_SHIFT, z1 >> CHUNK_SHIFT);
+	BuildChunkVbs(vertices, info);
+#else
+	UploadChunkVb(info, vertices, rec.vertsCount);
+#endif
+	Mem_Free(vertices);
+
+	Builder_CachedChunks++;
+	Builder_MeshVertices     += rec.vertsCount;
+	Builder_UnmergedVertices += rec.vertsCount;
+	return true;
+}
+#else
+static cc_bool MeshCache_Update(void) { return false; }
+static void MeshCache_Invalidate(void* obj) { }
+static void MeshCache_Init(void) { }
+static cc_uint64 MeshCache_CalcKey(struct BuilderContext* ctx, struct ChunkInfo* info) { return 0; }
+static cc_uint32 MeshCache_Find(cc_uint64 key) { return 0; }
+static void MeshCache_Open(void)  { }
+static void MeshCache_Free(void)  { }
+
+static void MeshCache_Store(cc_uint64 key, struct ChunkInfo* info, const struct ChunkPartMeta* parts,
+							const struct VertexTextured* vertices, int count) { }
+static cc_bool MeshCache_Load(cc_uint32 offset, cc_uint64 key, struct ChunkInfo* info) { return false; }
+#endif
+
+static void DropEditedChunk(struct ChunkInfo* info);
 
-	for (index = 0; index < MapRenderer_1DUsedCount; index++) {
-		int curIdx = cIndex + index * World.ChunksCount;
+void Builder_MakeChunk(struct ChunkInfo* info) {
+	struct BuilderContext* ctx = &mainCtx;
+#if CC_BUILD_MAXSTACK <= (32 * 1024)
+	void* mem        = TempMem_Alloc((EXTCHUNK_SIZE_3 * sizeof(BlockID)) + (CHUNK_SIZE_3 * FACE_COUNT));
+	BlockID* chunk   = (BlockID*)mem;
+	cc_uint8* counts = (cc_uint8*)(chunk + EXTCHUNK_SIZE_3);
+#else
+	BlockID chunk[EXTCHUNK_SIZE_3]; 
+	cc_uint8 counts[CHUNK_SIZE_3 * FACE_COUNT]; 
+#endif
 
-		BuildPartVbs(&MapRenderer_PartsNormal[curIdx]);
-		BuildPartVbs(&MapRenderer_PartsTranslucent[curIdx]);
+#ifdef CC_BUILD_ADVLIGHTING
+	int bitFlags[EXTCHUNK_SIZE_3];
+#else
+	int bitFlags[1];
+#endif
+	cc_bool allAir, needsMesh, cacheable;
+	cc_uint32 offset;
+	cc_uint64 key = 0;
+	int totalVerts;
+
+	ctx->chunk    = chunk;
+	ctx->counts   = counts;
+	ctx->bitFlags = bitFlags;
+	Builder_PrePrepareChunk(ctx);
+	DropEditedChunk(info);
+
+	needsMesh    = ReadChunk(ctx, info, &allAir);
+	info->allAir = allAir;
+	if (!needsMesh) { info->connectivity = allAir ? CHUNK_CONNECTED_ALL : 0; return; }
+
+	info->connectivity = CalcConnectivity(ctx);
+	Lighting.LightHint(info->centreX - 9, info->centreY - 9, info->centreZ - 9);
+	if (Lod_Needed(info)) DownsampleChunk(ctx, info);
+
+	if ((cacheable = MeshCache_Update())) {
+		key    = MeshCache_CalcKey(ctx, info);
+		offset = MeshCache_Find(key);
+		if (offset && MeshCache_Load(offset, key, info)) return;
 	}
+
+	totalVerts = CountChunk(ctx, info);
+	if (!totalVerts) return;
+	OutputChunkPartsMeta(ctx, info);
+	Builder_MeshVertices     += totalVerts;
+	Builder_UnmergedVertices += ctx->unmergedVerts;
+
+#if CC_GFX_BACKEND == CC_GFX_BACKEND_GL11
+	/* NOTE: Relies on assumption vb is ignored by GL11 Gfx_LockVb implementation */
+	ctx->vertices = (struct VertexTextured*)Gfx_LockVb(0, 
+													VERTEX_FORMAT_TEXTURED, totalVerts + 1);
+#elif defined CC_BUILD_PACKEDTERRAIN
+	/* vertices are converted to VERTEX_FORMAT_TERRAIN once built */
+	ctx->vertices = (struct VertexTextured*)Mem_Alloc(totalVerts, sizeof(struct VertexTextured), "chunk vertices");
 #else
-	Gfx_UnlockVb(info->vb);
+	ctx->vertices = (struct VertexTextured*)LockChunkVb(info, totalVerts);
+#endif
+	/* now render the chunk */
+	RenderChunk(ctx, info);
+	if (cacheable) MeshCache_Store(key, info, mainPartsMeta, ctx->vertices, totalVerts);
+
+#if CC_GFX_BACKEND == CC_GFX_BACKEND_GL11
+	BuildChunkVbs(ctx->vertices, info);
+#elif defined CC_BUILD_PACKEDTERRAIN
+	UploadChunkVb(info, ctx->vertices, totalVerts);
+	Mem_Free(ctx->vertices);
+#else
+	UnlockChunkVb(info);
 #endif
 }
 
-static cc_bool Builder_OccludedLiquid(int chunkIndex) {
+static cc_bool Builder_OccludedLiquid(struct BuilderContext* ctx, int chunkIndex) {
 	chunkIndex += EXTCHUNK_SIZE_2; /* Checking y above */
 	return
-		Blocks.FullOpaque[Builder_Chunk[chunkIndex]]
-		&& Blocks.Draw[Builder_Chunk[chunkIndex - EXTCHUNK_SIZE]] != DRAW_GAS
-		&& Blocks.Draw[Builder_Chunk[chunkIndex - 1]] != DRAW_GAS
-		&& Blocks.Draw[Builder_Chunk[chunkIndex + 1]] != DRAW_GAS
-		&& Blocks.Draw[Builder_Chunk[chunkIndex + EXTCHUNK_SIZE]] != DRAW_GAS;
+		Blocks.FullOpaque[ctx->chunk[chunkIndex]]
+		&& Blocks.Draw[ctx->chunk[chunkIndex - EXTCHUNK_SIZE]] != DRAW_GAS
+		&& Blocks.Draw[ctx->chunk[chunkIndex - 1]] != DRAW_GAS
+		&& Blocks.Draw[ctx->chunk[chunkIndex + 1]] != DRAW_GAS
+		&& Blocks.Draw[ctx->chunk[chunkIndex + EXTCHUNK_SIZE]] != DRAW_GAS;
 }
 
-static void DefaultPrePrepateChunk(void) {
-	Mem_Set(Builder_Parts, 0, sizeof(Builder_Parts));
+static void DefaultPrePrepateChunk(struct BuilderContext* ctx) {
+	Mem_Set(ctx->parts, 0, sizeof(ctx->parts));
 }
 
-static void DefaultPostStretchChunk(void) {
+static void DefaultPostStretchChunk(struct BuilderContext* ctx) {
 	int i, j, offset;
 	offset = 0;
 	for (i = 0; i < ATLAS1D_MAX_ATLASES; i++) {
 		j = i + ATLAS1D_MAX_ATLASES;
 
-		offset = Builder1DPart_CalcOffsets(&Builder_Parts[i], offset);
-		offset = Builder1DPart_CalcOffsets(&Builder_Parts[j], offset);
+		offset = Builder1DPart_CalcOffsets(ctx, &ctx->parts[i], offset);
+		offset = Builder1DPart_CalcOffsets(ctx, &ctx->parts[j], offset);
 	}
 }
 
-static RNGState spriteRng;
-static void Builder_DrawSprite(int x, int y, int z) {
+static void Builder_DrawSprite(struct BuilderContext* ctx, int x, int y, int z) {
 	struct Builder1DPart* part;
 	struct VertexTextured* v;
 	cc_uint8 offsetType;
@@ -507,29 +1398,29 @@ static void Builder_DrawSprite(int x, int y, int z) {
 
 #define s_u1 0.0f
 #define s_u2 UV2_Scale
-	loc = Block_Tex(Builder_Block, FACE_XMAX);
+	loc = Block_Tex(ctx->block, FACE_XMAX);
 	v1  = Atlas1D_RowId(loc) * Atlas1D.InvTileSize;
 	v2  = v1 + Atlas1D.InvTileSize * UV2_Scale;
 
-	offsetType = Blocks.SpriteOffset[Builder_Block];
+	offsetType = Blocks.SpriteOffset[ctx->block];
 	if (offsetType >= 6 && offsetType <= 7) {
-		Random_Seed(&spriteRng, (x + 1217 * z) & 0x7fffffff);
-		valX = Random_Range(&spriteRng, -3, 3 + 1) / 16.0f;
-		valY = Random_Range(&spriteRng, 0,  3 + 1) / 16.0f;
-		valZ = Random_Range(&spriteRng, -3, 3 + 1) / 16.0f;
+		Random_Seed(&ctx->spriteRng, (x + 1217 * z) & 0x7fffffff);
+		valX = Random_Range(&ctx->spriteRng, -3, 3 + 1) / 16.0f;
+		valY = Random_Range(&ctx->spriteRng, 0,  3 + 1) / 16.0f;
+		valZ = Random_Range(&ctx->spriteRng, -3, 3 + 1) / 16.0f;
 
 		x1 += valX - 1.7f/16.0f; x2 += valX + 1.7f/16.0f;
 		z1 += valZ - 1.7f/16.0f; z2 += valZ + 1.7f/16.0f;
 		if (offsetType == 7) { y1 -= valY; y2 -= valY; }
 	}
 	
-	bright = Blocks.Brightness[Builder_Block];
-	part   = &Builder_Parts[Atlas1D_Index(loc)];
-	color  = bright ? PACKEDCOL_WHITE : Lighting.Color_Sprite_Fast(x, y, z);
-	Block_Tint(color, Builder_Block);
+	bright = Blocks.Brightness[ctx->block];
+	part   = &ctx->parts[Atlas1D_Index(loc)];
+	color  = bright ? PACKEDCOL_WHITE : Builder_LightSprite(ctx, x, y, z);
+	Block_Tint(color, ctx->block);
 
 	/* Draw Z axis */
-	v = &Builder_Vertices[part->sOffset];
+	v = &ctx->vertices[part->sOffset];
 	v->x = x1; v->y = y1; v->z = z1; v->Col = color; v->U = s_u2; v->V = v2; v++;
 	v->x = x1; v->y = y2; v->z = z1; v->Col = color; v->U = s_u2; v->V = v1; v++;
 	v->x = x2; v->y = y2; v->z = z2; v->Col = color; v->U = s_u1; v->V = v1; v++;
@@ -563,93 +1454,93 @@ static void Builder_DrawSprite(int x, int y, int z) {
 /*########################################################################################################################*
 *--------------------------------------------------Normal mesh builder----------------------------------------------------*
 *#########################################################################################################################*/
-static PackedCol Normal_LightColor(int x, int y, int z, Face face, BlockID block) {
+static PackedCol Normal_LightColor(struct BuilderContext* ctx, int x, int y, int z, Face face, BlockID block) {
 	int offset = (Blocks.LightOffset[block] >> face) & 1;
 
 	switch (face) {
 	case FACE_XMIN:
-		return x < offset                ? Env.SunXSide : Lighting.Color_XSide_Fast(x - offset, y, z);
+		return x < offset                ? Env.SunXSide : Builder_LightXSide(ctx, x - offset, y, z);
 	case FACE_XMAX:
-		return x > (World.MaxX - offset) ? Env.SunXSide : Lighting.Color_XSide_Fast(x + offset, y, z);
+		return x > (World.MaxX - offset) ? Env.SunXSide : Builder_LightXSide(ctx, x + offset, y, z);
 	case FACE_ZMIN:
-		return z < offset                ? Env.SunZSide : Lighting.Color_ZSide_Fast(x, y, z - offset);
+		return z < offset                ? Env.SunZSide : Builder_LightZSide(ctx, x, y, z - offset);
 	case FACE_ZMAX:
-		return z > (World.MaxZ - offset) ? Env.SunZSide : Lighting.Color_ZSide_Fast(x, y, z + offset);
+		return z > (World.MaxZ - offset) ? Env.SunZSide : Builder_LightZSide(ctx, x, y, z + offset);
 
 	case FACE_YMIN:
-		return Lighting.Color_YMin_Fast(x, y - offset, z);		
+		return Builder_LightYMin(ctx, x, y - offset, z);		
 	case FACE_YMAX:
-		return Lighting.Color_YMax_Fast(x, y + offset, z);
+		return Builder_LightYMax(ctx, x, y + offset, z);
 	}
 	return 0; /* should never happen */
 }
 
-static cc_bool Normal_CanStretch(BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
-	BlockID cur = Builder_Chunk[chunkIndex];
+static cc_bool Normal_CanStretch(struct BuilderContext* ctx, BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
+	BlockID cur = ctx->chunk[chunkIndex];
 
-	if (cur != initial || Block_IsFaceHidden(cur, Builder_Chunk[chunkIndex + Builder_Offsets[face]], face)) return false;
-	if (Builder_FullBright) return true;
+	if (cur != initial || Block_IsFaceHidden(cur, ctx->chunk[chunkIndex + Builder_Offsets[face]], face)) return false;
+	if (ctx->fullBright) return true;
 
-	return Normal_LightColor(Builder_X, Builder_Y, Builder_Z, face, initial) == Normal_LightColor(x, y, z, face, cur);
+	return Normal_LightColor(ctx, ctx->x, ctx->y, ctx->z, face, initial) == Normal_LightColor(ctx, x, y, z, face, cur);
 }
 
-static int NormalBuilder_StretchXLiquid(int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
+static int NormalBuilder_StretchXLiquid(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
 	int count = 1; cc_bool stretchTile;
-	if (Builder_OccludedLiquid(chunkIndex)) return 0;
+	if (Builder_OccludedLiquid(ctx, chunkIndex)) return 0;
 	
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << FACE_YMAX)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Normal_CanStretch(block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(chunkIndex)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->chunkEndX && stretchTile && Normal_CanStretch(ctx, block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(ctx, chunkIndex)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, FACE_YMAX);
+	AddVertices(ctx, block, FACE_YMAX);
 	return count;
 }
 
-static int NormalBuilder_StretchX(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int NormalBuilder_StretchX(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Normal_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->chunkEndX && stretchTile && Normal_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static int NormalBuilder_StretchZ(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int NormalBuilder_StretchZ(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
 	z++;
 	chunkIndex += EXTCHUNK_SIZE;
 	countIndex += CHUNK_SIZE * FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (z < Builder_ChunkEndZ && stretchTile && Normal_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (z < ctx->chunkEndZ && stretchTile && Normal_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		z++;
 		chunkIndex += EXTCHUNK_SIZE;
 		countIndex += CHUNK_SIZE * FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static void NormalBuilder_RenderBlock(int index, int x, int y, int z) {	
+static void NormalBuilder_RenderBlock(struct BuilderContext* ctx, int index, int x, int y, int z) {	
 	/* counters */
 	int count_XMin, count_XMax, count_ZMin;
 	int count_ZMax, count_YMin, count_YMax;
@@ -665,90 +1556,90 @@ static void NormalBuilder_RenderBlock(int index, int x, int y, int z) {
 	PackedCol col;
 	int offset;
 
-	if (Blocks.Draw[Builder_Block] == DRAW_SPRITE) {
-		Builder_DrawSprite(x, y, z); return;
+	if (Blocks.Draw[ctx->block] == DRAW_SPRITE) {
+		Builder_DrawSprite(ctx, x, y, z); return;
 	}
 
-	count_XMin = Builder_Counts[index + FACE_XMIN];
-	count_XMax = Builder_Counts[index + FACE_XMAX];
-	count_ZMin = Builder_Counts[index + FACE_ZMIN];
-	count_ZMax = Builder_Counts[index + FACE_ZMAX];
-	count_YMin = Builder_Counts[index + FACE_YMIN];
-	count_YMax = Builder_Counts[index + FACE_YMAX];
+	count_XMin = ctx->counts[index + FACE_XMIN];
+	count_XMax = ctx->counts[index + FACE_XMAX];
+	count_ZMin = ctx->counts[index + FACE_ZMIN];
+	count_ZMax = ctx->counts[index + FACE_ZMAX];
+	count_YMin = ctx->counts[index + FACE_YMIN];
+	count_YMax = ctx->counts[index + FACE_YMAX];
 
 	if (!count_XMin && !count_XMax && !count_ZMin &&
 		!count_ZMax && !count_YMin && !count_YMax) return;
 
-	fullBright = Blocks.Brightness[Builder_Block];
-	baseOffset = (Blocks.Draw[Builder_Block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
-	lightFlags = Blocks.LightOffset[Builder_Block];
+	fullBright = Blocks.Brightness[ctx->block];
+	baseOffset = (Blocks.Draw[ctx->block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+	lightFlags = Blocks.LightOffset[ctx->block];
 
-	Drawer.MinBB = Blocks.MinBB[Builder_Block]; Drawer.MinBB.y = 1.0f - Drawer.MinBB.y;
-	Drawer.MaxBB = Blocks.MaxBB[Builder_Block]; Drawer.MaxBB.y = 1.0f - Drawer.MaxBB.y;
+	ctx->drawer.MinBB = Blocks.MinBB[ctx->block]; ctx->drawer.MinBB.y = 1.0f - ctx->drawer.MinBB.y;
+	ctx->drawer.MaxBB = Blocks.MaxBB[ctx->block]; ctx->drawer.MaxBB.y = 1.0f - ctx->drawer.MaxBB.y;
 
-	min = Blocks.RenderMinBB[Builder_Block]; max = Blocks.RenderMaxBB[Builder_Block];
-	Drawer.X1 = x + min.x; Drawer.Y1 = y + min.y; Drawer.Z1 = z + min.z;
-	Drawer.X2 = x + max.x; Drawer.Y2 = y + max.y; Drawer.Z2 = z + max.z;
+	min = Blocks.RenderMinBB[ctx->block]; max = Blocks.RenderMaxBB[ctx->block];
+	ctx->drawer.X1 = x + min.x; ctx->drawer.Y1 = y + min.y; ctx->drawer.Z1 = z + min.z;
+	ctx->drawer.X2 = x + max.x; ctx->drawer.Y2 = y + max.y; ctx->drawer.Z2 = z + max.z;
 
-	Drawer.Tinted  = Blocks.Tinted[Builder_Block];
-	Drawer.TintCol = Blocks.FogCol[Builder_Block];
+	ctx->drawer.Tinted  = Blocks.Tinted[ctx->block];
+	ctx->drawer.TintCol = Blocks.FogCol[ctx->block];
 
 	if (count_XMin) {
-		loc    = Block_Tex(Builder_Block, FACE_XMIN);
+		loc    = Block_Tex(ctx->block, FACE_XMIN);
 		offset = (lightFlags >> FACE_XMIN) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
-			x >= offset ? Lighting.Color_XSide_Fast(x - offset, y, z) : Env.SunXSide;
-		Drawer_XMin(count_XMin, col, loc, &part->faces.vertices[FACE_XMIN]);
+			x >= offset ? Builder_LightXSide(ctx, x - offset, y, z) : Env.SunXSide;
+		Drawer_XMin2(&ctx->drawer, count_XMin, col, loc, &part->faces.vertices[FACE_XMIN]);
 	}
 
 	if (count_XMax) {
-		loc    = Block_Tex(Builder_Block, FACE_XMAX);
+		loc    = Block_Tex(ctx->block, FACE_XMAX);
 		offset = (lightFlags >> FACE_XMAX) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
-			x <= (World.MaxX - offset) ? Lighting.Color_XSide_Fast(x + offset, y, z) : Env.SunXSide;
-		Drawer_XMax(count_XMax, col, loc, &part->faces.vertices[FACE_XMAX]);
+			x <= (World.MaxX - offset) ? Builder_LightXSide(ctx, x + offset, y, z) : Env.SunXSide;
+		Drawer_XMax2(&ctx->drawer, count_XMax, col, loc, &part->faces.vertices[FACE_XMAX]);
 	}
 
 	if (count_ZMin) {
-		loc    = Block_Tex(Builder_Block, FACE_ZMIN);
+		loc    = Block_Tex(ctx->block, FACE_ZMIN);
 		offset = (lightFlags >> FACE_ZMIN) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
-			z >= offset ? Lighting.Color_ZSide_Fast(x, y, z - offset) : Env.SunZSide;
-		Drawer_ZMin(count_ZMin, col, loc, &part->faces.vertices[FACE_ZMIN]);
+			z >= offset ? Builder_LightZSide(ctx, x, y, z - offset) : Env.SunZSide;
+		Drawer_ZMin2(&ctx->drawer, count_ZMin, col, loc, &part->faces.vertices[FACE_ZMIN]);
 	}
 
 	if (count_ZMax) {
-		loc    = Block_Tex(Builder_Block, FACE_ZMAX);
+		loc    = Block_Tex(ctx->block, FACE_ZMAX);
 		offset = (lightFlags >> FACE_ZMAX) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
 		col = fullBright ? PACKEDCOL_WHITE :
-			z <= (World.MaxZ - offset) ? Lighting.Color_ZSide_Fast(x, y, z + offset) : Env.SunZSide;
-		Drawer_ZMax(count_ZMax, col, loc, &part->faces.vertices[FACE_ZMAX]);
+			z <= (World.MaxZ - offset) ? Builder_LightZSide(ctx, x, y, z + offset) : Env.SunZSide;
+		Drawer_ZMax2(&ctx->drawer, count_ZMax, col, loc, &part->faces.vertices[FACE_ZMAX]);
 	}
 
 	if (count_YMin) {
-		loc    = Block_Tex(Builder_Block, FACE_YMIN);
+		loc    = Block_Tex(ctx->block, FACE_YMIN);
 		offset = (lightFlags >> FACE_YMIN) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
-		col = fullBright ? PACKEDCOL_WHITE : Lighting.Color_YMin_Fast(x, y - offset, z);
-		Drawer_YMin(count_YMin, col, loc, &part->faces.vertices[FACE_YMIN]);
+		col = fullBright ? PACKEDCOL_WHITE : Builder_LightYMin(ctx, x, y - offset, z);
+		Drawer_YMin2(&ctx->drawer, count_YMin, col, loc, &part->faces.vertices[FACE_YMIN]);
 	}
 
 	if (count_YMax) {
-		loc    = Block_Tex(Builder_Block, FACE_YMAX);
+		loc    = Block_Tex(ctx->block, FACE_YMAX);
 		offset = (lightFlags >> FACE_YMAX) & 1;
-		part   = &Builder_Parts[baseOffset + Atlas1D_Index(loc)];
+		part   = &ctx->parts[baseOffset + Atlas1D_Index(loc)];
 
-		col = fullBright ? PACKEDCOL_WHITE : Lighting.Color_YMax_Fast(x, y + offset, z);
-		Drawer_YMax(count_YMax, col, loc, &part->faces.vertices[FACE_YMAX]);
+		col = fullBright ? PACKEDCOL_WHITE : Builder_LightYMax(ctx, x, y + offset, z);
+		Drawer_YMax2(&ctx->drawer, count_YMax, col, loc, &part->faces.vertices[FACE_YMAX]);
 	}
 }
 
@@ -757,17 +1648,242 @@ static void Builder_SetDefault(void) {
 	Builder_StretchX       = NULL;
 	Builder_StretchZ       = NULL;
 	Builder_RenderBlock    = NULL;
+	Builder_MergeFaces     = NULL;
 
 	Builder_PrePrepareChunk  = DefaultPrePrepateChunk;
 	Builder_PostPrepareChunk = DefaultPostStretchChunk;
 }
 
-static void NormalBuilder_SetActive(void) {
+static void NormalBuilder_SetActive(void) {
+	Builder_SetDefault();
+	Builder_StretchXLiquid = NormalBuilder_StretchXLiquid;
+	Builder_StretchX       = NormalBuilder_StretchX;
+	Builder_StretchZ       = NormalBuilder_StretchZ;
+	Builder_RenderBlock    = NormalBuilder_RenderBlock;
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------Greedy mesh builder----------------------------------------------------*
+*#########################################################################################################################*/
+/* Same as normal mesh builder, except that faces of different blocks can also be merged together */
+/*  as long as they would produce exactly the same vertices (e.g. water and still water) */
+/* NOTE: Textures only repeat along the U axis of a 1D atlas, so faces can only be merged in the V direction */
+/*  when chunks use VERTEX_FORMAT_TERRAIN, whose shader repeats V within each tile row of the atlas */
+#define Greedy_IsLiquid(block) ((block) >= BLOCK_WATER && (block) <= BLOCK_STILL_LAVA)
+
+static cc_bool Greedy_SameFace(BlockID a, BlockID b, Face face) {
+	if (a == b) return true;
+
+	return Block_Tex(a, face)    == Block_Tex(b, face)    && Blocks.Draw[a] == Blocks.Draw[b]
+		&& Blocks.Brightness[a]  == Blocks.Brightness[b]  && Greedy_IsLiquid(a) == Greedy_IsLiquid(b)
+		&& (Blocks.CanStretch[b] & (1 << face))
+		&& Blocks.Tinted[a]      == Blocks.Tinted[b]      && (!Blocks.Tinted[a] || Blocks.FogCol[a] == Blocks.FogCol[b])
+		&& Vec3_Equals(&Blocks.MinBB[a], &Blocks.MinBB[b]) && Vec3_Equals(&Blocks.MaxBB[a], &Blocks.MaxBB[b])
+		&& Vec3_Equals(&Blocks.RenderMinBB[a], &Blocks.RenderMinBB[b]) 
+		&& Vec3_Equals(&Blocks.RenderMaxBB[a], &Blocks.RenderMaxBB[b]);
+}
+
+static cc_bool Greedy_CanStretch(struct BuilderContext* ctx, BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
+	BlockID cur = ctx->chunk[chunkIndex];
+
+	if (!Greedy_SameFace(initial, cur, face) || Block_IsFaceHidden(cur, ctx->chunk[chunkIndex + Builder_Offsets[face]], face)) return false;
+	if (ctx->fullBright) return true;
+
+	return Normal_LightColor(ctx, ctx->x, ctx->y, ctx->z, face, initial) == Normal_LightColor(ctx, x, y, z, face, cur);
+}
+
+static int GreedyBuilder_StretchXLiquid(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
+	int count = 1; cc_bool stretchTile;
+	if (Builder_OccludedLiquid(ctx, chunkIndex)) return 0;
+	
+	x++;
+	chunkIndex++;
+	countIndex += FACE_COUNT;
+	stretchTile = (Blocks.CanStretch[block] & (1 << FACE_YMAX)) != 0;
+
+	while (x < ctx->chunkEndX && stretchTile && Greedy_CanStretch(ctx, block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(ctx, chunkIndex)) {
+		ctx->counts[countIndex] = 0;
+		count++;
+		x++;
+		chunkIndex++;
+		countIndex += FACE_COUNT;
+	}
+	AddVertices(ctx, block, FACE_YMAX);
+	return count;
+}
+
+static int GreedyBuilder_StretchX(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+	int count = 1; cc_bool stretchTile;
+	x++;
+	chunkIndex++;
+	countIndex += FACE_COUNT;
+	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
+
+	while (x < ctx->chunkEndX && stretchTile && Greedy_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->counts[countIndex] = 0;
+		count++;
+		x++;
+		chunkIndex++;
+		countIndex += FACE_COUNT;
+	}
+	AddVertices(ctx, block, face);
+	return count;
+}
+
+static int GreedyBuilder_StretchZ(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+	int count = 1; cc_bool stretchTile;
+	z++;
+	chunkIndex += EXTCHUNK_SIZE;
+	countIndex += CHUNK_SIZE * FACE_COUNT;
+	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
+
+	while (z < ctx->chunkEndZ && stretchTile && Greedy_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->counts[countIndex] = 0;
+		count++;
+		z++;
+		chunkIndex += EXTCHUNK_SIZE;
+		countIndex += CHUNK_SIZE * FACE_COUNT;
+	}
+	AddVertices(ctx, block, face);
+	return count;
+}
+
+/* Runs of faces can also be merged across rows, but only when the terrain shader repeats each tile */
+/*  vertically (see VertexTerrain), so other backends only ever merge faces along rows */
+/* NOTE: Merging across rows is skipped while mipmaps are on, as tiles repeated in the shader have seams then */
+#ifdef CC_BUILD_PACKEDTERRAIN
+/* Whether the given face covers the whole block in the V direction of its texture */
+static cc_bool Greedy_FullRow(BlockID block, Face face) {
+	/* V is along Z for top and bottom faces, and along Y for side faces */
+	if (face >= FACE_YMIN) {
+		return Blocks.MinBB[block].z       == 0.0f && Blocks.MaxBB[block].z       == 1.0f
+			&& Blocks.RenderMinBB[block].z == 0.0f && Blocks.RenderMaxBB[block].z == 1.0f;
+	}
+	return Blocks.MinBB[block].y       == 0.0f && Blocks.MaxBB[block].y       == 1.0f
+		&& Blocks.RenderMinBB[block].y == 0.0f && Blocks.RenderMaxBB[block].y == 1.0f;
+}
+
+/* Merges the runs of faces in the rows after the given run into it, */
+/*  as long as they start at the same position, are the same length and look the same */
+static void Greedy_MergeRuns(struct BuilderContext* ctx, int x, int y, int z, int xx, int yy, int zz, Face face) {
+	int index  = Builder_PackCount(xx, yy, zz) + face;
+	int cIndex = Builder_PackChunk(xx, yy, zz);
+	int count  = ctx->counts[index];
+	BlockID block = ctx->chunk[cIndex], cur;
+	struct Builder1DPart* part;
+	cc_bool fullBright;
+	PackedCol col = 0;
+	int baseOffset, next;
+
+	if (Blocks.Draw[block] == DRAW_GAS || Blocks.Draw[block] == DRAW_SPRITE) return;
+	if (!Greedy_FullRow(block, face)) return;
+
+	baseOffset = (Blocks.Draw[block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+	part       = &ctx->parts[baseOffset + Atlas1D_Index(Block_Tex(block, face))];
+	fullBright = Blocks.Brightness[block];
+	if (!fullBright) col = Normal_LightColor(ctx, x, y, z, face, block);
+
+	for (;;) {
+		/* Rows of top and bottom faces go towards +Z, rows of side faces go towards -Y */
+		if (face >= FACE_YMIN) {
+			if (++zz == CHUNK_SIZE) break;
+			z++;
+		} else {
+			if (--yy < 0) break;
+			y--;
+		}
+
+		next   = Builder_PackCount(xx, yy, zz) + face;
+		cIndex = Builder_PackChunk(xx, yy, zz);
+		cur    = ctx->chunk[cIndex];
+
+		/* Counts of empty blocks are left as 1, so have to be checked for separately */
+		if (ctx->counts[next] != count || Blocks.Draw[cur] == DRAW_GAS || Blocks.Draw[cur] == DRAW_SPRITE) break;
+		if (!Greedy_SameFace(block, cur, face)) break;
+		if (!fullBright && Normal_LightColor(ctx, x, y, z, face, cur) != col) break;
+
+		ctx->counts[next] = 0;
+		ctx->rows[index]++;
+		ctx->unmergedVerts     += count * 4;
+		part->faces.count[face] -= 4;
+	}
+}
+
+static void GreedyBuilder_MergeFaces(struct BuilderContext* ctx, int x1, int y1, int z1) {
+	int xx, yy, zz, index;
+	Face face;
+	Mem_Set(ctx->rows, 1, sizeof(ctx->rows));
+	/* Repeating V in the shader breaks mipmap level selection along the seams between merged faces */
+	if (Gfx.Mipmaps) return;
+
+	/* Layers are processed from the top down, as rows of side faces go downwards */
+	for (yy = CHUNK_SIZE - 1; yy >= 0; yy--)
+		for (zz = 0; zz < CHUNK_SIZE; zz++)
+			for (xx = 0; xx < CHUNK_SIZE; xx++)
+	{
+		index = Builder_PackCount(xx, yy, zz);
+
+		for (face = 0; face < FACE_COUNT; face++)
+		{
+			if (!ctx->counts[index + face]) continue;
+			Greedy_MergeRuns(ctx, x1 + xx, y1 + yy, z1 + zz, xx, yy, zz, face);
+		}
+	}
+}
+
+/* Extends the quad of a run of faces downwards (side faces) or towards +Z (top and bottom faces) */
+/*  over the rows of faces that were merged into it */
+static void Greedy_ExtendQuad(struct BuilderContext* ctx, struct VertexTextured* v, Face face, int rows) {
+	float extra = (float)(rows - 1);
+	int i;
+
+	for (i = 0; i < 4; i++, v++)
+	{
+		if (face >= FACE_YMIN) {
+			if (v->z != ctx->drawer.Z2) continue;
+			v->z += extra;
+		} else {
+			if (v->y != ctx->drawer.Y1) continue;
+			v->y -= extra;
+		}
+		v->V += extra * Atlas1D.InvTileSize;
+	}
+}
+
+static void GreedyBuilder_RenderBlock(struct BuilderContext* ctx, int index, int x, int y, int z) {
+	struct VertexTextured* quads[FACE_COUNT];
+	struct Builder1DPart* part;
+	int baseOffset = (Blocks.Draw[ctx->block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+	Face face;
+
+	/* Have to remember where each face's quad will be written, as drawing moves past it */
+	for (face = 0; face < FACE_COUNT; face++)
+	{
+		part = &ctx->parts[baseOffset + Atlas1D_Index(Block_Tex(ctx->block, face))];
+		quads[face] = part->faces.vertices[face];
+	}
+	NormalBuilder_RenderBlock(ctx, index, x, y, z);
+
+	for (face = 0; face < FACE_COUNT; face++)
+	{
+		if (!ctx->counts[index + face] || ctx->rows[index + face] == 1) continue;
+		Greedy_ExtendQuad(ctx, quads[face], face, ctx->rows[index + face]);
+	}
+}
+#endif
+
+static void GreedyBuilder_SetActive(void) {
 	Builder_SetDefault();
-	Builder_StretchXLiquid = NormalBuilder_StretchXLiquid;
-	Builder_StretchX       = NormalBuilder_StretchX;
-	Builder_StretchZ       = NormalBuilder_StretchZ;
+	Builder_StretchXLiquid = GreedyBuilder_StretchXLiquid;
+	Builder_StretchX       = GreedyBuilder_StretchX;
+	Builder_StretchZ       = GreedyBuilder_StretchZ;
+#ifdef CC_BUILD_PACKEDTERRAIN
+	Builder_MergeFaces     = GreedyBuilder_MergeFaces;
+	Builder_RenderBlock    = GreedyBuilder_RenderBlock;
+#else
 	Builder_RenderBlock    = NormalBuilder_RenderBlock;
+#endif
 }
 
 
@@ -775,13 +1891,6 @@ static void NormalBuilder_SetActive(void) {
 *-------------------------------------------------Advanced mesh builder---------------------------------------------------*
 *#########################################################################################################################*/
 #ifdef CC_BUILD_ADVLIGHTING
-static Vec3 adv_minBB, adv_maxBB;
-static int adv_initBitFlags, adv_baseOffset;
-static int* adv_bitFlags;
-static float adv_x1, adv_y1, adv_z1, adv_x2, adv_y2, adv_z2;
-static PackedCol adv_lerp[5], adv_lerpX[5], adv_lerpZ[5], adv_lerpY[5];
-static cc_bool adv_tinted;
-
 enum ADV_MASK {
 	/* z-1 cube points */
 	xM1_yM1_zM1, xM1_yCC_zM1, xM1_yP1_zM1,
@@ -805,7 +1914,7 @@ enum ADV_MASK {
 /* - bit 0 set: Y-1 is in light */
 /* - bit 1 set: Y   is in light */
 /* - bit 2 set: Y+1 is in light */
-static int Adv_Lit(int x, int y, int z, int cIndex) {
+static int Adv_Lit(struct BuilderContext* ctx, int x, int y, int z, int cIndex) {
 	int flags, offset, lightFlags;
 	BlockID block;
 	if (y < 0 || y >= World.Height) return LIT_M1 | LIT_CC | LIT_P1; /* all faces lit */
@@ -816,7 +1925,7 @@ static int Adv_Lit(int x, int y, int z, int cIndex) {
 	}
 
 	flags = 0;
-	block = Builder_Chunk[cIndex];
+	block = ctx->chunk[cIndex];
 	lightFlags = Blocks.LightOffset[block];
 
 	/* TODO using LIGHT_FLAG_SHADES_FROM_BELOW is wrong here, */
@@ -834,26 +1943,26 @@ static int Adv_Lit(int x, int y, int z, int cIndex) {
 	flags |= Lighting.IsLit_Fast(x, (y + 1) - offset, z) ? LIT_P1 : 0;
 
 	/* If a block is fullbright, it should also look as if that spot is lit */
-	if (Blocks.Brightness[Builder_Chunk[cIndex - 324]]) flags |= LIT_M1;
+	if (Blocks.Brightness[ctx->chunk[cIndex - 324]]) flags |= LIT_M1;
 	if (Blocks.Brightness[block])                       flags |= LIT_CC;
-	if (Blocks.Brightness[Builder_Chunk[cIndex + 324]]) flags |= LIT_P1;
+	if (Blocks.Brightness[ctx->chunk[cIndex + 324]]) flags |= LIT_P1;
 	
 	return flags;
 }
 
-static int Adv_ComputeLightFlags(int x, int y, int z, int cIndex) {
-	if (Builder_FullBright) return (1 << xP1_yP1_zP1) - 1; /* all faces fully bright */
+static int Adv_ComputeLightFlags(struct BuilderContext* ctx, int x, int y, int z, int cIndex) {
+	if (ctx->fullBright) return (1 << xP1_yP1_zP1) - 1; /* all faces fully bright */
 
 	return
-		Adv_Lit(x - 1, y, z - 1, cIndex - 1 - 18) << xM1_yM1_zM1 |
-		Adv_Lit(x - 1, y, z,     cIndex - 1)      << xM1_yM1_zCC |
-		Adv_Lit(x - 1, y, z + 1, cIndex - 1 + 18) << xM1_yM1_zP1 |
-		Adv_Lit(x,     y, z - 1, cIndex + 0 - 18) << xCC_yM1_zM1 |
-		Adv_Lit(x,     y, z,     cIndex + 0)      << xCC_yM1_zCC |
-		Adv_Lit(x,     y, z + 1, cIndex + 0 + 18) << xCC_yM1_zP1 |
-		Adv_Lit(x + 1, y, z - 1, cIndex + 1 - 18) << xP1_yM1_zM1 |
-		Adv_Lit(x + 1, y, z,     cIndex + 1)      << xP1_yM1_zCC |
-		Adv_Lit(x + 1, y, z + 1, cIndex + 1 + 18) << xP1_yM1_zP1;
+		Adv_Lit(ctx, x - 1, y, z - 1, cIndex - 1 - 18) << xM1_yM1_zM1 |
+		Adv_Lit(ctx, x - 1, y, z,     cIndex - 1)      << xM1_yM1_zCC |
+		Adv_Lit(ctx, x - 1, y, z + 1, cIndex - 1 + 18) << xM1_yM1_zP1 |
+		Adv_Lit(ctx, x,     y, z - 1, cIndex + 0 - 18) << xCC_yM1_zM1 |
+		Adv_Lit(ctx, x,     y, z,     cIndex + 0)      << xCC_yM1_zCC |
+		Adv_Lit(ctx, x,     y, z + 1, cIndex + 0 + 18) << xCC_yM1_zP1 |
+		Adv_Lit(ctx, x + 1, y, z - 1, cIndex + 1 - 18) << xP1_yM1_zM1 |
+		Adv_Lit(ctx, x + 1, y, z,     cIndex + 1)      << xP1_yM1_zCC |
+		Adv_Lit(ctx, x + 1, y, z + 1, cIndex + 1 + 18) << xP1_yM1_zP1;
 }
 
 static int adv_masks[FACE_COUNT] = {
@@ -884,384 +1993,383 @@ static int adv_masks[FACE_COUNT] = {
 };
 
 
-static cc_bool Adv_CanStretch(BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
-	BlockID cur = Builder_Chunk[chunkIndex];
-	adv_bitFlags[chunkIndex] = Adv_ComputeLightFlags(x, y, z, chunkIndex);
+static cc_bool Adv_CanStretch(struct BuilderContext* ctx, BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
+	BlockID cur = ctx->chunk[chunkIndex];
+	ctx->bitFlags[chunkIndex] = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
 
 	return cur == initial
-		&& !Block_IsFaceHidden(cur, Builder_Chunk[chunkIndex + Builder_Offsets[face]], face)
-		&& (adv_initBitFlags == adv_bitFlags[chunkIndex]
+		&& !Block_IsFaceHidden(cur, ctx->chunk[chunkIndex + Builder_Offsets[face]], face)
+		&& (ctx->initBitFlags == ctx->bitFlags[chunkIndex]
 		/* Check that this face is either fully bright or fully in shadow */
-		&& (adv_initBitFlags == 0 || (adv_initBitFlags & adv_masks[face]) == adv_masks[face]));
+		&& (ctx->initBitFlags == 0 || (ctx->initBitFlags & adv_masks[face]) == adv_masks[face]));
 }
 
-static int Adv_StretchXLiquid(int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
+static int Adv_StretchXLiquid(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
 	int count = 1; cc_bool stretchTile;
-	if (Builder_OccludedLiquid(chunkIndex)) return 0;
-	adv_initBitFlags = Adv_ComputeLightFlags(x, y, z, chunkIndex);
-	adv_bitFlags[chunkIndex] = adv_initBitFlags;
+	if (Builder_OccludedLiquid(ctx, chunkIndex)) return 0;
+	ctx->initBitFlags = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
+	ctx->bitFlags[chunkIndex] = ctx->initBitFlags;
 
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << FACE_YMAX)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Adv_CanStretch(block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(chunkIndex)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->chunkEndX && stretchTile && Adv_CanStretch(ctx, block, chunkIndex, x, y, z, FACE_YMAX) && !Builder_OccludedLiquid(ctx, chunkIndex)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, FACE_YMAX);
+	AddVertices(ctx, block, FACE_YMAX);
 	return count;
 }
 
-static int Adv_StretchX(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int Adv_StretchX(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
-	adv_initBitFlags = Adv_ComputeLightFlags(x, y, z, chunkIndex);
-	adv_bitFlags[chunkIndex] = adv_initBitFlags;
+	ctx->initBitFlags = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
+	ctx->bitFlags[chunkIndex] = ctx->initBitFlags;
 	
 	x++;
 	chunkIndex++;
 	countIndex += FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (x < Builder_ChunkEndX && stretchTile && Adv_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (x < ctx->chunkEndX && stretchTile && Adv_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		x++;
 		chunkIndex++;
 		countIndex += FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static int Adv_StretchZ(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int Adv_StretchZ(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1; cc_bool stretchTile;
-	adv_initBitFlags = Adv_ComputeLightFlags(x, y, z, chunkIndex);
-	adv_bitFlags[chunkIndex] = adv_initBitFlags;
+	ctx->initBitFlags = Adv_ComputeLightFlags(ctx, x, y, z, chunkIndex);
+	ctx->bitFlags[chunkIndex] = ctx->initBitFlags;
 
 	z++;
 	chunkIndex += EXTCHUNK_SIZE;
 	countIndex += CHUNK_SIZE * FACE_COUNT;
 	stretchTile = (Blocks.CanStretch[block] & (1 << face)) != 0;
 
-	while (z < Builder_ChunkEndZ && stretchTile && Adv_CanStretch(block, chunkIndex, x, y, z, face)) {
-		Builder_Counts[countIndex] = 0;
+	while (z < ctx->chunkEndZ && stretchTile && Adv_CanStretch(ctx, block, chunkIndex, x, y, z, face)) {
+		ctx->counts[countIndex] = 0;
 		count++;
 		z++;
 		chunkIndex += EXTCHUNK_SIZE;
 		countIndex += CHUNK_SIZE * FACE_COUNT;
 	}
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
 
 #define Adv_CountBits(F, a, b, c, d) (((F >> a) & 1) + ((F >> b) & 1) + ((F >> c) & 1) + ((F >> d) & 1))
 
-static void Adv_DrawXMin(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_XMIN);
+static void Adv_DrawXMin(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_XMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.z, u2 = (count - 1) + adv_maxBB.z * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.z, u2 = (count - 1) + ctx->maxBB.z * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aY0_Z0 = Adv_CountBits(F, xM1_yM1_zM1, xM1_yCC_zM1, xM1_yM1_zCC, xM1_yCC_zCC);
 	int aY0_Z1 = Adv_CountBits(F, xM1_yM1_zP1, xM1_yCC_zP1, xM1_yM1_zCC, xM1_yCC_zCC);
 	int aY1_Z0 = Adv_CountBits(F, xM1_yP1_zM1, xM1_yCC_zM1, xM1_yP1_zCC, xM1_yCC_zCC);
 	int aY1_Z1 = Adv_CountBits(F, xM1_yP1_zP1, xM1_yCC_zP1, xM1_yP1_zCC, xM1_yCC_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpX[aY0_Z0], col1_0 = Builder_FullBright ? white : adv_lerpX[aY1_Z0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpX[aY1_Z1], col0_1 = Builder_FullBright ? white : adv_lerpX[aY0_Z1];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->lerpX[aY0_Z0], col1_0 = ctx->fullBright ? white : ctx->lerpX[aY1_Z0];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->lerpX[aY1_Z1], col0_1 = ctx->fullBright ? white : ctx->lerpX[aY0_Z1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_XMIN];
-	v.x = adv_x1;
+	v.x = ctx->x1;
 	if (aY0_Z0 + aY1_Z1 > aY0_Z1 + aY1_Z0) {
-		v.y = adv_y2; v.z = adv_z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
-		v.y = adv_y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
-		              v.z = adv_z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
-		v.y = adv_y2;                                       v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.y = ctx->y2; v.z = ctx->z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.y = ctx->y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
+		              v.z = ctx->z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
+		v.y = ctx->y2;                                       v.V = v1; v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.y = adv_y2; v.z = adv_z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		              v.z = adv_z1;               v.U = u1;           v.Col = col1_0; *vertices++ = v;
-		v.y = adv_y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
-		              v.z = adv_z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
+		v.y = ctx->y2; v.z = ctx->z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		              v.z = ctx->z1;               v.U = u1;           v.Col = col1_0; *vertices++ = v;
+		v.y = ctx->y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
+		              v.z = ctx->z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
 	}
 	part->faces.vertices[FACE_XMIN] = vertices;
 }
 
-static void Adv_DrawXMax(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_XMAX);
+static void Adv_DrawXMax(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_XMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - adv_minBB.z), u2 = (1 - adv_maxBB.z) * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = (count - ctx->minBB.z), u2 = (1 - ctx->maxBB.z) * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aY0_Z0 = Adv_CountBits(F, xP1_yM1_zM1, xP1_yCC_zM1, xP1_yM1_zCC, xP1_yCC_zCC);
 	int aY0_Z1 = Adv_CountBits(F, xP1_yM1_zP1, xP1_yCC_zP1, xP1_yM1_zCC, xP1_yCC_zCC);
 	int aY1_Z0 = Adv_CountBits(F, xP1_yP1_zM1, xP1_yCC_zM1, xP1_yP1_zCC, xP1_yCC_zCC);
 	int aY1_Z1 = Adv_CountBits(F, xP1_yP1_zP1, xP1_yCC_zP1, xP1_yP1_zCC, xP1_yCC_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpX[aY0_Z0], col1_0 = Builder_FullBright ? white : adv_lerpX[aY1_Z0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpX[aY1_Z1], col0_1 = Builder_FullBright ? white : adv_lerpX[aY0_Z1];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->lerpX[aY0_Z0], col1_0 = ctx->fullBright ? white : ctx->lerpX[aY1_Z0];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->lerpX[aY1_Z1], col0_1 = ctx->fullBright ? white : ctx->lerpX[aY0_Z1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_XMAX];
-	v.x = adv_x2;
+	v.x = ctx->x2;
 	if (aY0_Z0 + aY1_Z1 > aY0_Z1 + aY1_Z0) {
-		v.y = adv_y2; v.z = adv_z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
-		              v.z = adv_z2 + (count - 1); v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		v.y = adv_y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
-		              v.z = adv_z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		v.y = ctx->y2; v.z = ctx->z1;               v.U = u1; v.V = v1; v.Col = col1_0; *vertices++ = v;
+		              v.z = ctx->z2 + (count - 1); v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		v.y = ctx->y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
+		              v.z = ctx->z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
 	} else {
-		v.y = adv_y2; v.z = adv_z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		v.y = adv_y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
-		              v.z = adv_z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		v.y = adv_y2;                                       v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.y = ctx->y2; v.z = ctx->z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.y = ctx->y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
+		              v.z = ctx->z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		v.y = ctx->y2;                                       v.V = v1; v.Col = col1_0; *vertices++ = v;
 	}
 	part->faces.vertices[FACE_XMAX] = vertices;
 }
 
-static void Adv_DrawZMin(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_ZMIN);
+static void Adv_DrawZMin(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_ZMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - adv_minBB.x), u2 = (1 - adv_maxBB.x) * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = (count - ctx->minBB.x), u2 = (1 - ctx->maxBB.x) * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aX0_Y0 = Adv_CountBits(F, xM1_yM1_zM1, xM1_yCC_zM1, xCC_yM1_zM1, xCC_yCC_zM1);
 	int aX0_Y1 = Adv_CountBits(F, xM1_yP1_zM1, xM1_yCC_zM1, xCC_yP1_zM1, xCC_yCC_zM1);
 	int aX1_Y0 = Adv_CountBits(F, xP1_yM1_zM1, xP1_yCC_zM1, xCC_yM1_zM1, xCC_yCC_zM1);
 	int aX1_Y1 = Adv_CountBits(F, xP1_yP1_zM1, xP1_yCC_zM1, xCC_yP1_zM1, xCC_yCC_zM1);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpZ[aX0_Y0], col1_0 = Builder_FullBright ? white : adv_lerpZ[aX1_Y0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpZ[aX1_Y1], col0_1 = Builder_FullBright ? white : adv_lerpZ[aX0_Y1];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->lerpZ[aX0_Y0], col1_0 = ctx->fullBright ? white : ctx->lerpZ[aX1_Y0];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->lerpZ[aX1_Y1], col0_1 = ctx->fullBright ? white : ctx->lerpZ[aX0_Y1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_ZMIN];
-	v.z = adv_z1;
+	v.z = ctx->z1;
 	if (aX1_Y1 + aX0_Y0 > aX0_Y1 + aX1_Y0) {
-		v.x = adv_x2 + (count - 1); v.y = adv_y1; v.U = u2; v.V = v2; v.Col = col1_0; *vertices++ = v;
-		v.x = adv_x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		                            v.y = adv_y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1); v.y = ctx->y1; v.U = u2; v.V = v2; v.Col = col1_0; *vertices++ = v;
+		v.x = ctx->x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		                            v.y = ctx->y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.x = adv_x1;               v.y = adv_y1; v.U = u1; v.V = v2; v.Col = col0_0; *vertices++ = v;
-		                            v.y = adv_y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		                            v.y = adv_y1;           v.V = v2; v.Col = col1_0; *vertices++ = v;
+		v.x = ctx->x1;               v.y = ctx->y1; v.U = u1; v.V = v2; v.Col = col0_0; *vertices++ = v;
+		                            v.y = ctx->y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		                            v.y = ctx->y1;           v.V = v2; v.Col = col1_0; *vertices++ = v;
 	}
 	part->faces.vertices[FACE_ZMIN] = vertices;
 }
 
-static void Adv_DrawZMax(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_ZMAX);
+static void Adv_DrawZMax(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_ZMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.x, u2 = (count - 1) + adv_maxBB.x * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.x, u2 = (count - 1) + ctx->maxBB.x * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aX0_Y0 = Adv_CountBits(F, xM1_yM1_zP1, xM1_yCC_zP1, xCC_yM1_zP1, xCC_yCC_zP1);
 	int aX1_Y0 = Adv_CountBits(F, xP1_yM1_zP1, xP1_yCC_zP1, xCC_yM1_zP1, xCC_yCC_zP1);
 	int aX0_Y1 = Adv_CountBits(F, xM1_yP1_zP1, xM1_yCC_zP1, xCC_yP1_zP1, xCC_yCC_zP1);
 	int aX1_Y1 = Adv_CountBits(F, xP1_yP1_zP1, xP1_yCC_zP1, xCC_yP1_zP1, xCC_yCC_zP1);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerpZ[aX1_Y1], col1_0 = Builder_FullBright ? white : adv_lerpZ[aX1_Y0];
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerpZ[aX0_Y0], col0_1 = Builder_FullBright ? white : adv_lerpZ[aX0_Y1];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->lerpZ[aX1_Y1], col1_0 = ctx->fullBright ? white : ctx->lerpZ[aX1_Y0];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->lerpZ[aX0_Y0], col0_1 = ctx->fullBright ? white : ctx->lerpZ[aX0_Y1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_ZMAX];
-	v.z = adv_z2;
+	v.z = ctx->z2;
 	if (aX1_Y1 + aX0_Y0 > aX0_Y1 + aX1_Y0) {
-		v.x = adv_x1;               v.y = adv_y2; v.U = u1; v.V = v1; v.Col = col0_1; *vertices++ = v;
-		                            v.y = adv_y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
-		                            v.y = adv_y2;           v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x1;               v.y = ctx->y2; v.U = u1; v.V = v1; v.Col = col0_1; *vertices++ = v;
+		                            v.y = ctx->y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		                            v.y = ctx->y2;           v.V = v1; v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.x = adv_x2 + (count - 1); v.y = adv_y2; v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		v.x = adv_x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
-		                            v.y = adv_y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1); v.y = ctx->y2; v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
+		                            v.y = ctx->y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
 	}
 	part->faces.vertices[FACE_ZMAX] = vertices;
 }
 
-static void Adv_DrawYMin(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_YMIN);
+static void Adv_DrawYMin(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_YMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.x, u2 = (count - 1) + adv_maxBB.x * UV2_Scale;
-	float v1 = vOrigin + adv_minBB.z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.x, u2 = (count - 1) + ctx->maxBB.x * UV2_Scale;
+	float v1 = vOrigin + ctx->minBB.z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aX0_Z0 = Adv_CountBits(F, xM1_yM1_zM1, xM1_yM1_zCC, xCC_yM1_zM1, xCC_yM1_zCC);
 	int aX1_Z0 = Adv_CountBits(F, xP1_yM1_zM1, xP1_yM1_zCC, xCC_yM1_zM1, xCC_yM1_zCC);
 	int aX0_Z1 = Adv_CountBits(F, xM1_yM1_zP1, xM1_yM1_zCC, xCC_yM1_zP1, xCC_yM1_zCC);
 	int aX1_Z1 = Adv_CountBits(F, xP1_yM1_zP1, xP1_yM1_zCC, xCC_yM1_zP1, xCC_yM1_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_1 = Builder_FullBright ? white : adv_lerpY[aX0_Z1], col1_1 = Builder_FullBright ? white : adv_lerpY[aX1_Z1];
-	PackedCol col1_0 = Builder_FullBright ? white : adv_lerpY[aX1_Z0], col0_0 = Builder_FullBright ? white : adv_lerpY[aX0_Z0];
+	PackedCol col0_1 = ctx->fullBright ? white : ctx->lerpY[aX0_Z1], col1_1 = ctx->fullBright ? white : ctx->lerpY[aX1_Z1];
+	PackedCol col1_0 = ctx->fullBright ? white : ctx->lerpY[aX1_Z0], col0_0 = ctx->fullBright ? white : ctx->lerpY[aX0_Z0];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_YMIN];
-	v.y = adv_y1;
+	v.y = ctx->y1;
 	if (aX0_Z1 + aX1_Z0 > aX0_Z0 + aX1_Z1) {
-		v.x = adv_x2 + (count - 1); v.z = adv_z2; v.U = u2; v.V = v2; v.Col = col1_1; *vertices++ = v;
-		v.x = adv_x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
-		                            v.z = adv_z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1); v.z = ctx->z2; v.U = u2; v.V = v2; v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
+		                            v.z = ctx->z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
 	} else {
-		v.x = adv_x1;               v.z = adv_z2; v.U = u1; v.V = v2; v.Col = col0_1; *vertices++ = v;
-		                            v.z = adv_z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
-		                            v.z = adv_z2;           v.V = v2; v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x1;               v.z = ctx->z2; v.U = u1; v.V = v2; v.Col = col0_1; *vertices++ = v;
+		                            v.z = ctx->z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		                            v.z = ctx->z2;           v.V = v2; v.Col = col1_1; *vertices++ = v;
 	}
 	part->faces.vertices[FACE_YMIN] = vertices;
 }
 
-static void Adv_DrawYMax(int count) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_YMAX);
+static void Adv_DrawYMax(struct BuilderContext* ctx, int count) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_YMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.x, u2 = (count - 1) + adv_maxBB.x * UV2_Scale;
-	float v1 = vOrigin + adv_minBB.z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.x, u2 = (count - 1) + ctx->maxBB.x * UV2_Scale;
+	float v1 = vOrigin + ctx->minBB.z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
-	int F = adv_bitFlags[Builder_ChunkIndex];
+	int F = ctx->bitFlags[ctx->chunkIndex];
 	int aX0_Z0 = Adv_CountBits(F, xM1_yP1_zM1, xM1_yP1_zCC, xCC_yP1_zM1, xCC_yP1_zCC);
 	int aX1_Z0 = Adv_CountBits(F, xP1_yP1_zM1, xP1_yP1_zCC, xCC_yP1_zM1, xCC_yP1_zCC);
 	int aX0_Z1 = Adv_CountBits(F, xM1_yP1_zP1, xM1_yP1_zCC, xCC_yP1_zP1, xCC_yP1_zCC);
 	int aX1_Z1 = Adv_CountBits(F, xP1_yP1_zP1, xP1_yP1_zCC, xCC_yP1_zP1, xCC_yP1_zCC);
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	PackedCol col0_0 = Builder_FullBright ? white : adv_lerp[aX0_Z0], col1_0 = Builder_FullBright ? white : adv_lerp[aX1_Z0];
-	PackedCol col1_1 = Builder_FullBright ? white : adv_lerp[aX1_Z1], col0_1 = Builder_FullBright ? white : adv_lerp[aX0_Z1];
+	PackedCol col0_0 = ctx->fullBright ? white : ctx->lerp[aX0_Z0], col1_0 = ctx->fullBright ? white : ctx->lerp[aX1_Z0];
+	PackedCol col1_1 = ctx->fullBright ? white : ctx->lerp[aX1_Z1], col0_1 = ctx->fullBright ? white : ctx->lerp[aX0_Z1];
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_YMAX];
-	v.y = adv_y2;
+	v.y = ctx->y2;
 	if (aX0_Z0 + aX1_Z1 > aX0_Z1 + aX1_Z0) {
-		v.x = adv_x2 + (count - 1); v.z = adv_z1; v.U = u2; v.V = v1; v.Col = col1_0; *vertices++ = v;
-		v.x = adv_x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		                            v.z = adv_z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1); v.z = ctx->z1; v.U = u2; v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.x = ctx->x1;                             v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		                            v.z = ctx->z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
 	} else {
-		v.x = adv_x1;               v.z = adv_z1; v.U = u1; v.V = v1; v.Col = col0_0; *vertices++ = v;
-		                            v.z = adv_z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		                            v.z = adv_z1;           v.V = v1; v.Col = col1_0; *vertices++ = v;
+		v.x = ctx->x1;               v.z = ctx->z1; v.U = u1; v.V = v1; v.Col = col0_0; *vertices++ = v;
+		                            v.z = ctx->z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		                            v.z = ctx->z1;           v.V = v1; v.Col = col1_0; *vertices++ = v;
 	}
 	part->faces.vertices[FACE_YMAX] = vertices;
 }
 
-static void Adv_RenderBlock(int index, int x, int y, int z) {
+static void Adv_RenderBlock(struct BuilderContext* ctx, int index, int x, int y, int z) {
 	Vec3 min, max;
 	int count_XMin, count_XMax, count_ZMin;
 	int count_ZMax, count_YMin, count_YMax;
 
-	if (Blocks.Draw[Builder_Block] == DRAW_SPRITE) {
-		Builder_DrawSprite(x, y, z); return;
+	if (Blocks.Draw[ctx->block] == DRAW_SPRITE) {
+		Builder_DrawSprite(ctx, x, y, z); return;
 	}
 
-	count_XMin = Builder_Counts[index + FACE_XMIN];
-	count_XMax = Builder_Counts[index + FACE_XMAX];
-	count_ZMin = Builder_Counts[index + FACE_ZMIN];
-	count_ZMax = Builder_Counts[index + FACE_ZMAX];
-	count_YMin = Builder_Counts[index + FACE_YMIN];
-	count_YMax = Builder_Counts[index + FACE_YMAX];
+	count_XMin = ctx->counts[index + FACE_XMIN];
+	count_XMax = ctx->counts[index + FACE_XMAX];
+	count_ZMin = ctx->counts[index + FACE_ZMIN];
+	count_ZMax = ctx->counts[index + FACE_ZMAX];
+	count_YMin = ctx->counts[index + FACE_YMIN];
+	count_YMax = ctx->counts[index + FACE_YMAX];
 
 	if (!count_XMin && !count_XMax && !count_ZMin &&
 		!count_ZMax && !count_YMin && !count_YMax) return;
 
-	Builder_FullBright = Blocks.Brightness[Builder_Block];
-	adv_baseOffset = (Blocks.Draw[Builder_Block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
-	adv_tinted     = Blocks.Tinted[Builder_Block];
+	ctx->fullBright = Blocks.Brightness[ctx->block];
+	ctx->baseOffset = (Blocks.Draw[ctx->block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+	ctx->tinted     = Blocks.Tinted[ctx->block];
 
-	min = Blocks.RenderMinBB[Builder_Block]; max = Blocks.RenderMaxBB[Builder_Block];
-	adv_x1 = x + min.x; adv_y1 = y + min.y; adv_z1 = z + min.z;
-	adv_x2 = x + max.x; adv_y2 = y + max.y; adv_z2 = z + max.z;
+	min = Blocks.RenderMinBB[ctx->block]; max = Blocks.RenderMaxBB[ctx->block];
+	ctx->x1 = x + min.x; ctx->y1 = y + min.y; ctx->z1 = z + min.z;
+	ctx->x2 = x + max.x; ctx->y2 = y + max.y; ctx->z2 = z + max.z;
 
-	adv_minBB = Blocks.MinBB[Builder_Block]; adv_maxBB = Blocks.MaxBB[Builder_Block];
-	adv_minBB.y = 1.0f - adv_minBB.y; adv_maxBB.y = 1.0f - adv_maxBB.y;
+	ctx->minBB = Blocks.MinBB[ctx->block]; ctx->maxBB = Blocks.MaxBB[ctx->block];
+	ctx->minBB.y = 1.0f - ctx->minBB.y; ctx->maxBB.y = 1.0f - ctx->maxBB.y;
 
-	if (count_XMin) Adv_DrawXMin(count_XMin);
-	if (count_XMax) Adv_DrawXMax(count_XMax);
-	if (count_ZMin) Adv_DrawZMin(count_ZMin);
-	if (count_ZMax) Adv_DrawZMax(count_ZMax);
-	if (count_YMin) Adv_DrawYMin(count_YMin);
-	if (count_YMax) Adv_DrawYMax(count_YMax);
+	if (count_XMin) Adv_DrawXMin(ctx, count_XMin);
+	if (count_XMax) Adv_DrawXMax(ctx, count_XMax);
+	if (count_ZMin) Adv_DrawZMin(ctx, count_ZMin);
+	if (count_ZMax) Adv_DrawZMax(ctx, count_ZMax);
+	if (count_YMin) Adv_DrawYMin(ctx, count_YMin);
+	if (count_YMax) Adv_DrawYMax(ctx, count_YMax);
 }
 
-static void Adv_PrePrepareChunk(void) {
+static void Adv_PrePrepareChunk(struct BuilderContext* ctx) {
 	int i;
-	DefaultPrePrepateChunk();
-	adv_bitFlags = Builder_BitFlags;
+	DefaultPrePrepateChunk(ctx);
 
 	for (i = 0; i <= 4; i++) {
-		adv_lerp[i]  = PackedCol_Lerp(Env.ShadowCol,   Env.SunCol,   i / 4.0f);
-		adv_lerpX[i] = PackedCol_Lerp(Env.ShadowXSide, Env.SunXSide, i / 4.0f);
-		adv_lerpZ[i] = PackedCol_Lerp(Env.ShadowZSide, Env.SunZSide, i / 4.0f);
-		adv_lerpY[i] = PackedCol_Lerp(Env.ShadowYMin,  Env.SunYMin,  i / 4.0f);
+		ctx->lerp[i]  = PackedCol_Lerp(Env.ShadowCol,   Env.SunCol,   i / 4.0f);
+		ctx->lerpX[i] = PackedCol_Lerp(Env.ShadowXSide, Env.SunXSide, i / 4.0f);
+		ctx->lerpZ[i] = PackedCol_Lerp(Env.ShadowZSide, Env.SunZSide, i / 4.0f);
+		ctx->lerpY[i] = PackedCol_Lerp(Env.ShadowYMin,  Env.SunYMin,  i / 4.0f);
 	}
 }
 
@@ -1296,321 +2404,320 @@ static cc_bool Modern_IsOccluded(int x, int y, int z) {
 	return false;
 }
 
-static cc_bool Modern_CanStretch(BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
+static cc_bool Modern_CanStretch(struct BuilderContext* ctx, BlockID initial, int chunkIndex, int x, int y, int z, Face face) {
 	return false;
 }
 
-static int Modern_StretchXLiquid(int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
+static int Modern_StretchXLiquid(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block) {
 	int count = 1;
-	if (Builder_OccludedLiquid(chunkIndex)) return 0;
-	AddVertices(block, FACE_YMAX);
+	if (Builder_OccludedLiquid(ctx, chunkIndex)) return 0;
+	AddVertices(ctx, block, FACE_YMAX);
 	return count;
 }
 
-static int Modern_StretchX(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int Modern_StretchX(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1;
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static int Modern_StretchZ(int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
+static int Modern_StretchZ(struct BuilderContext* ctx, int countIndex, int x, int y, int z, int chunkIndex, BlockID block, Face face) {
 	int count = 1;
-	AddVertices(block, face);
+	AddVertices(ctx, block, face);
 	return count;
 }
 
-static PackedCol Modern_GetColorX(PackedCol orig, int x, int y, int z, int oY, int oZ) {
+static PackedCol Modern_GetColorX(struct BuilderContext* ctx, PackedCol orig, int x, int y, int z, int oY, int oZ) {
 	cc_bool xOccluded =  Modern_IsOccluded(x, y + oY, z     );
 	cc_bool zOccluded =  Modern_IsOccluded(x, y     , z + oZ);
 	cc_bool xzOccluded = Modern_IsOccluded(x, y + oY, z + oZ);
 
-	PackedCol CoX = xOccluded ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color_XSide_Fast(x, y + oY, z     );
-	PackedCol CoZ = zOccluded ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color_XSide_Fast(x, y     , z + oZ);
-	PackedCol CoXoZ = (xzOccluded || (xOccluded && zOccluded)) ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color_XSide_Fast(x, y + oY, z + oZ);
+	PackedCol CoX = xOccluded ? PackedCol_Scale(orig, FANCY_AO) : Builder_LightXSide(ctx, x, y + oY, z     );
+	PackedCol CoZ = zOccluded ? PackedCol_Scale(orig, FANCY_AO) : Builder_LightXSide(ctx, x, y     , z + oZ);
+	PackedCol CoXoZ = (xzOccluded || (xOccluded && zOccluded)) ? PackedCol_Scale(orig, FANCY_AO) : Builder_LightXSide(ctx, x, y + oY, z + oZ);
 
 	PackedCol ab = AVERAGE(CoX, CoZ);
 	PackedCol cd = AVERAGE(CoXoZ, orig);
 	return AVERAGE(ab, cd);
 }
-static void Modern_DrawXMin(int count, int x, int y, int z) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_XMIN);
+static void Modern_DrawXMin(struct BuilderContext* ctx, int count, int x, int y, int z) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_XMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.z, u2 = (count - 1) + adv_maxBB.z * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.z, u2 = (count - 1) + ctx->maxBB.z * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	int offset = 1;// (Blocks.LightOffset[Builder_Block] >> FACE_XMIN) & 1;
-	PackedCol orig = Lighting.Color_XSide_Fast(x-offset, y, z);
-	PackedCol col0_0 = Builder_FullBright ? white : Modern_GetColorX(orig, x-offset, y, z, -1, -1);
-	PackedCol col1_0 = Builder_FullBright ? white : Modern_GetColorX(orig, x-offset, y, z, 1, -1);
-	PackedCol col1_1 = Builder_FullBright ? white : Modern_GetColorX(orig, x-offset, y, z, 1, 1);
-	PackedCol col0_1 = Builder_FullBright ? white : Modern_GetColorX(orig, x-offset, y, z, -1, 1);
+	int offset = 1;// (Blocks.LightOffset[ctx->block] >> FACE_XMIN) & 1;
+	PackedCol orig = Builder_LightXSide(ctx, x-offset, y, z);
+	PackedCol col0_0 = ctx->fullBright ? white : Modern_GetColorX(ctx, orig, x-offset, y, z, -1, -1);
+	PackedCol col1_0 = ctx->fullBright ? white : Modern_GetColorX(ctx, orig, x-offset, y, z, 1, -1);
+	PackedCol col1_1 = ctx->fullBright ? white : Modern_GetColorX(ctx, orig, x-offset, y, z, 1, 1);
+	PackedCol col0_1 = ctx->fullBright ? white : Modern_GetColorX(ctx, orig, x-offset, y, z, -1, 1);
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_XMIN];
-	v.x = adv_x1;
-		v.y = adv_y2; v.z = adv_z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		              v.z = adv_z1;               v.U = u1;           v.Col = col1_0; *vertices++ = v;
-		v.y = adv_y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
-		              v.z = adv_z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
+	v.x = ctx->x1;
+		v.y = ctx->y2; v.z = ctx->z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		              v.z = ctx->z1;               v.U = u1;           v.Col = col1_0; *vertices++ = v;
+		v.y = ctx->y1;                                       v.V = v2; v.Col = col0_0; *vertices++ = v;
+		              v.z = ctx->z2 + (count - 1); v.U = u2;           v.Col = col0_1; *vertices++ = v;
 	part->faces.vertices[FACE_XMIN] = vertices;
 }
 
-static void Modern_DrawXMax(int count, int x, int y, int z) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_XMAX);
+static void Modern_DrawXMax(struct BuilderContext* ctx, int count, int x, int y, int z) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_XMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - adv_minBB.z), u2 = (1 - adv_maxBB.z) * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = (count - ctx->minBB.z), u2 = (1 - ctx->maxBB.z) * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	int offset = 1;// (Blocks.LightOffset[Builder_Block] >> FACE_XMAX) & 1;
-	PackedCol orig = Lighting.Color_XSide_Fast(x+offset, y, z);
-	PackedCol col0_0 = Builder_FullBright ? white : Modern_GetColorX(orig, x+offset, y, z, -1, -1);
-	PackedCol col1_0 = Builder_FullBright ? white : Modern_GetColorX(orig, x+offset, y, z, 1, -1);
-	PackedCol col1_1 = Builder_FullBright ? white : Modern_GetColorX(orig, x+offset, y, z, 1, 1);
-	PackedCol col0_1 = Builder_FullBright ? white : Modern_GetColorX(orig, x+offset, y, z, -1, 1);
+	int offset = 1;// (Blocks.LightOffset[ctx->block] >> FACE_XMAX) & 1;
+	PackedCol orig = Builder_LightXSide(ctx, x+offset, y, z);
+	PackedCol col0_0 = ctx->fullBright ? white : Modern_GetColorX(ctx, orig, x+offset, y, z, -1, -1);
+	PackedCol col1_0 = ctx->fullBright ? white : Modern_GetColorX(ctx, orig, x+offset, y, z, 1, -1);
+	PackedCol col1_1 = ctx->fullBright ? white : Modern_GetColorX(ctx, orig, x+offset, y, z, 1, 1);
+	PackedCol col0_1 = ctx->fullBright ? white : Modern_GetColorX(ctx, orig, x+offset, y, z, -1, 1);
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_XMAX];
-	v.x = adv_x2;
-		v.y = adv_y2; v.z = adv_z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		v.y = adv_y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
-		              v.z = adv_z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
-		v.y = adv_y2;                                       v.V = v1; v.Col = col1_0; *vertices++ = v;
+	v.x = ctx->x2;
+		v.y = ctx->y2; v.z = ctx->z2 + (count - 1); v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.y = ctx->y1;                                       v.V = v2; v.Col = col0_1; *vertices++ = v;
+		              v.z = ctx->z1;               v.U = u1;           v.Col = col0_0; *vertices++ = v;
+		v.y = ctx->y2;                                       v.V = v1; v.Col = col1_0; *vertices++ = v;
 	part->faces.vertices[FACE_XMAX] = vertices;
 }
 
-static PackedCol Modern_GetColorZ(PackedCol orig, int x, int y, int z, int oX, int oY) {
+static PackedCol Modern_GetColorZ(struct BuilderContext* ctx, PackedCol orig, int x, int y, int z, int oX, int oY) {
 	cc_bool xOccluded  = Modern_IsOccluded(x + oX, y     , z);
 	cc_bool zOccluded  = Modern_IsOccluded(x,      y + oY, z);
 	cc_bool xzOccluded = Modern_IsOccluded(x + oX, y + oY, z);
 
-	PackedCol CoX   =                                xOccluded ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color_ZSide_Fast(x + oX, y     , z);
-	PackedCol CoZ   =                                zOccluded ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color_ZSide_Fast(x     , y + oY, z);
-	PackedCol CoXoZ = (xzOccluded || (xOccluded && zOccluded)) ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color_ZSide_Fast(x + oX, y + oY, z);
+	PackedCol CoX   =                                xOccluded ? PackedCol_Scale(orig, FANCY_AO) : Builder_LightZSide(ctx, x + oX, y     , z);
+	PackedCol CoZ   =                                zOccluded ? PackedCol_Scale(orig, FANCY_AO) : Builder_LightZSide(ctx, x     , y + oY, z);
+	PackedCol CoXoZ = (xzOccluded || (xOccluded && zOccluded)) ? PackedCol_Scale(orig, FANCY_AO) : Builder_LightZSide(ctx, x + oX, y + oY, z);
 
 	PackedCol ab = AVERAGE(CoX, CoZ);
 	PackedCol cd = AVERAGE(CoXoZ, orig);
 	return AVERAGE(ab, cd);
 }
-static void Modern_DrawZMin(int count, int x, int y, int z) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_ZMIN);
+static void Modern_DrawZMin(struct BuilderContext* ctx, int count, int x, int y, int z) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_ZMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = (count - adv_minBB.x), u2 = (1 - adv_maxBB.x) * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = (count - ctx->minBB.x), u2 = (1 - ctx->maxBB.x) * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	int offset = 1;// (Blocks.LightOffset[Builder_Block] >> FACE_ZMIN) & 1;
-	PackedCol orig = Lighting.Color_ZSide_Fast(x, y, z-offset);
-	PackedCol col0_0 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z-offset, -1, -1);
-	PackedCol col1_0 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z-offset, 1, -1);
-	PackedCol col1_1 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z-offset, 1, 1);
-	PackedCol col0_1 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z-offset, -1, 1);
+	int offset = 1;// (Blocks.LightOffset[ctx->block] >> FACE_ZMIN) & 1;
+	PackedCol orig = Builder_LightZSide(ctx, x, y, z-offset);
+	PackedCol col0_0 = ctx->fullBright ? white : Modern_GetColorZ(ctx, orig, x, y, z-offset, -1, -1);
+	PackedCol col1_0 = ctx->fullBright ? white : Modern_GetColorZ(ctx, orig, x, y, z-offset, 1, -1);
+	PackedCol col1_1 = ctx->fullBright ? white : Modern_GetColorZ(ctx, orig, x, y, z-offset, 1, 1);
+	PackedCol col0_1 = ctx->fullBright ? white : Modern_GetColorZ(ctx, orig, x, y, z-offset, -1, 1);
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_ZMIN];
-	v.z = adv_z1;
-		v.x = adv_x1;               v.y = adv_y1; v.U = u1; v.V = v2; v.Col = col0_0; *vertices++ = v;
-		                            v.y = adv_y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		                            v.y = adv_y1;           v.V = v2; v.Col = col1_0; *vertices++ = v;
+	v.z = ctx->z1;
+		v.x = ctx->x1;               v.y = ctx->y1; v.U = u1; v.V = v2; v.Col = col0_0; *vertices++ = v;
+		                            v.y = ctx->y2;           v.V = v1; v.Col = col0_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		                            v.y = ctx->y1;           v.V = v2; v.Col = col1_0; *vertices++ = v;
 	part->faces.vertices[FACE_ZMIN] = vertices;
 }
 
-static void Modern_DrawZMax(int count, int x, int y, int z) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_ZMAX);
+static void Modern_DrawZMax(struct BuilderContext* ctx, int count, int x, int y, int z) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_ZMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.x, u2 = (count - 1) + adv_maxBB.x * UV2_Scale;
-	float v1 = vOrigin + adv_maxBB.y * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_minBB.y * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.x, u2 = (count - 1) + ctx->maxBB.x * UV2_Scale;
+	float v1 = vOrigin + ctx->maxBB.y * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->minBB.y * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	int offset = 1;// (Blocks.LightOffset[Builder_Block] >> FACE_ZMAX) & 1;
-	PackedCol orig = Lighting.Color_ZSide_Fast(x, y, z+offset);
-	PackedCol col0_0 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z+offset, -1, -1);
-	PackedCol col1_0 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z+offset, 1, -1);
-	PackedCol col1_1 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z+offset, 1, 1);
-	PackedCol col0_1 = Builder_FullBright ? white : Modern_GetColorZ(orig, x, y, z+offset, -1, 1);
+	int offset = 1;// (Blocks.LightOffset[ctx->block] >> FACE_ZMAX) & 1;
+	PackedCol orig = Builder_LightZSide(ctx, x, y, z+offset);
+	PackedCol col0_0 = ctx->fullBright ? white : Modern_GetColorZ(ctx, orig, x, y, z+offset, -1, -1);
+	PackedCol col1_0 = ctx->fullBright ? white : Modern_GetColorZ(ctx, orig, x, y, z+offset, 1, -1);
+	PackedCol col1_1 = ctx->fullBright ? white : Modern_GetColorZ(ctx, orig, x, y, z+offset, 1, 1);
+	PackedCol col0_1 = ctx->fullBright ? white : Modern_GetColorZ(ctx, orig, x, y, z+offset, -1, 1);
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_ZMAX];
-	v.z = adv_z2;
-		v.x = adv_x2 + (count - 1); v.y = adv_y2; v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
-		v.x = adv_x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
-		                            v.y = adv_y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+	v.z = ctx->z2;
+		v.x = ctx->x2 + (count - 1); v.y = ctx->y2; v.U = u2; v.V = v1; v.Col = col1_1; *vertices++ = v;
+		v.x = ctx->x1;                             v.U = u1;           v.Col = col0_1; *vertices++ = v;
+		                            v.y = ctx->y1;           v.V = v2; v.Col = col0_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
 	part->faces.vertices[FACE_ZMAX] = vertices;
 }
 
-static PackedCol Modern_GetColorYMin(PackedCol orig, int x, int y, int z, int oX, int oZ) {
+static PackedCol Modern_GetColorYMin(struct BuilderContext* ctx, PackedCol orig, int x, int y, int z, int oX, int oZ) {
 	cc_bool xOccluded  = Modern_IsOccluded(x + oX, y, z     );
 	cc_bool zOccluded  = Modern_IsOccluded(x,      y, z + oZ);
 	cc_bool xzOccluded = Modern_IsOccluded(x + oX, y, z + oZ);
 
-	PackedCol CoX   =                                xOccluded ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color_YMin_Fast(x + oX, y, z     );
-	PackedCol CoZ   =                                zOccluded ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color_YMin_Fast(x     , y, z + oZ);
-	PackedCol CoXoZ = (xzOccluded || (xOccluded && zOccluded)) ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color_YMin_Fast(x + oX, y, z + oZ);
+	PackedCol CoX   =                                xOccluded ? PackedCol_Scale(orig, FANCY_AO) : Builder_LightYMin(ctx, x + oX, y, z     );
+	PackedCol CoZ   =                                zOccluded ? PackedCol_Scale(orig, FANCY_AO) : Builder_LightYMin(ctx, x     , y, z + oZ);
+	PackedCol CoXoZ = (xzOccluded || (xOccluded && zOccluded)) ? PackedCol_Scale(orig, FANCY_AO) : Builder_LightYMin(ctx, x + oX, y, z + oZ);
 
 	PackedCol ab = AVERAGE(CoX, CoZ);
 	PackedCol cd = AVERAGE(CoXoZ, orig);
 	return AVERAGE(ab, cd);
 }
-static void Modern_DrawYMin(int count, int x, int y, int z) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_YMIN);
+static void Modern_DrawYMin(struct BuilderContext* ctx, int count, int x, int y, int z) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_YMIN);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.x, u2 = (count - 1) + adv_maxBB.x * UV2_Scale;
-	float v1 = vOrigin + adv_minBB.z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.x, u2 = (count - 1) + ctx->maxBB.x * UV2_Scale;
+	float v1 = vOrigin + ctx->minBB.z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	int offset = 1;// (Blocks.LightOffset[Builder_Block] >> FACE_YMIN) & 1;
-	PackedCol orig = Lighting.Color_YMin_Fast(x, y-offset, z);
-	PackedCol col0_0 = Builder_FullBright ? white : Modern_GetColorYMin(orig, x, y-offset, z, -1, -1);
-	PackedCol col1_0 = Builder_FullBright ? white : Modern_GetColorYMin(orig, x, y-offset, z,  1, -1);
-	PackedCol col1_1 = Builder_FullBright ? white : Modern_GetColorYMin(orig, x, y-offset, z,  1,  1);
-	PackedCol col0_1 = Builder_FullBright ? white : Modern_GetColorYMin(orig, x, y-offset, z, -1,  1);
+	int offset = 1;// (Blocks.LightOffset[ctx->block] >> FACE_YMIN) & 1;
+	PackedCol orig = Builder_LightYMin(ctx, x, y-offset, z);
+	PackedCol col0_0 = ctx->fullBright ? white : Modern_GetColorYMin(ctx, orig, x, y-offset, z, -1, -1);
+	PackedCol col1_0 = ctx->fullBright ? white : Modern_GetColorYMin(ctx, orig, x, y-offset, z,  1, -1);
+	PackedCol col1_1 = ctx->fullBright ? white : Modern_GetColorYMin(ctx, orig, x, y-offset, z,  1,  1);
+	PackedCol col0_1 = ctx->fullBright ? white : Modern_GetColorYMin(ctx, orig, x, y-offset, z, -1,  1);
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_YMIN];
-	v.y = adv_y1;
-		v.x = adv_x1;               v.z = adv_z2; v.U = u1; v.V = v2; v.Col = col0_1; *vertices++ = v;
-		                            v.z = adv_z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
-		                            v.z = adv_z2;           v.V = v2; v.Col = col1_1; *vertices++ = v;
+	v.y = ctx->y1;
+		v.x = ctx->x1;               v.z = ctx->z2; v.U = u1; v.V = v2; v.Col = col0_1; *vertices++ = v;
+		                            v.z = ctx->z1;           v.V = v1; v.Col = col0_0; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_0; *vertices++ = v;
+		                            v.z = ctx->z2;           v.V = v2; v.Col = col1_1; *vertices++ = v;
 	part->faces.vertices[FACE_YMIN] = vertices;
 }
 
-static PackedCol Modern_GetColorYMax(PackedCol orig, int x, int y, int z, int oX, int oZ) {
+static PackedCol Modern_GetColorYMax(struct BuilderContext* ctx, PackedCol orig, int x, int y, int z, int oX, int oZ) {
 	cc_bool xOccluded  = Modern_IsOccluded(x + oX, y, z     );
 	cc_bool zOccluded  = Modern_IsOccluded(x,      y, z + oZ);
 	cc_bool xzOccluded = Modern_IsOccluded(x + oX, y, z + oZ);
 
-	PackedCol CoX   =                                xOccluded ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color(x + oX, y, z     );
-	PackedCol CoZ   =                                zOccluded ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color(x     , y, z + oZ);
-	PackedCol CoXoZ = (xzOccluded || (xOccluded && zOccluded)) ? PackedCol_Scale(orig, FANCY_AO) : Lighting.Color(x + oX, y, z + oZ);
+	PackedCol CoX   =                                xOccluded ? PackedCol_Scale(orig, FANCY_AO) : Builder_LightColor(ctx, x + oX, y, z     );
+	PackedCol CoZ   =                                zOccluded ? PackedCol_Scale(orig, FANCY_AO) : Builder_LightColor(ctx, x     , y, z + oZ);
+	PackedCol CoXoZ = (xzOccluded || (xOccluded && zOccluded)) ? PackedCol_Scale(orig, FANCY_AO) : Builder_LightColor(ctx, x + oX, y, z + oZ);
 
 	PackedCol ab = AVERAGE(CoX, CoZ);
 	PackedCol cd = AVERAGE(CoXoZ, orig);
 	return AVERAGE(ab, cd);
 }
-static void Modern_DrawYMax(int count, int x, int y, int z) {
-	TextureLoc texLoc = Block_Tex(Builder_Block, FACE_YMAX);
+static void Modern_DrawYMax(struct BuilderContext* ctx, int count, int x, int y, int z) {
+	TextureLoc texLoc = Block_Tex(ctx->block, FACE_YMAX);
 	float vOrigin = Atlas1D_RowId(texLoc) * Atlas1D.InvTileSize;
 
-	float u1 = adv_minBB.x, u2 = (count - 1) + adv_maxBB.x * UV2_Scale;
-	float v1 = vOrigin + adv_minBB.z * Atlas1D.InvTileSize;
-	float v2 = vOrigin + adv_maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
-	struct Builder1DPart* part = &Builder_Parts[adv_baseOffset + Atlas1D_Index(texLoc)];
+	float u1 = ctx->minBB.x, u2 = (count - 1) + ctx->maxBB.x * UV2_Scale;
+	float v1 = vOrigin + ctx->minBB.z * Atlas1D.InvTileSize;
+	float v2 = vOrigin + ctx->maxBB.z * Atlas1D.InvTileSize * UV2_Scale;
+	struct Builder1DPart* part = &ctx->parts[ctx->baseOffset + Atlas1D_Index(texLoc)];
 
 	PackedCol tint, white = PACKEDCOL_WHITE;
-	int offset = 1;// (Blocks.LightOffset[Builder_Block] >> FACE_YMAX) & 1;
-	PackedCol orig = Lighting.Color(x, y+offset, z);
-	PackedCol col0_0 = Builder_FullBright ? white : Modern_GetColorYMax(orig, x, y+offset, z, -1, -1);
-	PackedCol col1_0 = Builder_FullBright ? white : Modern_GetColorYMax(orig, x, y+offset, z,  1, -1);
-	PackedCol col1_1 = Builder_FullBright ? white : Modern_GetColorYMax(orig, x, y+offset, z,  1,  1);
-	PackedCol col0_1 = Builder_FullBright ? white : Modern_GetColorYMax(orig, x, y+offset, z, -1,  1);
+	int offset = 1;// (Blocks.LightOffset[ctx->block] >> FACE_YMAX) & 1;
+	PackedCol orig = Builder_LightColor(ctx, x, y+offset, z);
+	PackedCol col0_0 = ctx->fullBright ? white : Modern_GetColorYMax(ctx, orig, x, y+offset, z, -1, -1);
+	PackedCol col1_0 = ctx->fullBright ? white : Modern_GetColorYMax(ctx, orig, x, y+offset, z,  1, -1);
+	PackedCol col1_1 = ctx->fullBright ? white : Modern_GetColorYMax(ctx, orig, x, y+offset, z,  1,  1);
+	PackedCol col0_1 = ctx->fullBright ? white : Modern_GetColorYMax(ctx, orig, x, y+offset, z, -1,  1);
 
 	struct VertexTextured* vertices, v;
 
-	if (adv_tinted) {
-		tint   = Blocks.FogCol[Builder_Block];
+	if (ctx->tinted) {
+		tint   = Blocks.FogCol[ctx->block];
 		col0_0 = PackedCol_Tint(col0_0, tint); col1_0 = PackedCol_Tint(col1_0, tint);
 		col1_1 = PackedCol_Tint(col1_1, tint); col0_1 = PackedCol_Tint(col0_1, tint);
 	}
 
 	vertices = part->faces.vertices[FACE_YMAX];
-	v.y = adv_y2;
-		v.x = adv_x1;               v.z = adv_z1; v.U = u1; v.V = v1; v.Col = col0_0; *vertices++ = v;
-		                            v.z = adv_z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
-		v.x = adv_x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
-		                            v.z = adv_z1;           v.V = v1; v.Col = col1_0; *vertices++ = v;
+	v.y = ctx->y2;
+		v.x = ctx->x1;               v.z = ctx->z1; v.U = u1; v.V = v1; v.Col = col0_0; *vertices++ = v;
+		                            v.z = ctx->z2;           v.V = v2; v.Col = col0_1; *vertices++ = v;
+		v.x = ctx->x2 + (count - 1);               v.U = u2;           v.Col = col1_1; *vertices++ = v;
+		                            v.z = ctx->z1;           v.V = v1; v.Col = col1_0; *vertices++ = v;
 	part->faces.vertices[FACE_YMAX] = vertices;
 }
 
-static void Modern_RenderBlock(int index, int x, int y, int z) {
+static void Modern_RenderBlock(struct BuilderContext* ctx, int index, int x, int y, int z) {
 	Vec3 min, max;
 	int count_XMin, count_XMax, count_ZMin;
 	int count_ZMax, count_YMin, count_YMax;
 
-	if (Blocks.Draw[Builder_Block] == DRAW_SPRITE) {
-		Builder_DrawSprite(x, y, z); return;
+	if (Blocks.Draw[ctx->block] == DRAW_SPRITE) {
+		Builder_DrawSprite(ctx, x, y, z); return;
 	}
 
-	count_XMin = Builder_Counts[index + FACE_XMIN];
-	count_XMax = Builder_Counts[index + FACE_XMAX];
-	count_ZMin = Builder_Counts[index + FACE_ZMIN];
-	count_ZMax = Builder_Counts[index + FACE_ZMAX];
-	count_YMin = Builder_Counts[index + FACE_YMIN];
-	count_YMax = Builder_Counts[index + FACE_YMAX];
+	count_XMin = ctx->counts[index + FACE_XMIN];
+	count_XMax = ctx->counts[index + FACE_XMAX];
+	count_ZMin = ctx->counts[index + FACE_ZMIN];
+	count_ZMax = ctx->counts[index + FACE_ZMAX];
+	count_YMin = ctx->counts[index + FACE_YMIN];
+	count_YMax = ctx->counts[index + FACE_YMAX];
 
 	if (!count_XMin && !count_XMax && !count_ZMin &&
 		!count_ZMax && !count_YMin && !count_YMax) return;
 
-	Builder_FullBright = Blocks.Brightness[Builder_Block];
-	adv_baseOffset = (Blocks.Draw[Builder_Block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
-	adv_tinted = Blocks.Tinted[Builder_Block];
+	ctx->fullBright = Blocks.Brightness[ctx->block];
+	ctx->baseOffset = (Blocks.Draw[ctx->block] == DRAW_TRANSLUCENT) * ATLAS1D_MAX_ATLASES;
+	ctx->tinted = Blocks.Tinted[ctx->block];
 
-	min = Blocks.RenderMinBB[Builder_Block]; max = Blocks.RenderMaxBB[Builder_Block];
-	adv_x1 = x + min.x; adv_y1 = y + min.y; adv_z1 = z + min.z;
-	adv_x2 = x + max.x; adv_y2 = y + max.y; adv_z2 = z + max.z;
+	min = Blocks.RenderMinBB[ctx->block]; max = Blocks.RenderMaxBB[ctx->block];
+	ctx->x1 = x + min.x; ctx->y1 = y + min.y; ctx->z1 = z + min.z;
+	ctx->x2 = x + max.x; ctx->y2 = y + max.y; ctx->z2 = z + max.z;
 
-	adv_minBB = Blocks.MinBB[Builder_Block]; adv_maxBB = Blocks.MaxBB[Builder_Block];
-	adv_minBB.y = 1.0f - adv_minBB.y; adv_maxBB.y = 1.0f - adv_maxBB.y;
+	ctx->minBB = Blocks.MinBB[ctx->block]; ctx->maxBB = Blocks.MaxBB[ctx->block];
+	ctx->minBB.y = 1.0f - ctx->minBB.y; ctx->maxBB.y = 1.0f - ctx->maxBB.y;
 
-	if (count_XMin) Modern_DrawXMin(count_XMin, x, y, z);
-	if (count_XMax) Modern_DrawXMax(count_XMax, x, y, z);
-	if (count_ZMin) Modern_DrawZMin(count_ZMin, x, y, z);
-	if (count_ZMax) Modern_DrawZMax(count_ZMax, x, y, z);
-	if (count_YMin) Modern_DrawYMin(count_YMin, x, y, z);
-	if (count_YMax) Modern_DrawYMax(count_YMax, x, y, z);
+	if (count_XMin) Modern_DrawXMin(ctx, count_XMin, x, y, z);
+	if (count_XMax) Modern_DrawXMax(ctx, count_XMax, x, y, z);
+	if (count_ZMin) Modern_DrawZMin(ctx, count_ZMin, x, y, z);
+	if (count_ZMax) Modern_DrawZMax(ctx, count_ZMax, x, y, z);
+	if (count_YMin) Modern_DrawYMin(ctx, count_YMin, x, y, z);
+	if (count_YMax) Modern_DrawYMax(ctx, count_YMax, x, y, z);
 }
 
-static void Modern_PrePrepareChunk(void) {
-	DefaultPrePrepateChunk();
-	adv_bitFlags = Builder_BitFlags;
+static void Modern_PrePrepareChunk(struct BuilderContext* ctx) {
+	DefaultPrePrepateChunk(ctx);
 }
 
 static void ModernBuilder_SetActive(void) {
@@ -1625,11 +2732,773 @@ static void ModernBuilder_SetActive(void) {
 static void ModernBuilder_SetActive(void) { NormalBuilder_SetActive(); }
 #endif
 
+/*########################################################################################################################*
+*-----------------------------------------------Incremental mesh building-------------------------------------------------*
+*#########################################################################################################################*/
+int Builder_PatchedChunks;
+#ifndef CC_BUILD_LOWMEM
+#define BUILDER_MAX_EDITED 16
+/* Number of runs of vertices in each part of a chunk mesh (4 for sprites, then 1 per face) */
+#define PATCH_STREAMS (4 + FACE_COUNT)
+#define PATCH_SPRITE_STREAMS 4
+/* Parts are ordered normal, translucent, normal, translucent.. in a chunk mesh */
+#define Patch_PartIndex(slot) (((slot) & 1) * ATLAS1D_MAX_ATLASES + ((slot) >> 1))
+
+/* Copy of the mesh of a recently edited chunk, along with the blocks and lighting used to build it */
+/* NOTE: Within each run of vertices, vertices are ordered by the layer of blocks they came from, */
+/*  so the vertices of layers that didn't change can just be copied from the previous mesh */
+struct EditedChunk {
+	struct ChunkInfo* info;
+	cc_uint32 lastUsed;
+	int slots;
+	struct VertexTextured* vertices;
+	/* Number of vertices in each run of vertices, per layer of blocks */
+	cc_uint16* counts;
+	cc_uint16* newCounts;
+	/* Offset of each run of vertices in the mesh */
+	int* starts;
+	BlockID blocks[EXTCHUNK_SIZE_3];
+	int heights[EXTCHUNK_SIZE_2];
+};
+static CC_BIG_VAR struct EditedChunk editedChunks[BUILDER_MAX_EDITED];
+static cc_uint32 editedTime;
+
+static void EditedChunk_Free(struct EditedChunk* e) {
+	Mem_Free(e->vertices);
+	Mem_Free(e->counts);
+	Mem_Free(e->starts);
+
+	e->info     = NULL;
+	e->vertices = NULL;
+	e->counts   = NULL;
+	e->starts   = NULL;
+}
+
+static struct EditedChunk* EditedChunk_Find(struct ChunkInfo* info) {
+	int i;
+	for (i = 0; i < BUILDER_MAX_EDITED; i++) 
+	{
+		if (editedChunks[i].info == info) return &editedChunks[i];
+	}
+	return NULL;
+}
+
+/* Reuses the least recently used entry to store the mesh of the given chunk */
+static struct EditedChunk* EditedChunk_Alloc(struct ChunkInfo* info) {
+	struct EditedChunk* e = &editedChunks[0];
+	int i, slots = MapRenderer_1DUsedCount * 2;
+
+	for (i = 1; i < BUILDER_MAX_EDITED; i++) 
+	{
+		if (editedChunks[i].lastUsed < e->lastUsed) e = &editedChunks[i];
+	}
+	EditedChunk_Free(e);
+
+	e->counts = (cc_uint16*)Mem_TryAlloc(slots * PATCH_STREAMS * CHUNK_SIZE * 2, sizeof(cc_uint16));
+	e->starts = (int*)Mem_TryAlloc(slots * PATCH_STREAMS, sizeof(int));
+	if (!e->counts || !e->starts) { EditedChunk_Free(e); return NULL; }
+
+	e->newCounts = e->counts + slots * PATCH_STREAMS * CHUNK_SIZE;
+	e->info      = info;
+	e->slots     = slots;
+	return e;
+}
+
+static void DropEditedChunk(struct ChunkInfo* info) {
+	struct EditedChunk* e = EditedChunk_Find(info);
+	if (e) EditedChunk_Free(e);
+}
+
+static void DropEditedChunks(void) {
+	int i;
+	for (i = 0; i < BUILDER_MAX_EDITED; i++) 
+	{
+		EditedChunk_Free(&editedChunks[i]);
+	}
+}
+
+static void Patch_ReadHeights(int* heights, int x1, int z1) {
+	int x, z, i = 0;
+	for (z = z1 - 1; z <= z1 + CHUNK_SIZE; z++) {
+		for (x = x1 - 1; x <= x1 + CHUNK_SIZE; x++, i++) {
+			heights[i] = World_ContainsXZ(x, z) ? ClassicLighting_GetLightHeight(x, z) : 0;
+		}
+	}
+}
+
+/* Returns a bit mask of the layers of blocks in the chunk whose vertices may have changed */
+static int Patch_DirtyLayers(struct EditedChunk* e, struct BuilderContext* ctx, const int* heights, int y1) {
+	int dirty = 0, i, y, minY, maxY;
+
+	/* Faces in a layer can be hidden by the blocks in the layers above and below it */
+	for (i = 0; i < EXTCHUNK_SIZE; i++) 
+	{
+		if (Mem_Equal(&e->blocks[i * EXTCHUNK_SIZE_2], &ctx->chunk[i * EXTCHUNK_SIZE_2], EXTCHUNK_SIZE_2 * sizeof(BlockID))) continue;
+		dirty |= (7 << i) >> 2;
+	}
+
+	/* Faces in a layer are also lit using the light in the layers above and below it */
+	for (i = 0; i < EXTCHUNK_SIZE_2; i++) 
+	{
+		if (e->heights[i] == heights[i]) continue;
+		minY = min(e->heights[i], heights[i]) - 1 - y1;
+		maxY = max(e->heights[i], heights[i]) + 2 - y1;
+
+		for (y = max(minY, 0); y <= min(maxY, CHUNK_MAX); y++) { dirty |= 1 << y; }
+	}
+	return dirty;
+}
+
+/* Calculates how many vertices each changed layer of blocks has, then the total for the whole chunk */
+static void Patch_CountLayers(struct BuilderContext* ctx, struct EditedChunk* e, int x1, int y1, int z1, int dirty) {
+	int layers = min(World.Height - y1, CHUNK_SIZE);
+	struct Builder1DPart* part;
+	int slot, i, j, yy, total;
+
+	Mem_Set(ctx->counts, 1, CHUNK_SIZE_3 * FACE_COUNT);
+	ctx->chunkEndX = min(World.Width,  x1 + CHUNK_SIZE);
+	ctx->chunkEndZ = min(World.Length, z1 + CHUNK_SIZE);
+
+	for (yy = 0; yy < CHUNK_SIZE; yy++) 
+	{
+		if (!(dirty & (1 << yy)) || yy >= layers) {
+			for (i = 0; i < e->slots * PATCH_STREAMS; i++) 
+			{
+				j = i * CHUNK_SIZE + yy;
+				e->newCounts[j] = yy < layers ? e->counts[j] : 0;
+			}
+			continue;
+		}
+		PrepareLayer(ctx, x1, y1 + yy, z1);
+
+		/* Part counts are reset after each layer, so they only contain the counts for this layer */
+		for (slot = 0; slot < e->slots; slot++) 
+		{
+			part = &ctx->parts[Patch_PartIndex(slot)];
+			j    = slot * PATCH_STREAMS * CHUNK_SIZE + yy;
+
+			for (i = 0; i < PATCH_SPRITE_STREAMS; i++, j += CHUNK_SIZE) 
+			{
+				e->newCounts[j] = part->sCount / PATCH_SPRITE_STREAMS;
+			}
+			for (i = 0; i < FACE_COUNT; i++, j += CHUNK_SIZE) 
+			{
+				e->newCounts[j] = part->faces.count[i];
+				part->faces.count[i] = 0;
+			}
+			part->sCount = 0;
+		}
+	}
+
+	for (slot = 0; slot < e->slots; slot++) 
+	{
+		part = &ctx->parts[Patch_PartIndex(slot)];
+		for (i = 0; i < PATCH_STREAMS; i++) 
+		{
+			j = (slot * PATCH_STREAMS + i) * CHUNK_SIZE;
+			for (yy = 0, total = 0; yy < CHUNK_SIZE; yy++) { total += e->newCounts[j + yy]; }
+
+			if (i < PATCH_SPRITE_STREAMS) {
+				part->sCount += total;
+			} else {
+				part->faces.count[i - PATCH_SPRITE_STREAMS] = total;
+			}
+		}
+	}
+}
+
+/* Copies the vertices of unchanged layers from the previous mesh into the new mesh */
+static void Patch_CopyLayers(struct EditedChunk* e, struct VertexTextured* vertices, int dirty) {
+	int i, yy, count, newPos = 0, oldPos = 0;
+
+	for (i = 0; i < e->slots * PATCH_STREAMS; i++) 
+	{
+		e->starts[i] = newPos;
+		for (yy = 0; yy < CHUNK_SIZE; yy++) 
+		{
+			count = e->newCounts[i * CHUNK_SIZE + yy];
+			if (!(dirty & (1 << yy))) {
+				Mem_Copy(&vertices[newPos], &e->vertices[oldPos], count * sizeof(struct VertexTextured));
+			}
+
+			newPos += count;
+			if (e->vertices) oldPos += e->counts[i * CHUNK_SIZE + yy];
+		}
+	}
+}
+
+static int Patch_LayerStart(struct EditedChunk* e, int stream, int layer) {
+	int yy, offset = e->starts[stream];
+	for (yy = 0; yy < layer; yy++) { offset += e->newCounts[stream * CHUNK_SIZE + yy]; }
+	return offset;
+}
+
+/* Writes the vertices of the changed layers into the new mesh */
+static void Patch_RenderLayers(struct BuilderContext* ctx, struct EditedChunk* e, int x1, int y1, int z1, int dirty) {
+	int layers = min(World.Height - y1, CHUNK_SIZE);
+	struct Builder1DPart* part;
+	int slot, i, yy, stream;
+
+	for (yy = 0; yy < layers; yy++) 
+	{
+		if (!(dirty & (1 << yy))) continue;
+
+		for (slot = 0; slot < e->slots; slot++) 
+		{
+			part   = &ctx->parts[Patch_PartIndex(slot)];
+			stream = slot * PATCH_STREAMS;
+			/* Builder_DrawSprite writes to the other sprite runs relative to sOffset */
+			part->sOffset = Patch_LayerStart(e, stream, yy);
+
+			for (i = 0; i < FACE_COUNT; i++) 
+			{
+				part->faces.vertices[i] = &ctx->vertices[Patch_LayerStart(e, stream + PATCH_SPRITE_STREAMS + i, yy)];
+			}
+		}
+		RenderLayer(ctx, x1, y1 + yy, z1);
+	}
+}
+
+/* Number of vertices saved by merging faces together in the changed layers */
+static int Patch_MergedVertices(struct BuilderContext* ctx, int dirty) {
+	int i, yy, faces = 0, quads = 0;
+
+	for (yy = 0; yy < CHUNK_SIZE; yy++) 
+	{
+		if (!(dirty & (1 << yy))) continue;
+
+		for (i = yy * CHUNK_SIZE_2 * FACE_COUNT; i < (yy + 1) * CHUNK_SIZE_2 * FACE_COUNT; i++) 
+		{
+			if (!ctx->counts[i]) continue;
+			faces += ctx->counts[i]; quads++;
+		}
+	}
+	return (faces - quads) * 4;
+}
+
+/* Returns false if the chunk's mesh couldn't be built and so must be built using Builder_MakeChunk instead */
+static cc_bool Patch_Chunk(struct BuilderContext* ctx, struct EditedChunk* e, struct ChunkInfo* info) {
+	int x1 = info->centreX - 8, y1 = info->centreY - 8, z1 = info->centreZ - 8;
+	struct VertexTextured* vertices;
+	int heights[EXTCHUNK_SIZE_2];
+	cc_bool allAir, needsMesh;
+	int dirty, totalVerts;
+	cc_uint16* counts;
+
+	Builder_PrePrepareChunk(ctx);
+	needsMesh    = ReadChunk(ctx, info, &allAir);
+	info->allAir = allAir;
+	/* Chunk has no mesh, so there's nothing for later rebuilds to reuse */
+	if (!needsMesh) {
+		info->connectivity = allAir ? CHUNK_CONNECTED_ALL : 0;
+		EditedChunk_Free(e); return true;
+	}
+
+	info->connectivity = CalcConnectivity(ctx);
+	Lighting.LightHint(x1 - 1, y1 - 1, z1 - 1);
+	Patch_ReadHeights(heights, x1, z1);
+
+	/* Chunk's previous mesh isn't known, so every layer has to be built */
+	dirty = e->vertices ? Patch_DirtyLayers(e, ctx, heights, y1) : 0xFFFF;
+	Patch_CountLayers(ctx, e, x1, y1, z1, dirty);
+
+	totalVerts = Builder_TotalVerticesCount(ctx);
+	if (!totalVerts) { EditedChunk_Free(e); return true; }
+	OutputChunkPartsMeta(ctx, info);
+
+	vertices = (struct VertexTextured*)Mem_TryAlloc(totalVerts, sizeof(struct VertexTextured));
+	if (!vertices) { EditedChunk_Free(e); return false; }
+	ctx->vertices = vertices;
+
+	Patch_CopyLayers(e, vertices, dirty);
+	Patch_RenderLayers(ctx, e, x1, y1, z1, dirty);
+
+#if CC_GFX_BACKEND == CC_GFX_BACKEND_GL11
+	BuildChunkVbs(vertices, info);
+#else
+	UploadChunkVb(info, vertices, totalVerts);
+#endif
+
+	if (e->vertices) Builder_PatchedChunks++;
+	Builder_MeshVertices     += totalVerts;
+	Builder_UnmergedVertices += totalVerts + Patch_MergedVertices(ctx, dirty);
+
+	Mem_Free(e->vertices);
+	e->vertices  = vertices;
+	counts       = e->counts;
+	e->counts    = e->newCounts;
+	e->newCounts = counts;
+
+	Mem_Copy(e->blocks,  ctx->chunk, sizeof(e->blocks));
+	Mem_Copy(e->heights, heights,    sizeof(e->heights));
+	return true;
+}
+
+cc_bool Builder_RemakeChunk(struct ChunkInfo* info) {
+	struct BuilderContext* ctx = &mainCtx;
+	struct EditedChunk* e;
+#if CC_BUILD_MAXSTACK <= (32 * 1024)
+	void* mem        = TempMem_Alloc((EXTCHUNK_SIZE_3 * sizeof(BlockID)) + (CHUNK_SIZE_3 * FACE_COUNT));
+	BlockID* chunk   = (BlockID*)mem;
+	cc_uint8* counts = (cc_uint8*)(chunk + EXTCHUNK_SIZE_3);
+#else
+	BlockID chunk[EXTCHUNK_SIZE_3]; 
+	cc_uint8 counts[CHUNK_SIZE_3 * FACE_COUNT]; 
+#endif
+
+#ifdef CC_BUILD_ADVLIGHTING
+	int bitFlags[EXTCHUNK_SIZE_3];
+#else
+	int bitFlags[1];
+#endif
+	/* Changed layers are found by comparing blocks and the classic lighting heightmap */
+	if (Lighting_Mode != LIGHTING_MODE_CLASSIC) return false;
+	/* A changed block can change the downsampled blocks of a whole cell */
+	if (Lod_Needed(info)) return false;
+	/* Faces merged across layers can't be rebuilt one layer at a time */
+	if (Builder_MergeFaces) return false;
+
+	e = EditedChunk_Find(info);
+	if (e && e->slots != MapRenderer_1DUsedCount * 2) { EditedChunk_Free(e); e = NULL; }
+	if (!e) e = EditedChunk_Alloc(info);
+	if (!e) return false;
+	e->lastUsed = ++editedTime;
+
+	ctx->chunk    = chunk;
+	ctx->counts   = counts;
+	ctx->bitFlags = bitFlags;
+	return Patch_Chunk(ctx, e, info);
+}
+#else
+cc_bool Builder_RemakeChunk(struct ChunkInfo* info) { return false; }
+
+static void DropEditedChunk(struct ChunkInfo* info) { }
+static void DropEditedChunks(void) { }
+#endif
+
+/*########################################################################################################################*
+*------------------------------------------------Background mesh building-------------------------------------------------*
+*#########################################################################################################################*/
+#if !defined CC_BUILD_COOPTHREADED && !defined CC_BUILD_LOWMEM
+#define BUILDER_MAX_WORKERS 16
+/* Same as maximum value of the max chunk updates option */
+#define BUILDER_MAX_JOBS 1024
+
+/* Jobs are run in two passes: first the chunk is read to work out whether it needs a mesh, */
+/*  then after lighting has been calculated for the chunk on the main thread, its mesh is built */
+#define JOBS_PASS_CLASSIFY 0
+#define JOBS_PASS_MESH     1
+
+struct BuilderJob {
+	struct ChunkInfo* info;
+	struct VertexTextured* vertices;
+	/* Layout of the parts of the chunk's mesh (see CalcPartsMeta) */
+	struct ChunkPartMeta* parts;
+	/* Light colours around the chunk, or NULL when lighting can be read on background threads */
+	struct LightSnapshot* light;
+	int totalVerts, unmergedVerts, partsCount;
+	cc_uint8 pass;
+	cc_bool inUse, needsMesh, allAir, cacheable;
+	/* Whether the chunk was changed after it was queued, so the built mesh must be thrown away */
+	/* NOTE: Guarded by jobsMutex, as worker threads skip running cancelled jobs */
+	cc_bool cancelled;
+	/* Whether the mesh couldn't be built on a background thread, so must be built on the main thread */
+	cc_bool failed;
+	cc_uint32 connectivity;
+	/* Key and offset in the mesh cache of the chunk's mesh (offset is 0 if not cached) */
+	cc_uint64 cacheKey;
+	cc_uint32 cacheOffset;
+};
+
+struct BuilderWorker {
+	struct BuilderContext ctx;
+	BlockID chunk[EXTCHUNK_SIZE_3];
+	cc_uint8 counts[CHUNK_SIZE_3 * FACE_COUNT];
+#ifdef CC_BUILD_ADVLIGHTING
+	int bitFlags[EXTCHUNK_SIZE_3];
+#else
+	int bitFlags[1];
+#endif
+	void* thread;
+	void* waitable;
+};
+
+/* Queue of indices into the jobs array */
+struct JobsQueue { int head, count; cc_uint16 items[BUILDER_MAX_JOBS]; };
+
+static struct BuilderJob jobs[BUILDER_MAX_JOBS];
+/* Indices of the jobs not currently in use (only used on the main thread) */
+static cc_uint16 jobsFree[BUILDER_MAX_JOBS];
+static int jobsFreeCount;
+/* Jobs waiting to be run by worker threads, and jobs that worker threads have finished running */
+static struct JobsQueue jobsPending, jobsFinished;
+static struct BuilderWorker* workers[BUILDER_MAX_WORKERS];
+static int workersCount, workersStarted, workersBusy;
+static cc_bool workersStop;
+/* Guards the job queues, workersBusy and workersStop */
+static void* jobsMutex;
+static void* jobsDone;
+
+static void JobsQueue_Push(struct JobsQueue* queue, int i) {
+	queue->items[(queue->head + queue->count) % BUILDER_MAX_JOBS] = i;
+	queue->count++;
+}
+
+/* Returns the index of the oldest job in the queue, or -1 if the queue is empty */
+static int JobsQueue_Pop(struct JobsQueue* queue) {
+	int i;
+	if (!queue->count) return -1;
+
+	i = queue->items[queue->head];
+	queue->head = (queue->head + 1) % BUILDER_MAX_JOBS;
+	queue->count--;
+	return i;
+}
+
+/* Copies the light colours of the blocks in and bordering the given chunk */
+static struct LightSnapshot* LightSnapshot_Take(struct ChunkInfo* info) {
+	struct LightSnapshot* s = (struct LightSnapshot*)Mem_TryAlloc(1, sizeof(struct LightSnapshot));
+	int x, y, z, i = 0;
+	if (!s) return NULL;
+
+	s->x = info->centreX - 9; s->y = info->centreY - 9; s->z = info->centreZ - 9;
+	for (y = s->y; y < s->y + EXTCHUNK_SIZE; y++)
+		for (z = s->z; z < s->z + EXTCHUNK_SIZE; z++)
+			for (x = s->x; x < s->x + EXTCHUNK_SIZE; x++, i++)
+	{
+		s->top[i]    = Lighting.Color_YMax_Fast(x, y, z);
+		s->bottom[i] = Lighting.Color_YMin_Fast(x, y, z);
+		s->xSide[i]  = Lighting.Color_XSide_Fast(x, y, z);
+		s->zSide[i]  = Lighting.Color_ZSide_Fast(x, y, z);
+	}
+	return s;
+}
+
+static void ClassifyJob(struct BuilderContext* ctx, struct BuilderJob* job) {
+	job->needsMesh = ReadChunk(ctx, job->info, &job->allAir);
+	if (job->needsMesh) {
+		job->connectivity = CalcConnectivity(ctx);
+	} else {
+		job->connectivity = job->allAir ? CHUNK_CONNECTED_ALL : 0;
+	}
+}
+
+/* NOTE: Runs on worker threads, so must not modify any state besides the job's */
+static void RunJob(struct BuilderContext* ctx, struct BuilderJob* job) {
+	cc_bool allAir;
+	if (job->pass == JOBS_PASS_CLASSIFY) { ClassifyJob(ctx, job); return; }
+
+	ctx->light = job->light;
+	Builder_PrePrepareChunk(ctx);
+	ReadChunk(ctx, job->info, &allAir);
+	if (Lod_Needed(job->info)) DownsampleChunk(ctx, job->info);
+
+	/* Cache lookups are guarded by cacheMutex, so are safe to do on worker threads */
+	if (job->cacheable) {
+		job->cacheKey    = MeshCache_CalcKey(ctx, job->info);
+		job->cacheOffset = MeshCache_Find(job->cacheKey);
+		if (job->cacheOffset) return;
+	}
+	job->totalVerts = CountChunk(ctx, job->info);
+	if (!job->totalVerts) return;
+	job->unmergedVerts = ctx->unmergedVerts;
+	CalcPartsMeta(ctx, job->parts, job->partsCount);
+
+	/* add an extra element to fix crashing on some GPUs */
+	ctx->vertices = (struct VertexTextured*)Mem_TryAlloc(job->totalVerts + 1, sizeof(struct VertexTextured));
+	job->vertices = ctx->vertices;
+	/* Out of memory on background thread, so fallback to building on main thread */
+	if (!ctx->vertices) { job->failed = true; return; }
+	RenderChunk(ctx, job->info);
+}
+
+static void WorkerLoop(void) {
+	struct BuilderWorker* worker;
+	cc_bool cancelled, last;
+	int i;
+
+	Mutex_Lock(jobsMutex);
+	worker = workers[workersStarted++];
+	Mutex_Unlock(jobsMutex);
+
+	for (;;)
+	{
+		Mutex_Lock(jobsMutex);
+		if (workersStop) { Mutex_Unlock(jobsMutex); return; }
+
+		i = JobsQueue_Pop(&jobsPending);
+		if (i >= 0) { cancelled = jobs[i].cancelled; workersBusy++; }
+		Mutex_Unlock(jobsMutex);
+
+		/* Waitable_Wait may return spuriously, so always recheck */
+		if (i == -1) { Waitable_Wait(worker->waitable); continue; }
+		if (!cancelled) RunJob(&worker->ctx, &jobs[i]);
+
+		Mutex_Lock(jobsMutex);
+		JobsQueue_Push(&jobsFinished, i);
+		last = --workersBusy == 0;
+		Mutex_Unlock(jobsMutex);
+		if (last) Waitable_Signal(jobsDone);
+	}
+}
+
+static void SignalWorkers(void) {
+	int i;
+	for (i = 0; i < workersCount; i++)
+	{
+		Waitable_Signal(workers[i]->waitable);
+	}
+}
+
+static void FreeJob(int i) {
+	struct BuilderJob* job = &jobs[i];
+	Mem_Free(job->vertices);
+	Mem_Free(job->parts);
+	Mem_Free(job->light);
+
+	job->vertices = NULL;
+	job->parts    = NULL;
+	job->light    = NULL;
+	job->inUse    = false;
+	jobsFree[jobsFreeCount++] = i;
+}
+
+cc_bool Builder_QueueChunk(struct ChunkInfo* info) {
+	struct BuilderJob* job;
+	int i;
+	if (!jobsFreeCount) return false;
+
+	i   = jobsFree[jobsFreeCount - 1];
+	job = &jobs[i];
+	job->partsCount = MapRenderer_1DUsedCount * 2;
+	job->parts      = (struct ChunkPartMeta*)Mem_TryAlloc(job->partsCount, sizeof(struct ChunkPartMeta));
+	if (!job->parts) return false;
+
+	jobsFreeCount--;
+	DropEditedChunk(info);
+
+	job->info        = info;
+	job->pass        = JOBS_PASS_CLASSIFY;
+	job->inUse       = true;
+	job->cancelled   = false;
+	job->failed      = false;
+	job->totalVerts  = 0;
+	job->cacheable   = false;
+	job->cacheOffset = 0;
+
+	Mutex_Lock(jobsMutex);
+	JobsQueue_Push(&jobsPending, i);
+	Mutex_Unlock(jobsMutex);
+	SignalWorkers();
+	return true;
+}
+
+void Builder_CancelChunk(struct ChunkInfo* info) {
+	int i;
+	if (!workersCount) return;
+
+	Mutex_Lock(jobsMutex);
+	for (i = 0; i < BUILDER_MAX_JOBS; i++)
+	{
+		if (jobs[i].inUse && jobs[i].info == info) jobs[i].cancelled = true;
+	}
+	Mutex_Unlock(jobsMutex);
+}
+
+int Builder_PendingChunks(void) {
+	return workersCount ? BUILDER_MAX_JOBS - jobsFreeCount : 0;
+}
+
+void Builder_StopBackground(void) {
+	int i, busy;
+	if (!workersCount) return;
+
+	/* Jobs not started yet are instead built on the main thread when they're finished */
+	Mutex_Lock(jobsMutex);
+	while ((i = JobsQueue_Pop(&jobsPending)) >= 0)
+	{
+		jobs[i].failed = true;
+		JobsQueue_Push(&jobsFinished, i);
+	}
+	Mutex_Unlock(jobsMutex);
+
+	for (;;)
+	{
+		Mutex_Lock(jobsMutex);
+		busy = workersBusy;
+		Mutex_Unlock(jobsMutex);
+
+		if (!busy) break;
+		Waitable_Wait(jobsDone);
+	}
+}
+
+/* Lighting state can only be safely modified on the main thread, so is calculated for the chunk here */
+/* Returns false if the chunk's mesh must be built on the main thread instead */
+static cc_bool PrepareMeshJob(struct BuilderJob* job) {
+	struct ChunkInfo* info = job->info;
+	Lighting.LightHint(info->centreX - 9, info->centreY - 9, info->centreZ - 9);
+	job->cacheable = MeshCache_Update();
+
+	if (Builder_CopyLighting && !(job->light = LightSnapshot_Take(info))) return false;
+	job->pass = JOBS_PASS_MESH;
+	return true;
+}
+
+static void UploadJob(struct BuilderJob* job) {
+	struct ChunkInfo* info = job->info;
+	if (job->cacheOffset && !MeshCache_Load(job->cacheOffset, job->cacheKey, info)) {
+		Builder_MakeChunk(info); return;
+	}
+	if (!job->totalVerts) return;
+
+	ApplyPartsMeta(job->parts, job->partsCount, info);
+	Builder_MeshVertices     += job->totalVerts;
+	Builder_UnmergedVertices += job->unmergedVerts;
+
+#if CC_GFX_BACKEND != CC_GFX_BACKEND_GL11
+	UploadChunkVb(info, job->vertices, job->totalVerts);
+#else
+	BuildChunkVbs(job->vertices, info);
+#endif
+	if (job->cacheable) MeshCache_Store(job->cacheKey, info, job->parts, job->vertices, job->totalVerts);
+}
+
+static void FinishJob(struct BuilderJob* job, Builder_ReplaceCallback onReplace, Builder_ChunkCallback onBuilt) {
+	struct ChunkInfo* info = job->info;
+	cc_uint32 connectivity = info->connectivity;
+
+	onReplace(info);
+	if (job->failed) {
+		Builder_MakeChunk(info);
+	} else {
+		info->allAir       = job->allAir;
+		info->connectivity = job->connectivity;
+		UploadJob(job);
+	}
+	onBuilt(info, connectivity);
+}
+
+int Builder_FinishChunks(Builder_ReplaceCallback onReplace, Builder_ChunkCallback onBuilt) {
+	struct BuilderJob* job;
+	int i, built = 0, queued = 0;
+	if (!workersCount) return 0;
+
+	for (;;)
+	{
+		Mutex_Lock(jobsMutex);
+		i = JobsQueue_Pop(&jobsFinished);
+		Mutex_Unlock(jobsMutex);
+
+		if (i == -1) break;
+		job = &jobs[i];
+		if (job->cancelled) { FreeJob(i); continue; }
+
+		if (job->pass == JOBS_PASS_CLASSIFY && job->needsMesh && !job->failed) {
+			if (PrepareMeshJob(job)) {
+				Mutex_Lock(jobsMutex);
+				JobsQueue_Push(&jobsPending, i);
+				Mutex_Unlock(jobsMutex);
+				queued++; continue;
+			}
+			job->failed = true;
+		}
+
+		FinishJob(job, onReplace, onBuilt);
+		FreeJob(i);
+		built++;
+	}
+
+	if (queued) SignalWorkers();
+	return built;
+}
+
+static struct BuilderWorker* AllocWorker(void) {
+	struct BuilderWorker* worker = (struct BuilderWorker*)Mem_TryAllocCleared(1, sizeof(struct BuilderWorker));
+	if (!worker) return NULL;
+
+	worker->ctx.chunk    = worker->chunk;
+	worker->ctx.counts   = worker->counts;
+	worker->ctx.bitFlags = worker->bitFlags;
+	return worker;
+}
+
+static void InitWorkers(void) {
+	int i, count = Options_GetInt(OPT_BUILDER_THREADS, 0, BUILDER_MAX_WORKERS, 2);
+	if (!count) return;
+
+	jobsMutex = Mutex_Create("Builder jobs");
+	jobsDone  = Waitable_Create("Builder done");
+
+	for (i = 0; i < count; i++)
+	{
+		if (!(workers[i] = AllocWorker())) break;
+		workers[i]->waitable = Waitable_Create("Builder worker");
+	}
+	/* All workers must be allocated before starting any of the threads */
+	workersCount = i;
+
+	for (i = 0; i < BUILDER_MAX_JOBS; i++)
+	{
+		jobsFree[i] = BUILDER_MAX_JOBS - 1 - i;
+	}
+	jobsFreeCount = workersCount ? BUILDER_MAX_JOBS : 0;
+
+	for (i = 0; i < workersCount; i++)
+	{
+		Thread_Run(&workers[i]->thread, WorkerLoop, 128 * 1024, "Chunk builder");
+	}
+}
+
+static void FreeWorkers(void) {
+	int i;
+	if (!jobsMutex) return;
+
+	Mutex_Lock(jobsMutex);
+	workersStop = true;
+	Mutex_Unlock(jobsMutex);
+
+	for (i = 0; i < workersCount; i++)
+	{
+		Waitable_Signal(workers[i]->waitable);
+		Thread_Join(workers[i]->thread);
+		Waitable_Free(workers[i]->waitable);
+		Mem_Free(workers[i]);
+	}
+
+	for (i = 0; i < BUILDER_MAX_JOBS; i++)
+	{
+		if (jobs[i].inUse) FreeJob(i);
+	}
+
+	Mutex_Free(jobsMutex);
+	Waitable_Free(jobsDone);
+
+	jobsMutex     = NULL;
+	workersCount  = 0;
+	jobsFreeCount = 0;
+}
+#else
+cc_bool Builder_QueueChunk(struct ChunkInfo* info) { return false; }
+void Builder_CancelChunk(struct ChunkInfo* info) { }
+int  Builder_PendingChunks(void) { return 0; }
+void Builder_StopBackground(void) { }
+int  Builder_FinishChunks(Builder_ReplaceCallback onReplace, Builder_ChunkCallback onBuilt) { return 0; }
+
+static void InitWorkers(void) { }
+static void FreeWorkers(void) { }
+#endif
+
+
 /*########################################################################################################################*
 *---------------------------------------------------Builder interface-----------------------------------------------------*
 *#########################################################################################################################*/
-cc_bool Builder_SmoothLighting;
+cc_bool Builder_SmoothLighting, Builder_GreedyMeshing;
+int Builder_MeshVertices, Builder_UnmergedVertices;
 void Builder_ApplyActive(void) {
+	/* Meshes still being built would otherwise be built using a mix of old and new state */
+	Builder_StopBackground();
+
 	if (Builder_SmoothLighting) {
 		if (Lighting_Mode != LIGHTING_MODE_CLASSIC) {
 			ModernBuilder_SetActive();
@@ -1637,9 +3506,15 @@ void Builder_ApplyActive(void) {
 		else {
 			AdvBuilder_SetActive();
 		}
+	} else if (Builder_GreedyMeshing) {
+		GreedyBuilder_SetActive();
 	} else {
 		NormalBuilder_SetActive();
 	}
+
+	/* Non-classic lighting modes lazily calculate lighting when it is read */
+	Builder_CopyLighting = Lighting_Mode != LIGHTING_MODE_CLASSIC;
+	MeshCache_Invalidate(NULL);
 }
 
 static void OnInit(void) {
@@ -1651,18 +3526,33 @@ static void OnInit(void) {
 	Builder_Offsets[FACE_YMAX] =  EXTCHUNK_SIZE_2;
 
 	if (!Game_ClassicMode) Builder_SmoothLighting = Options_GetBool(OPT_SMOOTH_LIGHTING, false);
+	if (!Game_ClassicMode) Builder_GreedyMeshing  = Options_GetBool(OPT_GREEDY_MESHING,  false);
 	Builder_ApplyActive();
+	InitWorkers();
+	MeshCache_Init();
+}
+
+static void OnFree(void) {
+	FreeWorkers();
+	DropEditedChunks();
+	MeshCache_Free();
+}
+
+static void OnNewMap(void) {
+	DropEditedChunks();
 }
 
 static void OnNewMapLoaded(void) {
 	Builder_SidesLevel = max(0, Env_SidesHeight);
 	Builder_EdgeLevel  = max(0, Env.EdgeHeight);
+	MeshCache_Invalidate(NULL);
+	MeshCache_Open();
 }
 
 struct IGameComponent Builder_Component = {
 	OnInit, /* Init */
-	NULL, /* Free */
+	OnFree, /* Free */
 	NULL, /* Reset */
-	NULL, /* OnNewMap */
+	OnNewMap, /* OnNewMap */
 	OnNewMapLoaded /* OnNewMapLoaded */
 };
@@ -18,9 +18,43 @@ extern struct IGameComponent Builder_Component;
 extern int Builder_SidesLevel, Builder_EdgeLevel;
 /* Whether smooth/advanced lighting mesh builder is used. */
 extern cc_bool Builder_SmoothLighting;
+/* Whether greedy mesh builder is used. (merges faces of different blocks that look the same) */
+extern cc_bool Builder_GreedyMeshing;
+/* Number of vertices in the meshes built since these counters were last reset to 0, */
+/*  and the number of vertices those meshes would have if no faces were merged together */
+extern int Builder_MeshVertices, Builder_UnmergedVertices;
+/* Number of chunk rebuilds that only re-meshed the layers of blocks which changed */
+extern int Builder_PatchedChunks;
+/* Number of chunk meshes that were uploaded from the mesh cache instead of being built */
+extern int Builder_CachedChunks;
 
 /* Builds the mesh of vertices for the given chunk. */
 void Builder_MakeChunk(struct ChunkInfo* info);
+/* Builds the mesh of vertices for a chunk that needs rebuilding only because blocks in or near it changed. */
+/* A copy of the mesh is kept, so later rebuilds of the chunk only re-mesh the layers of blocks that changed. */
+/* Returns false if this isn't supported (caller should use Builder_MakeChunk instead) */
+cc_bool Builder_RemakeChunk(struct ChunkInfo* info);
+
+/* connectivity is what the connectivity of the chunk was before its mesh was built */
+typedef void (*Builder_ChunkCallback)(struct ChunkInfo* info, cc_uint32 connectivity);
+/* Called just before the current mesh of a chunk is replaced by the mesh built for it on background threads */
+typedef void (*Builder_ReplaceCallback)(struct ChunkInfo* info);
+/* Queues the given chunk to have its mesh built on background threads. */
+/* Returns false if the mesh cannot be built on background threads (caller should use Builder_MakeChunk instead) */
+/* NOTE: The chunk's current mesh should be kept until Builder_FinishChunks replaces it */
+cc_bool Builder_QueueChunk(struct ChunkInfo* info);
+/* Stops the mesh of the given queued chunk from being used (e.g. because the chunk changed after being queued) */
+void Builder_CancelChunk(struct ChunkInfo* info);
+/* Returns the number of queued chunks whose meshes haven't been finished yet */
+int  Builder_PendingChunks(void);
+/* Uploads the meshes of the queued chunks that background threads have finished building since the last call, */
+/*  calling onReplace and then onBuilt for each of those chunks. Returns the number of chunks finished. */
+/* NOTE: Does not wait for any other queued chunks, which are finished in later calls instead. */
+int  Builder_FinishChunks(Builder_ReplaceCallback onReplace, Builder_ChunkCallback onBuilt);
+/* Waits until background threads are no longer building any chunk meshes. */
+/* Queued chunks not yet started are instead built on the main thread by Builder_FinishChunks. */
+/* NOTE: Must be called before freeing any state that background threads read (e.g. world blocks) */
+void Builder_StopBackground(void);
 
 void Builder_ApplyActive(void);
 
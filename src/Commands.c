@@ -18,6 +18,13 @@
 #include "Options.h"
 #include "Drawer2D.h"
 #include "Audio.h"
+#include "Deflate.h"
+#include "Bitmap.h"
+#include "Stream.h"
+#include "Platform.h"
+#include "Errors.h"
+#include "Formats.h"
+#include "Constants.h"
 
 #define COMMANDS_PREFIX "/client"
 #define COMMANDS_PREFIX_SPACE "/client "
@@ -793,6 +800,291 @@ static struct ChatCommand BlockEditCommand = {
 };
 
 
+/* Reads all the data in the given file into memory, returning false on failure */
+static cc_bool Commands_ReadFile(const cc_string* path, cc_uint8** data, cc_uint32* len) {
+	struct Stream stream;
+	cc_result res;
+	*data = NULL;
+	*len  = 0;
+
+	res = Stream_OpenFile(&stream, path);
+	if (res) { Logger_SysWarn2(res, "opening", path); return false; }
+
+	res = stream.Length(&stream, len);
+	if (!res) {
+		*data = (cc_uint8*)Mem_TryAlloc(*len, 1);
+		res   = *data ? Stream_Read(&stream, *data, *len) : ERR_OUT_OF_MEMORY;
+	}
+	(void)stream.Close(&stream);
+
+	if (!res) return true;
+	Logger_SysWarn2(res, "reading", path);
+	Mem_Free(*data);
+	return false;
+}
+
+
+/*########################################################################################################################*
+*------------------------------------------------------InflateBench command-----------------------------------------------*
+*#########################################################################################################################*/
+#ifdef INFLATE_MULTI_BITS
+#define INFLATEBENCH_RUNS 3
+static cc_uint8 inflateBench_buffer[16384];
+static struct ZipEntry inflateBench_entries[1024];
+static cc_uint32 inflateBench_size;
+
+/* Reads all the data from the given stream, keeping track of how much was read */
+static cc_result InflateBench_Drain(struct Stream* s) {
+	cc_uint32 read;
+	cc_result res;
+
+	for (;;) {
+		res = s->Read(s, inflateBench_buffer, sizeof(inflateBench_buffer), &read);
+		if (res)   return res;
+		if (!read) return 0;
+		inflateBench_size += read;
+	}
+}
+
+static cc_bool InflateBench_SelectEntry(const cc_string* path) { return true; }
+static cc_result InflateBench_ProcessEntry(const cc_string* path, struct Stream* data, struct ZipEntry* entry) {
+	return InflateBench_Drain(data);
+}
+
+/* Decompresses all of the given gzip/png/zip file data, returning how long it took in microseconds */
+static cc_result InflateBench_Run(cc_uint8* data, cc_uint32 len, cc_uint64* elapsed) {
+	struct InflateState* inflate;
+	struct GZipHeader gzHeader;
+	struct Stream src, stream;
+	struct Bitmap bmp;
+	cc_uint64 beg;
+	cc_result res = 0;
+
+	Stream_ReadonlyMemory(&src, data, len);
+	inflateBench_size = 0;
+	beg = Stopwatch_Measure();
+
+	if (len >= 2 && data[0] == 0x1F && data[1] == 0x8B) {
+		inflate = (struct InflateState*)Mem_TryAlloc(1, sizeof(struct InflateState));
+		if (!inflate) return ERR_OUT_OF_MEMORY;
+		GZipHeader_Init(&gzHeader);
+
+		while (!gzHeader.done) {
+			if ((res = GZipHeader_Read(&src, &gzHeader))) break;
+		}
+		if (!res) {
+			Inflate_MakeStream2(&stream, inflate, &src);
+			res = InflateBench_Drain(&stream);
+		}
+		Mem_Free(inflate);
+	} else if (Png_Detect(data, len)) {
+		res = Png_Decode(&bmp, &src);
+		inflateBench_size = bmp.width * bmp.height * BITMAPCOLOR_SIZE;
+		Mem_Free(bmp.scan0);
+	} else if (len >= 2 && data[0] == 'P' && data[1] == 'K') {
+		res = Zip_Extract(&src, InflateBench_SelectEntry, InflateBench_ProcessEntry,
+							inflateBench_entries, Array_Elems(inflateBench_entries));
+	} else {
+		res = ERR_NOT_SUPPORTED;
+	}
+
+	*elapsed = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+	return res;
+}
+
+/* Returns the fastest time out of several runs */
+static cc_result InflateBench_Time(cc_uint8* data, cc_uint32 len, cc_bool singleSymbol, cc_uint64* best) {
+	cc_uint64 elapsed;
+	cc_result res;
+	int i;
+
+	Inflate_SingleSymbol = singleSymbol;
+	*best = 0;
+
+	for (i = 0; i < INFLATEBENCH_RUNS; i++) {
+		res = InflateBench_Run(data, len, &elapsed);
+		if (res) break;
+		if (!i || elapsed < *best) *best = elapsed;
+	}
+
+	Inflate_SingleSymbol = false;
+	return res;
+}
+
+static void InflateBench_Print(const char* name, cc_uint64 elapsed) {
+	float rate = inflateBench_size / (float)(elapsed ? elapsed : 1);
+	int ms     = (int)(elapsed / 1000);
+	Chat_Add3("&e  %c: &f%f2 MB/s &e(%i ms)", name, &rate, &ms);
+}
+
+static void InflateBenchCommand_Execute(const cc_string* args, int argsCount) {
+	cc_uint64 singleTime, multiTime;
+	cc_uint8* data;
+	cc_uint32 len;
+	cc_result res;
+
+	if (!argsCount) {
+		Chat_AddRaw("&eInflateBench: &cFile path required");
+		return;
+	}
+	if (!Commands_ReadFile(args, &data, &len)) return;
+
+	res = InflateBench_Time(data, len, true, &singleTime);
+	if (!res) res = InflateBench_Time(data, len, false, &multiTime);
+	Mem_Free(data);
+
+	if (res) { Logger_SysWarn2(res, "decompressing", args); return; }
+	Chat_Add2("&eInflateBench: %i compressed bytes -> %i bytes", &len, &inflateBench_size);
+	InflateBench_Print("Single symbol", singleTime);
+	InflateBench_Print("Multi symbol ", multiTime);
+}
+
+static struct ChatCommand InflateBenchCommand = {
+	"InflateBench", InflateBenchCommand_Execute,
+	COMMAND_FLAG_UNSPLIT_ARGS,
+	{
+		"&a/client inflatebench [file]",
+		"&eDecompresses a map (.cw/.lvl/.dat), PNG or zip file with both the",
+		"&e  single symbol and multi symbol decoders, and prints their MB/s",
+	}
+};
+#endif
+
+
+/*########################################################################################################################*
+*------------------------------------------------------DeflateBench command-----------------------------------------------*
+*#########################################################################################################################*/
+static cc_uint32 deflateBench_size;
+
+static cc_result DeflateBench_Write(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	deflateBench_size += count;
+	*modified = count;
+	return 0;
+}
+
+static void DeflateBenchCommand_Execute(const cc_string* args, int argsCount) {
+	struct GZipState* state;
+	struct Stream sink, stream;
+	cc_uint64 beg, elapsed;
+	cc_uint8* data;
+	cc_uint32 len;
+	float ratio, rate;
+	int level;
+	cc_result res = 0;
+
+	if (argsCount) {
+		if (!Commands_ReadFile(args, &data, &len)) return;
+	} else if (World.Blocks) {
+		data = World.Blocks;
+		len  = World.Volume;
+	} else {
+		Chat_AddRaw("&eDeflateBench: &cNo map loaded");
+		return;
+	}
+
+	state = (struct GZipState*)Mem_TryAlloc(1, sizeof(struct GZipState));
+	if (!state) res = ERR_OUT_OF_MEMORY;
+	Stream_Init(&sink);
+	sink.Write = DeflateBench_Write;
+
+	Chat_Add1("&eDeflateBench: Compressing %i bytes", &len);
+	for (level = DEFLATE_LEVEL_FAST; !res && level <= DEFLATE_LEVEL_MAX; level++) {
+		deflateBench_size = 0;
+		beg = Stopwatch_Measure();
+
+		GZip_MakeStream(&stream, state, &sink);
+		Deflate_SetLevel(&state->Base, level);
+		res = Stream_Write(&stream, data, len);
+		if (!res) res = stream.Close(&stream);
+		elapsed = Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+
+		ratio = len / (float)(deflateBench_size ? deflateBench_size : 1);
+		rate  = len / (float)(elapsed ? elapsed : 1);
+		if (!res) Chat_Add4("&e  Level %i: &f%i bytes &e(ratio %f1x, %f1 MB/s)", &level, &deflateBench_size, &ratio, &rate);
+	}
+
+	if (argsCount) Mem_Free(data);
+	Mem_Free(state);
+	if (res) Logger_SysWarn(res, "compressing");
+}
+
+static struct ChatCommand DeflateBenchCommand = {
+	"DeflateBench", DeflateBenchCommand_Execute,
+	COMMAND_FLAG_UNSPLIT_ARGS,
+	{
+		"&a/client deflatebench [file]",
+		"&eCompresses the given file (or the current map's blocks if no file",
+		"&e  is given) with every compression level, and prints ratio and MB/s",
+	}
+};
+
+
+/*########################################################################################################################*
+*---------------------------------------------------------RawMap command--------------------------------------------------*
+*#########################################################################################################################*/
+static cc_result RawMapCommand_Save(const cc_string* path) {
+	struct Stream stream;
+	cc_result res, closeRes;
+
+#ifdef CC_BUILD_MMAP
+	/* Current map may be mapped from the same file, which is about to be truncated */
+	res = World_Unmap();
+	if (res) { Logger_SysWarn2(res, "unmapping", path); return res; }
+#endif
+
+	res = Stream_CreateFile(&stream, path);
+	if (res) { Logger_SysWarn2(res, "creating", path); return res; }
+
+	res      = Raw_Save(&stream);
+	closeRes = stream.Close(&stream);
+	if (!res) res = closeRes;
+
+	if (res) Logger_SysWarn2(res, "saving", path);
+	return res;
+}
+
+static void RawMapCommand_Execute(const cc_string* args, int argsCount) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	cc_uint64 beg;
+	cc_result res;
+	int ms;
+
+	if (argsCount < 2) {
+		Chat_AddRaw("&e/client rawmap: &cYou didn't specify save/load and a map name."); return;
+	}
+
+	String_InitArray(path, pathBuffer);
+	String_Format1(&path, "maps/%s.ccraw", &args[1]);
+	beg = Stopwatch_Measure();
+
+	if (String_CaselessEqualsConst(&args[0], "save")) {
+		if (!World.Blocks) { Chat_AddRaw("&e/client rawmap: &cNo map loaded"); return; }
+		res = RawMapCommand_Save(&path);
+	} else if (String_CaselessEqualsConst(&args[0], "load")) {
+		/* Map_LoadFrom already logs any errors */
+		res = Map_LoadFrom(&path);
+	} else {
+		Chat_Add1("&e/client rawmap: &cUnknown action &f\"%s\"&c.", &args[0]); return;
+	}
+
+	if (res) return;
+	ms = (int)(Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure()) / 1000);
+	Chat_Add3("&e/client rawmap: &f%s %s &ein %i ms", &args[0], &path, &ms);
+}
+
+static struct ChatCommand RawMapCommand = {
+	"RawMap", RawMapCommand_Execute,
+	COMMAND_FLAG_SINGLEPLAYER_ONLY,
+	{
+		"&a/client rawmap save [name]",
+		"&eSaves the current map to maps/[name].ccraw, an uncompressed format",
+		"&e  that is memory mapped when loading, so it loads almost instantly",
+		"&a/client rawmap load [name]",
+		"&eLoads maps/[name].ccraw, and prints how long it took",
+	}
+};
+
+
 /*########################################################################################################################*
 *------------------------------------------------------Commands component-------------------------------------------------*
 *#########################################################################################################################*/
@@ -810,6 +1102,11 @@ static void OnInit(void) {
 	Commands_Register(&BlockEditCommand);
 	Commands_Register(&CuboidCommand);
 	Commands_Register(&ReplaceCommand);
+	Commands_Register(&DeflateBenchCommand);
+	Commands_Register(&RawMapCommand);
+#ifdef INFLATE_MULTI_BITS
+	Commands_Register(&InflateBenchCommand);
+#endif
 }
 
 static void OnFree(void) {
@@ -654,6 +654,34 @@ typedef cc_uint8  cc_bool;
 #ifndef CC_BUILD_TINYMEM
 	#define EXTENDED_TEXTURES
 #endif
+/* Chunk meshes are uploaded in the compact VERTEX_FORMAT_TERRAIN format */
+#if CC_GFX_BACKEND == CC_GFX_BACKEND_GL2
+	#define CC_BUILD_PACKEDTERRAIN
+#endif
+/* Chunk meshes are sub-allocated from a few large shared vertex buffers */
+#if (CC_GFX_BACKEND == CC_GFX_BACKEND_GL1 || CC_GFX_BACKEND == CC_GFX_BACKEND_GL2) && !defined CC_BUILD_LOWMEM
+	#define CC_BUILD_CHUNKARENA
+#endif
+
+/* Files can be memory mapped copy-on-write (e.g. for loading raw map files) */
+#if (defined CC_BUILD_POSIX && !defined CC_BUILD_OS2) || (defined CC_BUILD_WIN && !defined CC_BUILD_UWP)
+	#define CC_BUILD_MMAP
+#endif
+
+/* Network data is received on a dedicated thread, instead of being polled once per network tick */
+/* NOTE: Requires a compiler that provides a memory barrier (or x86, which doesn't reorder stores) */
+#if defined CC_BUILD_NETWORKING && !defined CC_BUILD_COOPTHREADED && !defined CC_BUILD_WEB
+	#if (defined CC_BUILD_POSIX || (defined CC_BUILD_WIN && !defined CC_BUILD_UWP)) && (defined __GNUC__ || defined _M_IX86 || defined _M_X64)
+		#define CC_BUILD_NETTHREAD
+	#endif
+#endif
+
+/* SIMD instructions are available for vectorised versions of some hot loops */
+#if defined __SSE2__ || defined _M_X64 || (defined _M_IX86_FP && _M_IX86_FP >= 2)
+	#define CC_BUILD_SSE2
+#elif defined __ARM_NEON || defined __ARM_NEON__
+	#define CC_BUILD_NEON
+#endif
 
 #ifndef CC_BUILD_MAXSTACK
 	#define CC_BUILD_MAXSTACK (256 * 1024)
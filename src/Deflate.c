@@ -177,6 +177,16 @@ enum INFLATE_STATE_ {
 /* The most input bytes required for huffman codes and extra data is 16 + 5 + 16 + 13 bits. Add 3 extra bytes to account for putting data into the bit buffer. */
 #define INFLATE_FASTINF_IN 10
 
+#if defined __GNUC__ && (defined __i386__ || defined __x86_64__ || defined __aarch64__)
+/* These CPUs support unaligned memory accesses, so 8 bytes can be copied/compared at once */
+#define INFLATE_WORD_ACCESS
+typedef cc_uint64 __attribute__((may_alias, aligned(1))) Inflate_Word;
+#define Inflate_Copy8(dst, src) *((Inflate_Word*)(dst)) = *((const Inflate_Word*)(src));
+#else
+#define Inflate_Copy8(dst, src) dst[0] = src[0]; dst[1] = src[1]; dst[2] = src[2]; dst[3] = src[3]; \
+								dst[4] = src[4]; dst[5] = src[5]; dst[6] = src[6]; dst[7] = src[7];
+#endif
+
 static cc_uint32 Huffman_ReverseBits(cc_uint32 n, cc_uint8 bits) {
 	n = ((n & 0xAAAA) >> 1) | ((n & 0x5555) << 1);
 	n = ((n & 0xCCCC) >> 2) | ((n & 0x3333) << 2);
@@ -399,6 +409,23 @@ static const cc_uint8 codelens_order[INFLATE_MAX_CODELENS] = {
 	16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 
 };
 
+/* Copies data just decompressed into the window to the output */
+static void Inflate_FlushWindow(struct InflateState* s, cc_uint32 copyStart, cc_uint32 copyLen) {
+	cc_uint32 partLen;
+	if (!copyLen) return;
+
+	if (copyStart + copyLen < INFLATE_WINDOW_SIZE) {
+		Mem_Copy(s->Output, &s->Window[copyStart], copyLen);
+		s->Output += copyLen;
+	} else {
+		partLen = INFLATE_WINDOW_SIZE - copyStart;
+		Mem_Copy(s->Output, &s->Window[copyStart], partLen);
+		s->Output += partLen;
+		Mem_Copy(s->Output, s->Window, copyLen - partLen);
+		s->Output += (copyLen - partLen);
+	}
+}
+
 static void Inflate_InflateFast(struct InflateState* s) {
 	/* huffman variables */
 	cc_uint32 lit, len, dist;
@@ -408,7 +435,7 @@ static void Inflate_InflateFast(struct InflateState* s) {
 	/* window variables */
 	cc_uint8* window;
 	cc_uint32 i, curIdx, startIdx;
-	cc_uint32 copyStart, copyLen, partLen;
+	cc_uint32 copyStart, copyLen;
 
 	window = s->Window;
 	curIdx = s->WindowIndex;
@@ -461,19 +488,217 @@ static void Inflate_InflateFast(struct InflateState* s) {
 	}
 
 	s->WindowIndex = curIdx;
-	if (!copyLen) return;
+	Inflate_FlushWindow(s, copyStart, copyLen);
+}
 
-	if (copyStart + copyLen < INFLATE_WINDOW_SIZE) {
-		Mem_Copy(s->Output, &s->Window[copyStart], copyLen);
-		s->Output += copyLen;
-	} else {
-		partLen = INFLATE_WINDOW_SIZE - copyStart;
-		Mem_Copy(s->Output, &s->Window[copyStart], partLen);
-		s->Output += partLen;
-		Mem_Copy(s->Output, s->Window, copyLen - partLen);
-		s->Output += (copyLen - partLen);
+#ifdef INFLATE_MULTI_BITS
+cc_bool Inflate_SingleSymbol;
+
+/* Multi table entries are packed as: */
+/*   bits 0-8:   first symbol */
+/*   bits 9-16:  second literal (only if count is 2) */
+/*   bits 17-21: total length of codewords */
+/*   bits 22-23: number of symbols */
+/* Or if MULTI_SUBTABLE bit is set, then bits 0-15 are offset of second level table, */
+/*   and bits 17-21 are how many more bits index into that table */
+/* An entry of 0 means the codeword must be decoded with Huffman_DecodeBits instead */
+#define MULTI_SYM2_SHIFT  9
+#define MULTI_LEN_SHIFT   17
+#define MULTI_COUNT_SHIFT 22
+#define MULTI_SUBTABLE    (1UL << 24)
+#define MULTI_ROOT_MASK   ((1UL << INFLATE_MULTI_BITS) - 1)
+#define MULTI_TABLE_SIZE  ((1 << INFLATE_MULTI_BITS) + INFLATE_MULTI_SUBTABLES)
+
+#define Multi_Make(sym1, sym2, len, count) ((cc_uint32)(sym1) | ((cc_uint32)(sym2) << MULTI_SYM2_SHIFT) | \
+											((cc_uint32)(len) << MULTI_LEN_SHIFT) | ((cc_uint32)(count) << MULTI_COUNT_SHIFT))
+
+/* Decodes a symbol from the given bits (first bit is lowest), returning -1 if no codeword of at most maxBits matches */
+static int Huffman_DecodeBits(struct HuffmanTable* table, cc_uint32 bits, int maxBits, int* len) {
+	cc_uint32 codeword = 0;
+	int i, packed, offset;
+
+	if (maxBits >= INFLATE_FAST_BITS) {
+		packed = table->fast[bits & ((1 << INFLATE_FAST_BITS) - 1)];
+		if (packed >= 0) {
+			*len = packed >> INFLATE_FAST_LEN_SHIFT;
+			return packed & INFLATE_FAST_VAL_MASK;
+		}
+	}
+
+	for (i = 1; i <= maxBits && i < INFLATE_MAX_BITS; i++) {
+		codeword = (codeword << 1) | ((bits >> (i - 1)) & 1);
+
+		if (codeword < table->endCodewords[i]) {
+			offset = table->firstOffsets[i] + (codeword - table->firstCodewords[i]);
+			*len   = i;
+			return table->values[offset];
+		}
+	}
+	return -1;
+}
+
+/* Builds the multi-symbol table from the current literals/lengths huffman table */
+static void Inflate_BuildMulti(struct InflateState* s) {
+	struct HuffmanTable* table = &s->Table.Lits;
+	cc_uint32* multi = s->Multi;
+	int sym1, sym2, len1, len2, maxLen;
+	int i, j, subBits, next = 1 << INFLATE_MULTI_BITS;
+
+	for (maxLen = INFLATE_MAX_BITS - 1; maxLen > 0 && !table->endCodewords[maxLen]; maxLen--) { }
+	subBits = maxLen - INFLATE_MULTI_BITS;
+
+	for (i = 0; i < (1 << INFLATE_MULTI_BITS); i++) {
+		sym1     = Huffman_DecodeBits(table, i, INFLATE_MULTI_BITS, &len1);
+		multi[i] = 0;
+
+		if (sym1 == -1) {
+			/* Codeword is longer than INFLATE_MULTI_BITS, so needs a second level table */
+			if (subBits <= 0 || next + (1 << subBits) > MULTI_TABLE_SIZE) continue;
+
+			for (j = 0; j < (1 << subBits); j++) {
+				sym2 = Huffman_DecodeBits(table, i | (j << INFLATE_MULTI_BITS), maxLen, &len2);
+				multi[next + j] = sym2 == -1 ? 0 : Multi_Make(sym2, 0, len2, 1);
+			}
+			multi[i] = MULTI_SUBTABLE | next | ((cc_uint32)subBits << MULTI_LEN_SHIFT);
+			next    += 1 << subBits;
+			continue;
+		}
+
+		multi[i] = Multi_Make(sym1, 0, len1, 1);
+		if (sym1 >= 256 || len1 >= INFLATE_MULTI_BITS) continue;
+
+		/* Pack a second literal in too, if its codeword also fits */
+		sym2 = Huffman_DecodeBits(table, i >> len1, INFLATE_MULTI_BITS - len1, &len2);
+		if (sym2 >= 0 && sym2 < 256) multi[i] = Multi_Make(sym1, sym2, len1 + len2, 2);
+	}
+}
+
+/* Reads 8 bytes as a little endian integer (compilers turn this into a single load where possible) */
+#define Inflate_Load64(p) \
+	((cc_uint64)(p)[0]        | ((cc_uint64)(p)[1] << 8)  | ((cc_uint64)(p)[2] << 16) | ((cc_uint64)(p)[3] << 24) | \
+	((cc_uint64)(p)[4] << 32) | ((cc_uint64)(p)[5] << 40) | ((cc_uint64)(p)[6] << 48) | ((cc_uint64)(p)[7] << 56))
+
+/* Like Inflate_InflateFast, but keeps up to 64 bits in a local bit buffer, */
+/*  decodes up to two literals per table lookup, and copies matches 8 bytes at a time */
+static void Inflate_InflateFastMulti(struct InflateState* s) {
+	/* bit buffer variables */
+	cc_uint64 bitBuf    = s->Bits;
+	cc_uint32 bitCount  = s->NumBits;
+	const cc_uint8* in    = s->NextIn;
+	const cc_uint8* inEnd = s->NextIn + s->AvailIn;
+	cc_uint32* multi    = s->Multi;
+
+	/* huffman variables */
+	cc_uint32 entry, sym, len, dist, bits, unused;
+	int packed, distIdx, n;
+
+	/* window variables */
+	cc_uint8* window    = s->Window;
+	cc_uint32 availOut  = s->AvailOut;
+	cc_uint32 i, curIdx = s->WindowIndex, startIdx;
+	cc_uint32 copyStart = s->WindowIndex, copyLen = 0;
+
+	while (availOut >= INFLATE_FASTINF_OUT && inEnd - in >= 8 && copyLen < INFLATE_FAST_COPY_MAX) {
+		/* Refill to at least 56 bits, which is always enough for a whole length + distance pair */
+		bitBuf   |= Inflate_Load64(in) << bitCount;
+		in       += (63 - bitCount) >> 3;
+		bitCount |= 56;
+
+		entry = multi[bitBuf & MULTI_ROOT_MASK];
+		if (entry & MULTI_SUBTABLE) {
+			bits  = (entry >> MULTI_LEN_SHIFT) & 0x1F;
+			entry = multi[(entry & 0xFFFF) + ((bitBuf >> INFLATE_MULTI_BITS) & ((1UL << bits) - 1))];
+		}
+
+		if (!entry) {
+			packed = Huffman_DecodeBits(&s->Table.Lits, (cc_uint32)bitBuf, INFLATE_MAX_BITS - 1, &n);
+			if (packed == -1) { Inflate_Fail(s, INF_ERR_INVALID_CODE); break; }
+			entry  = Multi_Make(packed, 0, n, 1);
+		}
+
+		len = (entry >> MULTI_LEN_SHIFT) & 0x1F;
+		bitBuf >>= len; bitCount -= len;
+		sym = entry & INFLATE_FAST_VAL_MASK;
+
+		if (sym < 256) {
+			window[curIdx] = (cc_uint8)sym;
+			curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK;
+			availOut--; copyLen++;
+
+			if ((entry >> MULTI_COUNT_SHIFT) == 2) {
+				window[curIdx] = (cc_uint8)(entry >> MULTI_SYM2_SHIFT);
+				curIdx = (curIdx + 1) & INFLATE_WINDOW_MASK;
+				availOut--; copyLen++;
+			}
+			continue;
+		} else if (sym == 256) {
+			s->State = Inflate_NextBlockState(s);
+			break;
+		}
+
+		sym  -= 257;
+		bits  = len_bits[sym];
+		len   = len_base[sym] + (cc_uint32)(bitBuf & ((1UL << bits) - 1));
+		bitBuf >>= bits; bitCount -= bits;
+
+		packed = s->TableDists.fast[bitBuf & ((1 << INFLATE_FAST_BITS) - 1)];
+		if (packed >= 0) {
+			distIdx = packed & INFLATE_FAST_VAL_MASK;
+			n       = packed >> INFLATE_FAST_LEN_SHIFT;
+		} else {
+			distIdx = Huffman_DecodeBits(&s->TableDists, (cc_uint32)bitBuf, INFLATE_MAX_BITS - 1, &n);
+			if (distIdx == -1) { Inflate_Fail(s, INF_ERR_INVALID_CODE); break; }
+		}
+		bitBuf >>= n; bitCount -= n;
+
+		bits = dist_bits[distIdx];
+		dist = dist_base[distIdx] + (cc_uint32)(bitBuf & ((1UL << bits) - 1));
+		bitBuf >>= bits; bitCount -= bits;
+
+		startIdx = (curIdx - dist) & INFLATE_WINDOW_MASK;
+		if (curIdx >= startIdx && (curIdx + len) < INFLATE_WINDOW_SIZE) {
+			cc_uint8* src = &window[startIdx];
+			cc_uint8* dst = &window[curIdx];
+
+			if (dist >= 8) {
+				/* Source is always at least 8 bytes behind, so each 8 byte copy never overlaps */
+				for (i = 0; i + 8 <= len; i += 8, dst += 8, src += 8) { Inflate_Copy8(dst, src); }
+				for (; i < len; i++) { *dst++ = *src++; }
+			} else if (dist == 1) {
+				Mem_Set(dst, *src, len);
+			} else {
+				for (i = 0; i < len; i++) { *dst++ = *src++; }
+			}
+		} else {
+			for (i = 0; i < len; i++) {
+				window[(curIdx + i) & INFLATE_WINDOW_MASK] = window[(startIdx + i) & INFLATE_WINDOW_MASK];
+			}
+		}
+		curIdx = (curIdx + len) & INFLATE_WINDOW_MASK;
+		availOut -= len; copyLen += len;
 	}
+
+	/* Give back any whole bytes that were loaded into the bit buffer but not consumed */
+	unused    = bitCount >> 3;
+	in       -= unused;
+	bitCount -= unused << 3;
+
+	s->Bits     = (cc_uint32)(bitBuf & ((1UL << bitCount) - 1));
+	s->NumBits  = bitCount;
+	s->AvailIn  = (cc_uint32)(inEnd - in);
+	s->NextIn   = (cc_uint8*)in;
+	s->AvailOut = availOut;
+
+	s->WindowIndex = curIdx;
+	Inflate_FlushWindow(s, copyStart, copyLen);
 }
+#endif
+
+#ifdef INFLATE_MULTI_BITS
+#define Inflate_TablesBuilt(s) Inflate_BuildMulti(s)
+#else
+#define Inflate_TablesBuilt(s)
+#endif
 
 void Inflate_Process(struct InflateState* s) {
 	cc_uint32 len, dist, nlen;
@@ -507,6 +732,7 @@ void Inflate_Process(struct InflateState* s) {
 			case 1: { /* Fixed/static huffman compressed */
 				(void)Huffman_Build(&s->Table.Lits, fixed_lits,  INFLATE_MAX_LITS);
 				(void)Huffman_Build(&s->TableDists, fixed_dists, INFLATE_MAX_DISTS);
+				Inflate_TablesBuilt(s);
 				s->State = Inflate_NextCompressState(s);
 			} break;
 
@@ -619,6 +845,7 @@ void Inflate_Process(struct InflateState* s) {
 				if (res) { Inflate_Fail(s, res); return; }
 				res = Huffman_Build(&s->TableDists, s->Buffer + s->NumLits, s->NumDists);
 				if (res) { Inflate_Fail(s, res); return; }
+				Inflate_TablesBuilt(s);
 			}
 			break;
 		}
@@ -728,7 +955,15 @@ void Inflate_Process(struct InflateState* s) {
 		}
 
 		case INFLATE_STATE_FASTCOMPRESSED: {
+#ifdef INFLATE_MULTI_BITS
+			if (Inflate_SingleSymbol) {
+				Inflate_InflateFast(s);
+			} else {
+				Inflate_InflateFastMulti(s);
+			}
+#else
 			Inflate_InflateFast(s);
+#endif
 			if (s->State == INFLATE_STATE_FASTCOMPRESSED) {
 				s->State = Inflate_NextCompressState(s);
 			}
@@ -821,6 +1056,10 @@ static const cc_uint16 deflate_dist[31] = {
 /* Number of bytes that match (are the same) from a and b */
 static int Deflate_MatchLen(cc_uint8* a, cc_uint8* b, int maxLen) {
 	int i = 0;
+#ifdef INFLATE_WORD_ACCESS
+	/* Compare 8 bytes at a time, until a mismatch */
+	while (i + 8 <= maxLen && *((Inflate_Word*)a) == *((Inflate_Word*)b)) { i += 8; a += 8; b += 8; }
+#endif
 	while (i < maxLen && *a == *b) { i++; a++; b++; }
 	return i;
 }
@@ -854,7 +1093,7 @@ static void Deflate_LenDist(struct DeflateState* state, int len, int dist) {
 
 /* Moves "current block" to "previous block", adjusting state if needed. */
 static void Deflate_MoveBlock(struct DeflateState* state) {
-	int i;
+	int i, pos;
 	Mem_Copy(state->Input, state->Input + DEFLATE_BLOCK_SIZE, DEFLATE_BLOCK_SIZE);
 	state->InputPosition = DEFLATE_BLOCK_SIZE;
 
@@ -862,11 +1101,462 @@ static void Deflate_MoveBlock(struct DeflateState* state) {
 	for (i = 0; i < Array_Elems(state->Head); i++) {
 		state->Head[i] = state->Head[i] < DEFLATE_BLOCK_SIZE ? 0 : (state->Head[i] - DEFLATE_BLOCK_SIZE);
 	}
-	for (i = 0; i < Array_Elems(state->Prev); i++) {
-		state->Prev[i] = state->Prev[i] < DEFLATE_BLOCK_SIZE ? 0 : (state->Prev[i] - DEFLATE_BLOCK_SIZE);
+	/* Prev is indexed by position too, so entries of the current block also need to be moved down */
+	for (i = 0; i < DEFLATE_BLOCK_SIZE; i++) {
+		pos = state->Prev[i + DEFLATE_BLOCK_SIZE];
+		state->Prev[i] = pos < DEFLATE_BLOCK_SIZE ? 0 : (pos - DEFLATE_BLOCK_SIZE);
+	}
+}
+
+/* Constructs a huffman encoding table (for values to codewords) */
+static void Deflate_BuildTable(const cc_uint8* lens, int count, cc_uint16* codewords, cc_uint8* bitlens) {
+	int i, j, offset, codeword;
+	struct HuffmanTable table;
+
+	/* NOTE: Can ignore since lens table is not user controlled */
+	(void)Huffman_Build(&table, lens, count);
+	for (i = 0; i < INFLATE_MAX_BITS; i++) {
+		if (!table.endCodewords[i]) continue;
+		count = table.endCodewords[i] - table.firstCodewords[i];
+
+		for (j = 0; j < count; j++) {
+			offset   = table.values[table.firstOffsets[i] + j];
+			codeword = table.firstCodewords[i] + j;
+			bitlens[offset]   = i;
+			codewords[offset] = Huffman_ReverseBits(codeword, i);
+		}
+	}
+}
+
+#if DEFLATE_LEVEL_MAX > DEFLATE_LEVEL_FAST
+/*########################################################################################################################*
+*--------------------------------------------------Deflate compression levels---------------------------------------------*
+*#########################################################################################################################*/
+struct DeflateLevel {
+	cc_uint16 goodLen;  /* Search less of the hash chain when previous match is at least this long */
+	cc_uint16 lazyLen;  /* Don't look for a longer match when previous match is at least this long (0 = greedy) */
+	cc_uint16 niceLen;  /* Stop searching the hash chain when a match is at least this long */
+	cc_uint16 maxChain; /* Maximum number of entries in the hash chain to search */
+};
+
+/* Based on the configuration table from zlib */
+static const struct DeflateLevel deflate_levels[DEFLATE_LEVEL_MAX + 1] = {
+	{  0,   0,   0,    0 }, /* 0: unused */
+	{  0,   0,   0,    0 }, /* 1: unused (see Deflate_FlushBlock) */
+	{  4,   0,  16,    8 }, /* 2: greedy */
+	{  4,   0,  32,   32 }, /* 3: greedy */
+	{  4,   4,  16,   16 }, /* 4: lazy */
+	{  8,  16,  32,   32 }, /* 5: lazy */
+	{  8,  16, 128,  128 }, /* 6: lazy */
+	{  8,  32, 128,  256 }, /* 7: lazy */
+	{ 32, 128, 258, 1024 }, /* 8: lazy */
+	{ 32, 258, 258, 4096 }  /* 9: lazy */
+};
+/* Matches of MIN_MATCH_LEN bytes further back than this usually take more bits than 3 literals would */
+#define DEFLATE_TOO_FAR 4096
+
+/* Symbols are stored as either a literal, or a length | distance << 9 pair */
+#define DEFLATE_SYM_DIST_SHIFT 9
+#define DEFLATE_SYM_LEN_MASK   0x1FF
+
+/* Calculates the index into len_base/len_bits for the given match length */
+static int Deflate_LenCode(int len) {
+	int n, bits;
+	if (len == MAX_MATCH_LEN) return 28;
+	n = len - MIN_MATCH_LEN;
+	if (n < 8) return n;
+
+	for (bits = 0; (n >> bits) > 1; bits++) { }
+	return 4 * (bits - 1) + ((n >> (bits - 2)) & 3);
+}
+
+/* Calculates the index into dist_base/dist_bits for the given match distance */
+static int Deflate_DistCode(int dist) {
+	int n = dist - 1, bits;
+	if (n < 4) return n;
+
+	for (bits = 0; (n >> bits) > 1; bits++) { }
+	return 2 * bits + ((n >> (bits - 1)) & 1);
+}
+
+/* Inserts the 3 bytes at the given position into the hash chains, returning previous head of the chain */
+static int Deflate_Insert(struct DeflateState* state, int pos) {
+	cc_uint32 hash = Deflate_Hash(&state->Input[pos]);
+	int head = state->Head[hash];
+
+	state->Prev[pos]  = head;
+	state->Head[hash] = pos;
+	return head;
+}
+
+/* Searches the hash chain starting at pos for the longest match with the data at cur */
+static int Deflate_LongestMatch(struct DeflateState* state, int pos, int cur, int maxLen,
+								int chain, int niceLen, int* bestPos) {
+	cc_uint8* input = state->Input;
+	int len, bestLen = MIN_MATCH_LEN - 1;
+	if (niceLen > maxLen) niceLen = maxLen;
+
+	for (; pos && chain; chain--, pos = state->Prev[pos]) {
+		/* Quickly skip over matches that can't be longer than the best so far */
+		if (input[pos + bestLen] != input[cur + bestLen] || input[pos] != input[cur]) continue;
+
+		len = Deflate_MatchLen(&input[pos], &input[cur], maxLen);
+		if (len <= bestLen) continue;
+
+		bestLen  = len;
+		*bestPos = pos;
+		if (len >= niceLen) break;
+	}
+	return bestLen;
+}
+
+/* Converts the current block of data into literals and length/distance pairs, returning number of symbols */
+static int Deflate_CompressBlock(struct DeflateState* state, int len) {
+	const struct DeflateLevel* lvl = &deflate_levels[state->Level];
+	cc_uint32* syms = state->Syms;
+	int i = 0, j, pos, head, chain, numSyms = 0;
+	int matchLen = 0, matchPos = 0;
+	int prevLen, prevPos;
+	cc_bool pendingLit = false;
+
+	while (i < len) {
+		pos     = DEFLATE_BLOCK_SIZE + i;
+		prevLen = matchLen; prevPos = matchPos;
+		matchLen = 0;
+
+		if (len - i >= MIN_MATCH_LEN) {
+			head = Deflate_Insert(state, pos);
+
+			if (head && (!lvl->lazyLen || prevLen < lvl->lazyLen)) {
+				chain    = prevLen >= lvl->goodLen ? lvl->maxChain >> 2 : lvl->maxChain;
+				matchLen = Deflate_LongestMatch(state, head, pos, min(len - i, MAX_MATCH_LEN),
+												max(chain, 1), lvl->niceLen, &matchPos);
+
+				if (matchLen == MIN_MATCH_LEN && pos - matchPos > DEFLATE_TOO_FAR) matchLen = 0;
+				if (matchLen < MIN_MATCH_LEN) matchLen = 0;
+			}
+		}
+
+		if (!lvl->lazyLen) {
+			/* Greedy matching: Always use the match at the current byte */
+			if (matchLen) {
+				syms[numSyms++] = matchLen | ((pos - matchPos) << DEFLATE_SYM_DIST_SHIFT);
+				for (j = i + 1; j < i + matchLen && len - j >= MIN_MATCH_LEN; j++) {
+					Deflate_Insert(state, DEFLATE_BLOCK_SIZE + j);
+				}
+				i += matchLen;
+			} else {
+				syms[numSyms++] = state->Input[pos];
+				i++;
+			}
+			matchLen = 0;
+		} else if (prevLen && matchLen <= prevLen) {
+			/* Lazy matching: Match at previous byte is better than the match at this byte */
+			syms[numSyms++] = prevLen | ((pos - 1 - prevPos) << DEFLATE_SYM_DIST_SHIFT);
+			for (j = i + 1; j < i - 1 + prevLen && len - j >= MIN_MATCH_LEN; j++) {
+				Deflate_Insert(state, DEFLATE_BLOCK_SIZE + j);
+			}
+			i += prevLen - 1;
+
+			pendingLit = false;
+			matchLen   = 0;
+		} else {
+			/* Defer deciding what to do with this byte until the next byte has been checked */
+			if (pendingLit) syms[numSyms++] = state->Input[pos - 1];
+			pendingLit = true;
+			i++;
+		}
+	}
+
+	if (pendingLit) syms[numSyms++] = state->Input[DEFLATE_BLOCK_SIZE + len - 1];
+	return numSyms;
+}
+
+/* Calculates the optimal huffman codeword lengths for the given symbol frequencies, */
+/*  then adjusts them so that no codeword is longer than maxBits */
+/* Uses the in-place algorithm from "In-Place Calculation of Minimum-Redundancy Codes" by Moffat and Katajainen */
+static void Deflate_BuildLengths(const cc_uint32* freqs, int count, int maxBits, cc_uint8* lens) {
+	cc_uint16 syms[INFLATE_MAX_LITS];
+	cc_uint32 A[INFLATE_MAX_LITS];
+	int numLens[INFLATE_MAX_BITS];
+	int i, j, n = 0, root, leaf, next, avail, used, depth;
+	cc_uint32 total;
+
+	/* Sort the used symbols by ascending frequency */
+	for (i = 0; i < count; i++) {
+		lens[i] = 0;
+		if (!freqs[i]) continue;
+
+		for (j = n; j > 0 && freqs[syms[j - 1]] > freqs[i]; j--) { syms[j] = syms[j - 1]; }
+		syms[j] = i; n++;
+	}
+
+	if (!n) return;
+	if (n == 1) { lens[syms[0]] = 1; return; }
+	for (i = 0; i < n; i++) A[i] = freqs[syms[i]];
+
+	/* Compute the weights of the internal nodes, and parent pointers */
+	A[0] += A[1]; root = 0; leaf = 2;
+	for (next = 1; next < n - 1; next++) {
+		if (leaf >= n || A[root] < A[leaf]) {
+			A[next] = A[root]; A[root++] = next;
+		} else {
+			A[next] = A[leaf++];
+		}
+
+		if (leaf >= n || (root < next && A[root] < A[leaf])) {
+			A[next] += A[root]; A[root++] = next;
+		} else {
+			A[next] += A[leaf++];
+		}
+	}
+
+	/* Convert parent pointers into depths of internal nodes */
+	A[n - 2] = 0;
+	for (next = n - 3; next >= 0; next--) { A[next] = A[A[next]] + 1; }
+
+	/* Convert internal node depths into leaf depths */
+	avail = 1; used = 0; depth = 0;
+	root  = n - 2; next = n - 1;
+	while (avail > 0) {
+		while (root >= 0 && (int)A[root] == depth) { used++; root--; }
+		while (avail > used) { A[next--] = depth; avail--; }
+		avail = 2 * used; depth++; used = 0;
+	}
+
+	/* Shorten codewords that are too long, then lengthen shorter codewords until the code is valid again */
+	for (i = 0; i <= maxBits; i++) numLens[i] = 0;
+	for (i = 0; i < n; i++) numLens[min((int)A[i], maxBits)]++;
+
+	total = 0;
+	for (i = maxBits; i > 0; i--) total += (cc_uint32)numLens[i] << (maxBits - i);
+
+	while (total > (1UL << maxBits)) {
+		numLens[maxBits]--;
+		for (i = maxBits - 1; i > 0; i--) {
+			if (!numLens[i]) continue;
+			numLens[i]--; numLens[i + 1] += 2; break;
+		}
+		total--;
+	}
+
+	/* Least frequent symbols get the longest codewords */
+	for (i = maxBits, j = 0; i > 0; i--) {
+		for (n = numLens[i]; n > 0; n--) { lens[syms[j++]] = i; }
+	}
+}
+
+/* Calculates how many bits the symbols in a block take up with the given codeword lengths */
+static cc_uint32 Deflate_SymbolBits(const cc_uint32* litFreqs, const cc_uint32* distFreqs,
+									const cc_uint8* litLens, const cc_uint8* distLens) {
+	cc_uint32 bits = 0;
+	int i;
+
+	for (i = 0; i < INFLATE_MAX_LITS - 2; i++) {
+		bits += litFreqs[i] * litLens[i];
+	}
+	for (i = 0; i < 29; i++) {
+		bits += litFreqs[257 + i] * len_bits[i];
+	}
+	for (i = 0; i < INFLATE_MAX_DISTS - 2; i++) {
+		bits += distFreqs[i] * (distLens[i] + dist_bits[i]);
+	}
+	return bits;
+}
+
+/* Writes output buffer to destination stream, if there's less than the given number of bytes left in it */
+static cc_result Deflate_EnsureSpace(struct DeflateState* state, cc_uint32 space) {
+	cc_result res;
+	if (state->AvailOut >= space) return 0;
+
+	res = Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
+	state->NextOut  = state->Output;
+	state->AvailOut = DEFLATE_OUT_SIZE;
+	return res;
+}
+
+/* Writes the current block of data as an uncompressed block */
+static cc_result Deflate_WriteStored(struct DeflateState* state, int len) {
+	cc_result res;
+	Deflate_PushBits(state, 0, 3); /* final block FALSE, block type UNCOMPRESSED */
+	if (state->NumBits & 7) { Deflate_PushBits(state, 0, 8 - (state->NumBits & 7)); }
+	Deflate_FlushBits(state);
+
+	Deflate_PushBits(state, len, 16);
+	Deflate_FlushBits(state);
+	Deflate_PushBits(state, len ^ 0xFFFF, 16);
+	Deflate_FlushBits(state);
+
+	if ((res = Deflate_EnsureSpace(state, DEFLATE_OUT_SIZE))) return res;
+	return Stream_Write(state->Dest, state->Input + DEFLATE_BLOCK_SIZE, len);
+}
+
+/* Writes the header of a dynamic huffman block, which describes the codeword lengths */
+static void Deflate_WriteDynamicHeader(struct DeflateState* state, const cc_uint8* clLens, int numCodeLens, 
+										const cc_uint8* clSyms, const cc_uint8* clExtra, int numClSyms, int numLits, int numDists) {
+	static const cc_uint8 extraBits[3] = { 2, 3, 7 };
+	cc_uint16 clCodewords[INFLATE_MAX_CODELENS];
+	cc_uint8  clBitLens[INFLATE_MAX_CODELENS];
+	int i, sym;
+
+	Deflate_BuildTable(clLens, INFLATE_MAX_CODELENS, clCodewords, clBitLens);
+	Deflate_PushBits(state, 4, 3); /* final block FALSE, block type DYNAMIC */
+	Deflate_PushBits(state, numLits  - 257, 5);
+	Deflate_PushBits(state, numDists - 1,   5);
+	Deflate_PushBits(state, numCodeLens - 4, 4);
+	Deflate_FlushBits(state);
+
+	for (i = 0; i < numCodeLens; i++) {
+		Deflate_PushBits(state, clLens[codelens_order[i]], 3);
+		Deflate_FlushBits(state);
+	}
+
+	for (i = 0; i < numClSyms; i++) {
+		sym = clSyms[i];
+		Deflate_PushBits(state, clCodewords[sym], clLens[sym]);
+		if (sym >= 16) { Deflate_PushBits(state, clExtra[i], extraBits[sym - 16]); }
+		Deflate_FlushBits(state);
+	}
+}
+
+/* Writes the symbols of the current block using the current codewords */
+static cc_result Deflate_WriteSymbols(struct DeflateState* state, int numSyms) {
+	cc_uint32 sym, len, dist;
+	int i, code;
+	cc_result res;
+
+	for (i = 0; i < numSyms; i++) {
+		sym  = state->Syms[i];
+		dist = sym >> DEFLATE_SYM_DIST_SHIFT;
+
+		if (!dist) {
+			Deflate_PushLit(state, sym);
+		} else {
+			len  = sym & DEFLATE_SYM_LEN_MASK;
+			code = Deflate_LenCode(len);
+			Deflate_PushLit(state, code + 257);
+			Deflate_PushBits(state, len - len_base[code], len_bits[code]);
+			Deflate_FlushBits(state);
+
+			code = Deflate_DistCode(dist);
+			Deflate_PushBits(state, state->DistsCodewords[code], state->DistsLens[code]);
+			Deflate_FlushBits(state);
+			Deflate_PushBits(state, dist - dist_base[code], dist_bits[code]);
+		}
+		Deflate_FlushBits(state);
+
+		/* leave room for a few symbols at end */
+		if (state->AvailOut < 20 && (res = Deflate_EnsureSpace(state, 20))) return res;
+	}
+
+	Deflate_PushLit(state, 256);
+	Deflate_FlushBits(state);
+	return 0;
+}
+
+/* Writes the symbols of the current block, using whichever block type is smallest */
+static cc_result Deflate_WriteBlock(struct DeflateState* state, int len, int numSyms) {
+	cc_uint32 litFreqs[INFLATE_MAX_LITS], distFreqs[INFLATE_MAX_DISTS], clFreqs[INFLATE_MAX_CODELENS];
+	cc_uint8  litLens[INFLATE_MAX_LITS],  distLens[INFLATE_MAX_DISTS],  clLens[INFLATE_MAX_CODELENS];
+	cc_uint8  lens[INFLATE_MAX_LITS_DISTS], clSyms[INFLATE_MAX_LITS_DISTS], clExtra[INFLATE_MAX_LITS_DISTS];
+	cc_uint32 sym, dynamicBits, fixedBits, storedBits;
+	int i, run, cur, prev, used, numClSyms = 0;
+	int numLits, numDists, numCodeLens;
+	cc_result res;
+
+	Mem_Set(litFreqs,  0, sizeof(litFreqs));
+	Mem_Set(distFreqs, 0, sizeof(distFreqs));
+	Mem_Set(clFreqs,   0, sizeof(clFreqs));
+
+	for (i = 0; i < numSyms; i++) {
+		sym = state->Syms[i];
+		if (sym >> DEFLATE_SYM_DIST_SHIFT) {
+			litFreqs[Deflate_LenCode(sym & DEFLATE_SYM_LEN_MASK) + 257]++;
+			distFreqs[Deflate_DistCode(sym >> DEFLATE_SYM_DIST_SHIFT)]++;
+		} else {
+			litFreqs[sym]++;
+		}
+	}
+	litFreqs[256] = 1;
+
+	/* Ensure there are at least two distance codes, so that the distance codewords are complete */
+	for (i = 0, used = 0; i < INFLATE_MAX_DISTS - 2; i++) { used += distFreqs[i] != 0; }
+	for (i = 0; used < 2; i++) {
+		if (!distFreqs[i]) { distFreqs[i] = 1; used++; }
+	}
+
+	Deflate_BuildLengths(litFreqs,  INFLATE_MAX_LITS - 2,  15, litLens);
+	Deflate_BuildLengths(distFreqs, INFLATE_MAX_DISTS - 2, 15, distLens);
+	litLens[286]  = 0; litLens[287]  = 0;
+	distLens[30]  = 0; distLens[31]  = 0;
+
+	for (numLits  = INFLATE_MAX_LITS  - 2; numLits  > 257 && !litLens[numLits - 1];   numLits--)  { }
+	for (numDists = INFLATE_MAX_DISTS - 2; numDists > 1   && !distLens[numDists - 1]; numDists--) { }
+
+	/* Run length encode the codeword lengths */
+	Mem_Copy(lens,           litLens,  numLits);
+	Mem_Copy(lens + numLits, distLens, numDists);
+	prev = -1;
+
+	for (i = 0; i < numLits + numDists; i += run) {
+		cur = lens[i];
+		for (run = 1; i + run < numLits + numDists && lens[i + run] == cur && run < 138; run++) { }
+
+		if (!cur && run >= 11) {
+			clSyms[numClSyms] = 18; clExtra[numClSyms] = run - 11;
+		} else if (!cur && run >= 3) {
+			clSyms[numClSyms] = 17; clExtra[numClSyms] = run - 3;
+		} else if (cur == prev && run >= 3) {
+			run = min(run, 6);
+			clSyms[numClSyms] = 16; clExtra[numClSyms] = run - 3;
+		} else {
+			run = 1;
+			clSyms[numClSyms] = cur; clExtra[numClSyms] = 0;
+		}
+
+		clFreqs[clSyms[numClSyms++]]++;
+		prev = cur;
+	}
+
+	Deflate_BuildLengths(clFreqs, INFLATE_MAX_CODELENS, 7, clLens);
+	for (numCodeLens = INFLATE_MAX_CODELENS; numCodeLens > 4 && !clLens[codelens_order[numCodeLens - 1]]; numCodeLens--) { }
+
+	/* Work out which type of block is smallest */
+	dynamicBits = 3 + 14 + numCodeLens * 3 + clFreqs[16] * 2 + clFreqs[17] * 3 + clFreqs[18] * 7;
+	for (i = 0; i < INFLATE_MAX_CODELENS; i++) { dynamicBits += clFreqs[i] * clLens[i]; }
+	dynamicBits += Deflate_SymbolBits(litFreqs, distFreqs, litLens, distLens);
+
+	fixedBits  = 3 + Deflate_SymbolBits(litFreqs, distFreqs, fixed_lits, fixed_dists);
+	storedBits = 3 + 7 + 32 + len * 8;
+
+	if (storedBits < dynamicBits && storedBits < fixedBits) return Deflate_WriteStored(state, len);
+	/* The header of a dynamic block can take up a few hundred bytes */
+	if ((res = Deflate_EnsureSpace(state, 1024))) return res;
+
+	if (fixedBits <= dynamicBits) {
+		Deflate_PushBits(state, 2, 3); /* final block FALSE, block type FIXED */
+		Deflate_BuildTable(fixed_lits,  INFLATE_MAX_LITS,  state->LitsCodewords,  state->LitsLens);
+		Deflate_BuildTable(fixed_dists, INFLATE_MAX_DISTS, state->DistsCodewords, state->DistsLens);
+	} else {
+		Deflate_WriteDynamicHeader(state, clLens, numCodeLens, clSyms, clExtra, numClSyms, numLits, numDists);
+		Deflate_BuildTable(litLens,  INFLATE_MAX_LITS,  state->LitsCodewords,  state->LitsLens);
+		Deflate_BuildTable(distLens, INFLATE_MAX_DISTS, state->DistsCodewords, state->DistsLens);
 	}
+
+	if ((res = Deflate_WriteSymbols(state, numSyms))) return res;
+	return Deflate_EnsureSpace(state, DEFLATE_OUT_SIZE);
 }
 
+/* Compresses current block of data, using hash chains, lazy matching, and per block huffman codes */
+static cc_result Deflate_FlushLevelBlock(struct DeflateState* state, int len) {
+	cc_result res = 0;
+	if (len) res = Deflate_WriteBlock(state, len, Deflate_CompressBlock(state, len));
+
+	Deflate_MoveBlock(state);
+	return res;
+}
+#endif
+
 /* Compresses current block of data */
 static cc_result Deflate_FlushBlock(struct DeflateState* state, int len) {
 	cc_uint32 hash, nextHash;
@@ -877,6 +1567,9 @@ static cc_result Deflate_FlushBlock(struct DeflateState* state, int len) {
 	cc_uint8* cur;
 	cc_result res;
 
+#if DEFLATE_LEVEL_MAX > DEFLATE_LEVEL_FAST
+	if (state->Level > DEFLATE_LEVEL_FAST) return Deflate_FlushLevelBlock(state, len);
+#endif
 	if (!state->WroteHeader) {
 		state->WroteHeader = true;
 		Deflate_PushBits(state, 3, 3); /* final block TRUE, block type FIXED */
@@ -994,8 +1687,14 @@ static cc_result Deflate_StreamClose(struct Stream* stream) {
 	res   = Deflate_FlushBlock(state, state->InputPosition - DEFLATE_BLOCK_SIZE);
 	if (res) return res;
 
-	/* Write huffman encoded "literal 256" to terminate symbols */
-	Deflate_PushLit(state, 256);
+	if (state->Level > DEFLATE_LEVEL_FAST) {
+		/* Blocks from higher levels are already terminated, so finish with an empty final block */
+		Deflate_PushBits(state, 3, 3); /* final block TRUE, block type FIXED */
+		Deflate_PushBits(state, 0, 7); /* "literal 256" in fixed huffman codes */
+	} else {
+		/* Write huffman encoded "literal 256" to terminate symbols */
+		Deflate_PushLit(state, 256);
+	}
 	Deflate_FlushBits(state);
 
 	/* In case last byte still has a few extra bits */
@@ -1007,26 +1706,6 @@ static cc_result Deflate_StreamClose(struct Stream* stream) {
 	return Stream_Write(state->Dest, state->Output, DEFLATE_OUT_SIZE - state->AvailOut);
 }
 
-/* Constructs a huffman encoding table (for values to codewords) */
-static void Deflate_BuildTable(const cc_uint8* lens, int count, cc_uint16* codewords, cc_uint8* bitlens) {
-	int i, j, offset, codeword;
-	struct HuffmanTable table;
-
-	/* NOTE: Can ignore since lens table is not user controlled */
-	(void)Huffman_Build(&table, lens, count);
-	for (i = 0; i < INFLATE_MAX_BITS; i++) {
-		if (!table.endCodewords[i]) continue;
-		count = table.endCodewords[i] - table.firstCodewords[i];
-
-		for (j = 0; j < count; j++) {
-			offset   = table.values[table.firstOffsets[i] + j];
-			codeword = table.firstCodewords[i] + j;
-			bitlens[offset]   = i;
-			codewords[offset] = Huffman_ReverseBits(codeword, i);
-		}
-	}
-}
-
 void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struct Stream* underlying) {
 	Stream_Init(stream);
 	stream->meta.inflate = state;
@@ -1042,6 +1721,7 @@ void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struc
 	state->AvailOut = DEFLATE_OUT_SIZE;
 	state->Dest     = underlying;
 	state->WroteHeader = false;
+	state->Level       = DEFLATE_LEVEL_FAST;
 
 	Mem_Set(state->Head, 0, sizeof(state->Head));
 	Mem_Set(state->Prev, 0, sizeof(state->Prev));
@@ -1049,6 +1729,11 @@ void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struc
 }
 
 
+void Deflate_SetLevel(struct DeflateState* state, int level) {
+	state->Level = max(DEFLATE_LEVEL_FAST, min(level, DEFLATE_LEVEL_MAX));
+}
+
+
 /*########################################################################################################################*
 *-----------------------------------------------------GZip (compress)-----------------------------------------------------*
 *#########################################################################################################################*/
@@ -1096,6 +1781,654 @@ void GZip_MakeStream(struct Stream* stream, struct GZipState* state, struct Stre
 }
 
 
+/*########################################################################################################################*
+*-------------------------------------------------GZip (parallel compress)------------------------------------------------*
+*#########################################################################################################################*/
+#ifdef GZIP_PARALLEL
+/* Amount of the previous chunk that each chunk is primed with */
+#define GZIP_PARALLEL_DICT DEFLATE_BLOCK_SIZE
+#define GZIP_PARALLEL_MAX_JOBS (GZIP_PARALLEL_MAX_WORKERS * 2)
+
+struct GZipJob {
+	cc_uint8 input[GZIP_PARALLEL_DICT + GZIP_PARALLEL_CHUNK]; /* End of previous chunk, followed by this chunk */
+	cc_uint32 dictLen, len;
+	cc_uint8* output;
+	cc_uint32 outputLen, outputCapacity;
+	cc_uint32 crc32;
+	cc_bool last, done;
+	cc_result result;
+};
+
+static struct GZipParallelState {
+	struct Stream* dest;
+	struct GZipJob* jobs[GZIP_PARALLEL_MAX_JOBS];
+	struct DeflateState* deflaters[GZIP_PARALLEL_MAX_WORKERS];
+	void* threads[GZIP_PARALLEL_MAX_WORKERS];
+	void* waitables[GZIP_PARALLEL_MAX_WORKERS];
+	void* mutex;
+	void* jobDone;
+	int numWorkers, numJobs, workersStarted, level;
+	/* Number of chunks submitted to/taken by workers/written to destination */
+	int submitted, taken, written;
+	cc_bool stop, wroteHeader;
+	cc_uint32 crc32, size;
+	cc_result result;
+	/* Offset of each chunk's compressed data, when writing a GZipIndex */
+	cc_bool indexed;
+	cc_uint32* offsets;
+	cc_uint32 compressedSize;
+} gzipParallel;
+static cc_bool gzipParallelActive;
+
+/* Returns x^(2^k) mod p(x), where p(x) is the CRC32 polynomial (in reversed bit order) */
+static cc_uint32 Crc32_MultModP(cc_uint32 a, cc_uint32 b) {
+	cc_uint32 m = 1UL << 31, p = 0;
+
+	for (;;) {
+		if (a & m) {
+			p ^= b;
+			if ((a & (m - 1)) == 0) break;
+		}
+		m >>= 1;
+		b = (b & 1) ? (b >> 1) ^ 0xEDB88320UL : b >> 1;
+	}
+	return p;
+}
+
+/* Calculates CRC32 of A followed by B, from CRC32 of A, CRC32 of B, and length of B */
+/* Works by multiplying CRC32 of A by x^(8 * lenB) modulo p(x) (see zlib's crc32_combine) */
+static cc_uint32 Crc32_Combine(cc_uint32 crcA, cc_uint32 crcB, cc_uint32 lenB) {
+	cc_uint32 square = 1UL << 23; /* x^8, i.e. one byte */
+	cc_uint32 power  = 1UL << 31; /* x^0 */
+
+	for (; lenB; lenB >>= 1) {
+		if (lenB & 1) power = Crc32_MultModP(square, power);
+		square = Crc32_MultModP(square, square);
+	}
+	return Crc32_MultModP(power, crcA) ^ crcB;
+}
+
+static cc_result GZipJob_StreamWrite(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	struct GZipJob* job = (struct GZipJob*)stream->meta.inflate;
+	cc_uint32 capacity;
+	cc_uint8* output;
+
+	if (job->outputLen + count > job->outputCapacity) {
+		capacity = max(job->outputCapacity * 2, job->outputLen + count);
+		output   = (cc_uint8*)Mem_TryRealloc(job->output, capacity, 1);
+		if (!output) return ERR_OUT_OF_MEMORY;
+
+		job->output = output;
+		job->outputCapacity = capacity;
+	}
+
+	Mem_Copy(job->output + job->outputLen, data, count);
+	job->outputLen += count;
+	*modified = count;
+	return 0;
+}
+
+/* Primes the hash chains with data that came before what will be compressed */
+static void Deflate_SetDictionary(struct DeflateState* state, const cc_uint8* data, int len) {
+	int i, start = DEFLATE_BLOCK_SIZE - len;
+	Mem_Copy(state->Input + start, data, len);
+
+	/* Position 0 means 'no entry' in hash chains, so can't be inserted */
+	for (i = max(start, 1); i <= DEFLATE_BLOCK_SIZE - MIN_MATCH_LEN; i++) {
+		Deflate_Insert(state, i);
+	}
+}
+
+/* Compresses any buffered data, then pads to a byte boundary with an empty uncompressed block */
+static cc_result Deflate_SyncFlush(struct DeflateState* state) {
+	cc_result res = Deflate_FlushBlock(state, state->InputPosition - DEFLATE_BLOCK_SIZE);
+	if (res) return res;
+	return Deflate_WriteStored(state, 0);
+}
+
+static void GZipJob_Compress(struct DeflateState* state, struct GZipJob* job) {
+	struct Stream output, stream;
+	cc_uint8* data = job->input + GZIP_PARALLEL_DICT;
+	cc_uint32 i, crc32 = 0xFFFFFFFFUL;
+	cc_result res;
+
+	for (i = 0; i < job->len; i++) {
+		crc32 = Utils_Crc32Table[(crc32 ^ data[i]) & 0xFF] ^ (crc32 >> 8);
+	}
+	job->crc32     = crc32 ^ 0xFFFFFFFFUL;
+	job->outputLen = 0;
+
+	Stream_Init(&output);
+	output.meta.inflate = job;
+	output.Write        = GZipJob_StreamWrite;
+
+	/* Higher levels are required, as the fast level only ever writes a single final block */
+	Deflate_MakeStream(&stream, state, &output);
+	Deflate_SetLevel(state, max(gzipParallel.level, DEFLATE_LEVEL_FAST + 1));
+	Deflate_SetDictionary(state, data - job->dictLen, job->dictLen);
+
+	res = Stream_Write(&stream, data, job->len);
+	if (!res) res = job->last ? Deflate_StreamClose(&stream) : Deflate_SyncFlush(state);
+	job->result = res;
+}
+
+static void GZipWorker_Loop(void) {
+	struct GZipParallelState* s = &gzipParallel;
+	struct DeflateState* deflater;
+	struct GZipJob* job;
+	void* waitable;
+	cc_bool stop;
+	int id;
+
+	Mutex_Lock(s->mutex);
+	id = s->workersStarted++;
+	Mutex_Unlock(s->mutex);
+	deflater = s->deflaters[id];
+	waitable = s->waitables[id];
+
+	for (;;) {
+		job = NULL;
+		Mutex_Lock(s->mutex);
+		if (s->taken < s->submitted) job = s->jobs[s->taken++ % s->numJobs];
+		stop = s->stop;
+		Mutex_Unlock(s->mutex);
+
+		if (!job) {
+			if (stop) return;
+			/* Waitable_Wait may return spuriously, so always recheck */
+			Waitable_Wait(waitable); continue;
+		}
+		GZipJob_Compress(deflater, job);
+
+		Mutex_Lock(s->mutex);
+		job->done = true;
+		Mutex_Unlock(s->mutex);
+		Waitable_Signal(s->jobDone);
+	}
+}
+
+static void GZipParallel_AddOffset(struct GZipParallelState* s) {
+	int chunk = s->written - 1, count = chunk / GZIP_INDEX_SPAN;
+	cc_uint32* offsets;
+	/* Only chunks that start a span are unprimed, so those are the only restart points */
+	if (chunk % GZIP_INDEX_SPAN) return;
+
+	/* Grow offsets array every 256 chunks */
+	if (count && (count & 0xFF) == 0) {
+		offsets = (cc_uint32*)Mem_TryRealloc(s->offsets, count + 256, 4);
+		/* Out of memory just means no index is written */
+		if (!offsets) { Mem_Free(s->offsets); s->offsets = NULL; return; }
+		s->offsets = offsets;
+	}
+	s->offsets[count] = s->compressedSize;
+}
+
+/* Waits for the oldest submitted chunk to be compressed, then writes it to the destination */
+static cc_result GZipParallel_WriteNext(struct GZipParallelState* s) {
+	static cc_uint8 header[10] = { 0x1F, 0x8B, 0x08 }; /* GZip header */
+	struct GZipJob* job = s->jobs[s->written % s->numJobs];
+	cc_bool done;
+	cc_result res;
+
+	for (;;) {
+		Mutex_Lock(s->mutex);
+		done = job->done;
+		Mutex_Unlock(s->mutex);
+
+		if (done) break;
+		Waitable_Wait(s->jobDone);
+	}
+	s->written++;
+
+	if ((res = job->result)) return res;
+	if (!s->wroteHeader) {
+		s->wroteHeader = true;
+		if ((res = Stream_Write(s->dest, header, sizeof(header)))) return res;
+	}
+
+	if (s->offsets) GZipParallel_AddOffset(s);
+	s->crc32 = Crc32_Combine(s->crc32, job->crc32, job->len);
+	s->size += job->len;
+	s->compressedSize += job->outputLen;
+	return Stream_Write(s->dest, job->output, job->outputLen);
+}
+
+/* Hands the chunk currently being filled to the worker threads */
+static cc_result GZipParallel_Submit(struct GZipParallelState* s, cc_bool last) {
+	struct GZipJob* job  = s->jobs[s->submitted % s->numJobs];
+	struct GZipJob* next = s->jobs[(s->submitted + 1) % s->numJobs];
+	cc_result res;
+	int i;
+
+	job->last = last;
+	job->done = false;
+
+	Mutex_Lock(s->mutex);
+	s->submitted++;
+	Mutex_Unlock(s->mutex);
+
+	for (i = 0; i < s->numWorkers; i++) 
+	{
+		Waitable_Signal(s->waitables[i]);
+	}
+	if (last) return 0;
+
+	/* Wait for the next job to be free, before it's primed with the end of this chunk */
+	if (s->submitted - s->written == s->numJobs) {
+		if ((res = GZipParallel_WriteNext(s))) return res;
+	}
+
+	next->len     = 0;
+	/* Each indexed span must be independently decompressable */
+	next->dictLen = (s->indexed && s->submitted % GZIP_INDEX_SPAN == 0) ? 0 : min(job->len, GZIP_PARALLEL_DICT);
+	Mem_Copy(next->input + GZIP_PARALLEL_DICT - next->dictLen, 
+			 job->input  + GZIP_PARALLEL_DICT + job->len - next->dictLen, next->dictLen);
+	return 0;
+}
+
+static cc_result GZipParallel_StreamWrite(struct Stream* stream, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	struct GZipParallelState* s = &gzipParallel;
+	struct GZipJob* job;
+	cc_uint32 len;
+	cc_result res;
+	*modified = 0;
+
+	if (s->result) return s->result;
+	while (count) {
+		job = s->jobs[s->submitted % s->numJobs];
+		len = min(count, GZIP_PARALLEL_CHUNK - job->len);
+
+		Mem_Copy(job->input + GZIP_PARALLEL_DICT + job->len, data, len);
+		job->len  += len;
+		*modified += len;
+		data      += len;
+		count     -= len;
+
+		if (job->len < GZIP_PARALLEL_CHUNK) break;
+		if ((res = GZipParallel_Submit(s, false))) { s->result = res; return res; }
+	}
+	return 0;
+}
+
+static void GZipParallel_Free(struct GZipParallelState* s) {
+	int i;
+	Mutex_Lock(s->mutex);
+	s->stop = true;
+	Mutex_Unlock(s->mutex);
+
+	for (i = 0; i < s->numWorkers; i++) 
+	{
+		Waitable_Signal(s->waitables[i]);
+		Thread_Join(s->threads[i]);
+		Waitable_Free(s->waitables[i]);
+		Mem_Free(s->deflaters[i]);
+	}
+
+	for (i = 0; i < s->numJobs; i++) 
+	{
+		Mem_Free(s->jobs[i]->output);
+		Mem_Free(s->jobs[i]);
+	}
+
+	Mutex_Free(s->mutex);
+	Waitable_Free(s->jobDone);
+	Mem_Free(s->offsets);
+	gzipParallelActive = false;
+}
+
+#define GZIP_INDEX_CHUNK (GZIP_PARALLEL_CHUNK * GZIP_INDEX_SPAN)
+/* Appends the index as an empty GZIP member, which is the FEXTRA field, so that the file is still valid GZIP */
+static cc_result GZipIndex_Write(struct GZipParallelState* s) {
+	static const cc_uint8 header[10] = { 0x1F, 0x8B, 0x08, 0x04 }; /* GZip header, with FEXTRA flag */
+	/* Empty final fixed block, then CRC32 and size of 0 */
+	static const cc_uint8 footer[GZIP_INDEX_FOOTER_SIZE] = { 0x03, 0x00 };
+	/* Last chunk is empty when size is an exact multiple of chunk size, which isn't worth an entry */
+	cc_uint32 i, count = (s->size + GZIP_INDEX_CHUNK - 1) / GZIP_INDEX_CHUNK, len = count * 4 + 12;
+	cc_uint8 tmp[12];
+	cc_result res;
+
+	if (len > GZIP_INDEX_MAX_DATA) return 0;
+	if ((res = Stream_Write(s->dest, header, sizeof(header)))) return res;
+
+	Stream_SetU16_LE(&tmp[0], len + 4);
+	tmp[2] = 'C'; tmp[3] = 'I';
+	Stream_SetU16_LE(&tmp[4], len);
+	if ((res = Stream_Write(s->dest, tmp, 6))) return res;
+
+	for (i = 0; i < count; i++) 
+	{
+		Stream_SetU32_LE(tmp, s->offsets[i]);
+		if ((res = Stream_Write(s->dest, tmp, 4))) return res;
+	}
+
+	Stream_SetU32_LE(&tmp[0], GZIP_INDEX_CHUNK);
+	Stream_SetU32_LE(&tmp[4], s->size);
+	Stream_SetU32_LE(&tmp[8], count);
+	if ((res = Stream_Write(s->dest, tmp, 12))) return res;
+	return Stream_Write(s->dest, footer, sizeof(footer));
+}
+
+static cc_result GZipParallel_StreamClose(struct Stream* stream) {
+	struct GZipParallelState* s = &gzipParallel;
+	cc_result res = s->result;
+	cc_uint8 data[8];
+
+	/* Last chunk must always be submitted, since it's where the final block comes from */
+	if (!res) res = GZipParallel_Submit(s, true);
+	while (s->written < s->submitted) {
+		cc_result writeRes = GZipParallel_WriteNext(s);
+		if (!res) res = writeRes;
+	}
+
+	if (!res) {
+		Stream_SetU32_LE(&data[0], s->crc32);
+		Stream_SetU32_LE(&data[4], s->size);
+		res = Stream_Write(s->dest, data, sizeof(data));
+	}
+	if (!res && s->offsets) res = GZipIndex_Write(s);
+	GZipParallel_Free(s);
+	return res;
+}
+
+/* Allocates memory for jobs and worker state, returning false if unable to */
+static cc_bool GZipParallel_Alloc(struct GZipParallelState* s, int workers) {
+	int i;
+	s->numWorkers = 0;
+	s->numJobs    = 0;
+
+	for (i = 0; i < workers * 2; i++) 
+	{
+		s->jobs[i] = (struct GZipJob*)Mem_TryAllocCleared(1, sizeof(struct GZipJob));
+		if (!s->jobs[i]) break;
+		s->numJobs++;
+
+		s->jobs[i]->outputCapacity = GZIP_PARALLEL_CHUNK / 2;
+		s->jobs[i]->output = (cc_uint8*)Mem_TryAlloc(s->jobs[i]->outputCapacity, 1);
+		if (!s->jobs[i]->output) break;
+	}
+
+	for (i = 0; i < workers; i++) 
+	{
+		s->deflaters[i] = (struct DeflateState*)Mem_TryAlloc(1, sizeof(struct DeflateState));
+		if (!s->deflaters[i]) break;
+		s->numWorkers++;
+	}
+	if (s->numJobs == workers * 2 && s->numWorkers == workers && s->jobs[s->numJobs - 1]->output) return true;
+
+	for (i = 0; i < s->numJobs;    i++) { Mem_Free(s->jobs[i]->output); Mem_Free(s->jobs[i]); }
+	for (i = 0; i < s->numWorkers; i++) { Mem_Free(s->deflaters[i]); }
+	return false;
+}
+
+void GZip_MakeParallelStream(struct Stream* stream, struct GZipState* fallback, struct Stream* underlying,
+							int level, int workers, cc_bool indexed) {
+	struct GZipParallelState* s = &gzipParallel;
+	int i;
+	workers = min(workers, GZIP_PARALLEL_MAX_WORKERS);
+
+	/* Only one parallel stream can be used at a time */
+	if (workers <= 0 || gzipParallelActive || !GZipParallel_Alloc(s, workers)) {
+		GZip_MakeStream(stream, fallback, underlying);
+		Deflate_SetLevel(&fallback->Base, level);
+		return;
+	}
+
+	Stream_Init(stream);
+	stream->Write = GZipParallel_StreamWrite;
+	stream->Close = GZipParallel_StreamClose;
+	gzipParallelActive = true;
+
+	s->dest   = underlying;
+	s->level  = level;
+	s->crc32  = 0;
+	s->size   = 0;
+	s->result = 0;
+	s->stop   = false;
+	s->wroteHeader    = false;
+	s->workersStarted = 0;
+	s->submitted = 0; s->taken = 0; s->written = 0;
+
+	s->indexed = indexed;
+	s->offsets = indexed ? (cc_uint32*)Mem_TryAlloc(256, 4) : NULL;
+	s->compressedSize = 0;
+
+	s->mutex   = Mutex_Create("GZip jobs");
+	s->jobDone = Waitable_Create("GZip done");
+	for (i = 0; i < s->numWorkers; i++)
+	{
+		s->waitables[i] = Waitable_Create("GZip worker");
+	}
+	/* All waitables must be created before starting any of the threads */
+	for (i = 0; i < s->numWorkers; i++)
+	{
+		Thread_Run(&s->threads[i], GZipWorker_Loop, 64 * 1024, "GZip compressor");
+	}
+}
+
+/*########################################################################################################################*
+*-----------------------------------------------GZip (indexed decompress)-------------------------------------------------*
+*#########################################################################################################################*/
+static cc_result GZipIndex_ReadCore(struct GZipIndex* index, struct Stream* stream) {
+	static const cc_uint8 footer[GZIP_INDEX_FOOTER_SIZE] = { 0x03, 0x00 };
+	cc_uint8 tail[12 + GZIP_INDEX_FOOTER_SIZE];
+	cc_uint8 header[16];
+	cc_uint32 i, length, len;
+	cc_result res;
+
+	if ((res = stream->Length(stream, &length))) return res;
+	if (length < sizeof(header) + sizeof(tail))  return GZIP_ERR_NO_INDEX;
+
+	if ((res = stream->Seek(stream, length - sizeof(tail))))  return res;
+	if ((res = Stream_Read(stream, tail, sizeof(tail))))      return res;
+	if (!Mem_Equal(&tail[12], footer, sizeof(footer)))        return GZIP_ERR_NO_INDEX;
+
+	index->chunkSize = Stream_GetU32_LE(&tail[0]);
+	index->size      = Stream_GetU32_LE(&tail[4]);
+	index->count     = Stream_GetU32_LE(&tail[8]);
+	if (!index->chunkSize || index->count > GZIP_INDEX_MAX_DATA / 4) return GZIP_ERR_NO_INDEX;
+	if (index->count != (index->size + index->chunkSize - 1) / index->chunkSize) return GZIP_ERR_NO_INDEX;
+
+	len = index->count * 4 + 12;
+	if (length < sizeof(header) + len + GZIP_INDEX_FOOTER_SIZE) return GZIP_ERR_NO_INDEX;
+	index->end = length - GZIP_INDEX_FOOTER_SIZE - len - sizeof(header);
+
+	if ((res = stream->Seek(stream, index->end)))            return res;
+	if ((res = Stream_Read(stream, header, sizeof(header)))) return res;
+	if (header[0] != 0x1F || header[1] != 0x8B || header[3] != 0x04)  return GZIP_ERR_NO_INDEX;
+	if (header[12] != 'C' || header[13] != 'I')                        return GZIP_ERR_NO_INDEX;
+	if (Stream_GetU16_LE(&header[14]) != len)                          return GZIP_ERR_NO_INDEX;
+
+	index->offsets = (cc_uint32*)Mem_TryAlloc(max(index->count, 1), 4);
+	if (!index->offsets) return ERR_OUT_OF_MEMORY;
+
+	for (i = 0; i < index->count; i++) 
+	{
+		if ((res = Stream_Read(stream, tail, 4))) return res;
+		index->offsets[i] = Stream_GetU32_LE(tail);
+		if (i && index->offsets[i] <= index->offsets[i - 1]) return GZIP_ERR_NO_INDEX;
+	}
+	return 0;
+}
+
+cc_result GZipIndex_Read(struct GZipIndex* index, struct Stream* stream) {
+	cc_uint32 pos;
+	cc_result res;
+	Mem_Set(index, 0, sizeof(*index));
+
+	if ((res = stream->Position(stream, &pos))) return res;
+	res = GZipIndex_ReadCore(index, stream);
+	if (res) GZipIndex_Free(index);
+
+	/* Restore position regardless of whether index was read */
+	return stream->Seek(stream, pos) ? GZIP_ERR_NO_INDEX : res;
+}
+
+void GZipIndex_Free(struct GZipIndex* index) {
+	Mem_Free(index->offsets);
+	Mem_Free(index->data);
+	Mem_Free(index->cache);
+	Mem_Free(index->inflater);
+
+	index->offsets  = NULL;
+	index->data     = NULL;
+	index->cache    = NULL;
+	index->inflater = NULL;
+}
+
+static cc_uint32 GZipIndex_ChunkLen(struct GZipIndex* index, int chunk) {
+	return min(index->chunkSize, index->size - chunk * index->chunkSize);
+}
+
+static cc_result GZipIndex_Inflate(struct GZipIndex* index, struct InflateState* state, int chunk, cc_uint8* dst) {
+	struct Stream mem, stream;
+	cc_uint32 offset = index->offsets[chunk];
+	if (offset >= index->dataLen) return ERR_END_OF_STREAM;
+
+	Stream_ReadonlyMemory(&mem, index->data + offset, index->dataLen - offset);
+	Inflate_MakeStream2(&stream, state, &mem);
+	return Stream_Read(&stream, dst, GZipIndex_ChunkLen(index, chunk));
+}
+
+static struct GZipIndexJobs {
+	struct GZipIndex* index;
+	cc_uint8* dst;
+	void* mutex;
+	int first, next, end;
+	cc_result result;
+} gzipIndexJobs;
+
+static void GZipIndex_RunJobs(struct InflateState* state) {
+	struct GZipIndexJobs* j = &gzipIndexJobs;
+	cc_uint32 offset;
+	cc_result res;
+	int chunk;
+
+	for (;;) {
+		Mutex_Lock(j->mutex);
+		chunk = j->result ? j->end : j->next++;
+		Mutex_Unlock(j->mutex);
+		if (chunk >= j->end) return;
+
+		offset = (chunk - j->first) * j->index->chunkSize;
+		if (!(res = GZipIndex_Inflate(j->index, state, chunk, j->dst + offset))) continue;
+
+		Mutex_Lock(j->mutex);
+		if (!j->result) j->result = res;
+		Mutex_Unlock(j->mutex);
+	}
+}
+
+static void GZipIndex_WorkerLoop(void) {
+	struct InflateState* state = (struct InflateState*)Mem_TryAlloc(1, sizeof(struct InflateState));
+	/* Other threads will just pick up more chunks when out of memory */
+	if (!state) return;
+
+	GZipIndex_RunJobs(state);
+	Mem_Free(state);
+}
+
+/* Decompresses the given range of chunks directly into dst, spread across multiple threads */
+static cc_result GZipIndex_InflateChunks(struct GZipIndex* index, int first, int end, cc_uint8* dst) {
+	struct GZipIndexJobs* j = &gzipIndexJobs;
+	void* threads[GZIP_PARALLEL_MAX_WORKERS];
+	int i, numThreads = min(index->workers, end - first - 1);
+
+	j->index  = index;
+	j->dst    = dst;
+	j->first  = first;
+	j->next   = first;
+	j->end    = end;
+	j->result = 0;
+	j->mutex  = Mutex_Create("GZip index jobs");
+
+	for (i = 0; i < numThreads; i++)
+	{
+		Thread_Run(&threads[i], GZipIndex_WorkerLoop, 64 * 1024, "GZip decompressor");
+	}
+	/* Main thread would otherwise just be waiting, so it decompresses chunks too */
+	GZipIndex_RunJobs(index->inflater);
+
+	for (i = 0; i < numThreads; i++)
+	{
+		Thread_Join(threads[i]);
+	}
+	Mutex_Free(j->mutex);
+	return j->result;
+}
+
+static cc_result GZipIndex_LoadData(struct GZipIndex* index) {
+	cc_uint32 pos;
+	cc_result res;
+
+	if ((res = index->source->Position(index->source, &pos))) return res;
+	if (pos > index->end) return GZIP_ERR_NO_INDEX;
+
+	index->dataLen  = index->end - pos;
+	index->data     = (cc_uint8*)Mem_TryAlloc(max(index->dataLen, 1), 1);
+	index->cache    = (cc_uint8*)Mem_TryAlloc(index->chunkSize, 1);
+	index->inflater = (struct InflateState*)Mem_TryAlloc(1, sizeof(struct InflateState));
+
+	if (!index->data || !index->cache || !index->inflater) return ERR_OUT_OF_MEMORY;
+	return Stream_Read(index->source, index->data, index->dataLen);
+}
+
+static cc_result Inflate_IndexedRead(struct Stream* stream, cc_uint8* dst, cc_uint32 count, cc_uint32* modified) {
+	struct GZipIndex* index = (struct GZipIndex*)stream->meta.inflate;
+	cc_uint32 offset, len;
+	int chunk, end;
+	cc_result res;
+	*modified = 0;
+
+	if (!index->data && (res = GZipIndex_LoadData(index))) return res;
+	if (index->position >= index->size) return 0;
+
+	chunk  = index->position / index->chunkSize;
+	offset = index->position % index->chunkSize;
+	len    = GZipIndex_ChunkLen(index, chunk);
+
+	if (offset == 0 && count >= len) {
+		/* Read covers one or more whole chunks, so decompress those directly into destination */
+		end = chunk + 1 + (count - len) / index->chunkSize;
+		end = min(end, (int)index->count);
+		len = min(count, index->size - index->position);
+		len = (end == (int)index->count) ? len : (end - chunk) * index->chunkSize;
+
+		if ((res = GZipIndex_InflateChunks(index, chunk, end, dst))) return res;
+	} else {
+		if (index->cachedChunk != chunk) {
+			index->cachedChunk = -1;
+			if ((res = GZipIndex_Inflate(index, index->inflater, chunk, index->cache))) return res;
+			index->cachedChunk = chunk;
+		}
+
+		len = min(count, len - offset);
+		Mem_Copy(dst, index->cache + offset, len);
+	}
+
+	index->position += len;
+	*modified = len;
+	return 0;
+}
+
+void Inflate_MakeIndexedStream(struct Stream* stream, struct GZipIndex* index, struct Stream* underlying, int workers) {
+	Stream_Init(stream);
+	stream->meta.inflate = index;
+	stream->Read = Inflate_IndexedRead;
+
+	index->source      = underlying;
+	index->position    = 0;
+	index->cachedChunk = -1;
+	index->workers     = min(workers, GZIP_PARALLEL_MAX_WORKERS);
+}
+#else
+void GZip_MakeParallelStream(struct Stream* stream, struct GZipState* fallback, struct Stream* underlying,
+							int level, int workers, cc_bool indexed) {
+	GZip_MakeStream(stream, fallback, underlying);
+	Deflate_SetLevel(&fallback->Base, level);
+}
+#endif
+
+
 /*########################################################################################################################*
 *-----------------------------------------------------ZLib (compress)-----------------------------------------------------*
 *#########################################################################################################################*/
@@ -37,6 +37,13 @@ cc_result ZLibHeader_Read(struct Stream* s, struct ZLibHeader* header);
 #define INFLATE_WINDOW_SIZE 0x8000UL
 #define INFLATE_WINDOW_MASK 0x7FFFUL
 
+#ifndef CC_BUILD_LOWMEM
+/* Literals/lengths are decoded using a larger two-level table, which can also decode two literals at once */
+#define INFLATE_MULTI_BITS 11
+/* Size of the area for the second level tables of codewords longer than INFLATE_MULTI_BITS */
+#define INFLATE_MULTI_SUBTABLES 1024
+#endif
+
 struct HuffmanTable {
 	cc_int16 fast[1 << INFLATE_FAST_BITS];      /* Fast lookup table for huffman codes */
 	cc_uint16 firstCodewords[INFLATE_MAX_BITS]; /* Starting codeword for each bit length */
@@ -71,6 +78,9 @@ struct InflateState {
 	struct HuffmanTable TableDists;         /* Values represent distances back */
 	cc_uint8 Window[INFLATE_WINDOW_SIZE];    /* Holds circular buffer of recent output data, used for LZ77 */
 	cc_result result;
+#ifdef INFLATE_MULTI_BITS
+	cc_uint32 Multi[(1 << INFLATE_MULTI_BITS) + INFLATE_MULTI_SUBTABLES]; /* Multi-symbol lits/lens table */
+#endif
 };
 
 /* Initialises DEFLATE decompressor state to defaults. */
@@ -82,6 +92,10 @@ void Inflate_Process(struct InflateState* s);
 /* NOTE: This only uncompresses pure DEFLATE compressed data. */
 /* If data starts with a GZIP or ZLIB header, use GZipHeader_Read or ZLibHeader_Read to first skip it. */
 CC_API void Inflate_MakeStream2(struct Stream* stream, struct InflateState* state, struct Stream* underlying);
+#ifdef INFLATE_MULTI_BITS
+/* Whether to decode one symbol at a time in the fast path instead (only useful for benchmarking) */
+extern cc_bool Inflate_SingleSymbol;
+#endif
 
 
 #define DEFLATE_BLOCK_SIZE  16384
@@ -89,6 +103,17 @@ CC_API void Inflate_MakeStream2(struct Stream* stream, struct InflateState* stat
 #define DEFLATE_OUT_SIZE 8192
 #define DEFLATE_HASH_SIZE 0x1000UL
 #define DEFLATE_HASH_MASK 0x0FFFUL
+
+/* Level 1 is a fast greedy matcher that only outputs a single fixed huffman block */
+/* Levels 2 to 9 search longer hash chains, lazily match, and output dynamic huffman blocks */
+#define DEFLATE_LEVEL_FAST    1
+#define DEFLATE_LEVEL_DEFAULT 6
+#ifdef CC_BUILD_LOWMEM
+#define DEFLATE_LEVEL_MAX 1
+#else
+#define DEFLATE_LEVEL_MAX 9
+#endif
+
 struct DeflateState {
 	cc_uint32 Bits;         /* Holds bits across byte boundaries */
 	cc_uint32 NumBits;      /* Number of bits in Bits buffer */
@@ -108,10 +133,19 @@ struct DeflateState {
 	/* NOTE: The largest possible value that can get */
 	/*  stored in Head/Prev is <= DEFLATE_BUFFER_SIZE */
 	cc_bool WroteHeader;
+	cc_uint8 Level;
+#if DEFLATE_LEVEL_MAX > DEFLATE_LEVEL_FAST
+	cc_uint16 DistsCodewords[INFLATE_MAX_DISTS];
+	cc_uint8 DistsLens[INFLATE_MAX_DISTS];
+	cc_uint32 Syms[DEFLATE_BLOCK_SIZE]; /* Literals and length/distance pairs of current block */
+#endif
 };
 /* Compresses input data using DEFLATE, then writes compressed output to another stream. Write only stream. */
 /* DEFLATE compression is pure compressed data, there is no header or footer. */
 CC_API void Deflate_MakeStream(struct Stream* stream, struct DeflateState* state, struct Stream* underlying);
+/* Sets the compression level (clamped to between DEFLATE_LEVEL_FAST and DEFLATE_LEVEL_MAX) */
+/* NOTE: Must be called before any data is written. Streams default to DEFLATE_LEVEL_FAST */
+void Deflate_SetLevel(struct DeflateState* state, int level);
 
 struct GZipState { struct DeflateState Base; cc_uint32 Crc32, Size; };
 /* Compresses input data using GZIP, then writes compressed output to another stream. Write only stream. */
@@ -119,6 +153,50 @@ struct GZipState { struct DeflateState Base; cc_uint32 Crc32, Size; };
 CC_API  void GZip_MakeStream(      struct Stream* stream, struct GZipState* state, struct Stream* underlying);
 typedef void (*FP_GZip_MakeStream)(struct Stream* stream, struct GZipState* state, struct Stream* underlying);
 
+#if DEFLATE_LEVEL_MAX > DEFLATE_LEVEL_FAST && !defined CC_BUILD_COOPTHREADED
+#define GZIP_PARALLEL
+#endif
+/* Amount of input data that each worker thread compresses at once */
+#define GZIP_PARALLEL_CHUNK (128 * 1024)
+#define GZIP_PARALLEL_MAX_WORKERS 8
+/* Number of chunks between each point that an indexed stream can be decompressed from */
+#define GZIP_INDEX_SPAN 4
+/* Compresses input data using GZIP on the given number of worker threads, then writes compressed output to */
+/*  another stream in order. Each chunk is primed with the end of the previous chunk, and ends on a byte boundary, */
+/*  so the output is still a single valid GZIP stream. Write only stream. */
+/* If indexed, the first chunk of every GZIP_INDEX_SPAN chunks isn't primed, and a GZipIndex of where those */
+/*  chunks start is appended, so that each span of chunks can be decompressed in parallel. */
+/* NOTE: Falls back to GZip_MakeStream with the given state when workers is 0, or threads can't be used */
+/* NOTE: Close must always be called, even after a write fails, so that the worker threads are stopped */
+void GZip_MakeParallelStream(struct Stream* stream, struct GZipState* fallback, struct Stream* underlying,
+							int level, int workers, cc_bool indexed);
+
+#ifdef GZIP_PARALLEL
+#define GZIP_INDEX_FOOTER_SIZE 10
+#define GZIP_INDEX_MAX_DATA (0xFFFF - 4)
+/* Points in a GZIP file where decompression can restart from, without needing any prior data. */
+/* Stored in an empty GZIP member at the end of the file, so other GZIP readers just ignore it. */
+struct GZipIndex {
+	cc_uint32 chunkSize, size, count; /* Uncompressed size of each chunk, total size, and number of chunks */
+	cc_uint32* offsets; /* Offset of each chunk's compressed data, relative to start of the DEFLATE data */
+	cc_uint32 end;      /* Position in file where the index starts */
+	/* State used by Inflate_MakeIndexedStream */
+	cc_uint8* data;   cc_uint32 dataLen;  /* All of the compressed data */
+	cc_uint8* cache;  cc_uint32 position; /* Holds decompressed data of last partially read chunk */
+	struct InflateState* inflater;
+	struct Stream* source;
+	int cachedChunk, workers;
+};
+/* Attempts to read the index at the end of a GZIP file. Position of the stream is restored afterwards. */
+/* Returns non-zero (and index isn't usable) if the file has no index */
+cc_result GZipIndex_Read(struct GZipIndex* index, struct Stream* stream);
+void GZipIndex_Free(struct GZipIndex* index);
+/* Decompresses DEFLATE data described by an index. Reads that span whole chunks are */
+/*  decompressed on the given number of worker threads. Read only stream. */
+/* NOTE: The rest of the compressed data is read into memory from underlying on first read */
+void Inflate_MakeIndexedStream(struct Stream* stream, struct GZipIndex* index, struct Stream* underlying, int workers);
+#endif
+
 struct ZLibState { struct DeflateState Base; cc_uint32 Adler32; };
 /* Compresses input data using ZLIB, then writes compressed output to another stream. Write only stream. */
 /* ZLIB compression is ZLIB header, followed by DEFLATE compressed data, followed by ZLIB footer. */
@@ -138,5 +138,15 @@ enum CC_ERRORS {
 	SSL_ERR_CONTEXT_DEAD = 0xCCDED070UL, /* Server shutdown the SSL context and it must be recreated */
 	PNG_ERR_16BITSAMPLES = 0xCCDED071UL, /* Image uses 16 bit samples, which is unimplemented */
 	ERR_NO_NETWORKING    = 0xCCDED072UL, /* No working network connection */
+	GZIP_ERR_NO_INDEX    = 0xCCDED073UL, /* GZIP file doesn't end with a valid restart point index */
+	RAW_ERR_IDENTIFIER   = 0xCCDED074UL, /* Raw map stream bytes #1-#8 aren't "CCRAWMAP" */
+	RAW_ERR_VERSION      = 0xCCDED075UL, /* Raw map stream bytes #9-#12 aren't 1 */
+	RAW_ERR_BLOCKS_RANGE = 0xCCDED076UL, /* Raw map block arrays extend past end of file */
+	RGN_ERR_IDENTIFIER   = 0xCCDED077UL, /* Region map stream bytes #1-#8 aren't "CCREGION" */
+	RGN_ERR_VERSION      = 0xCCDED078UL, /* Region map version or chunk size is unsupported */
+	RGN_ERR_CHUNK_RANGE  = 0xCCDED079UL, /* Region map table or chunks extend past end of file */
+	REPLAY_ERR_IDENTIFIER= 0xCCDED07AUL, /* Replay stream bytes #1-#8 aren't "CCREPLAY" */
+	REPLAY_ERR_VERSION   = 0xCCDED07BUL, /* Replay stream byte #9 isn't 1 */
+	REPLAY_ERR_DATA_SIZE = 0xCCDED07CUL, /* Replay contains more data at once than could ever be received */
 };
 #endif
@@ -13,19 +13,60 @@
 #include "Options.h"
 #include "Queue.h"
 
-struct LightNode {
-	IVec3 coords; /* 12 bytes */
-	cc_uint8 brightness; /* 1 byte */
-	/* char padding[3]; */
+/* Light nodes are packed into 4 bytes, to keep the light queues small: */
+/*  9 bits for each of the X/Y/Z coordinates (relative to the origin of the context), then 4 bits for the light level */
+/* Light spreads at most FANCY_LIGHTING_MAX_LEVEL blocks (twice that when unlighting and then relighting), */
+/*  so coordinates relative to the origin always fit in 9 bits as long as the origin is set near to the change */
+typedef cc_uint32 LightNode;
+#define LIGHTNODE_HALF_RANGE 256
+
+/* State for propagating light, with each thread that calculates lighting having its own context */
+struct LightContext {
+	struct Queue lightQueue;
+	struct Queue unlightQueue;
+	int originX, originY, originZ;
+	/* Number of light nodes processed since last added to FancyLighting_NodesProcessed */
+	int nodes;
 };
+/* Context used when calculating lighting on the main thread */
+static struct LightContext mainCtx;
+int FancyLighting_NodesProcessed;
+
+#define LightNode_Make(ctx, x, y, z, level) \
+	((cc_uint32)((x) - (ctx)->originX) | ((cc_uint32)((y) - (ctx)->originY) << 9) | \
+	((cc_uint32)((z) - (ctx)->originZ) << 18) | ((cc_uint32)(level) << 27))
+#define LightNode_X(ctx, node) ((int)( (node)        & 0x1FF) + (ctx)->originX)
+#define LightNode_Y(ctx, node) ((int)(((node) >> 9)  & 0x1FF) + (ctx)->originY)
+#define LightNode_Z(ctx, node) ((int)(((node) >> 18) & 0x1FF) + (ctx)->originZ)
+#define LightNode_Level(node)  ((cc_uint8)((node) >> 27))
+
+static void LightContext_Init(struct LightContext* ctx) {
+	Queue_Init(&ctx->lightQueue,   sizeof(LightNode));
+	Queue_Init(&ctx->unlightQueue, sizeof(LightNode));
+}
+
+static void LightContext_Free(struct LightContext* ctx) {
+	Queue_Clear(&ctx->lightQueue);
+	Queue_Clear(&ctx->unlightQueue);
+}
+
+/* Sets the coordinates that light nodes are relative to, to be centred on the given coordinates */
+/* NOTE: Must only be called when the queues are empty */
+static void LightContext_SetOrigin(struct LightContext* ctx, int x, int y, int z) {
+	ctx->originX = x - LIGHTNODE_HALF_RANGE;
+	ctx->originY = y - LIGHTNODE_HALF_RANGE;
+	ctx->originZ = z - LIGHTNODE_HALF_RANGE;
+}
 
-static struct Queue lightQueue;
-static struct Queue unlightQueue;
+/* Which light level of a cell is being calculated */
+#define LIGHT_CHANNEL_LAVA 0
+#define LIGHT_CHANNEL_LAMP 1
+#define LIGHT_CHANNEL_SKY  2
 
 /* Top face, X face, Z face, bottomY face*/
 #define PALETTE_SHADES 4
-/* One palette-group for sunlight, one palette-group for shadow */
-#define PALLETE_GROUP_COUNT 2
+/* One palette-group for each sky light level (fancy lighting only uses full shadow and full sunlight) */
+#define PALLETE_GROUP_COUNT FANCY_LIGHTING_LEVELS
 #define PALETTE_COUNT (PALETTE_SHADES * PALLETE_GROUP_COUNT)
 
 #define PALETTE_YMAX_INDEX  0
@@ -34,7 +75,7 @@ static struct Queue unlightQueue;
 #define PALETTE_YMIN_INDEX  3
 
 /* Index into palettes of light colors. */
-/* There are 8 different palettes: Four block-face shades for shadowed areas and four block-face shades for sunlit areas. */
+/* There are 64 different palettes: Four block-face shades for each of the 16 sky light levels (0 = shadow, 15 = sunlit). */
 /* A palette is a 16x16 color array indexed by a byte where the leftmost 4 bits represent lamplight level and the rightmost 4 bits represent lavalight level */
 /* E.G. myPalette[0b_0010_0001] will give us the color for lamp level 2 and lava level 1 (lowest level is 0) */
 static PackedCol* palettes[PALETTE_COUNT];
@@ -45,6 +86,9 @@ static cc_uint8* chunkLightingDataFlags;
 #define CHUNK_SELF_CALCULATED 1
 #define CHUNK_ALL_CALCULATED 2
 static LightingChunk* chunkLightingData;
+/* Sky light levels of cells in shadow, packed two cells per byte (only used in sky lighting mode) */
+/* Cells above the light height of their column are always fully lit, so are never stored */
+static LightingChunk* chunkSkyData;
 
 #define MakePaletteIndex(lampLevel, lavaLevel) ((lampLevel << FANCY_LIGHTING_LAMP_SHIFT) | lavaLevel)
 /* Fill in a palette with values based on the current light colors, shaded by the given shade value and lightened by the given ambientColor */
@@ -78,25 +122,37 @@ static void InitPalette(PackedCol* palette, float shaded, PackedCol ambientColor
 	}
 }
 static void InitPalettes(void) {
-	int i;
+	PackedCol ambientColor;
+	float curLerp;
+	int i, skyLevel;
+
 	for (i = 0; i < PALETTE_COUNT; i++) {
+		if (palettes[i]) continue;
 		palettes[i] = (PackedCol*)Mem_Alloc(FANCY_LIGHTING_LEVELS * FANCY_LIGHTING_LEVELS, sizeof(PackedCol), "light color palette");
 	}
-	i = 0;
-	InitPalette(palettes[i + PALETTE_YMAX_INDEX],  1,                    Env.ShadowCol);
-	InitPalette(palettes[i + PALETTE_XSIDE_INDEX], PACKEDCOL_SHADE_X,    Env.ShadowCol);
-	InitPalette(palettes[i + PALETTE_ZSIDE_INDEX], PACKEDCOL_SHADE_Z,    Env.ShadowCol);
-	InitPalette(palettes[i + PALETTE_YMIN_INDEX],  PACKEDCOL_SHADE_YMIN, Env.ShadowCol);
-	i += PALETTE_SHADES;
-	InitPalette(palettes[i + PALETTE_YMAX_INDEX],  1,                    Env.SunCol);
-	InitPalette(palettes[i + PALETTE_XSIDE_INDEX], PACKEDCOL_SHADE_X,    Env.SunCol);
-	InitPalette(palettes[i + PALETTE_ZSIDE_INDEX], PACKEDCOL_SHADE_Z,    Env.SunCol);
-	InitPalette(palettes[i + PALETTE_YMIN_INDEX],  PACKEDCOL_SHADE_YMIN, Env.SunCol);
+
+	for (skyLevel = 0; skyLevel < FANCY_LIGHTING_LEVELS; skyLevel++) {
+		if (skyLevel == FANCY_LIGHTING_MAX_LEVEL) {
+			ambientColor = Env.SunCol;
+		} else {
+			curLerp = skyLevel / (float)(FANCY_LIGHTING_LEVELS - 1);
+			curLerp *= (MATH_PI / 2);
+			curLerp = Math_CosF(curLerp);
+			ambientColor = PackedCol_Lerp(Env.ShadowCol, Env.SunCol, 1 - curLerp);
+		}
+
+		i = skyLevel * PALETTE_SHADES;
+		InitPalette(palettes[i + PALETTE_YMAX_INDEX],  1,                    ambientColor);
+		InitPalette(palettes[i + PALETTE_XSIDE_INDEX], PACKEDCOL_SHADE_X,    ambientColor);
+		InitPalette(palettes[i + PALETTE_ZSIDE_INDEX], PACKEDCOL_SHADE_Z,    ambientColor);
+		InitPalette(palettes[i + PALETTE_YMIN_INDEX],  PACKEDCOL_SHADE_YMIN, ambientColor);
+	}
 }
 static void FreePalettes(void) {
 	int i;
 	for (i = 0; i < PALETTE_COUNT; i++) {
 		Mem_Free(palettes[i]);
+		palettes[i] = NULL;
 	}
 }
 
@@ -108,8 +164,8 @@ static void AllocState(void) {
 
 	chunkLightingDataFlags = (cc_uint8*)Mem_AllocCleared(chunksCount, sizeof(cc_uint8), "light flags");
 	chunkLightingData = (LightingChunk*)Mem_AllocCleared(chunksCount, sizeof(LightingChunk), "light chunks");
-	Queue_Init(&lightQueue, sizeof(struct LightNode));
-	Queue_Init(&unlightQueue, sizeof(struct LightNode));
+	chunkSkyData      = (LightingChunk*)Mem_AllocCleared(chunksCount, sizeof(LightingChunk), "sky light chunks");
+	LightContext_Init(&mainCtx);
 }
 
 static void FreeState(void) {
@@ -123,14 +179,16 @@ static void FreeState(void) {
 
 	for (i = 0; i < chunksCount; i++) {
 		Mem_Free(chunkLightingData[i]);
+		Mem_Free(chunkSkyData[i]);
 	}
 
 	Mem_Free(chunkLightingDataFlags);
 	Mem_Free(chunkLightingData);
+	Mem_Free(chunkSkyData);
 	chunkLightingDataFlags = NULL;
 	chunkLightingData = NULL;
-	Queue_Clear(&lightQueue);
-	Queue_Clear(&unlightQueue);
+	chunkSkyData      = NULL;
+	LightContext_Free(&mainCtx);
 }
 
 /* Converts chunk x/y/z coordinates to the corresponding index in chunks array/list */
@@ -141,53 +199,72 @@ static void FreeState(void) {
 #define GlobalCoordsToChunkCoordsIndex(x, y, z) (LocalCoordsToIndex(x & CHUNK_MASK, y & CHUNK_MASK, z & CHUNK_MASK))
 
 /* Sets the light level at this cell. Does NOT check that the cell is in bounds. */
-static void SetBrightness(cc_uint8 brightness, int x, int y, int z, cc_bool isLamp, cc_bool refreshChunk) {
-	cc_uint8 clearMask, shift = isLamp ? FANCY_LIGHTING_LAMP_SHIFT : 0, prevValue;
+/* Returns false if the chunk's light data could not be allocated */
+static cc_bool SetBrightness(cc_uint8 brightness, int x, int y, int z, cc_uint8 channel, cc_bool refreshChunk) {
+	cc_uint8 clearMask, shift, prevValue;
+	cc_uint8* data;
 	int cx = x >> CHUNK_SHIFT, lx = x & CHUNK_MASK;
 	int cy = y >> CHUNK_SHIFT, ly = y & CHUNK_MASK;
 	int cz = z >> CHUNK_SHIFT, lz = z & CHUNK_MASK;
 	int chunkIndex = ChunkCoordsToIndex(cx, cy, cz);
 	int localIndex = LocalCoordsToIndex(lx, ly, lz);
 
-	if (chunkLightingData[chunkIndex] == NULL) {
-		chunkLightingData[chunkIndex] = (cc_uint8*)Mem_TryAllocCleared(CHUNK_SIZE_3, sizeof(cc_uint8));
+	if (channel == LIGHT_CHANNEL_SKY) {
+		/* Most chunks never have any cells in partial sky light */
+		if (chunkSkyData[chunkIndex] == NULL) {
+			if (!brightness) return true;
+			chunkSkyData[chunkIndex] = (cc_uint8*)Mem_TryAllocCleared(CHUNK_SIZE_3 / 2, sizeof(cc_uint8));
+			if (!chunkSkyData[chunkIndex]) return false;
+		}
+		data  = &chunkSkyData[chunkIndex][localIndex >> 1];
+		shift = (localIndex & 1) * 4;
+	} else {
+		if (chunkLightingData[chunkIndex] == NULL) {
+			chunkLightingData[chunkIndex] = (cc_uint8*)Mem_TryAllocCleared(CHUNK_SIZE_3, sizeof(cc_uint8));
+			if (!chunkLightingData[chunkIndex]) return false;
+		}
+		data  = &chunkLightingData[chunkIndex][localIndex];
+		shift = channel == LIGHT_CHANNEL_LAMP ? FANCY_LIGHTING_LAMP_SHIFT : 0;
 	}
 
 	/* 00001111 if lamp, otherwise 11110000*/
 	clearMask = ~(FANCY_LIGHTING_MAX_LEVEL << shift);
-
-	if (refreshChunk) {
-		prevValue = chunkLightingData[chunkIndex][localIndex];
-
-		chunkLightingData[chunkIndex][localIndex] &= clearMask;
-		chunkLightingData[chunkIndex][localIndex] |= brightness << shift;
-
-		/* There is no reason to refresh current chunk as the builder does that automatically */
-		if (prevValue != chunkLightingData[chunkIndex][localIndex]) {
-			if (lx == CHUNK_MAX) MapRenderer_RefreshChunk(cx + 1, cy, cz);
-			if (lx == 0)         MapRenderer_RefreshChunk(cx - 1, cy, cz);
-			if (ly == CHUNK_MAX) MapRenderer_RefreshChunk(cx, cy + 1, cz);
-			if (ly == 0)         MapRenderer_RefreshChunk(cx, cy - 1, cz);
-			if (lz == CHUNK_MAX) MapRenderer_RefreshChunk(cx, cy, cz + 1);
-			if (lz == 0)         MapRenderer_RefreshChunk(cx, cy, cz - 1);
-		}
-	}
-	else {
-		chunkLightingData[chunkIndex][localIndex] &= clearMask;
-		chunkLightingData[chunkIndex][localIndex] |= brightness << shift;
+	prevValue = *data;
+
+	*data &= clearMask;
+	*data |= brightness << shift;
+
+	/* There is no reason to refresh current chunk as the builder does that automatically */
+	if (refreshChunk && prevValue != *data) {
+		if (lx == CHUNK_MAX) MapRenderer_RefreshChunk(cx + 1, cy, cz);
+		if (lx == 0)         MapRenderer_RefreshChunk(cx - 1, cy, cz);
+		if (ly == CHUNK_MAX) MapRenderer_RefreshChunk(cx, cy + 1, cz);
+		if (ly == 0)         MapRenderer_RefreshChunk(cx, cy - 1, cz);
+		if (lz == CHUNK_MAX) MapRenderer_RefreshChunk(cx, cy, cz + 1);
+		if (lz == 0)         MapRenderer_RefreshChunk(cx, cy, cz - 1);
 	}
+	return true;
 }
 /* Returns the light level at this cell. Does NOT check that the cell is in bounds. */
-static cc_uint8 GetBrightness(int x, int y, int z, cc_bool isLamp) {
+static cc_uint8 GetBrightness(int x, int y, int z, cc_uint8 channel) {
 	int cx = x >> CHUNK_SHIFT, lx = x & CHUNK_MASK;
 	int cy = y >> CHUNK_SHIFT, ly = y & CHUNK_MASK;
 	int cz = z >> CHUNK_SHIFT, lz = z & CHUNK_MASK;
 	int chunkIndex = ChunkCoordsToIndex(cx, cy, cz), localIndex;
 
+	if (channel == LIGHT_CHANNEL_SKY) {
+		/* Cells exposed to the sky are always fully lit */
+		if (y > ClassicLighting_GetLightHeight(x, z)) return FANCY_LIGHTING_MAX_LEVEL;
+		if (chunkSkyData[chunkIndex] == NULL) { return 0; }
+
+		localIndex = LocalCoordsToIndex(lx, ly, lz);
+		return (chunkSkyData[chunkIndex][localIndex >> 1] >> ((localIndex & 1) * 4)) & FANCY_LIGHTING_MAX_LEVEL;
+	}
+
 	if (chunkLightingData[chunkIndex] == NULL) { return 0; }
 	localIndex = LocalCoordsToIndex(lx, ly, lz);
 
-	return isLamp ?
+	return channel == LIGHT_CHANNEL_LAMP ?
 		chunkLightingData[chunkIndex][localIndex] >> FANCY_LIGHTING_LAMP_SHIFT :
 		chunkLightingData[chunkIndex][localIndex] & FANCY_LIGHTING_MAX_LEVEL;
 }
@@ -214,72 +291,111 @@ static cc_bool CanLightPass(BlockID thisBlock, Face face) {
 	return !Block_IsFaceHidden(BLOCK_STONE, thisBlock, face);
 }
 
-#define Light_TrySpreadInto(axis, AXIS, dir, limit, isLamp, thisFace, thatFace) \
-	if (ln.coords.axis dir ## = limit && \
+#define Light_TrySpreadInto(coord, dir, limit, AXIS, thisFace, thatFace) \
+	if (coord dir ## = limit && \
 		CanLightPass(thisBlock, FACE_ ## AXIS ## thisFace) && \
-		CanLightPass(World_GetBlock(ln.coords.x, ln.coords.y, ln.coords.z), FACE_ ## AXIS ## thatFace) && \
-		GetBrightness(ln.coords.x, ln.coords.y, ln.coords.z, isLamp) < ln.brightness) { \
-		Queue_Enqueue(&lightQueue, &ln); \
+		CanLightPass(World_GetBlock(x, y, z), FACE_ ## AXIS ## thatFace) && \
+		GetBrightness(x, y, z, channel) < brightness) { \
+		ln = LightNode_Make(ctx, x, y, z, brightness); \
+		Queue_Enqueue(&ctx->lightQueue, &ln); \
 	} \
 
-static void FlushLightQueue(cc_bool isLamp, cc_bool refreshChunk) {
-	struct LightNode ln;
-	cc_uint8 brightnessHere;
-	BlockID thisBlock;
-
-	while (lightQueue.count > 0) {
-		ln = *(struct LightNode*)(Queue_Dequeue(&lightQueue));
-
-		brightnessHere = GetBrightness(ln.coords.x, ln.coords.y, ln.coords.z, isLamp);
+/* Queues up spreading the given light level into the neighbours of this cell */
+static void SpreadLight(struct LightContext* ctx, int x, int y, int z, cc_uint8 brightness, cc_uint8 channel) {
+	BlockID thisBlock = World_GetBlock(x, y, z);
+	LightNode ln;
+
+	x--;
+	Light_TrySpreadInto(x, > , 0, X, MAX, MIN)
+	x += 2;
+	Light_TrySpreadInto(x, < , World.MaxX, X, MIN, MAX)
+	x--;
+
+	y--;
+	Light_TrySpreadInto(y, > , 0, Y, MAX, MIN)
+	y += 2;
+	Light_TrySpreadInto(y, < , World.MaxY, Y, MIN, MAX)
+	y--;
+
+	z--;
+	Light_TrySpreadInto(z, > , 0, Z, MAX, MIN)
+	z += 2;
+	Light_TrySpreadInto(z, < , World.MaxZ, Z, MIN, MAX)
+}
 
-		/* If this cell is already more lit, we can assume this cell and its neighbors have been accounted for */
-		if (brightnessHere >= ln.brightness) { continue; }
-		if (ln.brightness == 0) { continue; }
+static void FlushLightQueue(struct LightContext* ctx, cc_uint8 channel, cc_bool refreshChunk) {
+	LightNode ln;
+	cc_uint8 brightness;
+	int x, y, z;
 
-		SetBrightness(ln.brightness, ln.coords.x, ln.coords.y, ln.coords.z, isLamp, refreshChunk);
+	while (ctx->lightQueue.count > 0) {
+		ln = *(LightNode*)(Queue_Dequeue(&ctx->lightQueue));
+		ctx->nodes++;
 
-		thisBlock = World_GetBlock(ln.coords.x, ln.coords.y, ln.coords.z);
-		ln.brightness--;
-		if (ln.brightness == 0) continue;
+		x = LightNode_X(ctx, ln);
+		y = LightNode_Y(ctx, ln);
+		z = LightNode_Z(ctx, ln);
+		brightness = LightNode_Level(ln);
 
-		ln.coords.x--;
-		Light_TrySpreadInto(x, X, > , 0, isLamp, MAX, MIN)
-		ln.coords.x += 2;
-		Light_TrySpreadInto(x, X, < , World.MaxX, isLamp, MIN, MAX)
-		ln.coords.x--;
+		/* If this cell is already more lit, we can assume this cell and its neighbors have been accounted for */
+		if (GetBrightness(x, y, z, channel) >= brightness) { continue; }
+		if (brightness == 0) { continue; }
 
-		ln.coords.y--;
-		Light_TrySpreadInto(y, Y, >, 0, isLamp, MAX, MIN)
-		ln.coords.y += 2;
-		Light_TrySpreadInto(y, Y, <, World.MaxY, isLamp, MIN, MAX)
-		ln.coords.y--;
+		/* Out of memory, so give up on spreading this light any further */
+		if (!SetBrightness(brightness, x, y, z, channel, refreshChunk)) {
+			Queue_Clear(&ctx->lightQueue); return;
+		}
 
-		ln.coords.z--;
-		Light_TrySpreadInto(z, Z, > , 0, isLamp, MAX, MIN)
-		ln.coords.z += 2;
-		Light_TrySpreadInto(z, Z, < , World.MaxZ, isLamp, MIN, MAX)
+		brightness--;
+		if (brightness == 0) continue;
+		SpreadLight(ctx, x, y, z, brightness, channel);
 	}
 }
 
-cc_uint8 GetBlockBrightness(BlockID curBlock, cc_bool isLamp) {
-	if (isLamp) return Blocks.Brightness[curBlock] >> FANCY_LIGHTING_LAMP_SHIFT;
+cc_uint8 GetBlockBrightness(BlockID curBlock, cc_uint8 channel) {
+	/* Sky light only comes from cells exposed to the sky, never from blocks */
+	if (channel == LIGHT_CHANNEL_SKY)  return 0;
+	if (channel == LIGHT_CHANNEL_LAMP) return Blocks.Brightness[curBlock] >> FANCY_LIGHTING_LAMP_SHIFT;
 	return Blocks.Brightness[curBlock] & FANCY_LIGHTING_MAX_LEVEL;
 }
 
-#define LightNode_Init(node, X, Y, Z, bright) \
-	node.coords.x = X; node.coords.y = Y; node.coords.z = Z; node.brightness = bright;
+/* Sky light spreads out of the cells exposed to the sky into neighbouring cells in shadow */
+/* Only cells at or below the light height of a neighbouring column (or directly above the */
+/*  light height of their own column) have such neighbours, so only those need to be spread from */
+static void CalculateChunkSkyLightSelf(struct LightContext* ctx, int x1, int y1, int z1, int x2, int y2, int z2) {
+	int x, y, z, height, maxY;
+
+	for (z = z1; z < z2; z++) {
+		for (x = x1; x < x2; x++) {
+			height = ClassicLighting_GetLightHeight(x, z);
+			maxY   = height + 1;
+
+			if (x > 0)          maxY = max(maxY, ClassicLighting_GetLightHeight(x - 1, z));
+			if (x < World.MaxX) maxY = max(maxY, ClassicLighting_GetLightHeight(x + 1, z));
+			if (z > 0)          maxY = max(maxY, ClassicLighting_GetLightHeight(x, z - 1));
+			if (z < World.MaxZ) maxY = max(maxY, ClassicLighting_GetLightHeight(x, z + 1));
+			maxY = min(maxY, y2 - 1);
+
+			for (y = max(height + 1, y1); y <= maxY; y++) {
+				SpreadLight(ctx, x, y, z, FANCY_LIGHTING_MAX_LEVEL - 1, LIGHT_CHANNEL_SKY);
+			}
+		}
+	}
+	FlushLightQueue(ctx, LIGHT_CHANNEL_SKY, false);
+}
 
-static void CalculateChunkLightingSelf(int chunkIndex, int cx, int cy, int cz) {
+static void CalculateChunkLightingSelf(struct LightContext* ctx, int chunkIndex, int cx, int cy, int cz) {
 	int x, y, z;
 	/* Block coordinates */
 	int chunkStartX, chunkStartY, chunkStartZ, chunkEndX, chunkEndY, chunkEndZ;
 	cc_uint8 brightness;
 	BlockID curBlock;
-	struct LightNode entry;
+	LightNode entry;
 
 	chunkStartX = cx * CHUNK_SIZE;
 	chunkStartY = cy * CHUNK_SIZE;
 	chunkStartZ = cz * CHUNK_SIZE;
+	LightContext_SetOrigin(ctx, chunkStartX + HALF_CHUNK_SIZE, chunkStartY + HALF_CHUNK_SIZE, chunkStartZ + HALF_CHUNK_SIZE);
 	chunkEndX = chunkStartX + CHUNK_SIZE;
 	chunkEndY = chunkStartY + CHUNK_SIZE;
 	chunkEndZ = chunkStartZ + CHUNK_SIZE;
@@ -296,19 +412,19 @@ static void CalculateChunkLightingSelf(int chunkIndex, int cx, int cy, int cz) {
 				
 				if (Blocks.Brightness[curBlock] > 0) {
 
-					brightness = GetBlockBrightness(curBlock, false);
+					brightness = GetBlockBrightness(curBlock, LIGHT_CHANNEL_LAVA);
 
 					if (brightness > 0) {
-						LightNode_Init(entry, x, y, z, brightness);
-						Queue_Enqueue(&lightQueue, &entry);
-						FlushLightQueue(false, false);
+						entry = LightNode_Make(ctx, x, y, z, brightness);
+						Queue_Enqueue(&ctx->lightQueue, &entry);
+						FlushLightQueue(ctx, LIGHT_CHANNEL_LAVA, false);
 					}
 					else {
 						/* If no lava brightness, it must use lamp brightness */
 						brightness = Blocks.Brightness[curBlock] >> FANCY_LIGHTING_LAMP_SHIFT;
-						LightNode_Init(entry, x, y, z, brightness);
-						Queue_Enqueue(&lightQueue, &entry);
-						FlushLightQueue(true, false);
+						entry = LightNode_Make(ctx, x, y, z, brightness);
+						Queue_Enqueue(&ctx->lightQueue, &entry);
+						FlushLightQueue(ctx, LIGHT_CHANNEL_LAMP, false);
 					}
 				}
 
@@ -319,155 +435,450 @@ static void CalculateChunkLightingSelf(int chunkIndex, int cx, int cy, int cz) {
 		}
 	}
 
+	if (Lighting_Mode == LIGHTING_MODE_SKY) {
+		CalculateChunkSkyLightSelf(ctx, chunkStartX, chunkStartY, chunkStartZ, chunkEndX, chunkEndY, chunkEndZ);
+	}
 	chunkLightingDataFlags[chunkIndex] = CHUNK_SELF_CALCULATED;
 }
 
+/*########################################################################################################################*
+*---------------------------------------------------Parallel calculation--------------------------------------------------*
+*#########################################################################################################################*/
+/* Light from the blocks in a chunk spreads at most FANCY_LIGHTING_MAX_LEVEL (less than CHUNK_SIZE) blocks, */
+/*  so calculating the light from a chunk only ever reads/writes the light data of that chunk and its 26 neighbours */
+/* Chunks whose coordinates are all the same modulo 3 are at least 3 chunks apart from each other, */
+/*  so the areas their light spreads into never overlap, and hence can be calculated in parallel */
+/* Each batch of chunks is therefore calculated in 27 phases (one for each coordinates modulo 3) */
+#define LIGHT_PHASES 27
+#define LightPhase(cx, cy, cz) (((cy) % 3) * 9 + ((cz) % 3) * 3 + ((cx) % 3))
+
+/* How many chunks around the chunk being lit to also calculate the light from at the same time */
+#define LIGHT_BATCH_RADIUS 2
+#define LIGHT_BATCH_SIZE (2 * LIGHT_BATCH_RADIUS + 1)
+#define LIGHT_MAX_JOBS (LIGHT_BATCH_SIZE * LIGHT_BATCH_SIZE * LIGHT_BATCH_SIZE)
+static int lightJobs[LIGHT_MAX_JOBS];
+static int jobsCount;
+
+static void RunJob(struct LightContext* ctx, int chunkIndex) {
+	int cx = chunkIndex % World.ChunksX;
+	int cz = (chunkIndex / World.ChunksX) % World.ChunksZ;
+	int cy = (chunkIndex / World.ChunksX) / World.ChunksZ;
+	CalculateChunkLightingSelf(ctx, chunkIndex, cx, cy, cz);
+}
+
+#if !defined CC_BUILD_COOPTHREADED && !defined CC_BUILD_LOWMEM
+#define LIGHT_MAX_WORKERS 16
+
+struct LightWorker {
+	struct LightContext ctx;
+	void* thread;
+	void* waitable;
+};
+
+static struct LightWorker* workers[LIGHT_MAX_WORKERS];
+static int workersCount, workersStarted, workersBusy, workersGen, jobsNext;
+static cc_bool workersInited, workersStop;
+static void* jobsMutex;
+static void* jobsDone;
+
+static void RunJobs(struct LightContext* ctx) {
+	int i;
+	for (;;)
+	{
+		Mutex_Lock(jobsMutex);
+		i = jobsNext < jobsCount ? jobsNext++ : -1;
+		Mutex_Unlock(jobsMutex);
+
+		if (i == -1) return;
+		RunJob(ctx, lightJobs[i]);
+	}
+}
+
+static void WorkerLoop(void) {
+	struct LightWorker* worker;
+	int gen = 0, curGen;
+	cc_bool stop, last;
+
+	Mutex_Lock(jobsMutex);
+	worker = workers[workersStarted++];
+	Mutex_Unlock(jobsMutex);
+
+	for (;;)
+	{
+		Mutex_Lock(jobsMutex);
+		curGen = workersGen;
+		stop   = workersStop;
+		Mutex_Unlock(jobsMutex);
+
+		if (stop) return;
+		/* Waitable_Wait may return spuriously, so always recheck */
+		if (curGen == gen) { Waitable_Wait(worker->waitable); continue; }
+
+		gen = curGen;
+		RunJobs(&worker->ctx);
+
+		Mutex_Lock(jobsMutex);
+		last = --workersBusy == 0;
+		Mutex_Unlock(jobsMutex);
+		if (last) Waitable_Signal(jobsDone);
+	}
+}
+
+static void InitWorkers(void) {
+	int i, count = Options_GetInt(OPT_LIGHTING_THREADS, 0, LIGHT_MAX_WORKERS, 2);
+	workersInited = true;
+	if (!count) return;
+
+	jobsMutex = Mutex_Create("Lighting jobs");
+	jobsDone  = Waitable_Create("Lighting done");
+
+	for (i = 0; i < count; i++)
+	{
+		if (!(workers[i] = (struct LightWorker*)Mem_TryAllocCleared(1, sizeof(struct LightWorker)))) break;
+		LightContext_Init(&workers[i]->ctx);
+		workers[i]->waitable = Waitable_Create("Lighting worker");
+	}
+	/* All workers must be allocated before starting any of the threads */
+	workersCount = i;
+
+	for (i = 0; i < workersCount; i++)
+	{
+		Thread_Run(&workers[i]->thread, WorkerLoop, 128 * 1024, "Fancy lighting");
+	}
+}
+
+static void FreeWorkers(void) {
+	int i;
+	if (!workersInited) return;
+	workersInited = false;
+	if (!jobsMutex) return;
+
+	Mutex_Lock(jobsMutex);
+	workersStop = true;
+	Mutex_Unlock(jobsMutex);
+
+	for (i = 0; i < workersCount; i++)
+	{
+		Waitable_Signal(workers[i]->waitable);
+		Thread_Join(workers[i]->thread);
+		Waitable_Free(workers[i]->waitable);
+		LightContext_Free(&workers[i]->ctx);
+		Mem_Free(workers[i]);
+	}
+
+	Mutex_Free(jobsMutex);
+	Waitable_Free(jobsDone);
+	jobsMutex    = NULL;
+	workersCount = 0;
+}
+
+static int WorkersCount(void) {
+	if (!workersInited) InitWorkers();
+	return workersCount;
+}
+
+/* Calculates the light from all the chunks in lightJobs, using the worker threads and the main thread */
+static void RunAllJobs(void) {
+	int i, busy;
+	if (!workersCount) {
+		for (i = 0; i < jobsCount; i++) RunJob(&mainCtx, lightJobs[i]);
+		return;
+	}
+
+	Mutex_Lock(jobsMutex);
+	jobsNext    = 0;
+	workersBusy = workersCount;
+	workersGen++;
+	Mutex_Unlock(jobsMutex);
+
+	for (i = 0; i < workersCount; i++)
+	{
+		Waitable_Signal(workers[i]->waitable);
+	}
+	RunJobs(&mainCtx);
+
+	for (;;)
+	{
+		Mutex_Lock(jobsMutex);
+		busy = workersBusy;
+		Mutex_Unlock(jobsMutex);
+
+		if (!busy) break;
+		Waitable_Wait(jobsDone);
+	}
+
+	for (i = 0; i < workersCount; i++)
+	{
+		FancyLighting_NodesProcessed += workers[i]->ctx.nodes;
+		workers[i]->ctx.nodes = 0;
+	}
+}
+#else
+static int WorkersCount(void) { return 0; }
+static void FreeWorkers(void) { }
+
+static void RunAllJobs(void) {
+	int i;
+	for (i = 0; i < jobsCount; i++) RunJob(&mainCtx, lightJobs[i]);
+}
+#endif
+
+/* Sky light reads the light heights of columns up to a chunk away from the chunks being calculated */
+/* The heightmap is lazily calculated, so those heights must be calculated on the main thread beforehand */
+static void CalculateLightHeights(int x1, int z1, int x2, int z2) {
+	int cx, cz;
+	x1 = max(x1 - 1, 0); x2 = min(x2 + 1, World.ChunksX - 1);
+	z1 = max(z1 - 1, 0); z2 = min(z2 + 1, World.ChunksZ - 1);
+
+	for (cz = z1; cz <= z2; cz++) {
+		for (cx = x1; cx <= x2; cx++) {
+			ClassicLighting_LightHint((cx << CHUNK_SHIFT) - 1, 0, (cz << CHUNK_SHIFT) - 1);
+		}
+	}
+}
+
 static void CalculateChunkLightingAll(int chunkIndex, int cx, int cy, int cz) {
-	int x, y, z;
-	/* Chunk coordinates */
-	int chunkStartX, chunkStartY, chunkStartZ;
-	int chunkEndX, chunkEndY, chunkEndZ;
-	int curChunkIndex;
-
-	chunkStartX = cx - 1;
-	chunkStartY = cy - 1;
-	chunkStartZ = cz - 1;
-	chunkEndX = cx + 1;
-	chunkEndY = cy + 1;
-	chunkEndZ = cz + 1;
-
-	if (chunkStartX == -1) { chunkStartX++; }
-	if (chunkStartY == -1) { chunkStartY++; }
-	if (chunkStartZ == -1) { chunkStartZ++; }
-	if (chunkEndX == World.ChunksX) { chunkEndX--; }
-	if (chunkEndY == World.ChunksY) { chunkEndY--; }
-	if (chunkEndZ == World.ChunksZ) { chunkEndZ--; }
-
-	for (y = chunkStartY; y <= chunkEndY; y++) {
-		for (z = chunkStartZ; z <= chunkEndZ; z++) {
-			for (x = chunkStartX; x <= chunkEndX; x++) {
-				curChunkIndex = ChunkCoordsToIndex(x, y, z);
-
-				if (chunkLightingDataFlags[curChunkIndex] == CHUNK_UNCALCULATED) {
-					CalculateChunkLightingSelf(curChunkIndex, x, y, z);
+	/* Without worker threads, only calculate the light of the chunks that are needed */
+	int radius = WorkersCount() ? LIGHT_BATCH_RADIUS : 1;
+	int x1 = max(cx - radius, 0), x2 = min(cx + radius, World.ChunksX - 1);
+	int y1 = max(cy - radius, 0), y2 = min(cy + radius, World.ChunksY - 1);
+	int z1 = max(cz - radius, 0), z2 = min(cz + radius, World.ChunksZ - 1);
+	int phase, x, y, z, curChunkIndex;
+	if (Lighting_Mode == LIGHTING_MODE_SKY) CalculateLightHeights(x1, z1, x2, z2);
+
+	for (phase = 0; phase < LIGHT_PHASES; phase++) 
+	{
+		jobsCount = 0;
+		for (y = y1; y <= y2; y++) {
+			for (z = z1; z <= z2; z++) {
+				for (x = x1; x <= x2; x++) {
+					if (LightPhase(x, y, z) != phase) continue;
+					curChunkIndex = ChunkCoordsToIndex(x, y, z);
+
+					if (chunkLightingDataFlags[curChunkIndex] == CHUNK_UNCALCULATED) {
+						lightJobs[jobsCount++] = curChunkIndex;
+					}
 				}
 			}
 		}
+		RunAllJobs();
 	}
+
+	FancyLighting_NodesProcessed += mainCtx.nodes;
+	mainCtx.nodes = 0;
 	chunkLightingDataFlags[chunkIndex] = CHUNK_ALL_CALCULATED;
 }
 
-
-#define Light_TryUnSpreadInto(axis, dir, limit, AXIS, thisFace, thatFace) \
-		if (neighborCoords.axis dir ## = limit && \
+#define Light_TryUnSpreadInto(coord, dir, limit, AXIS, thisFace, thatFace) \
+		if (coord dir ## = limit && \
 			CanLightPass(thisBlock, FACE_ ## AXIS ## thisFace) && \
-			CanLightPass(World_GetBlock(neighborCoords.x, neighborCoords.y, neighborCoords.z), FACE_ ## AXIS ## thatFace) \
+			CanLightPass(World_GetBlock(nx, ny, nz), FACE_ ## AXIS ## thatFace) \
 		) \
 		{ \
-			neighborBrightness = GetBrightness(neighborCoords.x, neighborCoords.y, neighborCoords.z, isLamp); \
-			neighborBlockBrightness = GetBlockBrightness(World_GetBlock(neighborCoords.x, neighborCoords.y, neighborCoords.z), isLamp); \
+			neighborBrightness = GetBrightness(nx, ny, nz, channel); \
+			neighborBlockBrightness = GetBlockBrightness(World_GetBlock(nx, ny, nz), channel); \
 			/* This spot is a light caster, mark this spot as needing to be re-spread */ \
 			if (neighborBlockBrightness > 0) { \
-				LightNode_Init(otherNode, neighborCoords.x, neighborCoords.y, neighborCoords.z, neighborBlockBrightness); \
-				Queue_Enqueue(&lightQueue, &otherNode); \
+				otherNode = LightNode_Make(ctx, nx, ny, nz, neighborBlockBrightness); \
+				Queue_Enqueue(&ctx->lightQueue, &otherNode); \
 			} \
 			if (neighborBrightness > 0) { \
 				/* This neighbor is darker than cur spot, darken it*/ \
-				if (neighborBrightness < curNode.brightness) { \
-					SetBrightness(0, neighborCoords.x, neighborCoords.y, neighborCoords.z, isLamp, true); \
-					LightNode_Init(otherNode, neighborCoords.x, neighborCoords.y, neighborCoords.z, neighborBrightness); \
-					Queue_Enqueue(&unlightQueue, &otherNode); \
+				if (neighborBrightness < curBrightness) { \
+					SetBrightness(0, nx, ny, nz, channel, true); \
+					otherNode = LightNode_Make(ctx, nx, ny, nz, neighborBrightness); \
+					Queue_Enqueue(&ctx->unlightQueue, &otherNode); \
 				} \
 				/* This neighbor is brighter or same, mark this spot as needing to be re-spread */ \
 				else { \
 					/* But only if the neighbor actually *can* spread to this block */ \
 					if ( \
 						CanLightPass(thisBlockTrue, FACE_ ## AXIS ## thisFace) && \
-						CanLightPass(World_GetBlock(neighborCoords.x, neighborCoords.y, neighborCoords.z), FACE_ ## AXIS ## thatFace) \
+						CanLightPass(World_GetBlock(nx, ny, nz), FACE_ ## AXIS ## thatFace) \
 					) \
 					{ \
-						otherNode = curNode; \
-						otherNode.brightness = neighborBrightness-1; \
-						Queue_Enqueue(&lightQueue, &otherNode); \
+						otherNode = LightNode_Make(ctx, x, y, z, neighborBrightness - 1); \
+						Queue_Enqueue(&ctx->lightQueue, &otherNode); \
 					} \
 				} \
 			} \
 		} \
 
-/* Spreads darkness out from this point and relights any necessary areas afterward */
-static void CalcUnlight(int x, int y, int z, cc_uint8 brightness, cc_bool isLamp) {
-	int count = 0;
-	struct LightNode curNode, otherNode;
-	cc_uint8 neighborBrightness, neighborBlockBrightness;
-	IVec3 neighborCoords;
+/* Spreads darkness out from the cells in the unlight queue and relights any necessary areas afterward */
+/* The first airCount cells in the queue are treated as air, so that darkness can unspread "out" of them */
+static void FlushUnlightQueue(struct LightContext* ctx, cc_uint8 channel, int airCount) {
+	LightNode curNode, otherNode;
+	cc_uint8 curBrightness, neighborBrightness, neighborBlockBrightness;
+	int x, y, z, nx, ny, nz;
 	BlockID thisBlockTrue, thisBlock;
 
-	SetBrightness(0, x, y, z, isLamp, true);
-	LightNode_Init(curNode, x, y, z, brightness);
-	Queue_Enqueue(&unlightQueue, &curNode);
+	while (ctx->unlightQueue.count > 0) {
+		curNode = *(LightNode*)(Queue_Dequeue(&ctx->unlightQueue));
+		ctx->nodes++;
 
-	while (unlightQueue.count > 0) {
-		curNode = *(struct LightNode*)(Queue_Dequeue(&unlightQueue));
-		neighborCoords = curNode.coords;
+		x = LightNode_X(ctx, curNode);
+		y = LightNode_Y(ctx, curNode);
+		z = LightNode_Z(ctx, curNode);
+		curBrightness = LightNode_Level(curNode);
+		nx = x; ny = y; nz = z;
 
-		thisBlockTrue = World_GetBlock(neighborCoords.x, neighborCoords.y, neighborCoords.z);
-		/* For the original cell in the queue, assume this block is air
+		thisBlockTrue = World_GetBlock(x, y, z);
+		/* For the original cells in the queue, assume this block is air
 		so that light can unspread "out" of it in the case of a solid blocks. */
-		thisBlock = count == 0 ? BLOCK_AIR : thisBlockTrue;
-
-		count++;
-
-		neighborCoords.x--;
-		Light_TryUnSpreadInto(x, >, 0, X, MAX, MIN)
-		neighborCoords.x += 2;
-		Light_TryUnSpreadInto(x, <, World.MaxX, X, MIN, MAX)
-		neighborCoords.x--;
+		thisBlock = airCount > 0 ? BLOCK_AIR : thisBlockTrue;
+
+		airCount--;
+
+		nx--;
+		Light_TryUnSpreadInto(nx, >, 0, X, MAX, MIN)
+		nx += 2;
+		Light_TryUnSpreadInto(nx, <, World.MaxX, X, MIN, MAX)
+		nx--;
+
+		ny--;
+		Light_TryUnSpreadInto(ny, >, 0, Y, MAX, MIN)
+		ny += 2;
+		Light_TryUnSpreadInto(ny, <, World.MaxY, Y, MIN, MAX)
+		ny--;
+
+		nz--;
+		Light_TryUnSpreadInto(nz, >, 0, Z, MAX, MIN)
+		nz += 2;
+		Light_TryUnSpreadInto(nz, <, World.MaxZ, Z, MIN, MAX)
+	}
 
-		neighborCoords.y--;
-		Light_TryUnSpreadInto(y, >, 0, Y, MAX, MIN)
-		neighborCoords.y += 2;
-		Light_TryUnSpreadInto(y, <, World.MaxY, Y, MIN, MAX)
-		neighborCoords.y--;
+	FlushLightQueue(ctx, channel, true);
+}
 
-		neighborCoords.z--;
-		Light_TryUnSpreadInto(z, >, 0, Z, MAX, MIN)
-		neighborCoords.z += 2;
-		Light_TryUnSpreadInto(z, <, World.MaxZ, Z, MIN, MAX)
-	}
+/* Spreads darkness out from this point and relights any necessary areas afterward */
+static void CalcUnlight(struct LightContext* ctx, int x, int y, int z, cc_uint8 brightness, cc_uint8 channel) {
+	LightNode node;
 
-	FlushLightQueue(isLamp, true);
+	SetBrightness(0, x, y, z, channel, true);
+	node = LightNode_Make(ctx, x, y, z, brightness);
+	Queue_Enqueue(&ctx->unlightQueue, &node);
+	FlushUnlightQueue(ctx, channel, 1);
 }
-static void CalcBlockChange(int x, int y, int z, BlockID oldBlock, BlockID newBlock, cc_bool isLamp) {
-	cc_uint8 oldBlockLightLevel = GetBlockBrightness(oldBlock, isLamp);
-	cc_uint8 newBlockLightLevel = GetBlockBrightness(newBlock, isLamp);
-	cc_uint8 oldLightLevelHere = GetBrightness(x, y, z, isLamp);
-	struct LightNode entry;
+static void CalcBlockChange(struct LightContext* ctx, int x, int y, int z, BlockID oldBlock, BlockID newBlock, cc_uint8 channel) {
+	cc_uint8 oldBlockLightLevel = GetBlockBrightness(oldBlock, channel);
+	cc_uint8 newBlockLightLevel = GetBlockBrightness(newBlock, channel);
+	cc_uint8 oldLightLevelHere = GetBrightness(x, y, z, channel);
+	LightNode entry;
 
 	/* Cell has no lighting and new block doesn't cast light and blocks all light, no change */
 	if (!oldLightLevelHere && !newBlockLightLevel && IsFullOpaque(newBlock)) return;
+	LightContext_SetOrigin(ctx, x, y, z);
 
 	/* Cell is darker than the new block, only brighter case */
 	if (oldLightLevelHere < newBlockLightLevel) {
 		/* brighten this spot, recalculate lighting */
-		LightNode_Init(entry, x, y, z, newBlockLightLevel);
-		Queue_Enqueue(&lightQueue, &entry);
-		FlushLightQueue(isLamp, true);
+		entry = LightNode_Make(ctx, x, y, z, newBlockLightLevel);
+		Queue_Enqueue(&ctx->lightQueue, &entry);
+		FlushLightQueue(ctx, channel, true);
 		return;
 	}
 
 	/* Light passes through old and new, old block does not cast light, new block does not cast light; no change */
 	if (IsFullTransparent(oldBlock) && IsFullTransparent(newBlock) && !oldBlockLightLevel && !newBlockLightLevel) return;
 
-	CalcUnlight(x, y, z, oldLightLevelHere, isLamp);
+	CalcUnlight(ctx, x, y, z, oldLightLevelHere, channel);
 }
+
+/* How many cells of a column to update the sky light of at once */
+/* (keeps the light nodes of a slice and the light spread from it within range of the context origin) */
+#define SKY_COLUMN_SLICE 128
+
+/* Updates the sky light around the cells of a column that have become exposed to, or hidden from, the sky */
+/* Only the cells between the old and new light heights change, so the cost is bounded by how far */
+/*  the light height moved (plus the distance sky light spreads), rather than by the height of the column */
+static void CalcSkyColumn(struct LightContext* ctx, int x, int z, int oldHeight, int newHeight) {
+	int minY = max(min(oldHeight, newHeight) + 1, 0);
+	int maxY = min(max(oldHeight, newHeight), World.MaxY);
+	int y, endY, count;
+	LightNode node;
+
+	for (; minY <= maxY; minY = endY + 1) {
+		endY  = min(minY + SKY_COLUMN_SLICE - 1, maxY);
+		count = 0;
+		LightContext_SetOrigin(ctx, x, (minY + endY) >> 1, z);
+
+		for (y = minY; y <= endY; y++) {
+			if (newHeight > oldHeight) {
+				/* Cell is now in shadow, so darken everything that was lit from it */
+				SetBrightness(0, x, y, z, LIGHT_CHANNEL_SKY, true);
+				node = LightNode_Make(ctx, x, y, z, FANCY_LIGHTING_MAX_LEVEL);
+				Queue_Enqueue(&ctx->unlightQueue, &node);
+				count++;
+			} else {
+				/* Cell is now exposed to the sky, so light spreads out from it */
+				SpreadLight(ctx, x, y, z, FANCY_LIGHTING_MAX_LEVEL - 1, LIGHT_CHANNEL_SKY);
+			}
+		}
+
+		if (count) {
+			FlushUnlightQueue(ctx, LIGHT_CHANNEL_SKY, count);
+		} else {
+			FlushLightQueue(ctx, LIGHT_CHANNEL_SKY, true);
+		}
+	}
+}
+
+#define Sky_TryUnlightNeighbor(nx, ny, nz) \
+	if (World_Contains(nx, ny, nz) && (level = GetBrightness(nx, ny, nz, LIGHT_CHANNEL_SKY)) && \
+		level < FANCY_LIGHTING_MAX_LEVEL) { \
+		SetBrightness(0, nx, ny, nz, LIGHT_CHANNEL_SKY, true); \
+		node = LightNode_Make(ctx, nx, ny, nz, level); \
+		Queue_Enqueue(&ctx->unlightQueue, &node); \
+	}
+
+static void CalcSkyChange(struct LightContext* ctx, int x, int y, int z, BlockID oldBlock, BlockID newBlock, int oldHeight) {
+	int newHeight = ClassicLighting_GetLightHeight(x, z);
+	cc_uint8 level;
+	LightNode node;
+
+	if (newHeight != oldHeight) {
+		CalcSkyColumn(ctx, x, z, oldHeight, newHeight);
+		/* Changed cell was part of the column that was updated */
+		if (y > min(oldHeight, newHeight) && y <= max(oldHeight, newHeight)) return;
+	}
+
+	/* Cell is in shadow, so same as any other light source */
+	if (y <= newHeight) {
+		CalcBlockChange(ctx, x, y, z, oldBlock, newBlock, LIGHT_CHANNEL_SKY);
+		return;
+	}
+	if (IsFullTransparent(oldBlock) && IsFullTransparent(newBlock)) return;
+
+	/* Cell is still exposed to the sky, but light may now spread out of it differently */
+	/* So darken the neighbours in shadow, then relight them (including from this cell) */
+	LightContext_SetOrigin(ctx, x, y, z);
+	Sky_TryUnlightNeighbor(x - 1, y, z);
+	Sky_TryUnlightNeighbor(x + 1, y, z);
+	Sky_TryUnlightNeighbor(x, y - 1, z);
+	Sky_TryUnlightNeighbor(x, y + 1, z);
+	Sky_TryUnlightNeighbor(x, y, z - 1);
+	Sky_TryUnlightNeighbor(x, y, z + 1);
+
+	SpreadLight(ctx, x, y, z, FANCY_LIGHTING_MAX_LEVEL - 1, LIGHT_CHANNEL_SKY);
+	FlushUnlightQueue(ctx, LIGHT_CHANNEL_SKY, 0);
+}
+
 static void OnBlockChanged(int x, int y, int z, BlockID oldBlock, BlockID newBlock) {
+	int oldHeight = 0;
 	/* For some reason this is a possible case */
 	if (oldBlock == newBlock) { return; }
 
+	if (Lighting_Mode == LIGHTING_MODE_SKY) oldHeight = ClassicLighting_GetLightHeight(x, z);
 	ClassicLighting_OnBlockChanged(x, y, z, oldBlock, newBlock);
 
-	CalcBlockChange(x, y, z, oldBlock, newBlock, false);
-	CalcBlockChange(x, y, z, oldBlock, newBlock, true);
+	CalcBlockChange(&mainCtx, x, y, z, oldBlock, newBlock, LIGHT_CHANNEL_LAVA);
+	CalcBlockChange(&mainCtx, x, y, z, oldBlock, newBlock, LIGHT_CHANNEL_LAMP);
+	if (Lighting_Mode == LIGHTING_MODE_SKY) {
+		CalcSkyChange(&mainCtx, x, y, z, oldBlock, newBlock, oldHeight);
+	}
+
+	FancyLighting_NodesProcessed += mainCtx.nodes;
+	mainCtx.nodes = 0;
 }
 /* Invalidates/Resets lighting state for all of the blocks in the world */
 /*  (e.g. because a block changed whether it is full bright or not) */
@@ -485,7 +896,7 @@ static cc_bool IsLit_Fast(int x, int y, int z) { return ClassicLighting_IsLit_Fa
 	}
 
 static PackedCol Color_Core(int x, int y, int z, int paletteFace) {
-	cc_uint8 lightData;
+	cc_uint8 lightData, skyLevel;
 	int cx, cy, cz, chunkIndex;
 	int chunkCoordsIndex;
 
@@ -504,11 +915,10 @@ static PackedCol Color_Core(int x, int y, int z, int paletteFace) {
 		lightData = chunkLightingData[chunkIndex][chunkCoordsIndex];
 	}
 
-	/* This cell is exposed to sunlight */
-	if (y > ClassicLighting_GetLightHeight(x, z)) {
-		/* Push the pointer forward into the sun lit palette section */
-		paletteFace += PALETTE_SHADES;
-	}
+	/* Fully lit when exposed to sunlight, otherwise only sky lighting mode has partial sky light */
+	skyLevel = GetBrightness(x, y, z, LIGHT_CHANNEL_SKY);
+	/* Push the pointer forward into the palette section for this sky light level */
+	paletteFace += skyLevel * PALETTE_SHADES;
 
 	return palettes[paletteFace][lightData];
 }
@@ -581,3 +991,7 @@ static void OnEnvVariableChanged(void* obj, int envVar) {
 void FancyLighting_OnInit(void) {
 	Event_Register_(&WorldEvents.EnvVarChanged, NULL, OnEnvVariableChanged);
 }
+
+void FancyLighting_OnFree(void) {
+	FreeWorkers();
+}
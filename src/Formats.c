@@ -17,11 +17,18 @@
 #include "TexturePack.h"
 #include "Utils.h"
 #include "Audio.h"
+#include "Options.h"
 
 #ifdef CC_BUILD_FILESYSTEM
 static struct LocationUpdate* spawn_point;
 static struct MapImporter* imp_head;
 static struct MapImporter* imp_tail;
+#ifdef GZIP_PARALLEL
+/* Restart point index of the map file currently being loaded, if it has one */
+static struct GZipIndex* map_index;
+#endif
+/* Path of the map file currently being loaded */
+static const cc_string* map_path;
 
 
 /*########################################################################################################################*
@@ -35,6 +42,18 @@ static cc_result Map_ReadBlocks(struct Stream* stream) {
 	return Stream_Read(stream, World.Blocks, World.Volume);
 }
 
+/* Decompresses the GZIP map file, in parallel if the file was saved with a restart point index */
+static void Map_MakeGZipStream(struct Stream* compStream, struct InflateState* state, struct Stream* stream) {
+#ifdef GZIP_PARALLEL
+	if (map_index) {
+		Inflate_MakeIndexedStream(compStream, map_index, stream,
+			Options_GetInt(OPT_MAP_LOAD_THREADS, 0, GZIP_PARALLEL_MAX_WORKERS, 4));
+		return;
+	}
+#endif
+	Inflate_MakeStream2(compStream, state, stream);
+}
+
 static cc_result Map_SkipGZipHeader(struct Stream* stream) {
 	struct GZipHeader gzHeader;
 	cc_result res;
@@ -68,18 +87,33 @@ cc_result Map_LoadFrom(const cc_string* path) {
 	struct MapImporter* imp;
 	struct Stream stream;
 	cc_result res;
+#ifdef GZIP_PARALLEL
+	struct GZipIndex index;
+#endif
 	Game_Reset();
 	
 	spawn_point = &update;
 	res = Stream_OpenFile(&stream, path);
 	if (res) { Logger_SysWarn2(res, "opening", path); return res; }
 
+#ifdef GZIP_PARALLEL
+	/* Most map files won't have an index, so just ignore any errors */
+	map_index = GZipIndex_Read(&index, &stream) ? NULL : &index;
+#endif
+
 	imp = MapImporter_Find(path);
+	map_path = path;
 	if (!imp) {
 		res = ERR_NOT_SUPPORTED;
 	} else if ((res = imp->import(&stream))) {
 		World_Reset();
 	}
+	map_path = NULL;
+
+#ifdef GZIP_PARALLEL
+	if (map_index) GZipIndex_Free(map_index);
+	map_index = NULL;
+#endif
 
 	/* No point logging error for closing readonly file */
 	(void)stream.Close(&stream);
@@ -188,7 +222,7 @@ static cc_result Lvl_Load(struct Stream* stream) {
 
 	struct Stream compStream;
 	struct InflateState state;
-	Inflate_MakeStream2(&compStream, &state, stream);
+	Map_MakeGZipStream(&compStream, &state, stream);
 	
 	if ((res = Map_SkipGZipHeader(stream)))                       return res;
 	if ((res = Stream_Read(&compStream, header, sizeof(header)))) return res;
@@ -338,7 +372,6 @@ struct NbtTag {
 		cc_uint32 u32;
 		float     f32;
 		cc_uint8  small[NBT_SMALL_SIZE];
-		cc_uint8* big; /* malloc for big byte arrays */
 		struct { cc_string text; char buffer[STRING_SIZE * 2]; } str;
 	} value;
 	char _nameBuffer[NBT_STRING_SIZE];
@@ -389,7 +422,7 @@ static cc_uint8* NbtTag_U8_Array(struct NbtTag* tag, int minSize) {
 	if (tag->type != NBT_I8S)    { tag->result = NBT_ERR_EXPECTED_ARR;  return NULL; }
 	if (tag->dataSize < minSize) { tag->result = NBT_ERR_ARR_TOO_SMALL; return NULL; }
 
-	return NbtTag_IsSmall(tag) ? tag->value.small : tag->value.big;
+	return tag->value.small;
 }
 
 static cc_string NbtTag_String(struct NbtTag* tag) {
@@ -415,9 +448,17 @@ static cc_result Nbt_ReadString(struct Stream* stream, cc_string* str) {
 }
 
 typedef void (*Nbt_Callback)(struct NbtTag* tag);
+/* Called before the data of a byte array tag is read. Setting data to non NULL makes */
+/*  the array be read straight into that memory, and the tag callback is then skipped. */
+/* Large arrays that no destination is given for are skipped without being buffered. */
+typedef cc_result (*Nbt_ArrayCallback)(struct NbtTag* tag, cc_uint8** data);
+
+struct NbtCallbacks { Nbt_Callback tag; Nbt_ArrayCallback array; };
+
 static cc_result Nbt_ReadTag(cc_uint8 typeId, cc_bool readTagName, struct Stream* stream, 
-							struct NbtTag* parent, Nbt_Callback callback, int listIndex) {
+							struct NbtTag* parent, const struct NbtCallbacks* callbacks, int listIndex) {
 	struct NbtTag tag;
+	cc_uint8* dst = NULL;
 	cc_uint8 childType;
 	cc_uint8 tmp[5];	
 	cc_result res;
@@ -454,15 +495,14 @@ static cc_result Nbt_ReadTag(cc_uint8 typeId, cc_bool readTagName, struct Stream
 
 	case NBT_I8S:
 		if ((res = Stream_ReadU32_BE(stream, &tag.dataSize))) break;
+		if (callbacks->array && (res = callbacks->array(&tag, &dst))) return res;
 
-		if (NbtTag_IsSmall(&tag)) {
+		if (dst) {
+			return Stream_Read(stream, dst, tag.dataSize);
+		} else if (NbtTag_IsSmall(&tag)) {
 			res = Stream_Read(stream, tag.value.small, tag.dataSize);
 		} else {
-			tag.value.big = (cc_uint8*)Mem_TryAlloc(tag.dataSize, 1);
-			if (!tag.value.big) return ERR_OUT_OF_MEMORY;
-
-			res = Stream_Read(stream, tag.value.big, tag.dataSize);
-			if (res) Mem_Free(tag.value.big);
+			return stream->Skip(stream, tag.dataSize);
 		}
 		break;
 	case NBT_STR:
@@ -476,7 +516,7 @@ static cc_result Nbt_ReadTag(cc_uint8 typeId, cc_bool readTagName, struct Stream
 		count = Stream_GetU32_BE(&tmp[1]);
 
 		for (i = 0; i < count; i++) {
-			res = Nbt_ReadTag(childType, false, stream, &tag, callback, i);
+			res = Nbt_ReadTag(childType, false, stream, &tag, callbacks, i);
 			if (res) break;
 		}
 		break;
@@ -486,7 +526,7 @@ static cc_result Nbt_ReadTag(cc_uint8 typeId, cc_bool readTagName, struct Stream
 			if ((res = stream->ReadU8(stream, &childType))) break;
 			if (childType == NBT_END) break;
 
-			res = Nbt_ReadTag(childType, true, stream, &tag, callback, 0);
+			res = Nbt_ReadTag(childType, true, stream, &tag, callbacks, 0);
 			if (res) break;
 		}
 		break;
@@ -496,116 +536,144 @@ static cc_result Nbt_ReadTag(cc_uint8 typeId, cc_bool readTagName, struct Stream
 
 	if (res) return res;
 	tag.result = 0;
-	callback(&tag);
-	/* NOTE: callback must set DataBig to NULL, if doesn't want it to be freed */
-	if (!NbtTag_IsSmall(&tag)) Mem_Free(tag.value.big);
+	callbacks->tag(&tag);
 	return tag.result;
 }
 
+/* Allocates the destination for a block array that is read straight from the stream */
+static cc_result Nbt_AllocBlocks(struct NbtTag* tag, BlockRaw** blocks) {
+	if (!tag->dataSize) return 0;
 
-static BlockRaw* Nbt_TakeArray(struct NbtTag* tag, const char* type) {
-	BlockRaw* ptr;
-	if (NbtTag_IsSmall(tag)) {
-		/* Small data is stored inline in tha tag, so need to copy it out */
-		ptr = (BlockRaw*)Mem_Alloc(tag->dataSize, 1, type);
-		Mem_Copy(ptr, tag->value.small, tag->dataSize);
-	} else {
-		ptr = tag->value.big;
-		tag->value.big = NULL; /* So Nbt_ReadTag doesn't call Mem_Free on the array */
-	}
-	return ptr;
+	*blocks = (BlockRaw*)Mem_TryAlloc(tag->dataSize, 1);
+	return *blocks ? 0 : ERR_OUT_OF_MEMORY;
 }
 
-static cc_result Nbt_Read(struct Stream* stream, Nbt_Callback callback) {
-	struct Stream compStream;
-	struct InflateState state;
+static cc_result Nbt_ReadRoot(struct Stream* stream, Nbt_Callback callback, Nbt_ArrayCallback arrayCallback) {
+	struct NbtCallbacks callbacks;
 	cc_result res;
 	cc_uint8 tag;
 
-	Inflate_MakeStream2(&compStream, &state, stream);
-	if ((res = Map_SkipGZipHeader(stream))) return res;
-	if ((res = compStream.ReadU8(&compStream, &tag))) return res;
+	callbacks.tag   = callback;
+	callbacks.array = arrayCallback;
 
+	if ((res = stream->ReadU8(stream, &tag))) return res;
 	if (tag != NBT_DICT) return CW_ERR_ROOT_TAG;
-	return Nbt_ReadTag(NBT_DICT, true, &compStream, NULL, callback, 0);
+	return Nbt_ReadTag(NBT_DICT, true, stream, NULL, &callbacks, 0);
+}
+
+static cc_result Nbt_Read(struct Stream* stream, Nbt_Callback callback, Nbt_ArrayCallback arrayCallback) {
+	struct Stream compStream;
+	struct InflateState state;
+	cc_result res;
+
+	Map_MakeGZipStream(&compStream, &state, stream);
+	if ((res = Map_SkipGZipHeader(stream))) return res;
+	return Nbt_ReadRoot(&compStream, callback, arrayCallback);
 }
 
 
 /*########################################################################################################################*
 *--------------------------------------------------------NBTWriter--------------------------------------------------------*
 *#########################################################################################################################*/
-static cc_uint8* Nbt_WriteConst(cc_uint8* data, const char* text) {
-	int i, len = String_Length(text);
+/* Accumulates small tags in a buffer, which is flushed to the stream once full */
+/* Large arrays are written straight to the stream instead of being copied */
+struct NbtWriter {
+	struct Stream* stream;
+	cc_uint8* cur;
+	cc_result result; /* First error that occurred while writing, if any */
+	cc_uint8 buffer[2048];
+};
+
+static void Nbt_InitWriter(struct NbtWriter* w, struct Stream* stream) {
+	w->stream = stream;
+	w->cur    = w->buffer;
+	w->result = 0;
+}
+
+static cc_result Nbt_Flush(struct NbtWriter* w) {
+	int len = (int)(w->cur - w->buffer);
+	w->cur  = w->buffer;
+
+	if (w->result || !len) return w->result;
+	return (w->result = Stream_Write(w->stream, w->buffer, len));
+}
+
+/* Ensures at least size bytes are free in the buffer, then returns the current position */
+static cc_uint8* Nbt_Reserve(struct NbtWriter* w, int size) {
+	if (w->cur + size > w->buffer + sizeof(w->buffer)) Nbt_Flush(w);
+	return w->cur;
+}
+
+/* Writes type and name of a tag, then reserves size bytes for its value */
+static cc_uint8* Nbt_WriteTag(struct NbtWriter* w, cc_uint8 type, const char* name, int size) {
+	int i, len = String_Length(name);
+	cc_uint8* data = Nbt_Reserve(w, 3 + len + size);
+
+	*data++ = type;
 	*data++ = 0;
 	*data++ = (cc_uint8)len;
+	for (i = 0; i < len; i++) { *data++ = name[i]; }
 
-	for (i = 0; i < len; i++) { *data++ = text[i]; }
+	w->cur = data + size;
 	return data;
 }
 
-static cc_uint8* Nbt_WriteString(cc_uint8* data, const char* name, const cc_string* text) {
-	cc_uint8* start; int i;
-
-	*data++ = NBT_STR;
-	data    = Nbt_WriteConst(data, name);
-	start   = data;
-	data += 2; /* length written later */
+static void Nbt_WriteString(struct NbtWriter* w, const char* name, const cc_string* text) {
+	cc_uint8* start; cc_uint8* data; int i;
+	/* Each CP437 character is at most 3 bytes in UTF8 */
+	start = Nbt_WriteTag(w, NBT_STR, name, 2 + text->length * 3);
+	data  = start + 2;
 
 	for (i = 0; i < text->length; i++) {
 		data = Convert_CP437ToUtf8(text->buffer[i], data) + data;
 	}
 
 	Stream_SetU16_BE(start, (int)(data - start) - 2);
-	return data;
+	w->cur = data;
 }
 
-static cc_uint8* Nbt_WriteDict(cc_uint8* data, const char* name) {
-	*data++ = NBT_DICT;
-	data    = Nbt_WriteConst(data, name);
+static void Nbt_WriteDict(struct NbtWriter* w, const char* name) {
+	Nbt_WriteTag(w, NBT_DICT, name, 0);
+}
 
-	return data;
+static void Nbt_WriteEnd(struct NbtWriter* w) {
+	*Nbt_Reserve(w, 1) = NBT_END;
+	w->cur++;
 }
 
-static cc_uint8* Nbt_WriteArray(cc_uint8* data, const char* name, int size) {
-	*data++ = NBT_I8S;
-	data    = Nbt_WriteConst(data, name);
+static void Nbt_WriteArray(struct NbtWriter* w, const char* name, const void* data, cc_uint32 size) {
+	cc_uint8* dst = Nbt_WriteTag(w, NBT_I8S, name, 4);
+	Stream_SetU32_BE(dst, size);
 
-	Stream_SetU32_BE(data, size);
-	return data + 4;
+	if (size <= NBT_SMALL_SIZE) {
+		Mem_Copy(Nbt_Reserve(w, size), data, size);
+		w->cur += size;
+	} else if (!Nbt_Flush(w)) {
+		w->result = Stream_Write(w->stream, (const cc_uint8*)data, size);
+	}
 }
 
-static cc_uint8* Nbt_WriteUInt8(cc_uint8* data, const char* name, cc_uint8 value) {
-	*data++ = NBT_I8;
-	data  = Nbt_WriteConst(data, name);
-
+static void Nbt_WriteUInt8(struct NbtWriter* w, const char* name, cc_uint8 value) {
+	cc_uint8* data = Nbt_WriteTag(w, NBT_I8, name, 1);
 	*data = value;
-	return data + 1;
 }
 
-static cc_uint8* Nbt_WriteUInt16(cc_uint8* data, const char* name, cc_uint16 value) {
-	*data++ = NBT_I16;
-	data    = Nbt_WriteConst(data, name);
-
+static void Nbt_WriteUInt16(struct NbtWriter* w, const char* name, cc_uint16 value) {
+	cc_uint8* data = Nbt_WriteTag(w, NBT_I16, name, 2);
 	Stream_SetU16_BE(data, value);
-	return data + 2;
 }
 
-static cc_uint8* Nbt_WriteInt32(cc_uint8* data, const char* name, int value) {
-	*data++ = NBT_I32;
-	data    = Nbt_WriteConst(data, name);
-
+static void Nbt_WriteInt32(struct NbtWriter* w, const char* name, int value) {
+	cc_uint8* data = Nbt_WriteTag(w, NBT_I32, name, 4);
 	Stream_SetU32_BE(data, value);
-	return data + 4;
 }
 
-static cc_uint8* Nbt_WriteFloat(cc_uint8* data, const char* name, float value) {
+static void Nbt_WriteFloat(struct NbtWriter* w, const char* name, float value) {
+	cc_uint8* data = Nbt_WriteTag(w, NBT_F32, name, 4);
 	union IntAndFloat raw;
-	*data++ = NBT_F32;
-	data    = Nbt_WriteConst(data, name);
 
 	raw.f = value;
 	Stream_SetU32_BE(data, raw.u);
-	return data + 4;
 }
 
 
@@ -666,16 +734,6 @@ static void Cw_Callback_1(struct NbtTag* tag) {
 		}
 		return;
 	}
-
-	if (IsTag(tag, "BlockArray")) {
-		World.Volume = tag->dataSize;
-		World.Blocks = Nbt_TakeArray(tag, ".cw map blocks");
-	}
-#ifdef EXTENDED_BLOCKS
-	if (IsTag(tag, "BlockArray2")) {
-		World_SetMapUpper(Nbt_TakeArray(tag, ".cw map blocks2"));
-	}
-#endif
 }
 
 static void Cw_Callback_2(struct NbtTag* tag) {
@@ -872,10 +930,34 @@ static void Cw_Callback(struct NbtTag* tag) {
 	        0             1         2        3          4   */
 }
 
+static cc_result Cw_ArrayCallback(struct NbtTag* tag, cc_uint8** data) {
+	BlockRaw* blocks = NULL;
+	cc_result res;
+	/* Block arrays are only valid directly inside the root ClassicWorld compound */
+	if (!tag->parent || tag->parent->parent) return 0;
+
+	if (IsTag(tag, "BlockArray")) {
+		World.Volume = tag->dataSize;
+		res = Nbt_AllocBlocks(tag, &blocks);
+		World.Blocks = blocks;
+		*data = blocks;
+		return res;
+	}
+#ifdef EXTENDED_BLOCKS
+	if (IsTag(tag, "BlockArray2")) {
+		res = Nbt_AllocBlocks(tag, &blocks);
+		if (blocks) World_SetMapUpper(blocks);
+		*data = blocks;
+		return res;
+	}
+#endif
+	return 0;
+}
+
 /* Imports a world from a .cw ClassicWorld map file */
 /* Used by ClassiCube/ClassicalSharp */
 static cc_result Cw_Load(struct Stream* stream) {
-	return Nbt_Read(stream, Cw_Callback);
+	return Nbt_Read(stream, Cw_Callback, Cw_ArrayCallback);
 }
 
 
@@ -1348,7 +1430,7 @@ static cc_result Dat_Load(struct Stream* stream) {
 
 	struct Stream compStream;
 	struct InflateState state;
-	Inflate_MakeStream2(&compStream, &state, stream);
+	Map_MakeGZipStream(&compStream, &state, stream);
 	if ((res = Map_SkipGZipHeader(stream)))                       return res;
 	if ((res = Stream_Read(&compStream, header, sizeof(header)))) return res;
 
@@ -1400,11 +1482,6 @@ static void MCLevel_ParseMap(struct NbtTag* tag) {
 	if (IsTag(tag, "width"))  { World.Width  = NbtTag_U16(tag); return; }
 	if (IsTag(tag, "height")) { World.Height = NbtTag_U16(tag); return; }
 	if (IsTag(tag, "length")) { World.Length = NbtTag_U16(tag); return; }
-
-	if (IsTag(tag, "blocks")) {
-		World.Volume = tag->dataSize;
-		World.Blocks = Nbt_TakeArray(tag, ".mclevel map blocks");
-	}
 }
 
 static PackedCol MCLevel_ParseColor(struct NbtTag* tag) {
@@ -1472,10 +1549,22 @@ static void MCLevel_Callback(struct NbtTag* tag) {
 			0					1				 2 */
 }
 
+static cc_result MCLevel_ArrayCallback(struct NbtTag* tag, cc_uint8** data) {
+	BlockRaw* blocks = NULL;
+	cc_result res;
+	if (!tag->parent || !IsTag(tag->parent, "Map") || !IsTag(tag, "blocks")) return 0;
+
+	World.Volume = tag->dataSize;
+	res = Nbt_AllocBlocks(tag, &blocks);
+	World.Blocks = blocks;
+	*data = blocks;
+	return res;
+}
+
 /* Imports a world from a .mclevel NBT map file */
 /* Used by Minecraft Indev client */
 static cc_result MCLevel_Load(struct Stream* stream) {
-	cc_result res = Nbt_Read(stream, MCLevel_Callback);
+	cc_result res = Nbt_Read(stream, MCLevel_Callback, MCLevel_ArrayCallback);
 
 	Env.EdgeHeight  = mcl_edgeHeight;
 	Env.SidesOffset = mcl_sidesHeight - mcl_edgeHeight;
@@ -1486,28 +1575,18 @@ static cc_result MCLevel_Load(struct Stream* stream) {
 /*########################################################################################################################*
 *--------------------------------------------------ClassicWorld export----------------------------------------------------*
 *#########################################################################################################################*/
-static cc_uint8* Cw_WriteColor(cc_uint8* data, const char* name, PackedCol color) {
-	data = Nbt_WriteDict(data, name);
+static void Cw_WriteColor(struct NbtWriter* w, const char* name, PackedCol color) {
+	Nbt_WriteDict(w, name);
 	{
-		data  = Nbt_WriteUInt16(data, "R", PackedCol_R(color));
-		data  = Nbt_WriteUInt16(data, "G", PackedCol_G(color));
-		data  = Nbt_WriteUInt16(data, "B", PackedCol_B(color));
-	} *data++ = NBT_END;
-
-	return data;
+		Nbt_WriteUInt16(w, "R", PackedCol_R(color));
+		Nbt_WriteUInt16(w, "G", PackedCol_G(color));
+		Nbt_WriteUInt16(w, "B", PackedCol_B(color));
+	} Nbt_WriteEnd(w);
 }
 
-static const cc_uint8 cw_end[4] = {
-			NBT_END,
-		NBT_END,
-	NBT_END,
-NBT_END,
-};
-
-static cc_result Cw_WriteBockDef(struct Stream* stream, int b) {
-	cc_uint8 buffer[1024];
+static void Cw_WriteBockDef(struct NbtWriter* w, int b) {
 	char nameBuffer[10];
-	cc_uint8* cur;
+	cc_uint8 data[12];
 	cc_string name;
 	cc_bool sprite = Blocks.Draw[b] == DRAW_SPRITE;
 	TextureLoc tex;
@@ -1522,160 +1601,923 @@ static cc_result Cw_WriteBockDef(struct Stream* stream, int b) {
 	String_AppendHex(&name, b);
 	nameBuffer[9] = '\0';
 
-	cur = buffer;
-	cur = Nbt_WriteDict(cur, nameBuffer);
+	Nbt_WriteDict(w, nameBuffer);
 	{
-		cur  = Nbt_WriteUInt8(cur,  "ID", b);
+		Nbt_WriteUInt8(w,  "ID", b);
 		/* It would be have been better to just change ID to be a I16 */
 		/* Unfortunately this isn't backwards compatible with ClassicalSharp */
-		cur  = Nbt_WriteUInt16(cur, "ID2", b);
-		cur  = Nbt_WriteUInt8(cur,  "CollideType", Blocks.Collide[b]);
-		cur  = Nbt_WriteFloat(cur,  "Speed", Blocks.SpeedMultiplier[b]);
+		Nbt_WriteUInt16(w, "ID2", b);
+		Nbt_WriteUInt8(w,  "CollideType", Blocks.Collide[b]);
+		Nbt_WriteFloat(w,  "Speed", Blocks.SpeedMultiplier[b]);
 
 		/* Originally only up to 256 textures were supported, which used up 6 bytes total */
 		/*  Later, support for more textures was added, which requires 2 bytes per texture */
 		/*   For backwards compatibility, the lower byte of each texture is */
 		/*   written into first 6 bytes, then higher byte into next 6 bytes (ugly hack) */
-		cur = Nbt_WriteArray(cur, "Textures", 12);
-		tex = Block_Tex(b, FACE_YMAX); cur[0] = (cc_uint8)tex; cur[ 6] = (cc_uint8)(tex >> 8);
-		tex = Block_Tex(b, FACE_YMIN); cur[1] = (cc_uint8)tex; cur[ 7] = (cc_uint8)(tex >> 8);
-		tex = Block_Tex(b, FACE_XMIN); cur[2] = (cc_uint8)tex; cur[ 8] = (cc_uint8)(tex >> 8);
-		tex = Block_Tex(b, FACE_XMAX); cur[3] = (cc_uint8)tex; cur[ 9] = (cc_uint8)(tex >> 8);
-		tex = Block_Tex(b, FACE_ZMIN); cur[4] = (cc_uint8)tex; cur[10] = (cc_uint8)(tex >> 8);
-		tex = Block_Tex(b, FACE_ZMAX); cur[5] = (cc_uint8)tex; cur[11] = (cc_uint8)(tex >> 8);
-		cur += 12;
-
-		cur  = Nbt_WriteUInt8(cur,  "TransmitsLight", Blocks.BlocksLight[b] ? 0 : 1);
-		cur  = Nbt_WriteUInt8(cur,  "WalkSound",      Blocks.DigSounds[b]);
-		cur  = Nbt_WriteUInt8(cur,  "FullBright",     Block_WriteFullBright(Blocks.Brightness[b]));
-		cur  = Nbt_WriteUInt8(cur,  "Shape",          sprite ? 0 : (cc_uint8)(Blocks.MaxBB[b].y * 16));
-		cur  = Nbt_WriteUInt8(cur,  "BlockDraw",      sprite ? Blocks.SpriteOffset[b] : Blocks.Draw[b]);
-
-		cur = Nbt_WriteArray(cur, "Fog", 4);
+		tex = Block_Tex(b, FACE_YMAX); data[0] = (cc_uint8)tex; data[ 6] = (cc_uint8)(tex >> 8);
+		tex = Block_Tex(b, FACE_YMIN); data[1] = (cc_uint8)tex; data[ 7] = (cc_uint8)(tex >> 8);
+		tex = Block_Tex(b, FACE_XMIN); data[2] = (cc_uint8)tex; data[ 8] = (cc_uint8)(tex >> 8);
+		tex = Block_Tex(b, FACE_XMAX); data[3] = (cc_uint8)tex; data[ 9] = (cc_uint8)(tex >> 8);
+		tex = Block_Tex(b, FACE_ZMIN); data[4] = (cc_uint8)tex; data[10] = (cc_uint8)(tex >> 8);
+		tex = Block_Tex(b, FACE_ZMAX); data[5] = (cc_uint8)tex; data[11] = (cc_uint8)(tex >> 8);
+		Nbt_WriteArray(w, "Textures", data, 12);
+
+		Nbt_WriteUInt8(w,  "TransmitsLight", Blocks.BlocksLight[b] ? 0 : 1);
+		Nbt_WriteUInt8(w,  "WalkSound",      Blocks.DigSounds[b]);
+		Nbt_WriteUInt8(w,  "FullBright",     Block_WriteFullBright(Blocks.Brightness[b]));
+		Nbt_WriteUInt8(w,  "Shape",          sprite ? 0 : (cc_uint8)(Blocks.MaxBB[b].y * 16));
+		Nbt_WriteUInt8(w,  "BlockDraw",      sprite ? Blocks.SpriteOffset[b] : Blocks.Draw[b]);
+
 		fog = (cc_uint8)(128 * Blocks.FogDensity[b] - 1);
 		col = Blocks.FogCol[b];
-		cur[0] = Blocks.FogDensity[b] ? fog : 0xFF; /* write 0xFF instead of 0 for backwards compatibility */
-		cur[1] = PackedCol_R(col); cur[2] = PackedCol_G(col); cur[3] = PackedCol_B(col);
-		cur += 4;
+		data[0] = Blocks.FogDensity[b] ? fog : 0xFF; /* write 0xFF instead of 0 for backwards compatibility */
+		data[1] = PackedCol_R(col); data[2] = PackedCol_G(col); data[3] = PackedCol_B(col);
+		Nbt_WriteArray(w, "Fog", data, 4);
 
-		cur  = Nbt_WriteArray(cur,  "Coords", 6);
-		minBB  = Blocks.MinBB[b]; maxBB = Blocks.MaxBB[b];
-		cur[0] = (cc_uint8)(minBB.x * 16); cur[1] = (cc_uint8)(minBB.y * 16); cur[2] = (cc_uint8)(minBB.z * 16);
-		cur[3] = (cc_uint8)(maxBB.x * 16); cur[4] = (cc_uint8)(maxBB.y * 16); cur[5] = (cc_uint8)(maxBB.z * 16);
-		cur += 6;
+		minBB   = Blocks.MinBB[b]; maxBB = Blocks.MaxBB[b];
+		data[0] = (cc_uint8)(minBB.x * 16); data[1] = (cc_uint8)(minBB.y * 16); data[2] = (cc_uint8)(minBB.z * 16);
+		data[3] = (cc_uint8)(maxBB.x * 16); data[4] = (cc_uint8)(maxBB.y * 16); data[5] = (cc_uint8)(maxBB.z * 16);
+		Nbt_WriteArray(w, "Coords", data, 6);
 
 		name = Block_UNSAFE_GetName(b);
-		cur  = Nbt_WriteString(cur, "Name", &name);
-	} *cur++ = NBT_END;
-
-	return Stream_Write(stream, buffer, (int)(cur - buffer));
+		Nbt_WriteString(w, "Name", &name);
+	} Nbt_WriteEnd(w);
 }
 
-cc_result Cw_Save(struct Stream* stream) {
+/* Writes the ClassicWorld NBT compound, optionally without the block arrays */
+static cc_result Cw_WriteWorld(struct Stream* stream, cc_bool blocks) {
 	struct LocalPlayer* p = Entities.CurPlayer;
-	cc_uint8 buffer[2048];
-	cc_uint8* cur;
-	cc_result res;
+	struct NbtWriter w;
 	int b;
+	Nbt_InitWriter(&w, stream);
 
-	cur = buffer;
-	cur = Nbt_WriteDict(cur,   "ClassicWorld");
-	cur = Nbt_WriteUInt8(cur,  "FormatVersion", 1);
-	cur = Nbt_WriteArray(cur,  "UUID", WORLD_UUID_LEN); Mem_Copy(cur, World.Uuid, WORLD_UUID_LEN); cur += WORLD_UUID_LEN;
-	cur = Nbt_WriteUInt16(cur, "X", World.Width);
-	cur = Nbt_WriteUInt16(cur, "Y", World.Height);
-	cur = Nbt_WriteUInt16(cur, "Z", World.Length);
+	Nbt_WriteDict(&w,   "ClassicWorld");
+	Nbt_WriteUInt8(&w,  "FormatVersion", 1);
+	Nbt_WriteArray(&w,  "UUID", World.Uuid, WORLD_UUID_LEN);
+	Nbt_WriteUInt16(&w, "X", World.Width);
+	Nbt_WriteUInt16(&w, "Y", World.Height);
+	Nbt_WriteUInt16(&w, "Z", World.Length);
 
-	cur = Nbt_WriteDict(cur, "MapGenerator");
+	Nbt_WriteDict(&w, "MapGenerator");
 	{
-		cur  = Nbt_WriteInt32(cur, "Seed", World.Seed);
-	} *cur++ = NBT_END;
+		Nbt_WriteInt32(&w, "Seed", World.Seed);
+	} Nbt_WriteEnd(&w);
 	
 
 	/* TODO: Maybe keep real spawn too? */
-	cur = Nbt_WriteDict(cur, "Spawn");
+	Nbt_WriteDict(&w, "Spawn");
 	{
-		cur  = Nbt_WriteUInt16(cur, "X", (cc_uint16)p->Base.Position.x);
-		cur  = Nbt_WriteUInt16(cur, "Y", (cc_uint16)p->Base.Position.y);
-		cur  = Nbt_WriteUInt16(cur, "Z", (cc_uint16)p->Base.Position.z);
-		cur  = Nbt_WriteUInt8(cur,  "H", Math_Deg2Packed(p->SpawnYaw));
-		cur  = Nbt_WriteUInt8(cur,  "P", Math_Deg2Packed(p->SpawnPitch));
-	} *cur++ = NBT_END;
-	cur = Nbt_WriteArray(cur, "BlockArray", World.Volume);
-
-	if ((res = Stream_Write(stream, buffer, (int)(cur - buffer)))) return res;
-	if ((res = Stream_Write(stream, World.Blocks, World.Volume)))  return res;
+		Nbt_WriteUInt16(&w, "X", (cc_uint16)p->Base.Position.x);
+		Nbt_WriteUInt16(&w, "Y", (cc_uint16)p->Base.Position.y);
+		Nbt_WriteUInt16(&w, "Z", (cc_uint16)p->Base.Position.z);
+		Nbt_WriteUInt8(&w,  "H", Math_Deg2Packed(p->SpawnYaw));
+		Nbt_WriteUInt8(&w,  "P", Math_Deg2Packed(p->SpawnPitch));
+	} Nbt_WriteEnd(&w);
+	if (blocks) Nbt_WriteArray(&w, "BlockArray", World.Blocks, World.Volume);
 
 #ifdef EXTENDED_BLOCKS
-	if (World.Blocks != World.Blocks2) {
-		cur = buffer;
-		cur = Nbt_WriteArray(cur, "BlockArray2", World.Volume);
-
-		if ((res = Stream_Write(stream, buffer, (int)(cur - buffer)))) return res;
-		if ((res = Stream_Write(stream, World.Blocks2, World.Volume))) return res;
+	if (blocks && World.Blocks != World.Blocks2) {
+		Nbt_WriteArray(&w, "BlockArray2", World.Blocks2, World.Volume);
 	}
 #endif
 
-	cur = buffer;
-	cur = Nbt_WriteDict(cur, "Metadata");
-	cur = Nbt_WriteDict(cur, "CPE");
+	Nbt_WriteDict(&w, "Metadata");
+	Nbt_WriteDict(&w, "CPE");
 	{
-		cur = Nbt_WriteDict(cur, "ClickDistance");
+		Nbt_WriteDict(&w, "ClickDistance");
 		{
-			cur  = Nbt_WriteUInt16(cur, "Distance", (cc_uint16)(p->ReachDistance * 32));
-		} *cur++ = NBT_END;
+			Nbt_WriteUInt16(&w, "Distance", (cc_uint16)(p->ReachDistance * 32));
+		} Nbt_WriteEnd(&w);
 
-		cur = Nbt_WriteDict(cur, "EnvWeatherType");
+		Nbt_WriteDict(&w, "EnvWeatherType");
 		{
-			cur  = Nbt_WriteUInt8(cur, "WeatherType", Env.Weather);
-		} *cur++ = NBT_END;
+			Nbt_WriteUInt8(&w, "WeatherType", Env.Weather);
+		} Nbt_WriteEnd(&w);
 
-		cur = Nbt_WriteDict(cur, "EnvColors");
+		Nbt_WriteDict(&w, "EnvColors");
 		{
-			cur = Cw_WriteColor(cur, "Sky",      Env.SkyCol);
-			cur = Cw_WriteColor(cur, "Cloud",    Env.CloudsCol);
-			cur = Cw_WriteColor(cur, "Fog",      Env.FogCol);
-			cur = Cw_WriteColor(cur, "Ambient",  Env.ShadowCol);
-			cur = Cw_WriteColor(cur, "Sunlight", Env.SunCol);
-			cur = Cw_WriteColor(cur, "Skybox",   Env.SkyboxCol);
-		} *cur++ = NBT_END;
-
-		cur = Nbt_WriteDict(cur, "EnvMapAppearance");
+			Cw_WriteColor(&w, "Sky",      Env.SkyCol);
+			Cw_WriteColor(&w, "Cloud",    Env.CloudsCol);
+			Cw_WriteColor(&w, "Fog",      Env.FogCol);
+			Cw_WriteColor(&w, "Ambient",  Env.ShadowCol);
+			Cw_WriteColor(&w, "Sunlight", Env.SunCol);
+			Cw_WriteColor(&w, "Skybox",   Env.SkyboxCol);
+		} Nbt_WriteEnd(&w);
+
+		Nbt_WriteDict(&w, "EnvMapAppearance");
 		{
-			cur  = Nbt_WriteUInt8(cur, "SideBlock", (BlockRaw)Env.SidesBlock);
-			cur  = Nbt_WriteUInt8(cur, "EdgeBlock", (BlockRaw)Env.EdgeBlock);
-			cur  = Nbt_WriteUInt16(cur, "SideLevel", Env.EdgeHeight);
-			cur  = Nbt_WriteString(cur, "TextureURL", &TexturePack_Url);
-		} *cur++ = NBT_END;
+			Nbt_WriteUInt8(&w,  "SideBlock", (BlockRaw)Env.SidesBlock);
+			Nbt_WriteUInt8(&w,  "EdgeBlock", (BlockRaw)Env.EdgeBlock);
+			Nbt_WriteUInt16(&w, "SideLevel", Env.EdgeHeight);
+			Nbt_WriteString(&w, "TextureURL", &TexturePack_Url);
+		} Nbt_WriteEnd(&w);
 
-		cur = Nbt_WriteDict(cur, "EnvMapAspect");
+		Nbt_WriteDict(&w, "EnvMapAspect");
 		{
-			cur  = Nbt_WriteUInt16(cur, "EdgeBlock",    Env.EdgeBlock);
-			cur  = Nbt_WriteUInt16(cur, "SideBlock",    Env.SidesBlock);
-			cur  = Nbt_WriteInt32(cur,  "EdgeHeight",   Env.EdgeHeight);
-			cur  = Nbt_WriteInt32(cur,  "SidesOffset",  Env.SidesOffset);
-			cur  = Nbt_WriteInt32(cur,  "CloudsHeight", Env.CloudsHeight);
-			cur  = Nbt_WriteFloat(cur,  "CloudsSpeed",  Env.CloudsSpeed);
-			cur  = Nbt_WriteFloat(cur,  "WeatherSpeed", Env.WeatherSpeed);
-			cur  = Nbt_WriteFloat(cur,  "WeatherFade",  Env.WeatherFade);
-			cur  = Nbt_WriteUInt8(cur,  "ExpFog",       (cc_uint8)Env.ExpFog);
-			cur  = Nbt_WriteFloat(cur,  "SkyboxHor",    Env.SkyboxHorSpeed);
-			cur  = Nbt_WriteFloat(cur,  "SkyboxVer",    Env.SkyboxVerSpeed);
-		} *cur++ = NBT_END;
-
-		cur = Nbt_WriteDict(cur, "BlockDefinitions");
-		if ((res = Stream_Write(stream, buffer, (int)(cur - buffer)))) return res;
-
+			Nbt_WriteUInt16(&w, "EdgeBlock",    Env.EdgeBlock);
+			Nbt_WriteUInt16(&w, "SideBlock",    Env.SidesBlock);
+			Nbt_WriteInt32(&w,  "EdgeHeight",   Env.EdgeHeight);
+			Nbt_WriteInt32(&w,  "SidesOffset",  Env.SidesOffset);
+			Nbt_WriteInt32(&w,  "CloudsHeight", Env.CloudsHeight);
+			Nbt_WriteFloat(&w,  "CloudsSpeed",  Env.CloudsSpeed);
+			Nbt_WriteFloat(&w,  "WeatherSpeed", Env.WeatherSpeed);
+			Nbt_WriteFloat(&w,  "WeatherFade",  Env.WeatherFade);
+			Nbt_WriteUInt8(&w,  "ExpFog",       (cc_uint8)Env.ExpFog);
+			Nbt_WriteFloat(&w,  "SkyboxHor",    Env.SkyboxHorSpeed);
+			Nbt_WriteFloat(&w,  "SkyboxVer",    Env.SkyboxVerSpeed);
+		} Nbt_WriteEnd(&w);
+
+		Nbt_WriteDict(&w, "BlockDefinitions");
 		{
 			/* Write block definitions in reverse order so that software that only reads byte 'ID' */
 			/* still loads correct first 256 block defs when saving a map with over 256 block defs */
 			for (b = BLOCK_MAX_DEFINED; b >= 1; b--) {
 				if (!Block_IsCustomDefined(b)) continue;
-				if ((res = Cw_WriteBockDef(stream, b))) return res;
+				Cw_WriteBockDef(&w, b);
+			}
+		} Nbt_WriteEnd(&w);
+	} Nbt_WriteEnd(&w);
+
+	Nbt_WriteEnd(&w); /* Metadata */
+	Nbt_WriteEnd(&w); /* ClassicWorld */
+	return Nbt_Flush(&w);
+}
+
+cc_result Cw_Save(struct Stream* stream) {
+	return Cw_WriteWorld(stream, true);
+}
+
+
+/*########################################################################################################################*
+*---------------------------------------------------Raw native map format-------------------------------------------------*
+*#########################################################################################################################*/
+#define RAW_VERSION 1
+#define RAW_HEADER_SIZE 32
+/* Block arrays are page aligned, so that they can be memory mapped */
+#define RAW_PAGE_SIZE 4096
+#define Raw_Align(offset) (((offset) + (RAW_PAGE_SIZE - 1)) & ~(RAW_PAGE_SIZE - 1))
+static const cc_uint8 raw_identifier[8] = { 'C','C','R','A','W','M','A','P' };
+/* Raw is an uncompressed native map format, for maps that are loaded very frequently.
+	U8[8] "Identifier" (must be "CCRAWMAP")
+	U32 "Version" (must be 1)
+	U16 "Width", "Height", "Length"
+	U16 "Flags" (unused)
+	U32 "Blocks offset"  (lower 8 bits, page aligned)
+	U32 "Blocks2 offset" (upper 8 bits, page aligned, 0 if not present)
+	U32 "Metadata offset"
+	U8* "Blocks", "Blocks2" (each padded to a multiple of page size)
+	NBT "Metadata" (ClassicWorld compound, without BlockArray/BlockArray2)
+All values are little endian. */
+
+static cc_result Raw_ReadArray(struct Stream* stream, cc_uint32 offset, BlockRaw** blocks) {
+	cc_result res;
+	*blocks = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+
+	if (!(*blocks)) return ERR_OUT_OF_MEMORY;
+	if ((res = stream->Seek(stream, offset))) return res;
+	return Stream_Read(stream, *blocks, World.Volume);
+}
+
+/* NOTE: stream must be a file stream when memory mapping is supported */
+static cc_result Raw_ReadBlocks(struct Stream* stream, cc_uint32 blocksOffset, cc_uint32 blocks2Offset) {
+	cc_result res;
+#ifdef EXTENDED_BLOCKS
+	BlockRaw* blocks2;
+#endif
+#ifdef CC_BUILD_MMAP
+	cc_uint8* data;
+	cc_uint32 len;
+
+	/* Pages are only read from disc when first accessed, and only copied when first modified */
+	if (!File_Map(stream->meta.file, (void**)&data, &len)) {
+		World_SetMapping(data, len);
+		World.Blocks = data + blocksOffset;
+	#ifdef EXTENDED_BLOCKS
+		if (blocks2Offset) World_SetMapUpper(data + blocks2Offset);
+	#endif
+		return 0;
+	}
+	/* Fallback to just reading the data when file can't be mapped */
+#endif
+
+	if ((res = Raw_ReadArray(stream, blocksOffset, &World.Blocks))) return res;
+#ifdef EXTENDED_BLOCKS
+	if (blocks2Offset) {
+		res = Raw_ReadArray(stream, blocks2Offset, &blocks2);
+		/* Even on error, still need to be freed by World_Reset */
+		if (blocks2) World_SetMapUpper(blocks2);
+	}
+#endif
+	return res;
+}
+
+/* Imports a world from a .ccraw native map file */
+/* Used by ClassiCube */
+static cc_result Raw_Load(struct Stream* stream) {
+	cc_uint8 header[RAW_HEADER_SIZE];
+	cc_uint8 buffer[4096];
+	cc_uint32 length, blocksOffset, blocks2Offset, metaOffset;
+	struct Stream metaStream;
+	cc_result res;
+
+	if ((res = Stream_Read(stream, header, sizeof(header)))) return res;
+	if (!Mem_Equal(header, raw_identifier, sizeof(raw_identifier))) return RAW_ERR_IDENTIFIER;
+	if (Stream_GetU32_LE(&header[8]) != RAW_VERSION)                return RAW_ERR_VERSION;
+
+	World.Width  = Stream_GetU16_LE(&header[12]);
+	World.Height = Stream_GetU16_LE(&header[14]);
+	World.Length = Stream_GetU16_LE(&header[16]);
+	World.Volume = World.Width * World.Height * World.Length;
+
+	blocksOffset  = Stream_GetU32_LE(&header[20]);
+	blocks2Offset = Stream_GetU32_LE(&header[24]);
+	metaOffset    = Stream_GetU32_LE(&header[28]);
+
+	if ((res = stream->Length(stream, &length))) return res;
+	if (blocksOffset  > length || length - blocksOffset  < World.Volume) return RAW_ERR_BLOCKS_RANGE;
+	if (blocks2Offset > length || length - blocks2Offset < World.Volume) return RAW_ERR_BLOCKS_RANGE;
+
+	if ((res = Raw_ReadBlocks(stream, blocksOffset, blocks2Offset))) return res;
+	if ((res = stream->Seek(stream, metaOffset))) return res;
+
+	Stream_ReadonlyBuffered(&metaStream, stream, buffer, sizeof(buffer));
+	/* Block arrays were already mapped in above, so any arrays in the metadata are ignored */
+	return Nbt_ReadRoot(&metaStream, Cw_Callback, NULL);
+}
+
+static cc_result Raw_WritePadding(struct Stream* stream, cc_uint32 offset) {
+	static const cc_uint8 zeroes[RAW_PAGE_SIZE];
+	return Stream_Write(stream, zeroes, Raw_Align(offset) - offset);
+}
+
+cc_result Raw_Save(struct Stream* stream) {
+	cc_uint8 header[RAW_HEADER_SIZE] = { 0 };
+	cc_uint32 blocksOffset  = RAW_PAGE_SIZE;
+	cc_uint32 blocks2Offset = 0;
+	cc_uint32 metaOffset    = Raw_Align(blocksOffset + World.Volume);
+	cc_result res;
+
+#ifdef EXTENDED_BLOCKS
+	if (World.Blocks != World.Blocks2) {
+		blocks2Offset = metaOffset;
+		metaOffset    = Raw_Align(blocks2Offset + World.Volume);
+	}
+#endif
+
+	Mem_Copy(header, raw_identifier, sizeof(raw_identifier));
+	Stream_SetU32_LE(&header[8],  RAW_VERSION);
+	Stream_SetU16_LE(&header[12], World.Width);
+	Stream_SetU16_LE(&header[14], World.Height);
+	Stream_SetU16_LE(&header[16], World.Length);
+	Stream_SetU32_LE(&header[20], blocksOffset);
+	Stream_SetU32_LE(&header[24], blocks2Offset);
+	Stream_SetU32_LE(&header[28], metaOffset);
+
+	if ((res = Stream_Write(stream, header, sizeof(header))))        return res;
+	if ((res = Raw_WritePadding(stream, sizeof(header))))            return res;
+	if ((res = Stream_Write(stream, World.Blocks, World.Volume)))    return res;
+	if ((res = Raw_WritePadding(stream, World.Volume)))              return res;
+
+#ifdef EXTENDED_BLOCKS
+	if (blocks2Offset) {
+		if ((res = Stream_Write(stream, World.Blocks2, World.Volume))) return res;
+		if ((res = Raw_WritePadding(stream, World.Volume)))            return res;
+	}
+#endif
+	return Cw_WriteWorld(stream, false);
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------Region native map format------------------------------------------------*
+*#########################################################################################################################*/
+#define RGN_VERSION 1
+#define RGN_HEADER_SIZE 40
+#define RGN_ENTRY_SIZE  16
+#define RGN_CHUNK_SIZE  32
+#define RGN_MAX_CHUNK_SIZE 64
+#define RGN_FLAG_BLOCKS2 0x01
+/* Chunks are stored in slots that are a multiple of this size, so that when the map */
+/*  is saved again, modified chunks can usually reuse the slots of previously modified chunks */
+#define RGN_SLOT_SIZE 512
+#define Rgn_AlignSlot(len) (((len) + (RGN_SLOT_SIZE - 1)) & ~(RGN_SLOT_SIZE - 1))
+static const cc_uint8 rgn_identifier[8] = { 'C','C','R','E','G','I','O','N' };
+/* Region is a native map format made up of independently compressed chunks, so that any chunk
+   can be read on its own, and only the chunks that changed need to be rewritten when saving.
+	U8[8] "Identifier" (must be "CCREGION")
+	U32 "Version" (must be 1)
+	U16 "Width", "Height", "Length"
+	U16 "Chunk size" (chunks are size x size x size blocks, smaller at edges of the world)
+	U16 "Flags" (1 = upper 8 bits of blocks are present)
+	U16 "Reserved"
+	U32 "Table offset"
+	U32 "Metadata offset", "Metadata capacity", "Metadata length"
+	ENTRY[chunks] "Table" (ordered by chunk X, then Z, then Y)
+		U32 "Offset" (0 if every block in the chunk is the same)
+		U32 "Length" (length of compressed data, or the block if offset is 0)
+		U32 "Capacity" (size of the slot at offset that the chunk is stored in)
+		U32 "CRC32" (of the uncompressed chunk data)
+	U8* "Chunks" (DEFLATE compressed lower 8 bits of blocks, followed by upper 8 bits if present)
+	NBT "Metadata" (ClassicWorld compound, without BlockArray/BlockArray2)
+The table, chunks and metadata may be stored in any order after the header.
+All values are little endian. */
+
+/* When saving into an existing region file, modified chunks, the metadata and the table are */
+/*  only ever written into parts of the file that the current header and table don't use. */
+/* Writing the header last then switches over to the new table all at once, */
+/*  so if saving is interrupted, the file still contains the previously saved map */
+struct RegionChunk { cc_uint32 offset, length, capacity, crc; };
+struct RegionSlot  { cc_uint32 offset, capacity; };
+struct RegionSlots { struct RegionSlot* slots; int count, capacity; };
+
+/* Layout of the region file that was last loaded or saved */
+static struct RegionFile {
+	struct RegionChunk* chunks;
+	int chunksX, chunksY, chunksZ, count, chunkSize, flags;
+	int width, height, length;
+	cc_uint32 metaOffset, metaCapacity, metaLength, end;
+	cc_uint32 tableOffset, tableCapacity;
+	cc_string path; char _pathBuffer[FILENAME_SIZE];
+} rgn;
+/* Scratch buffer for compressed chunk data and metadata */
+static cc_uint8* rgn_data;
+static cc_uint32 rgn_dataLen, rgn_dataCapacity;
+/* Parts of the file not used by the last saved layout, which can be written to when saving */
+static struct RegionSlots rgn_free;
+/* Slots used by the last saved layout that will be free once the current save has finished */
+static struct RegionSlots rgn_freeing;
+
+static void Region_Reset(void) {
+	Mem_Free(rgn.chunks);
+	rgn.chunks      = NULL;
+	rgn.path.length = 0;
+	rgn_free.count    = 0;
+	rgn_freeing.count = 0;
+}
+
+static cc_result Region_Init(int width, int height, int length, int chunkSize, int flags) {
+	Region_Reset();
+	String_InitArray(rgn.path, rgn._pathBuffer);
+
+	rgn.width  = width; rgn.height = height; rgn.length = length;
+	rgn.flags  = flags;
+	rgn.chunkSize = chunkSize;
+	rgn.chunksX   = (width  + chunkSize - 1) / chunkSize;
+	rgn.chunksY   = (height + chunkSize - 1) / chunkSize;
+	rgn.chunksZ   = (length + chunkSize - 1) / chunkSize;
+	rgn.count     = rgn.chunksX * rgn.chunksY * rgn.chunksZ;
+
+	rgn.metaOffset  = 0; rgn.metaCapacity  = 0; rgn.metaLength = 0;
+	rgn.tableOffset = 0; rgn.tableCapacity = 0;
+	rgn.end    = RGN_HEADER_SIZE;
+	rgn.chunks = (struct RegionChunk*)Mem_TryAllocCleared(rgn.count, sizeof(struct RegionChunk));
+	return rgn.chunks ? 0 : ERR_OUT_OF_MEMORY;
+}
+
+static cc_result Region_GrowData(cc_uint32 len) {
+	cc_uint8* data;
+	if (len <= rgn_dataCapacity) return 0;
+
+	len  = max(len, rgn_dataCapacity * 2);
+	data = (cc_uint8*)Mem_TryRealloc(rgn_data, len, 1);
+	if (!data) return ERR_OUT_OF_MEMORY;
+
+	rgn_data = data;
+	rgn_dataCapacity = len;
+	return 0;
+}
+
+static cc_result Region_BufferWrite(struct Stream* s, const cc_uint8* data, cc_uint32 count, cc_uint32* modified) {
+	cc_result res;
+	*modified = 0;
+	if ((res = Region_GrowData(rgn_dataLen + count))) return res;
+
+	Mem_Copy(rgn_data + rgn_dataLen, data, count);
+	rgn_dataLen += count;
+	*modified    = count;
+	return 0;
+}
+
+/* Calculates the origin and size of a chunk, returning the number of blocks in it */
+static int Region_ChunkBounds(int index, IVec3* pos, IVec3* size) {
+	int chunkSize = rgn.chunkSize;
+	pos->x = (index % rgn.chunksX) * chunkSize;
+	pos->z = (index / rgn.chunksX % rgn.chunksZ) * chunkSize;
+	pos->y = (index / (rgn.chunksX * rgn.chunksZ)) * chunkSize;
+
+	size->x = min(chunkSize, World.Width  - pos->x);
+	size->y = min(chunkSize, World.Height - pos->y);
+	size->z = min(chunkSize, World.Length - pos->z);
+	return size->x * size->y * size->z;
+}
+
+/* Copies the blocks of a chunk between the world and the chunk buffer, returning number of blocks in the chunk */
+/* NOTE: The chunk buffer holds lower 8 bits of all the blocks, followed by upper 8 bits if RGN_FLAG_BLOCKS2 */
+static int Region_CopyChunk(int index, cc_uint8* chunk, cc_bool toWorld) {
+	IVec3 pos, size;
+	int volume = Region_ChunkBounds(index, &pos, &size);
+	int x = pos.x, y = pos.y, z = pos.z;
+	int w = size.x, h = size.y, l = size.z;
+	int yy, zz, i;
+	cc_uint8* cur = chunk;
+
+	for (yy = y; yy < y + h; yy++) {
+		for (zz = z; zz < z + l; zz++, cur += w) 
+		{
+			i = World_Pack(x, yy, zz);
+			if (toWorld) {
+				Mem_Copy(World.Blocks + i, cur, w);
+			} else {
+				Mem_Copy(cur, World.Blocks + i, w);
 			}
+#ifdef EXTENDED_BLOCKS
+			if (!(rgn.flags & RGN_FLAG_BLOCKS2)) continue;
+
+			if (toWorld) {
+				Mem_Copy(World.Blocks2 + i, cur + volume, w);
+			} else {
+				Mem_Copy(cur + volume, World.Blocks2 + i, w);
+			}
+#endif
 		}
 	}
-	return Stream_Write(stream, cw_end, sizeof(cw_end));
+	return volume;
+}
+
+static cc_bool Region_IsUniform(const cc_uint8* data, int volume) {
+	int i;
+	for (i = 1; i < volume; i++) 
+	{
+		if (data[i] != data[0]) return false;
+	}
+	return true;
+}
+
+static cc_result Region_AddSlot(struct RegionSlots* list, cc_uint32 offset, cc_uint32 capacity) {
+	struct RegionSlot* slots;
+	int newCapacity;
+	if (!capacity) return 0;
+
+	if (list->count == list->capacity) {
+		newCapacity = max(list->capacity * 2, 64);
+		slots = (struct RegionSlot*)Mem_TryRealloc(list->slots, newCapacity, sizeof(struct RegionSlot));
+		if (!slots) return ERR_OUT_OF_MEMORY;
+
+		list->slots    = slots;
+		list->capacity = newCapacity;
+	}
+
+	list->slots[list->count].offset   = offset;
+	list->slots[list->count].capacity = capacity;
+	list->count++;
+	return 0;
+}
+
+static struct RegionSlot* rgn_sortSlots;
+static void Region_QuickSort(int left, int right) {
+	struct RegionSlot* keys = rgn_sortSlots; struct RegionSlot key;
+
+	while (left < right) {
+		int i = left, j = right;
+		cc_uint32 pivot = keys[(i + j) >> 1].offset;
+
+		/* partition the list */
+		while (i <= j) {
+			while (keys[i].offset < pivot) i++;
+			while (keys[j].offset > pivot) j--;
+			QuickSort_Swap_Maybe();
+		}
+		/* recurse into the smaller subset */
+		QuickSort_Recurse(Region_QuickSort)
+	}
+}
+
+static void Region_SortSlots(struct RegionSlots* list) {
+	rgn_sortSlots = list->slots;
+	Region_QuickSort(0, list->count - 1);
+}
+
+/* Finds all the parts of the file that aren't used by the header, table, metadata or any chunk */
+static cc_result Region_FindFreeSlots(void) {
+	struct RegionSlots* used = &rgn_freeing;
+	struct RegionSlot* slot;
+	cc_uint32 pos = 0;
+	cc_result res;
+	int i;
+
+	rgn_free.count = 0;
+	used->count    = 0;
+	if ((res = Region_AddSlot(used, 0, RGN_HEADER_SIZE)))                  return res;
+	if ((res = Region_AddSlot(used, rgn.tableOffset, rgn.tableCapacity))) return res;
+	if ((res = Region_AddSlot(used, rgn.metaOffset,  rgn.metaCapacity)))  return res;
+
+	for (i = 0; i < rgn.count; i++) 
+	{
+		if (!rgn.chunks[i].offset) continue;
+		if ((res = Region_AddSlot(used, rgn.chunks[i].offset, rgn.chunks[i].capacity))) return res;
+	}
+	Region_SortSlots(used);
+
+	for (i = 0; i < used->count; i++) 
+	{
+		slot = &used->slots[i];
+		if (slot->offset > pos && (res = Region_AddSlot(&rgn_free, pos, slot->offset - pos))) return res;
+		pos = max(pos, slot->offset + slot->capacity);
+	}
+	if (rgn.end > pos && (res = Region_AddSlot(&rgn_free, pos, rgn.end - pos))) return res;
+
+	used->count = 0;
+	return 0;
+}
+
+/* Marks the slots used by the previously saved layout as free, once the new layout has been saved */
+static cc_result Region_CommitFreed(void) {
+	struct RegionSlot* slots;
+	struct RegionSlot* slot;
+	cc_result res;
+	int i, count = 0;
+
+	for (i = 0; i < rgn_freeing.count; i++) 
+	{
+		slot = &rgn_freeing.slots[i];
+		if ((res = Region_AddSlot(&rgn_free, slot->offset, slot->capacity))) return res;
+	}
+	rgn_freeing.count = 0;
+	Region_SortSlots(&rgn_free);
+	slots = rgn_free.slots;
+
+	/* Merge adjacent free slots together, and remove slots that have been entirely used up */
+	for (i = 0; i < rgn_free.count; i++) 
+	{
+		if (!slots[i].capacity) continue;
+
+		if (count && slots[count - 1].offset + slots[count - 1].capacity == slots[i].offset) {
+			slots[count - 1].capacity += slots[i].capacity;
+		} else {
+			slots[count++] = slots[i];
+		}
+	}
+	rgn_free.count = count;
+	return 0;
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------Region native map import------------------------------------------------*
+*#########################################################################################################################*/
+static cc_result Region_ReadTable(struct Stream* stream, cc_uint32 offset, cc_uint32 length) {
+	cc_uint8 buffer[RGN_ENTRY_SIZE * 256];
+	struct RegionChunk* c;
+	cc_uint8* entry;
+	int i, j, count;
+	cc_result res;
+
+	if (offset > length || (length - offset) / RGN_ENTRY_SIZE < (cc_uint32)rgn.count) return RGN_ERR_CHUNK_RANGE;
+	if ((res = stream->Seek(stream, offset))) return res;
+
+	for (i = 0; i < rgn.count; i += count) {
+		count = min(rgn.count - i, 256);
+		if ((res = Stream_Read(stream, buffer, count * RGN_ENTRY_SIZE))) return res;
+
+		for (j = 0; j < count; j++) 
+		{
+			c     = &rgn.chunks[i + j];
+			entry = &buffer[j * RGN_ENTRY_SIZE];
+
+			c->offset   = Stream_GetU32_LE(&entry[0]);
+			c->length   = Stream_GetU32_LE(&entry[4]);
+			c->capacity = Stream_GetU32_LE(&entry[8]);
+			c->crc      = Stream_GetU32_LE(&entry[12]);
+
+			if (!c->offset) continue;
+			if (c->offset > length || length - c->offset < c->length) return RGN_ERR_CHUNK_RANGE;
+		}
+	}
+	return 0;
+}
+
+/* Decompresses a single chunk into the chunk buffer */
+static cc_result Region_ReadChunk(struct Stream* stream, struct RegionChunk* c, cc_uint8* chunk, 
+								int volume, struct InflateState* state) {
+	struct Stream mem, inflate;
+	cc_bool blocks2 = rgn.flags & RGN_FLAG_BLOCKS2;
+	cc_result res;
+
+	if (!c->offset) {
+		Mem_Set(chunk, (cc_uint8)c->length, volume);
+		if (blocks2) Mem_Set(chunk + volume, (cc_uint8)(c->length >> 8), volume);
+		return 0;
+	}
+
+	if ((res = Region_GrowData(c->length)))             return res;
+	if ((res = stream->Seek(stream, c->offset)))        return res;
+	if ((res = Stream_Read(stream, rgn_data, c->length))) return res;
+
+	Stream_ReadonlyMemory(&mem, rgn_data, c->length);
+	Inflate_MakeStream2(&inflate, state, &mem);
+	return Stream_Read(&inflate, chunk, blocks2 ? volume * 2 : volume);
+}
+
+static cc_result Region_ReadChunks(struct Stream* stream) {
+	struct InflateState* state;
+	IVec3 pos, chunkSize;
+	cc_uint8* chunk;
+	int i, volume, size = rgn.chunkSize;
+	cc_result res = 0;
+
+	state = (struct InflateState*)Mem_TryAlloc(1, sizeof(struct InflateState));
+	chunk = (cc_uint8*)Mem_TryAlloc(size * size * size, 2);
+	if (!state || !chunk) res = ERR_OUT_OF_MEMORY;
+
+	for (i = 0; i < rgn.count && !res; i++) 
+	{
+		volume = Region_ChunkBounds(i, &pos, &chunkSize);
+		res    = Region_ReadChunk(stream, &rgn.chunks[i], chunk, volume, state);
+		if (!res) Region_CopyChunk(i, chunk, true);
+	}
+
+	Mem_Free(state);
+	Mem_Free(chunk);
+	return res;
+}
+
+/* Imports a world from a .ccrgn region native map file */
+/* Used by ClassiCube */
+static cc_result Region_Load(struct Stream* stream) {
+	cc_uint8 header[RGN_HEADER_SIZE];
+	cc_uint8 buffer[4096];
+	cc_uint32 length, tableOffset;
+	struct Stream metaStream;
+	int chunkSize, flags;
+	cc_result res;
+#ifdef EXTENDED_BLOCKS
+	BlockRaw* blocks2;
+#endif
+
+	if ((res = Stream_Read(stream, header, sizeof(header)))) return res;
+	if (!Mem_Equal(header, rgn_identifier, sizeof(rgn_identifier))) return RGN_ERR_IDENTIFIER;
+	if (Stream_GetU32_LE(&header[8]) != RGN_VERSION)                return RGN_ERR_VERSION;
+
+	World.Width  = Stream_GetU16_LE(&header[12]);
+	World.Height = Stream_GetU16_LE(&header[14]);
+	World.Length = Stream_GetU16_LE(&header[16]);
+	World.Volume = World.Width * World.Height * World.Length;
+
+	chunkSize   = Stream_GetU16_LE(&header[18]);
+	flags       = Stream_GetU16_LE(&header[20]);
+	tableOffset = Stream_GetU32_LE(&header[24]);
+	if (!chunkSize || chunkSize > RGN_MAX_CHUNK_SIZE) return RGN_ERR_VERSION;
+
+	if ((res = stream->Length(stream, &length))) return res;
+	if ((res = Region_Init(World.Width, World.Height, World.Length, chunkSize, flags))) return res;
+	if ((res = Region_ReadTable(stream, tableOffset, length))) { Region_Reset(); return res; }
+
+	rgn.metaOffset   = Stream_GetU32_LE(&header[28]);
+	rgn.metaCapacity = Stream_GetU32_LE(&header[32]);
+	rgn.metaLength   = Stream_GetU32_LE(&header[36]);
+	rgn.end          = length;
+	/* Any padding after the table is just found as free space */
+	rgn.tableOffset   = tableOffset;
+	rgn.tableCapacity = rgn.count * RGN_ENTRY_SIZE;
+
+	World.Blocks = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+	if (!World.Blocks) { Region_Reset(); return ERR_OUT_OF_MEMORY; }
+#ifdef EXTENDED_BLOCKS
+	if (flags & RGN_FLAG_BLOCKS2) {
+		blocks2 = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+		if (!blocks2) { Region_Reset(); return ERR_OUT_OF_MEMORY; }
+		World_SetMapUpper(blocks2);
+	}
+#endif
+
+	res = Region_ReadChunks(stream);
+	if (!res) res = stream->Seek(stream, rgn.metaOffset);
+
+	if (!res) {
+		Stream_ReadonlyBuffered(&metaStream, stream, buffer, sizeof(buffer));
+		res = Nbt_ReadRoot(&metaStream, Cw_Callback, NULL);
+	}
+
+	/* Remember where the map came from, so that saving to it later only rewrites changed chunks */
+	if (res || !map_path || Region_FindFreeSlots()) {
+		Region_Reset();
+	} else {
+		String_Copy(&rgn.path, map_path);
+	}
+	return res;
+}
+
+
+/*########################################################################################################################*
+*-------------------------------------------------Region native map export------------------------------------------------*
+*#########################################################################################################################*/
+/* Releases the given slot once the current save has finished */
+static cc_result Region_FreeSlot(cc_uint32* offset, cc_uint32* capacity) {
+	cc_result res = 0;
+	if (*offset) res = Region_AddSlot(&rgn_freeing, *offset, *capacity);
+
+	*offset   = 0;
+	*capacity = 0;
+	return res;
+}
+
+/* Writes the contents of the scratch buffer into a new slot, replacing the given slot */
+/* The new slot is either a free part of the file that's large enough, or at the end of the file */
+static cc_result Region_WriteSlot(struct Stream* stream, cc_uint32* offset, cc_uint32* capacity) {
+	cc_uint32 len  = rgn_dataLen;
+	cc_uint32 size = Rgn_AlignSlot(len);
+	struct RegionSlot* best = NULL;
+	struct RegionSlot* slot;
+	cc_result res;
+	int i;
+
+	if ((res = Region_FreeSlot(offset, capacity))) return res;
+	*capacity = size;
+
+	/* Use the smallest free part of the file that fits, to reduce fragmentation */
+	for (i = 0; i < rgn_free.count; i++) 
+	{
+		slot = &rgn_free.slots[i];
+		if (slot->capacity < size) continue;
+		if (!best || slot->capacity < best->capacity) best = slot;
+	}
+
+	if (best) {
+		*offset         = best->offset;
+		best->offset   += size;
+		best->capacity -= size;
+	} else {
+		*offset  = rgn.end;
+		rgn.end += size;
+
+		/* Slot is padded out, so the file always ends where the last slot does */
+		if ((res = Region_GrowData(size))) return res;
+		Mem_Set(rgn_data + len, 0, size - len);
+		len = size;
+	}
+
+	if ((res = stream->Seek(stream, *offset))) return res;
+	return Stream_Write(stream, rgn_data, len);
+}
+
+static cc_result Region_WriteChunk(struct Stream* stream, int index, cc_uint8* chunk, 
+								struct DeflateState* state, int level) {
+	struct RegionChunk* c = &rgn.chunks[index];
+	cc_bool blocks2 = rgn.flags & RGN_FLAG_BLOCKS2;
+	struct Stream output, deflate;
+	int volume, len;
+	cc_uint32 crc;
+	cc_result res;
+
+	volume = Region_CopyChunk(index, chunk, false);
+	len    = blocks2 ? volume * 2 : volume;
+
+	if (Region_IsUniform(chunk, volume) && (!blocks2 || Region_IsUniform(chunk + volume, volume))) {
+		c->length = blocks2 ? (chunk[0] | (chunk[volume] << 8)) : chunk[0];
+		c->crc    = 0;
+		return Region_FreeSlot(&c->offset, &c->capacity);
+	}
+
+	/* Chunk hasn't changed since it was last loaded or saved */
+	crc = Utils_CRC32(chunk, len);
+	if (c->offset && c->crc == crc) return 0;
+
+	Stream_Init(&output);
+	output.Write = Region_BufferWrite;
+	rgn_dataLen  = 0;
+
+	Deflate_MakeStream(&deflate, state, &output);
+	Deflate_SetLevel(state, level);
+	if ((res = Stream_Write(&deflate, chunk, len))) return res;
+	if ((res = deflate.Close(&deflate)))            return res;
+
+	c->length = rgn_dataLen;
+	c->crc    = crc;
+	return Region_WriteSlot(stream, &c->offset, &c->capacity);
+}
+
+static cc_result Region_WriteMetadata(struct Stream* stream) {
+	struct Stream output;
+	cc_result res;
+
+	Stream_Init(&output);
+	output.Write = Region_BufferWrite;
+	rgn_dataLen  = 0;
+
+	if ((res = Cw_WriteWorld(&output, false))) return res;
+	rgn.metaLength = rgn_dataLen;
+	return Region_WriteSlot(stream, &rgn.metaOffset, &rgn.metaCapacity);
+}
+
+static cc_result Region_WriteTable(struct Stream* stream) {
+	struct RegionChunk* c;
+	cc_uint8* entry;
+	cc_result res;
+	int i;
+
+	rgn_dataLen = rgn.count * RGN_ENTRY_SIZE;
+	if ((res = Region_GrowData(rgn_dataLen))) return res;
+
+	for (i = 0; i < rgn.count; i++) 
+	{
+		c     = &rgn.chunks[i];
+		entry = &rgn_data[i * RGN_ENTRY_SIZE];
+
+		Stream_SetU32_LE(&entry[0],  c->offset);
+		Stream_SetU32_LE(&entry[4],  c->length);
+		Stream_SetU32_LE(&entry[8],  c->capacity);
+		Stream_SetU32_LE(&entry[12], c->crc);
+	}
+	return Region_WriteSlot(stream, &rgn.tableOffset, &rgn.tableCapacity);
+}
+
+static cc_result Region_WriteHeader(struct Stream* stream) {
+	cc_uint8 header[RGN_HEADER_SIZE] = { 0 };
+	cc_result res;
+
+	Mem_Copy(header, rgn_identifier, sizeof(rgn_identifier));
+	Stream_SetU32_LE(&header[8],  RGN_VERSION);
+	Stream_SetU16_LE(&header[12], rgn.width);
+	Stream_SetU16_LE(&header[14], rgn.height);
+	Stream_SetU16_LE(&header[16], rgn.length);
+	Stream_SetU16_LE(&header[18], rgn.chunkSize);
+	Stream_SetU16_LE(&header[20], rgn.flags);
+	Stream_SetU32_LE(&header[24], rgn.tableOffset);
+	Stream_SetU32_LE(&header[28], rgn.metaOffset);
+	Stream_SetU32_LE(&header[32], rgn.metaCapacity);
+	Stream_SetU32_LE(&header[36], rgn.metaLength);
+
+	if ((res = stream->Seek(stream, 0))) return res;
+	return Stream_Write(stream, header, sizeof(header));
+}
+
+/* Opens the region file that was last loaded from or saved to, if the world can be saved into it in place */
+static cc_bool Region_OpenExisting(struct Stream* stream, const cc_string* path, int flags) {
+	cc_filepath str;
+	cc_uint32 length;
+	cc_file file;
+	cc_result res;
+
+	if (!rgn.chunks || !String_Equals(&rgn.path, path)) return false;
+	if (rgn.width  != World.Width  || rgn.height != World.Height) return false;
+	if (rgn.length != World.Length || rgn.flags  != flags)        return false;
+
+	Platform_EncodePath(&str, path);
+	if (File_Open(&file, &str)) return false;
+	Stream_FromFile(stream, file);
+	
+	/* Something else might have modified the file since then */
+	res = stream->Length(stream, &length);
+	(void)stream->Close(stream);
+	if (res || length != rgn.end) return false;
+
+	if (File_OpenOrCreate(&file, &str)) return false;
+	Stream_FromFile(stream, file);
+	return true;
+}
+
+cc_result Region_Save(const cc_string* path, int level) {
+	struct DeflateState* state;
+	struct Stream stream;
+	cc_uint8* chunk;
+	int i, size, flags = 0;
+	cc_result res;
+
+#ifdef EXTENDED_BLOCKS
+	if (World.Blocks != World.Blocks2) flags = RGN_FLAG_BLOCKS2;
+#endif
+	if (!Region_OpenExisting(&stream, path, flags)) {
+		if ((res = Region_Init(World.Width, World.Height, World.Length, RGN_CHUNK_SIZE, flags))) return res;
+		if ((res = Stream_CreateFile(&stream, path))) { Region_Reset(); return res; }
+	}
+
+	size  = rgn.chunkSize;
+	state = (struct DeflateState*)Mem_TryAlloc(1, sizeof(struct DeflateState));
+	chunk = (cc_uint8*)Mem_TryAlloc(size * size * size, 2);
+	res   = (state && chunk) ? 0 : ERR_OUT_OF_MEMORY;
+
+	for (i = 0; i < rgn.count && !res; i++) 
+	{
+		res = Region_WriteChunk(&stream, i, chunk, state, level);
+	}
+	if (!res) res = Region_WriteMetadata(&stream);
+	if (!res) res = Region_WriteTable(&stream);
+	/* Header is written last, so that the new table is only used once everything else has been written */
+	if (!res) res = Region_WriteHeader(&stream);
+	if (!res) res = Region_CommitFreed();
+
+	Mem_Free(state);
+	Mem_Free(chunk);
+
+	if (res) {
+		(void)stream.Close(&stream);
+	} else {
+		res = stream.Close(&stream);
+	}
+
+	if (res) { Region_Reset(); return res; }
+	String_Copy(&rgn.path, path);
+	return 0;
 }
 
 
@@ -1866,6 +2708,8 @@ static struct MapImporter lvl_imp   = { ".lvl",     Lvl_Load };
 static struct MapImporter mine_imp  = { ".mine",    Dat_Load };
 static struct MapImporter fcm_imp   = { ".fcm",     Fcm_Load };
 static struct MapImporter mclvl_imp = { ".mclevel", MCLevel_Load };
+static struct MapImporter raw_imp   = { ".ccraw",   Raw_Load };
+static struct MapImporter rgn_imp   = { ".ccrgn",   Region_Load };
 
 static void OnInit(void) {
 	MapImporter_Register(&cw_imp);
@@ -1874,10 +2718,17 @@ static void OnInit(void) {
 	MapImporter_Register(&mine_imp);
 	MapImporter_Register(&fcm_imp);
 	MapImporter_Register(&mclvl_imp);
+	MapImporter_Register(&raw_imp);
+	MapImporter_Register(&rgn_imp);
 }
 
 static void OnFree(void) {
 	imp_head = NULL;
+	Region_Reset();
+
+	Mem_Free(rgn_data);
+	rgn_data = NULL;
+	rgn_dataLen = 0; rgn_dataCapacity = 0;
 }
 #else
 /* No point including map format code when can't save/load maps anyways */
@@ -1887,6 +2738,8 @@ cc_result Map_LoadFrom(const cc_string* path) { return ERR_NOT_SUPPORTED; }
 cc_result Cw_Save(struct Stream* stream)  { return ERR_NOT_SUPPORTED; }
 cc_result Dat_Save(struct Stream* stream) { return ERR_NOT_SUPPORTED; }
 cc_result Schematic_Save(struct Stream* stream) { return ERR_NOT_SUPPORTED; }
+cc_result Raw_Save(struct Stream* stream) { return ERR_NOT_SUPPORTED; }
+cc_result Region_Save(const cc_string* path, int level) { return ERR_NOT_SUPPORTED; }
 
 static void OnInit(void) { }
 static void OnFree(void) { }
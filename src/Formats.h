@@ -38,6 +38,12 @@ cc_result Schematic_Save(struct Stream* stream);
 /* Exports a world to a .dat Classic map file */
 /* Used by MineCraft Classic */
 cc_result Dat_Save(struct Stream* stream);
+/* Exports a world to a .ccraw uncompressed native map file */
+/* Block arrays are page aligned, so they can be memory mapped when loading */
+cc_result Raw_Save(struct Stream* stream);
+/* Exports a world to a .ccrgn region native map file, made up of independently compressed chunks */
+/* When saving to the same file the world was last loaded from or saved to, only changed chunks are rewritten */
+cc_result Region_Save(const cc_string* path, int level);
 
 CC_END_HEADER
 #endif
@@ -51,7 +51,7 @@ int Game_ViewDistance     = DEFAULT_VIEWDIST;
 int Game_UserViewDistance = DEFAULT_VIEWDIST;
 int Game_MaxViewDistance  = DEFAULT_MAX_VIEWDIST;
 
-int     Game_FpsLimit, Game_Vertices;
+int     Game_FpsLimit, Game_Vertices, Game_DrawCalls;
 cc_bool Game_SimpleArmsAnim;
 static float gfx_minFrameMs;
 static cc_bool autoPause;
@@ -207,6 +207,48 @@ void Game_UpdateBlock(int x, int y, int z, BlockID block) {
 	MapRenderer_OnBlockChanged(x, y, z, block);
 }
 
+void Game_UpdateBlocks(const cc_int32* indices, const BlockID* blocks, int count) {
+	int x = 0, y = 0, z = 0, i, index, last = -2;
+	int cx, cy, cz, curX = 0, curY = 0, curZ = 0;
+	cc_bool inChunk = false;
+	BlockID old, block, drawn = BLOCK_AIR;
+
+	for (i = 0; i < count; i++) {
+		index = indices[i];
+		block = blocks[i];
+
+		/* Changes are usually to consecutive blocks (e.g. from /cuboid), so avoid World_Unpack's divisions for those */
+		if (index == last + 1 && x < World.MaxX) {
+			x++;
+		} else {
+			World_Unpack(index, x, y, z);
+		}
+		last = index;
+
+		old = World_GetRawBlock(index);
+		if (old == block) continue;
+		World_SetBlock(x, y, z, block);
+
+		if (Weather_Heightmap) {
+			EnvRenderer_OnBlockChanged(x, y, z, old, block);
+		}
+		Lighting.OnBlockChanged(x, y, z, old, block);
+
+		/* Only need to mark the chunk as needing rebuilding once per run of changes within it */
+		cx = x >> CHUNK_SHIFT; cy = y >> CHUNK_SHIFT; cz = z >> CHUNK_SHIFT;
+		if (inChunk && cx == (curX >> CHUNK_SHIFT) && cy == (curY >> CHUNK_SHIFT) && cz == (curZ >> CHUNK_SHIFT)) {
+			if (Blocks.Draw[block] != DRAW_GAS) drawn = block;
+			continue;
+		}
+
+		if (inChunk) MapRenderer_OnBlockChanged(curX, curY, curZ, drawn);
+		curX = x; curY = y; curZ = z;
+		drawn   = block;
+		inChunk = true;
+	}
+	if (inChunk) MapRenderer_OnBlockChanged(curX, curY, curZ, drawn);
+}
+
 void Game_ChangeBlock(int x, int y, int z, BlockID block) {
 	BlockID old = World_GetBlock(x, y, z);
 	Game_UpdateBlock(x, y, z, block);
@@ -774,7 +816,8 @@ void Game_RenderFrame(void) {
 	Gfx_BeginFrame();
 	Gfx_BindIb(Gfx.DefaultIb);
 	Game.Time += deltaD;
-	Game_Vertices = 0;
+	Game_Vertices  = 0;
+	Game_DrawCalls = 0;
 	Gamepad_Tick(delta);
 
 #ifdef CC_BUILD_SPLITSCREEN
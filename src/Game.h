@@ -56,6 +56,7 @@ extern int Game_UserViewDistance;
 extern int     Game_FpsLimit;
 extern cc_bool Game_SimpleArmsAnim;
 extern int     Game_Vertices;
+extern int     Game_DrawCalls;
 
 extern cc_bool Game_ClassicMode;
 extern cc_bool Game_ClassicHacks;
@@ -105,6 +106,10 @@ void Game_Reset(void);
 /* (updating state means recalculating light, redrawing chunk block is in, etc) */
 /* NOTE: This does NOT notify the server, use Game_ChangeBlock for that. */
 CC_API void Game_UpdateBlock(int x, int y, int z, BlockID block);
+/* Sets multiple blocks in the map at once (given as World_Pack indices), then updates state associated with them. */
+/* Much faster than calling Game_UpdateBlock for each block when many blocks are changed at once. */
+/* NOTE: Blocks that are unchanged are skipped, and indices MUST be inside the map. */
+void Game_UpdateBlocks(const cc_int32* indices, const BlockID* blocks, int count);
 /* Calls Game_UpdateBlock, then informs server connection of the block change. */
 /* In multiplayer this is sent to the server, in singleplayer just activates physics. */
 CC_API void Game_ChangeBlock(int x, int y, int z, BlockID block);
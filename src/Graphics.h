@@ -28,11 +28,12 @@ struct MenuOptionsScreen;
 extern struct IGameComponent Gfx_Component;
 
 typedef enum VertexFormat_ {
-	VERTEX_FORMAT_COLOURED, VERTEX_FORMAT_TEXTURED
+	VERTEX_FORMAT_COLOURED, VERTEX_FORMAT_TEXTURED, VERTEX_FORMAT_TERRAIN
 } VertexFormat;
 
 #define SIZEOF_VERTEX_COLOURED 16
 #define SIZEOF_VERTEX_TEXTURED 24
+#define SIZEOF_VERTEX_TERRAIN  16
 
 #if defined CC_BUILD_PSP
 /* 3 floats for position (XYZ), 4 bytes for colour */
@@ -45,6 +46,12 @@ struct VertexColoured { float x, y, z; PackedCol Col; };
 /* 3 floats for position (XYZ), 2 floats for texture coordinates (UV), 4 bytes for colour */
 struct VertexTextured { float x, y, z; PackedCol Col; float U, V; };
 #endif
+/* 3 shorts for position (XYZ) relative to terrain origin in 1/64 blocks, 1 short for U in 1/1024 tiles, */
+/*  1 float for V (tile row * 32 + V within that row in tiles, which repeats within the row), */
+/*  4 bytes for colour. (only supported when CC_BUILD_PACKEDTERRAIN is defined) */
+/* NOTE: V and colour can't be packed any smaller without losing exact tile edges or tinted lighting, */
+/*  so positions are relative to a shared origin (see TERRAIN_REGION_SIZE) instead of absolute */
+struct VertexTerrain { cc_int16 x, y, z, U; float V; PackedCol Col; };
 
 void Gfx_Create(void);
 void Gfx_Free(void);
@@ -328,6 +335,12 @@ void Gfx_BindVb_Textured(GfxResourceID vb);
 #else
 #define Gfx_BindVb_Textured Gfx_BindVb
 #endif
+#ifdef CC_BUILD_PACKEDTERRAIN
+/* Special case Gfx_BindVb for VERTEX_FORMAT_TERRAIN vertices relative to the given origin */
+void Gfx_BindVb_Terrain(GfxResourceID vb, int originX, int originY, int originZ);
+/* Sets the height of a tile row in the texture used with VERTEX_FORMAT_TERRAIN vertices */
+void Gfx_SetTerrainTileHeight(float height);
+#endif
 
 /* Creates a new dynamic vertex buffer, whose contents can be updated later */
 CC_API GfxResourceID Gfx_CreateDynamicVb(VertexFormat fmt, int maxVertices);
@@ -342,6 +355,12 @@ CC_API void  Gfx_UnlockDynamicVb(GfxResourceID vb);
 
 /* Updates the data of a dynamic vertex buffer */
 CC_API void Gfx_SetDynamicVbData(GfxResourceID vb, void* vertices, int vCount);
+#ifdef CC_BUILD_CHUNKARENA
+/* Acquires temp memory for changing the contents of part of a dynamic vertex buffer, starting at given vertex */
+void* Gfx_LockDynamicVbRange(GfxResourceID vb, VertexFormat fmt, int startVertex, int count);
+/* Binds then submits the changed contents of part of a dynamic vertex buffer */
+void  Gfx_UnlockDynamicVbRange(GfxResourceID vb);
+#endif
 
 
 /*########################################################################################################################*
@@ -380,6 +399,9 @@ CC_API void Gfx_DrawVb_IndexedTris_Range(int verticesCount, int startVertex, Dra
 CC_API void Gfx_DrawVb_IndexedTris(int verticesCount);
 /* Special case Gfx_DrawVb_IndexedTris_Range for map renderer */
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex);
+/* Calls Gfx_DrawIndexedTris_T2fC4b for each of the given ranges, but in as few draw calls as possible */
+/* Returns the number of draw calls that were actually made */
+int  Gfx_DrawIndexedTris_T2fC4b_Multi(int numRanges, const int* verticesCounts, const int* startVertices);
 
 
 /*########################################################################################################################*
@@ -40,6 +40,7 @@ static void (APIENTRY *_glDeleteBuffers)(GLsizei n, const GLuint *buffers);
 static void (APIENTRY *_glGenBuffers)(GLsizei n, GLuint *buffers);
 static void (APIENTRY *_glBufferData)(GLenum target, cc_uintptr size, const GLvoid* data, GLenum usage);
 static void (APIENTRY *_glBufferSubData)(GLenum target, cc_uintptr offset, cc_uintptr size, const GLvoid* data);
+static void (APIENTRY *_glMultiDrawElementsBaseVertex)(GLenum mode, const GLsizei* count, GLenum type, const GLvoid* const* indices, GLsizei drawcount, const GLint* basevertex);
 
 
 #if defined CC_BUILD_GL11_FALLBACK
@@ -198,6 +199,20 @@ void Gfx_SetDynamicVbData(GfxResourceID vb, void* vertices, int vCount) {
 	_glBufferSubData(GL_ARRAY_BUFFER, 0, size, vertices);
 }
 
+#ifdef CC_BUILD_CHUNKARENA
+static cc_uint32 tmpOffset;
+
+void* Gfx_LockDynamicVbRange(GfxResourceID vb, VertexFormat fmt, int startVertex, int count) {
+	tmpOffset = startVertex * strideSizes[fmt];
+	return FastAllocTempMem(count * strideSizes[fmt]);
+}
+
+void Gfx_UnlockDynamicVbRange(GfxResourceID vb) {
+	_glBindBuffer(GL_ARRAY_BUFFER, vb);
+	_glBufferSubData(GL_ARRAY_BUFFER, tmpOffset, tmpSize, tmpData);
+}
+#endif
+
 
 /*########################################################################################################################*
 *----------------------------------------------------------Drawing--------------------------------------------------------*
@@ -273,6 +288,38 @@ void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
 	_glDrawElements(GL_TRIANGLES,        ICOUNT(verticesCount),  GL_UNSIGNED_SHORT, IB_PTR);
 }
 
+#ifdef CC_BUILD_CHUNKARENA
+#define MAX_MULTI_DRAWS 256
+
+int Gfx_DrawIndexedTris_T2fC4b_Multi(int numRanges, const int* verticesCounts, const int* startVertices) {
+	GLsizei counts[MAX_MULTI_DRAWS];
+	const GLvoid* indices[MAX_MULTI_DRAWS];
+	GLint bases[MAX_MULTI_DRAWS];
+	int i, j, calls = 0;
+
+	if (!_glMultiDrawElementsBaseVertex) {
+		for (i = 0; i < numRanges; i++)
+		{
+			Gfx_DrawIndexedTris_T2fC4b(verticesCounts[i], startVertices[i]);
+		}
+		return numRanges;
+	}
+	GL_SetupVbTextured();
+
+	for (i = 0; i < numRanges; i += j, calls++)
+	{
+		for (j = 0; j < MAX_MULTI_DRAWS && i + j < numRanges; j++)
+		{
+			counts[j]  = ICOUNT(verticesCounts[i + j]);
+			indices[j] = IB_PTR;
+			bases[j]   = startVertices[i + j];
+		}
+		_glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts, GL_UNSIGNED_SHORT, indices, j, bases);
+	}
+	return calls;
+}
+#endif
+
 
 /*########################################################################################################################*
 *---------------------------------------------------------Textures--------------------------------------------------------*
@@ -507,7 +554,7 @@ static void APIENTRY legacy_bufferData(GLenum target, cc_uintptr size, const GLv
 
 static void APIENTRY legacy_bufferSubData(GLenum target, cc_uintptr offset, cc_uintptr size, const GLvoid* data) {
 	legacy_buffer* buffer = *legacy_GetBuffer(target);
-	Mem_Copy(buffer->data, data, size);
+	Mem_Copy(buffer->data + offset, data, size);
 }
 
 
@@ -674,6 +721,13 @@ static void GLBackend_Init(void) {
 		DynamicLib_ReqSym2("glBufferSubDataARB", glBufferSubData)
 	};
 
+#ifdef CC_BUILD_CHUNKARENA
+	static const struct DynamicLibSym baseVertexFuncs[] = {
+		DynamicLib_OptSym2("glMultiDrawElementsBaseVertex", glMultiDrawElementsBaseVertex)
+	};
+	static const cc_string baseVertexExt = String_FromConst("GL_ARB_draw_elements_base_vertex");
+#endif
+
 	static const cc_string vboExt  = String_FromConst("GL_ARB_vertex_buffer_object");
 	static const cc_string bgraExt = String_FromConst("GL_EXT_bgra");
 	cc_string extensions = String_FromReadonly((const char*)_glGetString(GL_EXTENSIONS));
@@ -692,6 +746,13 @@ static void GLBackend_Init(void) {
 		convert_rgba = major == 1 && minor <= 1 && !String_CaselessContains(&extensions, &bgraExt);
 		FallbackOpenGL();
 	}
+
+#ifdef CC_BUILD_CHUNKARENA
+	/* Supported in core since 3.2 */
+	if (major > 3 || (major == 3 && minor >= 2) || String_CaselessContains(&extensions, &baseVertexExt)) {
+		GLContext_GetAll(baseVertexFuncs, Array_Elems(baseVertexFuncs));
+	}
+#endif
 #endif
 }
 #endif
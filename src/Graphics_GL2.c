@@ -35,6 +35,10 @@ static const struct DynamicLibSym core_funcs[] = {
 
 #include "../misc/opengl/GL1Macros.h"
 
+#ifdef CC_BUILD_CHUNKARENA
+static void (APIENTRY *_glMultiDrawElementsBaseVertex)(GLenum mode, const GLsizei* count, GLenum type, const GLvoid* const* indices, GLsizei drawcount, const GLint* basevertex);
+#endif
+
 #if CC_BUILD_MAXSTACK <= (64 * 1024)
 static cc_uint16 gl_indices[GFX_MAX_INDICES];
 #define GL_INDICES
@@ -164,6 +168,20 @@ void Gfx_SetDynamicVbData(GfxResourceID vb, void* vertices, int vCount) {
 	glBufferSubData(GL_ARRAY_BUFFER, 0, size, vertices);
 }
 
+#ifdef CC_BUILD_CHUNKARENA
+static cc_uint32 tmpOffset;
+
+void* Gfx_LockDynamicVbRange(GfxResourceID vb, VertexFormat fmt, int startVertex, int count) {
+	tmpOffset = startVertex * strideSizes[fmt];
+	return FastAllocTempMem(count * strideSizes[fmt]);
+}
+
+void Gfx_UnlockDynamicVbRange(GfxResourceID vb) {
+	glBindBuffer(GL_ARRAY_BUFFER, ptr_to_uint(vb));
+	glBufferSubData(GL_ARRAY_BUFFER, tmpOffset, tmpSize, tmpData);
+}
+#endif
+
 
 /*########################################################################################################################*
 *------------------------------------------------------OpenGL modern------------------------------------------------------*
@@ -173,6 +191,7 @@ void Gfx_SetDynamicVbData(GfxResourceID vb, void* vertices, int vCount) {
 #define FTR_TEX_OFFSET (1 << 2)
 #define FTR_LINEAR_FOG (1 << 3)
 #define FTR_DENSIT_FOG (1 << 4)
+#define FTR_TERRAIN    (1 << 5)
 #define FTR_HASANY_FOG (FTR_LINEAR_FOG | FTR_DENSIT_FOG)
 #define FTR_FS_MEDIUMP (1 << 7)
 
@@ -181,12 +200,15 @@ void Gfx_SetDynamicVbData(GfxResourceID vb, void* vertices, int vCount) {
 #define UNI_FOG_COL    (1 << 2)
 #define UNI_FOG_END    (1 << 3)
 #define UNI_FOG_DENS   (1 << 4)
-#define UNI_MASK_ALL   0x1F
+#define UNI_TERRAIN    (1 << 5)
+#define UNI_TILE_SIZE  (1 << 6)
+#define UNI_MASK_ALL   0x7F
 
 /* cached uniforms (cached for multiple programs */
 static struct Matrix _view, _proj, _mvp;
 static cc_bool gfx_texTransform;
 static float _texX, _texY;
+static float _terrainX, _terrainY, _terrainZ, _tileHeight;
 static PackedCol gfx_fogColor;
 static float gfx_fogEnd = -1.0f, gfx_fogDensity = -1.0f;
 static int gfx_fogMode = -1;
@@ -196,8 +218,8 @@ static struct GLShader {
 	int features;     /* what features are enabled for this shader */
 	int uniforms;     /* which associated uniforms need to be resent to GPU */
 	GLuint program;   /* OpenGL program ID (0 if not yet compiled) */
-	int locations[5]; /* location of uniforms (not constant) */
-} shaders[6 * 3] = {
+	int locations[7]; /* location of uniforms (not constant) */
+} shaders[8 * 3] = {
 	/* no fog */
 	{ 0              },
 	{ 0              | FTR_ALPHA_TEST },
@@ -205,6 +227,8 @@ static struct GLShader {
 	{ FTR_TEXTURE_UV | FTR_ALPHA_TEST },
 	{ FTR_TEXTURE_UV | FTR_TEX_OFFSET },
 	{ FTR_TEXTURE_UV | FTR_TEX_OFFSET | FTR_ALPHA_TEST },
+	{ FTR_TEXTURE_UV | FTR_TERRAIN    },
+	{ FTR_TEXTURE_UV | FTR_TERRAIN    | FTR_ALPHA_TEST },
 	/* linear fog */
 	{ FTR_LINEAR_FOG | 0              },
 	{ FTR_LINEAR_FOG | 0              | FTR_ALPHA_TEST },
@@ -212,6 +236,8 @@ static struct GLShader {
 	{ FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_ALPHA_TEST },
 	{ FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_TEX_OFFSET },
 	{ FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_TEX_OFFSET | FTR_ALPHA_TEST },
+	{ FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_TERRAIN    },
+	{ FTR_LINEAR_FOG | FTR_TEXTURE_UV | FTR_TERRAIN    | FTR_ALPHA_TEST },
 	/* density fog */
 	{ FTR_DENSIT_FOG | 0              },
 	{ FTR_DENSIT_FOG | 0              | FTR_ALPHA_TEST },
@@ -219,6 +245,8 @@ static struct GLShader {
 	{ FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_ALPHA_TEST },
 	{ FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_TEX_OFFSET },
 	{ FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_TEX_OFFSET | FTR_ALPHA_TEST },
+	{ FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_TERRAIN    },
+	{ FTR_DENSIT_FOG | FTR_TEXTURE_UV | FTR_TERRAIN    | FTR_ALPHA_TEST },
 };
 static struct GLShader* gfx_activeShader;
 
@@ -226,16 +254,36 @@ static struct GLShader* gfx_activeShader;
 static void GenVertexShader(const struct GLShader* shader, cc_string* dst) {
 	int uv = shader->features & FTR_TEXTURE_UV;
 	int tm = shader->features & FTR_TEX_OFFSET;
-
-	String_AppendConst(dst,         "attribute vec3 in_pos;\n");
-	String_AppendConst(dst,         "attribute vec4 in_col;\n");
-	if (uv) String_AppendConst(dst, "attribute vec2 in_uv;\n");
+	int tr = shader->features & FTR_TERRAIN;
+
+	/* Terrain vertices pack U into in_pos.w, so only V is in in_uv */
+	/* Terrain V is (tile row * 32) + V within the row in tiles, which wraps within the row */
+	if (tr) {
+		String_AppendConst(dst,     "attribute vec4 in_pos;\n");
+		String_AppendConst(dst,     "attribute vec4 in_col;\n");
+		String_AppendConst(dst,     "attribute float in_uv;\n");
+	} else {
+		String_AppendConst(dst,     "attribute vec3 in_pos;\n");
+		String_AppendConst(dst,     "attribute vec4 in_col;\n");
+		if (uv) String_AppendConst(dst, "attribute vec2 in_uv;\n");
+	}
 	String_AppendConst(dst,         "varying vec4 out_col;\n");
 	if (uv) String_AppendConst(dst, "varying vec2 out_uv;\n");
+	if (tr) String_AppendConst(dst, "varying float out_tile;\n");
 	String_AppendConst(dst,         "uniform mat4 mvp;\n");
 	if (tm) String_AppendConst(dst, "uniform vec2 texOffset;\n");
+	if (tr) String_AppendConst(dst, "uniform vec3 terrainOrigin;\n");
 
 	String_AppendConst(dst,         "void main() {\n");
+	if (tr) {
+		String_AppendConst(dst,     "  gl_Position = mvp * vec4(in_pos.xyz * (1.0 / 64.0) + terrainOrigin, 1.0);\n");
+		String_AppendConst(dst,     "  out_col = in_col;\n");
+		String_AppendConst(dst,     "  out_tile = floor(in_uv * (1.0 / 32.0));\n");
+		String_AppendConst(dst,     "  out_uv   = vec2(in_pos.w * (1.0 / 1024.0), in_uv - out_tile * 32.0);\n");
+		String_AppendConst(dst,     "}");
+		return;
+	}
+
 	String_AppendConst(dst,         "  gl_Position = mvp * vec4(in_pos, 1.0);\n");
 	String_AppendConst(dst,         "  out_col = in_col;\n");
 	if (uv) String_AppendConst(dst, "  out_uv  = in_uv;\n");
@@ -259,6 +307,7 @@ static void GenFragmentShader(const struct GLShader* shader, cc_string* dst) {
 	int fl = shader->features & FTR_LINEAR_FOG;
 	int fd = shader->features & FTR_DENSIT_FOG;
 	int fm = shader->features & FTR_HASANY_FOG;
+	int tr = shader->features & FTR_TERRAIN;
 
 #ifdef CC_BUILD_GLES
 	int mp = shader->features & FTR_FS_MEDIUMP;
@@ -269,12 +318,16 @@ static void GenFragmentShader(const struct GLShader* shader, cc_string* dst) {
 	String_AppendConst(dst,         "varying vec4 out_col;\n");
 	if (uv) String_AppendConst(dst, "varying vec2 out_uv;\n");
 	if (uv) String_AppendConst(dst, "uniform sampler2D texImage;\n");
+	if (tr) String_AppendConst(dst, "varying float out_tile;\n");
+	if (tr) String_AppendConst(dst, "uniform float tileHeight;\n");
 	if (fm) String_AppendConst(dst, "uniform vec3 fogCol;\n");
 	if (fl) String_AppendConst(dst, "uniform float fogEnd;\n");
 	if (fd) String_AppendConst(dst, "uniform float fogDensity;\n");
 
 	String_AppendConst(dst,         "void main() {\n");
-	if (uv) String_AppendConst(dst, "  vec4 col = texture2D(texImage, out_uv) * out_col;\n");
+	if (tr) String_AppendConst(dst, "  vec2 uv  = vec2(out_uv.x, (out_tile + fract(out_uv.y)) * tileHeight);\n");
+	if (tr) String_AppendConst(dst, "  vec4 col = texture2D(texImage, uv) * out_col;\n");
+	else if (uv) String_AppendConst(dst, "  vec4 col = texture2D(texImage, out_uv) * out_col;\n");
 	else    String_AppendConst(dst, "  vec4 col = out_col;\n");
 	if (al) String_AppendConst(dst, "  if (col.a < 0.5) discard;\n");
 	if (fm) String_AppendConst(dst, "  float depth = 1.0 / gl_FragCoord.w;\n");
@@ -374,6 +427,8 @@ static void CompileProgram(struct GLShader* shader) {
 		shader->locations[2] = glGetUniformLocation(program, "fogCol");
 		shader->locations[3] = glGetUniformLocation(program, "fogEnd");
 		shader->locations[4] = glGetUniformLocation(program, "fogDensity");
+		shader->locations[5] = glGetUniformLocation(program, "terrainOrigin");
+		shader->locations[6] = glGetUniformLocation(program, "tileHeight");
 		return;
 	}
 	temp = 0;
@@ -423,6 +478,14 @@ static void ReloadUniforms(void) {
 		glUniform1f(s->locations[4], -gfx_fogDensity);
 		s->uniforms &= ~UNI_FOG_DENS;
 	}
+	if ((s->uniforms & UNI_TERRAIN) && (s->features & FTR_TERRAIN)) {
+		glUniform3f(s->locations[5], _terrainX, _terrainY, _terrainZ);
+		s->uniforms &= ~UNI_TERRAIN;
+	}
+	if ((s->uniforms & UNI_TILE_SIZE) && (s->features & FTR_TERRAIN)) {
+		glUniform1f(s->locations[6], _tileHeight);
+		s->uniforms &= ~UNI_TILE_SIZE;
+	}
 }
 
 /* Switches program to one that duplicates current fixed function state */
@@ -432,13 +495,17 @@ static void SwitchProgram(void) {
 	int index = 0;
 
 	if (gfx_fogEnabled) {
-		index += 6;                       /* linear fog */
-		if (gfx_fogMode >= 1) index += 6; /* exp fog */
+		index += 8;                       /* linear fog */
+		if (gfx_fogMode >= 1) index += 8; /* exp fog */
 	}
 
-	if (gfx_format == VERTEX_FORMAT_TEXTURED) index += 2;
-	if (gfx_texTransform) index += 2;
-	if (gfx_alphaTest)    index += 1;
+	if (gfx_format == VERTEX_FORMAT_TERRAIN) {
+		index += 6;
+	} else {
+		if (gfx_format == VERTEX_FORMAT_TEXTURED) index += 2;
+		if (gfx_texTransform) index += 2;
+	}
+	if (gfx_alphaTest) index += 1;
 
 	shader = &shaders[index];
 	if (shader == gfx_activeShader) { ReloadUniforms(); return; }
@@ -537,6 +604,21 @@ void Gfx_DisableTextureOffset(void) {
 /*########################################################################################################################*
 *-------------------------------------------------------State setup-------------------------------------------------------*
 *#########################################################################################################################*/
+#if defined CC_BUILD_CHUNKARENA && !defined CC_BUILD_GLES
+static void GL_LoadMultiDraw(int major, int minor) {
+	static const struct DynamicLibSym baseVertexFuncs[] = {
+		DynamicLib_OptSym2("glMultiDrawElementsBaseVertex", glMultiDrawElementsBaseVertex)
+	};
+	static const cc_string baseVertexExt = String_FromConst("GL_ARB_draw_elements_base_vertex");
+	cc_string extensions = String_FromReadonly((const char*)glGetString(GL_EXTENSIONS));
+
+	/* Supported in core since 3.2 */
+	if (major > 3 || (major == 3 && minor >= 2) || String_CaselessContains(&extensions, &baseVertexExt)) {
+		GLContext_GetAll(baseVertexFuncs, Array_Elems(baseVertexFuncs));
+	}
+}
+#endif
+
 static void GLBackend_Init(void) {
 #ifdef CC_BUILD_GLES
 	// OpenGL ES 2.0 doesn't support custom mipmaps levels, but 3.2 does
@@ -567,6 +649,9 @@ static void GLBackend_Init(void) {
     customMipmapsLevels = true;
     const GLubyte* ver  = glGetString(GL_VERSION);
     int major = ver[0] - '0', minor = ver[2] - '0';
+#ifdef CC_BUILD_CHUNKARENA
+    GL_LoadMultiDraw(major, minor);
+#endif
     if (major >= 2) return;
 
     // OpenGL 1.x.. will likely either not work or perform poorly
@@ -678,6 +763,12 @@ static void GL_SetupVbTextured(void) {
 	glVertexAttribPointer(2, 2, GL_FLOAT,         false, SIZEOF_VERTEX_TEXTURED, uint_to_ptr(16));
 }
 
+static void GL_SetupVbTerrain(void) {
+	glVertexAttribPointer(0, 4, GL_SHORT,         false, SIZEOF_VERTEX_TERRAIN, uint_to_ptr( 0));
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true,  SIZEOF_VERTEX_TERRAIN, uint_to_ptr(12));
+	glVertexAttribPointer(2, 1, GL_FLOAT,         false, SIZEOF_VERTEX_TERRAIN, uint_to_ptr( 8));
+}
+
 static void GL_SetupVbColoured_Range(int startVertex) {
 	cc_uint32 offset = startVertex * SIZEOF_VERTEX_COLOURED;
 	glVertexAttribPointer(0, 3, GL_FLOAT,         false, SIZEOF_VERTEX_COLOURED, uint_to_ptr(offset     ));
@@ -691,6 +782,13 @@ static void GL_SetupVbTextured_Range(int startVertex) {
 	glVertexAttribPointer(2, 2, GL_FLOAT,         false, SIZEOF_VERTEX_TEXTURED, uint_to_ptr(offset + 16));
 }
 
+static void GL_SetupVbTerrain_Range(int startVertex) {
+	cc_uint32 offset = startVertex * SIZEOF_VERTEX_TERRAIN;
+	glVertexAttribPointer(0, 4, GL_SHORT,         false, SIZEOF_VERTEX_TERRAIN, uint_to_ptr(offset     ));
+	glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, true,  SIZEOF_VERTEX_TERRAIN, uint_to_ptr(offset + 12));
+	glVertexAttribPointer(2, 1, GL_FLOAT,         false, SIZEOF_VERTEX_TERRAIN, uint_to_ptr(offset +  8));
+}
+
 void Gfx_SetVertexFormat(VertexFormat fmt) {
 	if (fmt == gfx_format) return;
 	gfx_format = fmt;
@@ -700,6 +798,10 @@ void Gfx_SetVertexFormat(VertexFormat fmt) {
 		glEnableVertexAttribArray(2);
 		gfx_setupVBFunc      = GL_SetupVbTextured;
 		gfx_setupVBRangeFunc = GL_SetupVbTextured_Range;
+	} else if (fmt == VERTEX_FORMAT_TERRAIN) {
+		glEnableVertexAttribArray(2);
+		gfx_setupVBFunc      = GL_SetupVbTerrain;
+		gfx_setupVBRangeFunc = GL_SetupVbTerrain_Range;
 	} else {
 		glDisableVertexAttribArray(2);
 		gfx_setupVBFunc      = GL_SetupVbColoured;
@@ -728,14 +830,63 @@ void Gfx_BindVb_Textured(GfxResourceID vb) {
 	GL_SetupVbTextured();
 }
 
+void Gfx_BindVb_Terrain(GfxResourceID vb, int originX, int originY, int originZ) {
+	Gfx_BindVb(vb);
+	GL_SetupVbTerrain();
+
+	_terrainX = (float)originX; _terrainY = (float)originY; _terrainZ = (float)originZ;
+	DirtyUniform(UNI_TERRAIN);
+	ReloadUniforms();
+}
+
+void Gfx_SetTerrainTileHeight(float height) {
+	if (height == _tileHeight) return;
+	_tileHeight = height;
+	DirtyUniform(UNI_TILE_SIZE);
+	ReloadUniforms();
+}
+
+/* NOTE: Also used to draw VERTEX_FORMAT_TERRAIN vertices when that is the active format */
 void Gfx_DrawIndexedTris_T2fC4b(int verticesCount, int startVertex) {
 	if (startVertex + verticesCount > GFX_MAX_VERTICES) {
-		GL_SetupVbTextured_Range(startVertex);
+		gfx_setupVBRangeFunc(startVertex);
 		glDrawElements(GL_TRIANGLES, ICOUNT(verticesCount), GL_UNSIGNED_SHORT, NULL);
-		GL_SetupVbTextured();
+		gfx_setupVBFunc();
 	} else {
 		/* ICOUNT(startVertex) * 2 = startVertex * 3  */
 		glDrawElements(GL_TRIANGLES, ICOUNT(verticesCount), GL_UNSIGNED_SHORT, uint_to_ptr(startVertex * 3));
 	}
 }
+
+#ifdef CC_BUILD_CHUNKARENA
+#define MAX_MULTI_DRAWS 256
+
+int Gfx_DrawIndexedTris_T2fC4b_Multi(int numRanges, const int* verticesCounts, const int* startVertices) {
+	GLsizei counts[MAX_MULTI_DRAWS];
+	const GLvoid* indices[MAX_MULTI_DRAWS];
+	GLint bases[MAX_MULTI_DRAWS];
+	int i, j, calls = 0;
+
+	if (!_glMultiDrawElementsBaseVertex) {
+		for (i = 0; i < numRanges; i++)
+		{
+			Gfx_DrawIndexedTris_T2fC4b(verticesCounts[i], startVertices[i]);
+		}
+		return numRanges;
+	}
+	gfx_setupVBFunc();
+
+	for (i = 0; i < numRanges; i += j, calls++)
+	{
+		for (j = 0; j < MAX_MULTI_DRAWS && i + j < numRanges; j++)
+		{
+			counts[j]  = ICOUNT(verticesCounts[i + j]);
+			indices[j] = NULL;
+			bases[j]   = startVertices[i + j];
+		}
+		_glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts, GL_UNSIGNED_SHORT, indices, j, bases);
+	}
+	return calls;
+}
+#endif
 #endif
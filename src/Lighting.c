@@ -12,8 +12,13 @@
 #include "ExtMath.h"
 #include "Options.h"
 #include "Builder.h"
+#if defined CC_BUILD_SSE2
+#include <emmintrin.h>
+#elif defined CC_BUILD_NEON
+#include <arm_neon.h>
+#endif
 
-const char* const LightingMode_Names[LIGHTING_MODE_COUNT] = { "Classic", "Fancy" };
+const char* const LightingMode_Names[LIGHTING_MODE_COUNT] = { "Classic", "Fancy", "Sky" };
 
 cc_uint8 Lighting_Mode;
 cc_bool  Lighting_ModeLockedByServer;
@@ -117,11 +122,20 @@ static PackedCol ClassicLighting_Color_ZSide_Fast(int x, int y, int z) {
 	return y > classic_heightmap[Lighting_Pack(x, z)] ? Env.SunZSide : Env.ShadowZSide;
 }
 
+static void Heightmap_InitLUT(void);
+static void Heightmap_StartEager(void);
+static void Heightmap_StopEager(void);
+static cc_bool Heightmap_EagerActive(void);
+
 void ClassicLighting_Refresh(void) {
 	int i;
+	Heightmap_StopEager();
 	for (i = 0; i < World.Width * World.Length; i++) {
 		classic_heightmap[i] = HEIGHT_UNCALCULATED;
 	}
+
+	Heightmap_InitLUT();
+	Heightmap_StartEager();
 }
 
 
@@ -262,7 +276,11 @@ void ClassicLighting_OnBlockChanged(int x, int y, int z, BlockID oldBlock, Block
 
 	/* Since light wasn't checked to begin with, means column never had meshes for any of its chunks built. */
 	/* So we don't need to do anything. */
-	if (lightH == HEIGHT_UNCALCULATED) return;
+	if (lightH == HEIGHT_UNCALCULATED) {
+		/* ..except make sure the possibly outdated eagerly calculated height is never used */
+		if (Heightmap_EagerActive()) ClassicLighting_CalcHeightAt(x, World.Height - 1, z, hIndex);
+		return;
+	}
 
 	ClassicLighting_UpdateLighting(x, y, z, oldBlock, newBlock, hIndex, lightH);
 	newHeight = classic_heightmap[hIndex] + 1;
@@ -273,120 +291,243 @@ void ClassicLighting_OnBlockChanged(int x, int y, int z, BlockID oldBlock, Block
 /*########################################################################################################################*
 *---------------------------------------------------Lighting heightmap----------------------------------------------------*
 *#########################################################################################################################*/
-static int Heightmap_InitialCoverage(int x1, int z1, int xCount, int zCount, int* skip) {
-	int elemsLeft = 0, index = 0, curRunCount = 0;
-	int x, z, hIndex, lightH;
-
-	for (z = 0; z < zCount; z++) {
-		hIndex = Lighting_Pack(x1, z1 + z);
-		for (x = 0; x < xCount; x++) {
-			lightH = classic_heightmap[hIndex++];
-
-			skip[index] = 0;
-			if (lightH == HEIGHT_UNCALCULATED) {
-				elemsLeft++;
-				curRunCount = 0;
-			} else {
-				skip[index - curRunCount]++;
-				curRunCount++;
-			}
-			index++;
-		}
-		curRunCount = 0; /* We can only skip an entire X row at most. */
+/* For each block, 0 if it does not block light, otherwise 1 + how far below the block the light height is */
+static cc_uint8 heightmap_LUT[BLOCK_COUNT];
+/* How many adjacent columns of a row are calculated at once */
+#define HEIGHTMAP_GROUP_SIZE 16
+
+/* The blocks that light heights are calculated from */
+/* (the eager heightmap thread uses its own copy, rather than reading World while it may be changing) */
+struct HeightmapSource {
+	const BlockRaw* blocks;
+#ifdef EXTENDED_BLOCKS
+	const BlockRaw* blocks2;
+	int idMask;
+#endif
+	int width, height, length;
+};
+
+static void Heightmap_InitSource(struct HeightmapSource* src) {
+	src->blocks  = World.Blocks;
+#ifdef EXTENDED_BLOCKS
+	src->blocks2 = World.Blocks2;
+	src->idMask  = World.IDMask;
+#endif
+	src->width   = World.Width;
+	src->height  = World.Height;
+	src->length  = World.Length;
+}
+
+static void Heightmap_CalcLUT(cc_uint8* lut) {
+	int i;
+	for (i = 0; i < BLOCK_COUNT; i++) {
+		lut[i] = Blocks.BlocksLight[i] ? 1 + ((Blocks.LightOffset[i] >> LIGHT_FLAG_SHADES_FROM_BELOW) & 1) : 0;
 	}
-	return elemsLeft;
 }
+static void Heightmap_InitLUT(void) { Heightmap_CalcLUT(heightmap_LUT); }
 
-#define Heightmap_CalculateBody(get_block)\
-for (y = World.Height - 1; y >= 0; y--) {\
-	if (elemsLeft <= 0) { return true; } \
-	mapIndex = World_Pack(x1, y, z1);\
-	hIndex   = Lighting_Pack(x1, z1);\
-\
-	for (z = 0; z < zCount; z++) {\
-		baseIndex = mapIndex;\
-		index = z * xCount;\
-		for (x = 0; x < xCount;) {\
-			curRunCount = skip[index];\
-			x += curRunCount; mapIndex += curRunCount; index += curRunCount;\
-\
-			if (x < xCount && Blocks.BlocksLight[get_block]) {\
-				lightOffset = (Blocks.LightOffset[get_block] >> LIGHT_FLAG_SHADES_FROM_BELOW) & 1;\
-				classic_heightmap[hIndex + x] = (cc_int16)(y - lightOffset);\
-				elemsLeft--;\
-				skip[index] = 0;\
-\
-				offset = prevRunCount + curRunCount;\
-				newRunCount = skip[index - offset] + 1;\
-\
-				/* consider case 1 0 1 0, where we are at last 0 */ \
-				/* we need to make this 3 0 0 0 and advance by 1 */ \
-				oldRunCount = (x - offset + newRunCount) < xCount ? skip[index - offset + newRunCount] : 0; \
-				if (oldRunCount != 0) {\
-					skip[index - offset + newRunCount] = 0; \
-					newRunCount += oldRunCount; \
-				} \
-				skip[index - offset] = newRunCount; \
-				x += oldRunCount; index += oldRunCount; mapIndex += oldRunCount; \
-				prevRunCount = newRunCount; \
-			} else { \
-				prevRunCount = 0; \
-			}\
-			x++; mapIndex++; index++; \
-		}\
-		prevRunCount = 0;\
-		hIndex += World.Width;\
-		mapIndex = baseIndex + World.Width; /* advance one Z */ \
-	}\
+/* Light heights calculated so far (possibly of the entire map by the eager thread) may now be wrong, */
+/*  so they need to be calculated again with the new definitions */
+static void Heightmap_OnBlockDefChanged(void* obj) {
+	cc_uint8 lut[BLOCK_COUNT];
+	Heightmap_CalcLUT(lut);
+
+	if (Mem_Equal(lut, heightmap_LUT, sizeof(lut))) return;
+	/* LUT is rebuilt by refreshing, or otherwise when the map is loaded */
+	if (World.Loaded) Lighting.Refresh();
 }
 
-static cc_bool Heightmap_CalculateCoverage(int x1, int z1, int xCount, int zCount, int elemsLeft, int* skip) {
-	int prevRunCount = 0, curRunCount, newRunCount, oldRunCount;
-	int lightOffset, offset;
-	int mapIndex, hIndex, baseIndex, index;
-	int x, y, z;
+/* Returns a bitmask of which of the given adjacent blocks are not air */
+static int Heightmap_NonAirMask(const BlockRaw* blocks, int count) {
+	int i, mask = 0;
+#if defined CC_BUILD_SSE2
+	if (count == HEIGHTMAP_GROUP_SIZE) {
+		__m128i v = _mm_loadu_si128((const __m128i*)blocks);
+		return ~_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) & 0xFFFF;
+	}
+#elif defined CC_BUILD_NEON
+	static const cc_uint8 laneBits[16] = { 1,2,4,8,16,32,64,128, 1,2,4,8,16,32,64,128 };
+	if (count == HEIGHTMAP_GROUP_SIZE) {
+		uint8x16_t v = vld1q_u8(blocks);
+		uint8x16_t bits = vandq_u8(vtstq_u8(v, v), vld1q_u8(laneBits));
+		/* Horizontally add the bits of each half together, as NEON has no movemask */
+		uint8x8_t sum = vpadd_u8(vget_low_u8(bits), vget_high_u8(bits));
+		sum = vpadd_u8(sum, sum);
+		sum = vpadd_u8(sum, sum);
+		return vget_lane_u8(sum, 0) | (vget_lane_u8(sum, 1) << 8);
+	}
+#endif
 
-#ifndef EXTENDED_BLOCKS
-	Heightmap_CalculateBody(World.Blocks[mapIndex]);
-#else
-	if (World.IDMask <= 0xFF) {
-		Heightmap_CalculateBody(World.Blocks[mapIndex]);
-	} else {
-		Heightmap_CalculateBody(World.Blocks[mapIndex] | (World.Blocks2[mapIndex] << 8));
+	for (i = 0; i < count; i++) {
+		if (blocks[i]) mask |= 1 << i;
 	}
+	return mask;
+}
+
+/* Calculates the light heights of up to 16 adjacent columns in a row at once */
+/* Since most blocks near the top of a map are air, layers where the remaining columns */
+/*  are all air are skipped over without needing to look up each block individually */
+/* pending has a bit set for each column whose light height still needs to be calculated */
+static void Heightmap_CalculateGroup(const struct HeightmapSource* src, int x1, int z, int count, int pending, cc_int16* heights) {
+	int oneY  = src->width * src->length;
+	int index = (src->height - 1) * oneY + z * src->width + x1;
+	cc_bool airBlocksLight = heightmap_LUT[BLOCK_AIR] != 0;
+	int y, i, mask;
+	cc_uint8 value;
+	BlockID block;
+
+	for (y = src->height - 1; y >= 0 && pending; y--, index -= oneY) {
+		if (airBlocksLight) {
+			mask = pending;
+		} else {
+			mask = Heightmap_NonAirMask(src->blocks + index, count);
+#ifdef EXTENDED_BLOCKS
+			if (src->idMask > 0xFF) mask |= Heightmap_NonAirMask(src->blocks2 + index, count);
 #endif
-	return false;
+			mask &= pending;
+		}
+
+		for (i = 0; mask; i++, mask >>= 1) {
+			if (!(mask & 1)) continue;
+
+			block = src->blocks[index + i];
+#ifdef EXTENDED_BLOCKS
+			if (src->idMask > 0xFF) block |= src->blocks2[index + i] << 8;
+#endif
+			value = heightmap_LUT[block];
+			if (!value) continue;
+
+			heights[i] = (cc_int16)(y - (value - 1));
+			pending &= ~(1 << i);
+		}
+	}
+
+	/* No blocks in these columns block light */
+	for (i = 0; pending; i++, pending >>= 1) {
+		if (pending & 1) heights[i] = -10;
+	}
 }
 
-static void Heightmap_FinishCoverage(int x1, int z1, int xCount, int zCount) {
-	int x, z, hIndex, lightH;
+/* Calculates the light heights of the uncalculated columns in part of a row */
+static void Heightmap_CalculateRow(const struct HeightmapSource* src, cc_int16* heights, int x1, int z, int xCount) {
+	int x, i, count, pending;
 
-	for (z = 0; z < zCount; z++) {
-		hIndex = Lighting_Pack(x1, z1 + z);
-		for (x = 0; x < xCount; x++, hIndex++) {
-			lightH = classic_heightmap[hIndex];
+	for (x = 0; x < xCount; x += HEIGHTMAP_GROUP_SIZE) {
+		count   = min(HEIGHTMAP_GROUP_SIZE, xCount - x);
+		pending = 0;
 
-			if (lightH == HEIGHT_UNCALCULATED) {
-				classic_heightmap[hIndex] = -10;
-			}
+		for (i = 0; i < count; i++) {
+			if (heights[x + i] == HEIGHT_UNCALCULATED) pending |= 1 << i;
 		}
+		if (pending) Heightmap_CalculateGroup(src, x1 + x, z, count, pending, heights + x);
+	}
+}
+
+
+/*########################################################################################################################*
+*----------------------------------------------------Eager heightmap------------------------------------------------------*
+*#########################################################################################################################*/
+#if !defined CC_BUILD_COOPTHREADED && !defined CC_BUILD_LOWMEM
+/* The light heights of the entire map are calculated on a background thread after a new map is loaded */
+/* They are calculated into a separate heightmap, and then copied across row by row on the main thread */
+/*  (only for columns that still haven't been calculated, as blocks may have been changed since) */
+static cc_int16* eager_heightmap;
+static struct HeightmapSource eager_source;
+static void* eager_thread;
+static void* eager_mutex;
+static int eager_rows, eager_merged;
+static cc_bool eager_stop;
+
+static void Heightmap_EagerLoop(void) {
+	int x, z, width = eager_source.width;
+	cc_int16* heights;
+	cc_bool stop;
+
+	for (z = 0; z < eager_source.length; z++) {
+		heights = eager_heightmap + z * width;
+		for (x = 0; x < width; x++) heights[x] = HEIGHT_UNCALCULATED;
+		Heightmap_CalculateRow(&eager_source, heights, 0, z, width);
+
+		Mutex_Lock(eager_mutex);
+		eager_rows = z + 1;
+		stop       = eager_stop;
+		Mutex_Unlock(eager_mutex);
+		if (stop) return;
+	}
+}
+
+static void Heightmap_StartEager(void) {
+	if (!Options_GetBool(OPT_EAGER_HEIGHTMAP, true)) return;
+	eager_heightmap = (cc_int16*)Mem_TryAlloc(World.Width * World.Length, 2);
+	if (!eager_heightmap) return;
+
+	Heightmap_InitSource(&eager_source);
+	eager_mutex  = Mutex_Create("Eager heightmap");
+	eager_rows   = 0;
+	eager_merged = 0;
+	eager_stop   = false;
+	Thread_Run(&eager_thread, Heightmap_EagerLoop, 64 * 1024, "Eager heightmap");
+}
+
+static void Heightmap_StopEager(void) {
+	if (!eager_thread) return;
+
+	Mutex_Lock(eager_mutex);
+	eager_stop = true;
+	Mutex_Unlock(eager_mutex);
+	Thread_Join(eager_thread);
+
+	Mutex_Free(eager_mutex);
+	Mem_Free(eager_heightmap);
+	eager_thread    = NULL;
+	eager_mutex     = NULL;
+	eager_heightmap = NULL;
+}
+
+/* Copies across the rows that have been calculated by the background thread since last merged */
+static void Heightmap_MergeEager(void) {
+	int i, end, rows;
+	if (!eager_thread) return;
+
+	Mutex_Lock(eager_mutex);
+	rows = eager_rows;
+	Mutex_Unlock(eager_mutex);
+	if (rows == eager_merged) return;
+
+	end = rows * World.Width;
+	for (i = eager_merged * World.Width; i < end; i++) {
+		if (classic_heightmap[i] == HEIGHT_UNCALCULATED) classic_heightmap[i] = eager_heightmap[i];
 	}
+
+	eager_merged = rows;
+	if (rows == World.Length) Heightmap_StopEager();
 }
 
+static cc_bool Heightmap_EagerActive(void) { return eager_thread != NULL; }
+#else
+static void Heightmap_StartEager(void) { }
+static void Heightmap_StopEager(void)  { }
+static void Heightmap_MergeEager(void) { }
+static cc_bool Heightmap_EagerActive(void) { return false; }
+#endif
 
 void ClassicLighting_LightHint(int startX, int startY, int startZ) {
 	int x1 = max(startX, 0), x2 = min(World.Width,  startX + EXTCHUNK_SIZE);
 	int z1 = max(startZ, 0), z2 = min(World.Length, startZ + EXTCHUNK_SIZE);
-	int xCount = x2 - x1, zCount = z2 - z1;
-	int skip[EXTCHUNK_SIZE * EXTCHUNK_SIZE];
+	struct HeightmapSource src;
+	int z;
+	Heightmap_MergeEager();
+	Heightmap_InitSource(&src);
 
-	int elemsLeft = Heightmap_InitialCoverage(x1, z1, xCount, zCount, skip);
-	if (!Heightmap_CalculateCoverage(x1, z1, xCount, zCount, elemsLeft, skip)) {
-		Heightmap_FinishCoverage(x1, z1, xCount, zCount);
+	for (z = z1; z < z2; z++) {
+		Heightmap_CalculateRow(&src, classic_heightmap + Lighting_Pack(x1, z), x1, z, x2 - x1);
 	}
 }
 
+void Lighting_StopBackground(void) { Heightmap_StopEager(); }
+
 void ClassicLighting_FreeState(void) {
+	Heightmap_StopEager();
 	Mem_Free(classic_heightmap);
 	classic_heightmap = NULL;
 }
@@ -462,13 +603,19 @@ static void OnInit(void) {
 	Lighting_ApplyActive();
 
 	Event_Register_(&WorldEvents.LightingModeChanged, NULL, Lighting_HandleModeChanged);
+	Event_Register_(&BlockEvents.BlockDefChanged,     NULL, Heightmap_OnBlockDefChanged);
 }
 static void OnReset(void)        { Lighting.FreeState(); }
 static void OnNewMapLoaded(void) { Lighting.AllocState(); }
 
+static void OnFree(void) {
+	Lighting.FreeState();
+	FancyLighting_OnFree();
+}
+
 struct IGameComponent Lighting_Component = {
 	OnInit,  /* Init  */
-	OnReset, /* Free  */
+	OnFree,  /* Free  */
 	OnReset, /* Reset */
 	OnReset, /* OnNewMap */
 	OnNewMapLoaded /* OnNewMapLoaded */
@@ -13,8 +13,9 @@ Copyright 2014-2025 ClassiCube | Licensed under BSD-3
 struct IGameComponent;
 extern struct IGameComponent Lighting_Component;
 
+/* Sky lighting mode is fancy lighting, with sky light also propagated into areas in shadow */
 enum LightingMode {
-	LIGHTING_MODE_CLASSIC, LIGHTING_MODE_FANCY, LIGHTING_MODE_COUNT
+	LIGHTING_MODE_CLASSIC, LIGHTING_MODE_FANCY, LIGHTING_MODE_SKY, LIGHTING_MODE_COUNT
 };
 extern const char* const LightingMode_Names[LIGHTING_MODE_COUNT];
 extern cc_uint8 Lighting_Mode;
@@ -76,6 +77,13 @@ CC_VAR extern struct _Lighting {
 
 void FancyLighting_SetActive(void);
 void FancyLighting_OnInit(void);
+void FancyLighting_OnFree(void);
+/* Number of light nodes processed by fancy lighting since this counter was last reset to 0 */
+extern int FancyLighting_NodesProcessed;
+
+/* Stops any background calculation that is reading from the blocks of the current world */
+/* NOTE: Must be called before the blocks of the current world are freed or unmapped */
+void Lighting_StopBackground(void);
 
 /* Expose ClassicLighting functions for reuse in Fancy lighting */
 void ClassicLighting_Refresh(void);
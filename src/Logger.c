@@ -102,6 +102,13 @@ static const char* GetCCErrorDesc(cc_result res) {
 	case NBT_ERR_UNKNOWN:   return "Unknown NBT tag type";
 	case CW_ERR_ROOT_TAG:   return "Invalid root NBT tag";
 	case CW_ERR_STRING_LEN: return "NBT string too long";
+	case RAW_ERR_VERSION:   return "Unsupported raw map version";
+	case RAW_ERR_BLOCKS_RANGE: return "Raw map file is truncated";
+	case RGN_ERR_VERSION:      return "Unsupported region map version";
+	case RGN_ERR_CHUNK_RANGE:  return "Region map file is truncated";
+	case REPLAY_ERR_IDENTIFIER: return "Not a replay file";
+	case REPLAY_ERR_VERSION:    return "Unsupported replay version";
+	case REPLAY_ERR_DATA_SIZE:  return "Replay file is corrupted";
 
 	case ERR_DOWNLOAD_INVALID: return "Website denied download or doesn't exist";
 	case ERR_NO_AUDIO_OUTPUT:  return "No audio output devices plugged in";
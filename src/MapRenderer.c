@@ -14,6 +14,9 @@
 #include "Utils.h"
 #include "World.h"
 #include "Options.h"
+#ifdef CC_BUILD_CHUNKARENA
+#include "_BlockAlloc.h"
+#endif
 
 int MapRenderer_1DUsedCount;
 struct ChunkPartInfo* MapRenderer_PartsNormal;
@@ -46,6 +49,72 @@ static cc_uint32* distances;
 static int maxChunkUpdates;
 /* Cached number of chunks in the world */
 static int chunksCount;
+/* Whether chunks that can't be seen from the camera through other chunks are skipped */
+static cc_bool caveCulling;
+/* Whether which chunks are reachable from the camera needs to be recalculated */
+static cc_bool reachableDirty;
+/* Queue of chunks to visit when calculating which chunks are reachable from the camera */
+static cc_uint32* visitQueue;
+/* Number of chunks at the start of sortedChunks that are within render distance of the camera */
+static int renderRange;
+
+/* Dirty chunks are kept in buckets by their squared distance (in chunks) from the camera, */
+/*  so the closest dirty chunks can be found without having to check every chunk. */
+/* The last bucket contains dirty chunks that are too far away from the camera to be built. */
+/* NOTE: The buckets are recreated from scratch whenever the sort order of chunks is updated */
+static int* dirtyBuckets; /* Index of first chunk in each bucket, or -1 when bucket is empty */
+static int* dirtyNext;    /* Index of the next chunk in the same bucket as each chunk, or -1 */
+static int dirtyBucketsCount, dirtyBucketsCapacity;
+/* Index of lowest bucket that might not be empty */
+static int dirtyMin;
+
+/* Distance from the camera beyond which chunks are built at a lower level of detail, or 0 if disabled */
+/* Each further level of detail is used from twice the distance of the previous level */
+static int lodDistance;
+/* How far past the switching distance a chunk must be before it switches level of detail */
+/*  (avoids chunks being constantly rebuilt when the camera moves back and forth around that distance) */
+#define LOD_HYSTERESIS CHUNK_SIZE
+
+static int ChunkInfo_DistSqr(struct ChunkInfo* chunk) {
+	int dx = chunk->centreX - chunkPos.x, dy = chunk->centreY - chunkPos.y, dz = chunk->centreZ - chunkPos.z;
+	return dx * dx + dy * dy + dz * dz;
+}
+
+/* Adds a chunk that has just been marked dirty to the bucket for its distance from the camera */
+static void DirtyChunks_Add(struct ChunkInfo* chunk) {
+	int index, bucket;
+	if (!dirtyBucketsCount) return; /* All dirty chunks are added when buckets are recreated anyways */
+
+	index  = (int)(chunk - mapChunks);
+	/* Chunk centres are always a multiple of 16 apart, so squared distance is a multiple of 256 */
+	bucket = min(ChunkInfo_DistSqr(chunk) >> 8, dirtyBucketsCount - 1);
+
+	dirtyNext[index]     = dirtyBuckets[bucket];
+	dirtyBuckets[bucket] = index;
+	if (bucket < dirtyMin) dirtyMin = bucket;
+}
+
+/* Removes and returns the closest dirty chunk within the given squared distance, or NULL if there are none */
+static struct ChunkInfo* DirtyChunks_Pop(int maxDistSqr) {
+	int index;
+	for (; dirtyMin < dirtyBucketsCount - 1; dirtyMin++) 
+	{
+		index = dirtyBuckets[dirtyMin];
+		if (index == -1) continue;
+		/* Chunks in this and all later buckets are too far away */
+		if (ChunkInfo_DistSqr(&mapChunks[index]) > maxDistSqr) return NULL;
+
+		dirtyBuckets[dirtyMin] = dirtyNext[index];
+		return &mapChunks[index];
+	}
+	return NULL;
+}
+
+/* Invalidates the sort order of chunks, so that it is recalculated on the next frame */
+static void ResetSortOrder(void) {
+	chunkPos = IVec3_MaxValue();
+	dirtyBucketsCount = 0;
+}
 
 static void ChunkInfo_Init(struct ChunkInfo* chunk, int x, int y, int z) {
 	chunk->centreX = x + HALF_CHUNK_SIZE; chunk->centreY = y + HALF_CHUNK_SIZE; 
@@ -53,12 +122,21 @@ static void ChunkInfo_Init(struct ChunkInfo* chunk, int x, int y, int z) {
 #if CC_GFX_BACKEND != CC_GFX_BACKEND_GL11
 	chunk->vb = 0;
 #endif
+#ifdef CC_BUILD_CHUNKARENA
+	chunk->vbBase     = 0;
+	chunk->arenaIndex = -1;
+#endif
+	chunk->lod = 0;
 
 	chunk->visible = true;  
 	chunk->empty   = false;
 	chunk->allAir  = false;
 	chunk->noData  = true;
 	chunk->dirty   = true;
+	chunk->edited  = false;
+	chunk->building = false;
+	chunk->reachable    = true;
+	chunk->connectivity = CHUNK_CONNECTED_ALL;
 
 	chunk->drawXMin = false; chunk->drawXMax = false; chunk->drawZMin = false;
 	chunk->drawZMax = false; chunk->drawYMin = false; chunk->drawYMax = false;
@@ -67,8 +145,39 @@ static void ChunkInfo_Init(struct ChunkInfo* chunk, int x, int y, int z) {
 	chunk->translucentParts = NULL;
 }
 
+/* Throws away the mesh being built for the chunk on background threads, as the chunk has changed since */
+/* NOTE: The chunk is still dirty, so is added back to be built again */
+static void ChunkInfo_CancelBuild(struct ChunkInfo* chunk) {
+	Builder_CancelChunk(chunk);
+	chunk->building = false;
+	DirtyChunks_Add(chunk);
+}
+
 static CC_INLINE void ChunkInfo_Refresh(struct ChunkInfo* chunk) {
 	if (chunk->allAir) return; /* do not recreate chunks completely air */
+	if (chunk->building) {
+		ChunkInfo_CancelBuild(chunk);
+	} else if (!chunk->dirty) {
+		DirtyChunks_Add(chunk);
+	}
+
+	chunk->empty  = false;
+	chunk->dirty  = true;
+	chunk->edited = false;
+}
+
+/* Marks the chunk as needing to be rebuilt because blocks in or near it changed */
+static CC_INLINE void ChunkInfo_RefreshEdited(struct ChunkInfo* chunk) {
+	if (chunk->allAir) return; /* do not recreate chunks completely air */
+	/* Chunks already pending being rebuilt for another reason still need to be fully rebuilt */
+	/* (chunks being built on background threads still have their old mesh, so can be rebuilt straight away) */
+	if (chunk->building) {
+		ChunkInfo_CancelBuild(chunk);
+		chunk->edited = true;
+	} else if (!chunk->dirty) {
+		chunk->edited = true;
+		DirtyChunks_Add(chunk);
+	}
 
 	chunk->empty = false;
 	chunk->dirty = true;
@@ -106,19 +215,82 @@ static void CheckWeather(float delta) {
 	Gfx_SetAlphaBlending(false);
 }
 
+#ifdef CC_BUILD_CHUNKARENA
+	#define ChunkVbBase(info) info->vbBase
+#else
+	#define ChunkVbBase(info) 0
+#endif
+
 #if CC_GFX_BACKEND == CC_GFX_BACKEND_GL11
-	#define DrawFace(face, ign)    Gfx_BindVb(part.vbs[face]); Gfx_DrawIndexedTris_T2fC4b(0, 0);
+	#define DrawFace(face, ign)    Gfx_BindVb(part.vbs[face]); Gfx_DrawIndexedTris_T2fC4b(0, 0); Game_DrawCalls++;
 	#define DrawFaces(f1, f2, ign) DrawFace(f1, ign); DrawFace(f2, ign);
+	#define BeginCulledFaces()     Gfx_SetFaceCulling(true);
+	#define EndCulledFaces()       Gfx_SetFaceCulling(false);
 #else
-	#define DrawFace(face, offset)    Gfx_DrawIndexedTris_T2fC4b(part.counts[face], offset);
-	#define DrawFaces(f1, f2, offset) Gfx_DrawIndexedTris_T2fC4b(part.counts[f1] + part.counts[f2], offset);
+	#define DrawFace(face, offset)    DrawRanges_Add(ranges, part.counts[face], offset);
+	#define DrawFaces(f1, f2, offset) DrawRanges_Add(ranges, part.counts[f1] + part.counts[f2], offset);
+	#define BeginCulledFaces()        ranges = &culledRanges;
+	#define EndCulledFaces()          ranges = &unculledRanges;
+
+/* Ranges of vertices to draw from the currently bound chunk vertex buffer */
+/* Ranges are only drawn once a different vertex buffer is bound, so that */
+/*  ranges from many chunks can be drawn using very few draw calls */
+#define MAX_DRAW_RANGES 1024
+static struct DrawRanges {
+	cc_bool culled; /* Whether face culling must be enabled when drawing these ranges */
+	int count;
+	int counts[MAX_DRAW_RANGES], starts[MAX_DRAW_RANGES];
+} culledRanges = { true }, unculledRanges;
+static GfxResourceID boundVb;
+
+static void DrawRanges_Flush(struct DrawRanges* r) {
+	if (!r->count) return;
+
+	if (r->culled) Gfx_SetFaceCulling(true);
+	Game_DrawCalls += Gfx_DrawIndexedTris_T2fC4b_Multi(r->count, r->counts, r->starts);
+	if (r->culled) Gfx_SetFaceCulling(false);
+	r->count = 0;
+}
+
+static void DrawRanges_Add(struct DrawRanges* r, int count, int start) {
+	int last = r->count - 1;
+	/* Extend the previous range if this range immediately follows it */
+	if (last >= 0 && r->starts[last] + r->counts[last] == start && r->counts[last] + count <= GFX_MAX_VERTICES) {
+		r->counts[last] += count; return;
+	}
+
+	if (r->count == MAX_DRAW_RANGES) DrawRanges_Flush(r);
+	r->counts[r->count] = count;
+	r->starts[r->count] = start;
+	r->count++;
+}
+
+static void DrawRanges_FlushAll(void) {
+	DrawRanges_Flush(&culledRanges);
+	DrawRanges_Flush(&unculledRanges);
+	boundVb = 0;
+}
+
+/* Draws pending ranges from the previous vertex buffer if needed, then binds the chunk's vertex buffer */
+static void BindChunkVb(struct ChunkInfo* info) {
+	if (info->vb == boundVb) return;
+	DrawRanges_FlushAll();
+#ifdef CC_BUILD_PACKEDTERRAIN
+	/* All chunks in the same vertex buffer are from the same region, so have the same origin */
+	Gfx_BindVb_Terrain(info->vb, TerrainRegion_Origin(info->centreX),
+						TerrainRegion_Origin(info->centreY), TerrainRegion_Origin(info->centreZ));
+#else
+	Gfx_BindVb_Textured(info->vb);
+#endif
+	boundVb = info->vb;
+}
 #endif
 
 #define DrawNormalFaces(minFace, maxFace) \
 if (drawMin && drawMax) { \
-	Gfx_SetFaceCulling(true); \
+	BeginCulledFaces(); \
 	DrawFaces(minFace, maxFace, offset); \
-	Gfx_SetFaceCulling(false); \
+	EndCulledFaces(); \
 	Game_Vertices += (part.counts[minFace] + part.counts[maxFace]); \
 } else if (drawMin) { \
 	DrawFace(minFace, offset); \
@@ -134,6 +306,9 @@ static void RenderNormalBatch(int batch) {
 	struct ChunkPartInfo part;
 	cc_bool drawMin, drawMax;
 	int i, offset, count;
+#if CC_GFX_BACKEND != CC_GFX_BACKEND_GL11
+	struct DrawRanges* ranges = &unculledRanges;
+#endif
 
 	for (i = 0; i < renderChunksCount; i++) {
 		info = renderChunks[i];
@@ -144,10 +319,10 @@ static void RenderNormalBatch(int batch) {
 		hasNormParts[batch] = true;
 
 #if CC_GFX_BACKEND != CC_GFX_BACKEND_GL11
-		Gfx_BindVb_Textured(info->vb);
+		BindChunkVb(info);
 #endif
 
-		offset  = part.offset + part.spriteCount;
+		offset  = ChunkVbBase(info) + part.offset + part.spriteCount;
 		drawMin = info->drawXMin && part.counts[FACE_XMIN];
 		drawMax = info->drawXMax && part.counts[FACE_XMAX];
 		DrawNormalFaces(FACE_XMIN, FACE_XMAX);
@@ -163,42 +338,48 @@ static void RenderNormalBatch(int batch) {
 		DrawNormalFaces(FACE_YMIN, FACE_YMAX);
 
 		if (!part.spriteCount) continue;
-		offset = part.offset;
+		offset = ChunkVbBase(info) + part.offset;
 		count  = part.spriteCount >> 2; /* 4 per sprite */
 
-		Gfx_SetFaceCulling(true);
 		/* TODO: fix to not render them all */
 #if CC_GFX_BACKEND == CC_GFX_BACKEND_GL11
+		Gfx_SetFaceCulling(true);
 		Gfx_BindVb(part.vbs[FACE_COUNT]);
 		Gfx_DrawIndexedTris_T2fC4b(0, 0);
 		Game_Vertices += count * 4;
+		Game_DrawCalls++;
 		Gfx_SetFaceCulling(false);
-		continue;
-#endif
+#else
 		if (info->drawXMax || info->drawZMin) {
-			Gfx_DrawIndexedTris_T2fC4b(count, offset); Game_Vertices += count;
+			DrawRanges_Add(&culledRanges, count, offset); Game_Vertices += count;
 		} offset += count;
 
 		if (info->drawXMin || info->drawZMax) {
-			Gfx_DrawIndexedTris_T2fC4b(count, offset); Game_Vertices += count;
+			DrawRanges_Add(&culledRanges, count, offset); Game_Vertices += count;
 		} offset += count;
 
 		if (info->drawXMin || info->drawZMin) {
-			Gfx_DrawIndexedTris_T2fC4b(count, offset); Game_Vertices += count;
+			DrawRanges_Add(&culledRanges, count, offset); Game_Vertices += count;
 		} offset += count;
 
 		if (info->drawXMax || info->drawZMax) {
-			Gfx_DrawIndexedTris_T2fC4b(count, offset); Game_Vertices += count;
+			DrawRanges_Add(&culledRanges, count, offset); Game_Vertices += count;
 		}
-		Gfx_SetFaceCulling(false);
+#endif
 	}
+#if CC_GFX_BACKEND != CC_GFX_BACKEND_GL11
+	DrawRanges_FlushAll();
+#endif
 }
 
 void MapRenderer_RenderNormal(float delta) {
 	int batch;
 	if (!mapChunks) return;
 
-	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
+	Gfx_SetVertexFormat(CHUNK_VERTEX_FORMAT);
+#ifdef CC_BUILD_PACKEDTERRAIN
+	Gfx_SetTerrainTileHeight(Atlas1D.InvTileSize);
+#endif
 	Gfx_SetAlphaTest(true);
 	
 	Gfx_EnableMipmaps();
@@ -238,6 +419,9 @@ static void RenderTranslucentBatch(int batch) {
 	struct ChunkPartInfo part;
 	cc_bool drawMin, drawMax;
 	int i, offset;
+#if CC_GFX_BACKEND != CC_GFX_BACKEND_GL11
+	struct DrawRanges* ranges = &unculledRanges;
+#endif
 
 	for (i = 0; i < renderChunksCount; i++) {
 		info = renderChunks[i];
@@ -248,10 +432,10 @@ static void RenderTranslucentBatch(int batch) {
 		hasTranParts[batch] = true;
 
 #if CC_GFX_BACKEND != CC_GFX_BACKEND_GL11
-		Gfx_BindVb_Textured(info->vb);
+		BindChunkVb(info);
 #endif
 
-		offset  = part.offset;
+		offset  = ChunkVbBase(info) + part.offset;
 		drawMin = (inTranslucent || info->drawXMin) && part.counts[FACE_XMIN];
 		drawMax = (inTranslucent || info->drawXMax) && part.counts[FACE_XMAX];
 		DrawTranslucentFaces(FACE_XMIN, FACE_XMAX);
@@ -266,6 +450,9 @@ static void RenderTranslucentBatch(int batch) {
 		drawMax = (inTranslucent || info->drawYMax) && part.counts[FACE_YMAX];
 		DrawTranslucentFaces(FACE_YMIN, FACE_YMAX);
 	}
+#if CC_GFX_BACKEND != CC_GFX_BACKEND_GL11
+	DrawRanges_FlushAll();
+#endif
 }
 
 void MapRenderer_RenderTranslucent(float delta) {
@@ -274,7 +461,10 @@ void MapRenderer_RenderTranslucent(float delta) {
 
 	/* First fill depth buffer */
 	vertices = Game_Vertices;
-	Gfx_SetVertexFormat(VERTEX_FORMAT_TEXTURED);
+	Gfx_SetVertexFormat(CHUNK_VERTEX_FORMAT);
+#ifdef CC_BUILD_PACKEDTERRAIN
+	Gfx_SetTerrainTileHeight(Atlas1D.InvTileSize);
+#endif
 	Gfx_SetAlphaBlending(false);
 	Gfx_DepthOnlyRendering(true);
 
@@ -315,6 +505,127 @@ void MapRenderer_RenderTranslucent(float delta) {
 }
 
 
+/*########################################################################################################################*
+*---------------------------------------------------Chunk vertex arena----------------------------------------------------*
+*#########################################################################################################################*/
+#ifdef CC_BUILD_CHUNKARENA
+/* Chunk meshes are sub-allocated in pages from a few large shared vertex buffers, */
+/*  which avoids creating and deleting a vertex buffer every time a chunk is built */
+#define ARENA_PAGE_VERTICES 512
+#define ARENA_MAX_PAGES    1024
+#define ARENA_MAX_COUNT      64
+
+static struct ChunkArena {
+	GfxResourceID vb;
+	int usedPages;
+	cc_uint8 table[ARENA_MAX_PAGES / BLOCKS_PER_PAGE];
+#ifdef CC_BUILD_PACKEDTERRAIN
+	int originX, originY, originZ;
+#endif
+} arenas[ARENA_MAX_COUNT];
+static int arenasCount;
+
+#ifdef CC_BUILD_PACKEDTERRAIN
+/* Only chunks from the same region share a vertex buffer, so that each vertex buffer has just one origin */
+#define ChunkArena_InRegion(arena, info) (arena->originX == TerrainRegion_Origin(info->centreX) && \
+	arena->originY == TerrainRegion_Origin(info->centreY) && arena->originZ == TerrainRegion_Origin(info->centreZ))
+#define ChunkArena_SetRegion(arena, info) arena->originX = TerrainRegion_Origin(info->centreX); \
+	arena->originY = TerrainRegion_Origin(info->centreY); arena->originZ = TerrainRegion_Origin(info->centreZ);
+#else
+#define ChunkArena_InRegion(arena, info) true
+#define ChunkArena_SetRegion(arena, info)
+#endif
+
+/* Returns index of the shared vertex buffer the pages were allocated from, or -1 if no space */
+static int ChunkArena_Alloc(struct ChunkInfo* info, int pages, int* page) {
+	struct ChunkArena* arena;
+	GfxResourceID vb;
+	int i, empty = -1;
+
+	for (i = 0; i < arenasCount; i++)
+	{
+		arena = &arenas[i];
+		if (!arena->usedPages && empty == -1) empty = i;
+		if (!ChunkArena_InRegion(arena, info)) continue;
+		if (arena->usedPages + pages > ARENA_MAX_PAGES) continue;
+
+		*page = blockalloc_alloc(arena->table, ARENA_MAX_PAGES, pages);
+		if (*page >= 0) return i;
+	}
+
+	/* Reuse an empty vertex buffer left over from another region before creating a new one */
+	if (empty >= 0) {
+		arena = &arenas[empty];
+		ChunkArena_SetRegion(arena, info);
+		*page = blockalloc_alloc(arena->table, ARENA_MAX_PAGES, pages);
+		return empty;
+	}
+	if (arenasCount == ARENA_MAX_COUNT) return -1;
+
+	/* NOTE: Creating the vertex buffer may delete all chunks when out of VRAM */
+	vb = Gfx_CreateDynamicVb(CHUNK_VERTEX_FORMAT, ARENA_MAX_PAGES * ARENA_PAGE_VERTICES);
+	if (!vb) return -1;
+
+	arena     = &arenas[arenasCount];
+	arena->vb = vb;
+	ChunkArena_SetRegion(arena, info);
+	*page     = blockalloc_alloc(arena->table, ARENA_MAX_PAGES, pages);
+	return arenasCount++;
+}
+
+void* MapRenderer_LockChunkVb(struct ChunkInfo* info, int count) {
+	/* add an extra element to fix crashing on some GPUs */
+	int pages = SIZE_TO_BLOCKS(count + 1, ARENA_PAGE_VERTICES);
+	int index, page;
+	if (pages > ARENA_MAX_PAGES) return NULL;
+
+	index = ChunkArena_Alloc(info, pages, &page);
+	if (index < 0) return NULL;
+	arenas[index].usedPages += pages;
+
+	info->vb         = arenas[index].vb;
+	info->vbBase     = page * ARENA_PAGE_VERTICES;
+	info->arenaIndex = index;
+	info->arenaPages = pages;
+	return Gfx_LockDynamicVbRange(info->vb, CHUNK_VERTEX_FORMAT, info->vbBase, count);
+}
+
+void MapRenderer_UnlockChunkVb(struct ChunkInfo* info) {
+	Gfx_UnlockDynamicVbRange(info->vb);
+}
+
+static void FreeChunkVb(struct ChunkInfo* info) {
+	struct ChunkArena* arena;
+	if (info->arenaIndex < 0) { Gfx_DeleteVb(&info->vb); return; }
+
+	arena = &arenas[info->arenaIndex];
+	blockalloc_dealloc(arena->table, info->vbBase / ARENA_PAGE_VERTICES, info->arenaPages);
+	arena->usedPages -= info->arenaPages;
+
+	info->vb         = 0;
+	info->vbBase     = 0;
+	info->arenaIndex = -1;
+}
+
+/* Deletes all the shared vertex buffers (all chunks must have been deleted beforehand) */
+static void FreeArenas(void) {
+	int i;
+	for (i = 0; i < arenasCount; i++)
+	{
+		Gfx_DeleteDynamicVb(&arenas[i].vb);
+		Mem_Set(arenas[i].table, 0, sizeof(arenas[i].table));
+		arenas[i].usedPages = 0;
+	}
+	arenasCount = 0;
+}
+#else
+#if CC_GFX_BACKEND != CC_GFX_BACKEND_GL11
+static void FreeChunkVb(struct ChunkInfo* info) { Gfx_DeleteVb(&info->vb); }
+#endif
+static void FreeArenas(void) { }
+#endif
+
+
 /*########################################################################################################################*
 *---------------------------------------------------Chunk functionality---------------------------------------------------*
 *#########################################################################################################################*/
@@ -325,13 +636,19 @@ static void DeleteChunk(struct ChunkInfo* info) {
 #if CC_GFX_BACKEND == CC_GFX_BACKEND_GL11
 	int j;
 #else
-	Gfx_DeleteVb(&info->vb);
+	FreeChunkVb(info);
 #endif
+	if (info->building) {
+		ChunkInfo_CancelBuild(info);
+	} else if (!info->dirty) {
+		DirtyChunks_Add(info);
+	}
 
 	info->empty  = false; 
 	info->allAir = false;
 	info->noData = true;
 	info->dirty  = true;
+	info->edited = false;
 
 #ifdef OCCLUSION
 	info.OcclusionFlags = 0;
@@ -363,15 +680,11 @@ static void DeleteChunk(struct ChunkInfo* info) {
 	}
 }
 
-/* Builds the mesh (hence vertex buffer) for the given chunk, and updates internal state */
-static void BuildChunk(struct ChunkInfo* info, int* chunkUpdates) {
+/* Updates internal state after the mesh for the given chunk has been built */
+static void OnChunkBuilt(struct ChunkInfo* info) {
 	struct ChunkPartInfo* ptr;
 	int i;
 
-	Game.ChunkUpdates++;
-	(*chunkUpdates)++;
-	Builder_MakeChunk(info);
-
 	info->dirty  = false;
 	info->noData = !info->normalParts && !info->translucentParts;
 	info->empty  = info->noData;
@@ -392,6 +705,43 @@ static void BuildChunk(struct ChunkInfo* info, int* chunkUpdates) {
 	}
 }
 
+/* Builds the mesh (hence vertex buffer) for the given chunk, and updates internal state */
+/* NOTE: The mesh might instead be built on background threads, and then replace the */
+/*  chunk's current mesh on a later frame in Builder_FinishChunks */
+static void BuildChunk(struct ChunkInfo* info, int* chunkUpdates) {
+	cc_uint32 connectivity = info->connectivity;
+	cc_bool edited = info->edited;
+	Game.ChunkUpdates++;
+	(*chunkUpdates)++;
+
+	/* Chunks changed by the player are still rebuilt straight away, so changes appear without delay */
+	if (!edited && Builder_QueueChunk(info)) {
+		info->building = true; return;
+	}
+
+	DeleteChunk(info);
+	if (edited && Builder_RemakeChunk(info)) {
+		/* nothing to do here */
+	} else {
+		Builder_MakeChunk(info);
+	}
+
+	OnChunkBuilt(info);
+	if (caveCulling && info->connectivity != connectivity) reachableDirty = true;
+}
+
+/* Deletes the current mesh of a chunk, as the mesh built for it on background threads is replacing it */
+static void OnQueuedChunkReplaced(struct ChunkInfo* info) {
+	info->building = false;
+	DeleteChunk(info);
+}
+
+/* Updates internal state after the mesh for a chunk has been built on background threads */
+static void OnQueuedChunkBuilt(struct ChunkInfo* info, cc_uint32 connectivity) {
+	OnChunkBuilt(info);
+	if (caveCulling && info->connectivity != connectivity) reachableDirty = true;
+}
+
 
 /*########################################################################################################################*
 *----------------------------------------------------Chunks mangagement---------------------------------------------------*
@@ -407,11 +757,21 @@ static void FreeChunks(void) {
 	Mem_Free(sortedChunks);
 	Mem_Free(renderChunks);
 	Mem_Free(distances);
+	Mem_Free(visitQueue);
+	Mem_Free(dirtyNext);
+	Mem_Free(dirtyBuckets);
 
 	mapChunks    = NULL;
 	sortedChunks = NULL;
 	renderChunks = NULL;
 	distances    = NULL;
+	visitQueue   = NULL;
+	dirtyNext    = NULL;
+	dirtyBuckets = NULL;
+
+	renderRange          = 0;
+	dirtyBucketsCount    = 0;
+	dirtyBucketsCapacity = 0;
 }
 
 static void AllocateParts(void) {
@@ -428,6 +788,8 @@ static void AllocateChunks(void) {
 	sortedChunks = (struct ChunkInfo**)Mem_Alloc(chunksCount, sizeof(struct ChunkInfo*), "sorted chunk info");
 	renderChunks = (struct ChunkInfo**)Mem_Alloc(chunksCount, sizeof(struct ChunkInfo*), "render chunk info");
 	distances    = (cc_uint32*)Mem_Alloc(chunksCount, 4, "chunk distances");
+	visitQueue   = (cc_uint32*)Mem_Alloc(chunksCount, 4, "chunk visit queue");
+	dirtyNext    = (int*)Mem_Alloc(chunksCount, 4, "dirty chunks");
 }
 
 static void ResetPartFlags(void) {
@@ -481,12 +843,13 @@ static void DeleteChunks(void) {
 	{
 		DeleteChunk(&mapChunks[i]);
 	}
+	FreeArenas();
 	ResetPartCounts();
 }
 
 void MapRenderer_Refresh(void) {
 	int oldCount;
-	chunkPos = IVec3_MaxValue();
+	ResetSortOrder();
 
 	if (mapChunks && World.Blocks) {
 		DeleteChunks();
@@ -507,7 +870,7 @@ static void RefreshBorderChunks(int maxHeight) {
 	int cx, cy, cz;
 	cc_bool onBorder;
 
-	chunkPos = IVec3_MaxValue();
+	ResetSortOrder();
 	if (!mapChunks || !World.Blocks) return;
 
 	for (cz = 0; cz < World.ChunksZ; cz++) {
@@ -516,7 +879,7 @@ static void RefreshBorderChunks(int maxHeight) {
 				onBorder = cx == 0 || cz == 0 || cx == (World.ChunksX - 1) || cz == (World.ChunksZ - 1);
 
 				if (onBorder && (cy * CHUNK_SIZE) < maxHeight) {
-					MapRenderer_RefreshChunk(cx, cy, cz);
+					ChunkInfo_Refresh(&mapChunks[World_ChunkPack(cx, cy, cz)]);
 				}
 			}
 		}
@@ -549,73 +912,146 @@ static void CalcViewDists(void) {
 	renderDistSquared = AdjustDist(Game_ViewDistance);
 }
 
-static int UpdateChunksAndVisibility(int* chunkUpdates) {
-	int renderDistSqr = renderDistSquared;
-	int buildDistSqr  = buildDistSquared;
+/* Marks the given chunk as reachable and adds it to the visit queue, if it hasn't been already */
+static int VisitChunk(int cx, int cy, int cz, int from, int dirs, int tail) {
+	struct ChunkInfo* info;
+	int index, dx, dy, dz;
+	if (cx < 0 || cy < 0 || cz < 0 || cx >= World.ChunksX || cy >= World.ChunksY || cz >= World.ChunksZ) return tail;
+
+	index = World_ChunkPack(cx, cy, cz);
+	info  = &mapChunks[index];
+	if (info->reachable) return tail;
+
+	dx = info->centreX - chunkPos.x; dy = info->centreY - chunkPos.y; dz = info->centreZ - chunkPos.z;
+	if (dx * dx + dy * dy + dz * dz > renderDistSquared) return tail;
 
+	info->reachable   = true;
+	visitQueue[tail] = (index << 9) | (dirs << 3) | from;
+	return tail + 1;
+}
+
+#define VISIT_NO_FACE 7
+/* Calculates which chunks might be seen from the camera, by doing a breadth first search outwards */
+/*  from the chunk the camera is in, only going through faces of chunks that are connected together */
+/* NOTE: The search never travels back towards the camera, so chunks are only entered once */
+static void CalcReachableChunks(void) {
+	static const cc_int8 offsetX[FACE_COUNT] = { -1, 1,  0, 0,  0, 0 };
+	static const cc_int8 offsetY[FACE_COUNT] = {  0, 0,  0, 0, -1, 1 };
+	static const cc_int8 offsetZ[FACE_COUNT] = {  0, 0, -1, 1,  0, 0 };
 	struct ChunkInfo* info;
-	int i, j = 0, distSqr;
+	int i, head = 0, tail = 0;
+	int entry, from, dirs, face;
+	int cx, cy, cz, a, b;
+	IVec3 pos;
 
+	reachableDirty = false;
 	for (i = 0; i < chunksCount; i++) 
 	{
-		info = sortedChunks[i];
-		if (info->empty) continue;
-		distSqr = distances[i];
-		
-		/* Auto unload chunks far away chunks */
-		if (!info->noData && distSqr >= buildDistSqr + 32 * 16) {
-			DeleteChunk(info); continue;
-		}
+		mapChunks[i].reachable = !caveCulling;
+	}
+	if (!caveCulling) return;
 
-		if (info->dirty && distSqr <= buildDistSqr && *chunkUpdates < chunksTarget) {
-			DeleteChunk(info);
-			BuildChunk(info, chunkUpdates);
+	IVec3_Floor(&pos, &Camera.CurrentPos);
+	if (World_Contains(pos.x, pos.y, pos.z)) {
+		tail = VisitChunk(pos.x >> CHUNK_SHIFT, pos.y >> CHUNK_SHIFT, pos.z >> CHUNK_SHIFT, VISIT_NO_FACE, 0, tail);
+	}
+
+	/* Camera is outside the map, so start from all the chunks on the sides of the map facing the camera */
+	for (a = 0; a < World.ChunksX; a++) {
+		for (b = 0; b < World.ChunksZ; b++) {
+			if (pos.y < 0)             tail = VisitChunk(a, 0,                  b, FACE_YMIN, 1 << FACE_YMAX, tail);
+			if (pos.y >= World.Height) tail = VisitChunk(a, World.ChunksY - 1,  b, FACE_YMAX, 1 << FACE_YMIN, tail);
 		}
+	}
+	for (a = 0; a < World.ChunksY; a++) {
+		for (b = 0; b < World.ChunksZ; b++) {
+			if (pos.x < 0)             tail = VisitChunk(0,                 a,  b, FACE_XMIN, 1 << FACE_XMAX, tail);
+			if (pos.x >= World.Width)  tail = VisitChunk(World.ChunksX - 1, a,  b, FACE_XMAX, 1 << FACE_XMIN, tail);
+		}
+		for (b = 0; b < World.ChunksX; b++) {
+			if (pos.z < 0)             tail = VisitChunk(b, a, 0,                 FACE_ZMIN, 1 << FACE_ZMAX, tail);
+			if (pos.z >= World.Length) tail = VisitChunk(b, a, World.ChunksZ - 1, FACE_ZMAX, 1 << FACE_ZMIN, tail);
+		}
+	}
 
-		info->visible = distSqr <= renderDistSqr &&
-			FrustumCulling_SphereInFrustum(info->centreX, info->centreY, info->centreZ, 14); /* 14 ~ sqrt(3 * 8^2) */
-		if (info->visible && !info->empty) { renderChunks[j] = info; j++; }
+	while (head < tail) 
+	{
+		entry = visitQueue[head++];
+		info  = &mapChunks[entry >> 9];
+		dirs  = (entry >> 3) & 0x3F;
+		from  = entry & 0x07;
+
+		cx = info->centreX >> CHUNK_SHIFT;
+		cy = info->centreY >> CHUNK_SHIFT;
+		cz = info->centreZ >> CHUNK_SHIFT;
+
+		for (face = 0; face < FACE_COUNT; face++) 
+		{
+			/* Don't travel back towards the camera */
+			if (dirs & (1 << (face ^ 1))) continue;
+			if (from != VISIT_NO_FACE && !(info->connectivity & ChunkInfo_FacesBit(from, face))) continue;
+
+			tail = VisitChunk(cx + offsetX[face], cy + offsetY[face], cz + offsetZ[face], 
+								face ^ 1, dirs | (1 << face), tail);
+		}
 	}
-	return j;
 }
 
-static int UpdateChunksStill(int* chunkUpdates) {
+/* Calculates which chunks within render distance are visible, and then updates renderChunks */
+static int UpdateVisibility(void) {
 	int renderDistSqr = renderDistSquared;
-	int buildDistSqr  = buildDistSquared;
-
 	struct ChunkInfo* info;
-	int i, j = 0, distSqr;
+	int i, j = 0;
 
 	for (i = 0; i < chunksCount; i++) 
 	{
+		/* Chunks are sorted by distance, so all later chunks are too far away to be rendered */
+		if (distances[i] > renderDistSqr) break;
 		info = sortedChunks[i];
 		if (info->empty) continue;
-		distSqr = distances[i];
 
-		/* Auto unload chunks far away chunks */
-		if (!info->noData && distSqr >= buildDistSqr + 32 * 16) {
-			DeleteChunk(info); continue;
-		}
+		info->visible = info->reachable &&
+			FrustumCulling_SphereInFrustum(info->centreX, info->centreY, info->centreZ, 14); /* 14 ~ sqrt(3 * 8^2) */
+		if (info->visible) { renderChunks[j] = info; j++; }
+	}
 
-		if (info->dirty && distSqr <= buildDistSqr && *chunkUpdates < chunksTarget) {
-			DeleteChunk(info);
-			BuildChunk(info, chunkUpdates);
-
-			/* only need to update the visibility of chunks in range. */
-			info->visible = distSqr <= renderDistSqr &&
-				FrustumCulling_SphereInFrustum(info->centreX, info->centreY, info->centreZ, 14); /* 14 ~ sqrt(3 * 8^2) */
-			if (info->visible && !info->empty) { renderChunks[j] = info; j++; }
-		} else if (info->visible) {
-			renderChunks[j] = info; j++;
-		}
+	renderRange = i;
+	return j;
+}
+
+/* Updates renderChunks after some chunks were built, without recalculating visibility of all chunks */
+static int UpdateRenderChunks(void) {
+	struct ChunkInfo* info;
+	int i, j = 0;
+
+	for (i = 0; i < renderRange; i++) 
+	{
+		info = sortedChunks[i];
+		if (info->visible && !info->empty) { renderChunks[j] = info; j++; }
 	}
 	return j;
 }
 
+/* Builds the closest dirty chunks to the camera, up to the number of chunks allowed this frame */
+static void BuildDirtyChunks(int* chunkUpdates) {
+	struct ChunkInfo* info;
+
+	/* Chunks still being built on background threads also count towards the limit */
+	while (*chunkUpdates < chunksTarget && Builder_PendingChunks() < maxChunkUpdates 
+			&& (info = DirtyChunks_Pop(buildDistSquared))) 
+	{
+		BuildChunk(info, chunkUpdates);
+
+		/* only need to update the visibility of chunks that have changed */
+		info->visible = info->reachable && ChunkInfo_DistSqr(info) <= renderDistSquared &&
+			FrustumCulling_SphereInFrustum(info->centreX, info->centreY, info->centreZ, 14); /* 14 ~ sqrt(3 * 8^2) */
+	}
+}
+
 static void UpdateChunks(float delta) {
 	struct LocalPlayer* p;
 	cc_bool samePos;
-	int chunkUpdates = 0;
+	int chunkUpdates = 0, built;
 
 	/* Build more chunks if 30 FPS or over, otherwise slowdown */
 	chunksTarget += delta < CHUNK_TARGET_TIME ? 1 : -1; 
@@ -625,40 +1061,113 @@ static void UpdateChunks(float delta) {
 	samePos = Vec3_Equals(&Camera.CurrentPos, &lastCamPos)
 		&& p->Base.Pitch == lastPitch && p->Base.Yaw == lastYaw;
 
-	renderChunksCount = samePos ?
-		UpdateChunksStill(&chunkUpdates) :
-		UpdateChunksAndVisibility(&chunkUpdates);
+	/* Visibility of every chunk needs to be recalculated when reachability changes */
+	if (reachableDirty) { CalcReachableChunks(); samePos = false; }
+
+	built = Builder_FinishChunks(OnQueuedChunkReplaced, OnQueuedChunkBuilt);
+	BuildDirtyChunks(&chunkUpdates);
+
+	if (!samePos) {
+		renderChunksCount = UpdateVisibility();
+	} else if (chunkUpdates || built) {
+		renderChunksCount = UpdateRenderChunks();
+	}
 
 	lastCamPos = Camera.CurrentPos;
 	lastPitch  = p->Base.Pitch;
 	lastYaw    = p->Base.Yaw;
 
-	if (!samePos || chunkUpdates) ResetPartFlags();
+	if (!samePos || chunkUpdates || built) ResetPartFlags();
 }
 
-static void SortMapChunks(int left, int right) {
-	struct ChunkInfo** values = sortedChunks; struct ChunkInfo* value;
-	cc_uint32* keys = distances; cc_uint32 key;
+/* Sorts chunks by their distance from the camera, using a counting sort */
+/* NOTE: Chunks too far away to be built are not sorted amongst themselves */
+static void SortMapChunks(int bucketsCount) {
+	struct ChunkInfo* info;
+	int i, bucket, total = 0, count;
 
-	while (left < right) {
-		int i = left, j = right;
-		cc_uint32 pivot = keys[(i + j) >> 1];
+	for (i = 0; i < bucketsCount; i++) dirtyBuckets[i] = 0;
+	for (i = 0; i < chunksCount; i++) 
+	{
+		bucket = min(ChunkInfo_DistSqr(&mapChunks[i]) >> 8, bucketsCount - 1);
+		dirtyBuckets[bucket]++;
+	}
 
-		/* partition the list */
-		while (i <= j) {
-			while (pivot > keys[i]) i++;
-			while (pivot < keys[j]) j--;
-			QuickSort_Swap_KV_Maybe();
-		}
-		/* recurse into the smaller subset */
-		QuickSort_Recurse(SortMapChunks)
+	/* Convert counts into index of first chunk in each bucket */
+	for (i = 0; i < bucketsCount; i++) 
+	{
+		count = dirtyBuckets[i];
+		dirtyBuckets[i] = total;
+		total += count;
+	}
+
+	for (i = 0; i < chunksCount; i++) 
+	{
+		info   = &mapChunks[i];
+		bucket = min(ChunkInfo_DistSqr(info) >> 8, bucketsCount - 1);
+
+		sortedChunks[dirtyBuckets[bucket]] = info;
+		distances[dirtyBuckets[bucket]]    = ChunkInfo_DistSqr(info);
+		dirtyBuckets[bucket]++;
+	}
+}
+
+/* Recreates the buckets of dirty chunks from scratch */
+static void InitDirtyChunks(int bucketsCount) {
+	struct ChunkInfo* info;
+	int i;
+
+	for (i = 0; i < bucketsCount; i++) dirtyBuckets[i] = -1;
+	dirtyBucketsCount = bucketsCount;
+	dirtyMin          = bucketsCount;
+
+	for (i = 0; i < chunksCount; i++) 
+	{
+		info = &mapChunks[i];
+		/* Chunks being built on background threads are only added back if cancelled */
+		if (info->dirty && !info->building) DirtyChunks_Add(info);
+	}
+}
+
+/* Calculates the level of detail a chunk currently at the given level should be built at */
+static int CalcChunkLod(int lod, int distSqr) {
+	int dist;
+	if (!lodDistance) return 0;
+
+	while (lod < MAPRENDERER_MAX_LOD) {
+		dist = (lodDistance << lod) + LOD_HYSTERESIS;
+		if (distSqr < dist * dist) break;
+		lod++;
+	}
+	while (lod > 0) {
+		dist = (lodDistance << (lod - 1)) - LOD_HYSTERESIS;
+		if (distSqr >= dist * dist) break;
+		lod--;
+	}
+	return lod;
+}
+
+/* Marks the chunks around the given chunk as needing to be rebuilt, because which of */
+/*  their faces along the shared border are hidden depends on the chunk's level of detail */
+static void RefreshLodNeighbours(struct ChunkInfo* info) {
+	int cx = info->centreX >> CHUNK_SHIFT, cy = info->centreY >> CHUNK_SHIFT, cz = info->centreZ >> CHUNK_SHIFT;
+	int x, y, z;
+
+	for (y = cy - 1; y <= cy + 1; y++)
+		for (z = cz - 1; z <= cz + 1; z++)
+			for (x = cx - 1; x <= cx + 1; x++)
+	{
+		if (x < 0 || y < 0 || z < 0 || x >= World.ChunksX || y >= World.ChunksY || z >= World.ChunksZ) continue;
+		if (x == cx && y == cy && z == cz) continue;
+		ChunkInfo_Refresh(&mapChunks[World_ChunkPack(x, y, z)]);
 	}
 }
 
 static void UpdateSortOrder(void) {
 	struct ChunkInfo* info;
+	int i, dx, dy, dz, distSqr, lod;
+	int maxDistSqr = 0, bucketsCount;
 	IVec3 pos;
-	int i, dx, dy, dz;
 
 	/* pos is centre coordinate of chunk camera is in */
 	IVec3_Floor(&pos, &Camera.CurrentPos);
@@ -669,13 +1178,16 @@ static void UpdateSortOrder(void) {
 	/* If in same chunk, don't need to recalculate sort order */
 	if (pos.x == chunkPos.x && pos.y == chunkPos.y && pos.z == chunkPos.z) return;
 	chunkPos = pos;
+	reachableDirty    = true;
+	dirtyBucketsCount = 0;
 	if (!chunksCount) return;
 
 	for (i = 0; i < chunksCount; i++) {
-		info = sortedChunks[i];
+		info = &mapChunks[i];
 		/* Calculate distance to chunk centre */
 		dx = info->centreX - pos.x; dy = info->centreY - pos.y; dz = info->centreZ - pos.z;
-		distances[i] = dx * dx + dy * dy + dz * dz;
+		distSqr    = dx * dx + dy * dy + dz * dz;
+		maxDistSqr = max(maxDistSqr, distSqr);
 
 		/* Consider these 3 chunks: */
 		/* |       X-1      |        X        |       X+1      | */
@@ -688,11 +1200,31 @@ static void UpdateSortOrder(void) {
 		info->drawXMin = dx >= 0; info->drawXMax = dx <= 0;
 		info->drawZMin = dz >= 0; info->drawZMax = dz <= 0;
 		info->drawYMin = dy >= 0; info->drawYMax = dy <= 0;
+
+		/* Auto unload chunks far away chunks */
+		if (!info->empty && !info->noData && distSqr >= buildDistSquared + 32 * 16) {
+			DeleteChunk(info);
+		}
+
+		/* Rebuild chunks that have moved into a different level of detail range */
+		lod = CalcChunkLod(info->lod, distSqr);
+		if (lod == info->lod) continue;
+		info->lod = lod;
+		if (!info->empty) ChunkInfo_Refresh(info);
+		RefreshLodNeighbours(info);
+	}
+
+	/* One bucket for each distance chunks can be built within, plus one for all further away chunks */
+	bucketsCount = min(maxDistSqr, buildDistSquared) / 256 + 2;
+	if (bucketsCount > dirtyBucketsCapacity) {
+		Mem_Free(dirtyBuckets);
+		dirtyBuckets         = (int*)Mem_Alloc(bucketsCount, 4, "dirty chunk buckets");
+		dirtyBucketsCapacity = bucketsCount;
 	}
 
-	SortMapChunks(0, chunksCount - 1);
+	SortMapChunks(bucketsCount);
+	InitDirtyChunks(bucketsCount);
 	ResetPartFlags();
-	/*SimpleOcclusionCulling();*/
 }
 
 void MapRenderer_Update(float delta) {
@@ -710,7 +1242,12 @@ void MapRenderer_RefreshChunk(int cx, int cy, int cz) {
 	if (cx < 0 || cy < 0 || cz < 0 || cx >= World.ChunksX || cy >= World.ChunksY || cz >= World.ChunksZ) return;
 
 	chunk = &mapChunks[World_ChunkPack(cx, cy, cz)];
-	ChunkInfo_Refresh(chunk);
+	ChunkInfo_RefreshEdited(chunk);
+}
+
+int MapRenderer_GetChunkLod(int cx, int cy, int cz) {
+	if (cx < 0 || cy < 0 || cz < 0 || cx >= World.ChunksX || cy >= World.ChunksY || cz >= World.ChunksZ) return 0;
+	return mapChunks[World_ChunkPack(cx, cy, cz)].lod;
 }
 
 void MapRenderer_OnBlockChanged(int x, int y, int z, BlockID block) {
@@ -720,7 +1257,7 @@ void MapRenderer_OnBlockChanged(int x, int y, int z, BlockID block) {
 	chunk = &mapChunks[World_ChunkPack(cx, cy, cz)];
 	chunk->allAir &= Blocks.Draw[block] == DRAW_GAS;
 	/* TODO: Don't lookup twice, refresh directly using chunk pointer */
-	ChunkInfo_Refresh(chunk);
+	ChunkInfo_RefreshEdited(chunk);
 }
 
 static void OnEnvVariableChanged(void* obj, int envVar) {
@@ -757,6 +1294,8 @@ static void OnBlockDefinitionChanged(void* obj) {
 static void OnVisibilityChanged(void* obj) {
 	lastCamPos = Vec3_BigPos();
 	CalcViewDists();
+	/* Which chunks can be built/need to be unloaded depends on view distance */
+	ResetSortOrder();
 }
 static void DeleteChunks_(void* obj) { DeleteChunks(); }
 static void Refresh_(void* obj)      { MapRenderer_Refresh(); }
@@ -766,7 +1305,7 @@ static void OnNewMap(void) {
 	DeleteChunks();
 	ResetPartCounts();
 
-	chunkPos = IVec3_MaxValue();
+	ResetSortOrder();
 	FreeChunks();
 	FreeParts();
 }
@@ -798,8 +1337,12 @@ static void OnInit(void) {
 
 	/* This = 87 fixes map being invisible when no textures */
 	MapRenderer_1DUsedCount = 87; /* Atlas1D_UsedAtlasesCount(); */
-	chunkPos   = IVec3_MaxValue();
+	ResetSortOrder();
 	maxChunkUpdates = Options_GetInt(OPT_MAX_CHUNK_UPDATES, 4, 1024, 30);
+	caveCulling     = Options_GetBool(OPT_CAVE_CULLING, true);
+	lodDistance     = Options_GetInt(OPT_LOD_DISTANCE, 0, 8192, 0);
+	/* Needs to be far enough away that the hysteresis distance can't go negative */
+	if (lodDistance) lodDistance = max(lodDistance, 2 * LOD_HYSTERESIS);
 	CalcViewDists();
 }
 
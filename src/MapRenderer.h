@@ -20,6 +20,17 @@ with parts for 'normal' buffer being in lower half. */
 extern struct ChunkPartInfo* MapRenderer_PartsNormal; /* TODO: THAT DESC SUCKS */
 extern struct ChunkPartInfo* MapRenderer_PartsTranslucent;
 
+/* Format of the vertices in a chunk's vertex buffer */
+#ifdef CC_BUILD_PACKEDTERRAIN
+	#define CHUNK_VERTEX_FORMAT VERTEX_FORMAT_TERRAIN
+#else
+	#define CHUNK_VERTEX_FORMAT VERTEX_FORMAT_TEXTURED
+#endif
+
+/* Max level of detail chunk meshes are built at */
+/* At level N, the chunk is built from cells of (2^N x 2^N x 2^N) blocks, instead of from individual blocks */
+#define MAPRENDERER_MAX_LOD 2
+
 /* Describes a portion of the data needed for rendering a chunk. */
 struct ChunkPartInfo {
 #if CC_GFX_BACKEND == CC_GFX_BACKEND_GL11
@@ -32,6 +43,11 @@ struct ChunkPartInfo {
 	cc_uint16 counts[FACE_COUNT]; /* Counts per face */
 };
 
+/* Bit in ChunkInfo.connectivity for whether the given two different faces of a chunk are connected */
+#define ChunkInfo_FacesBit(a, b) ((a) < (b) ? (1u << ((a) * FACE_COUNT + (b))) : (1u << ((b) * FACE_COUNT + (a))))
+/* Value of ChunkInfo.connectivity when all faces of a chunk are connected to each other */
+#define CHUNK_CONNECTED_ALL 0x20C38F3Eu
+
 /* Describes data necessary for rendering a chunk. */
 struct ChunkInfo {	
 	cc_uint16 centreX, centreY, centreZ; /* Centre coordinates of the chunk */
@@ -41,6 +57,9 @@ struct ChunkInfo {
 	cc_uint8 dirty : 1;   /* Whether chunk is pending being rebuilt */
 	cc_uint8 allAir : 1;  /* Whether chunk is completely air */
 	cc_uint8 noData : 1;  /* Whether the chunk is currently empty of data, but may have data if built */
+	cc_uint8 reachable : 1; /* Whether chunk might be seen from the camera through other chunks */
+	cc_uint8 edited : 1;  /* Whether chunk is pending being rebuilt only because blocks in or near it changed */
+	cc_uint8 building : 1; /* Whether chunk's mesh is currently being built on background threads */
 	cc_uint8 : 0;         /* pad to next byte*/
 
 	cc_uint8 drawXMin : 1;
@@ -49,13 +68,18 @@ struct ChunkInfo {
 	cc_uint8 drawZMax : 1;
 	cc_uint8 drawYMin : 1;
 	cc_uint8 drawYMax : 1;
+	cc_uint8 lod : 2;      /* Level of detail of the chunk's mesh (see MAPRENDERER_MAX_LOD) */
 	cc_uint8 : 0;          /* pad to next byte */
-#ifdef OCCLUSION
-	public cc_bool Visited = false, Occluded = false;
-	public byte OcclusionFlags, OccludedFlags, DistanceFlags;
-#endif
+	/* Which faces of the chunk can be seen from which other faces (see ChunkInfo_FacesBit) */
+	/* NOTE: Unbuilt chunks are treated as having all faces connected */
+	cc_uint32 connectivity;
 #if CC_GFX_BACKEND != CC_GFX_BACKEND_GL11
 	GfxResourceID vb;
+#endif
+#ifdef CC_BUILD_CHUNKARENA
+	int vbBase;           /* Index of the first vertex of this chunk's mesh in vb */
+	cc_int16 arenaIndex;  /* Shared vertex buffer that vb is, or -1 if vb is only used by this chunk */
+	cc_uint16 arenaPages; /* Number of pages used in the shared vertex buffer */
 #endif
 	struct ChunkPartInfo* normalParts;
 	struct ChunkPartInfo* translucentParts;
@@ -65,14 +89,35 @@ struct ChunkInfo {
 void MapRenderer_RenderNormal(float delta);
 /* Renders the meshes of translucent blocks in visible chunks. */
 void MapRenderer_RenderTranslucent(float delta);
+#ifdef CC_BUILD_PACKEDTERRAIN
+/* Packed terrain vertices of all chunks in the same region are relative to the centre of that region, */
+/*  so that chunks from the same region can be drawn together without changing the origin */
+/* NOTE: Regions must be small enough that 1/64 block positions relative to the centre fit in a short */
+#define TERRAIN_REGION_SHIFT 9
+#define TERRAIN_REGION_SIZE  (1 << TERRAIN_REGION_SHIFT)
+/* Returns the origin of the region that the given block coordinate is in */
+#define TerrainRegion_Origin(coord) ((((coord) >> TERRAIN_REGION_SHIFT) << TERRAIN_REGION_SHIFT) + TERRAIN_REGION_SIZE / 2)
+#endif
+#ifdef CC_BUILD_CHUNKARENA
+/* Sub-allocates space for a chunk's mesh from the shared chunk vertex buffers, */
+/*  then acquires temp memory for filling in the given number of vertices */
+/* Returns NULL if the chunk's mesh must use its own vertex buffer instead */
+void* MapRenderer_LockChunkVb(struct ChunkInfo* info, int count);
+/* Submits the vertices acquired by MapRenderer_LockChunkVb */
+void  MapRenderer_UnlockChunkVb(struct ChunkInfo* info);
+#endif
+
 /* Potentially updates sort order of rendered chunks. */
 /* Potentially builds meshes for several nearby chunks. */
 /* NOTE: This should be called once per frame. */
 void MapRenderer_Update(float delta);
 
-/* Marks the given chunk as needing to be rebuilt/redrawn. */
+/* Marks the given chunk as needing to be rebuilt/redrawn, because blocks in or near it changed. */
 /* NOTE: Coordinates outside the map are simply ignored. */
 void MapRenderer_RefreshChunk(int cx, int cy, int cz);
+/* Returns the level of detail the given chunk is rendered at. */
+/* NOTE: Coordinates outside the map are treated as being rendered at full detail. */
+int MapRenderer_GetChunkLod(int cx, int cy, int cz);
 /* Called when a block is changed, to update internal state. */
 void MapRenderer_OnBlockChanged(int x, int y, int z, BlockID block);
 /* Deletes all chunks and resets internal state. */
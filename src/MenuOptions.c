@@ -737,6 +737,22 @@ static void    GrO_SetSmooth(cc_bool v) {
 	MapRenderer_Refresh();
 }
 
+static cc_bool GrO_GetGreedy(void) { return Builder_GreedyMeshing; }
+static void    GrO_SetGreedy(cc_bool v) {
+	Builder_GreedyMeshing = v;
+	Options_SetBool(OPT_GREEDY_MESHING, v);
+	Builder_ApplyActive();
+	MapRenderer_Refresh();
+}
+
+#ifdef CC_BUILD_PACKEDTERRAIN
+/* Merged faces are only repeated vertically by the terrain shader, which doesn't work with mipmaps */
+#define GREEDY_MESHING_NOTE "&cNote: &eWhen mipmaps are on, faces are only merged along rows."
+#else
+/* Only the packed terrain vertex format used by the modern OpenGL renderer can repeat vertically */
+#define GREEDY_MESHING_NOTE "&cNote: &eWith this renderer, faces are only merged along rows."
+#endif
+
 static int  GrO_GetLighting(void) { return Lighting_Mode; }
 static void GrO_SetLighting(int v) {
 	cc_string str = String_FromReadonly(LightingMode_Names[v]);
@@ -783,6 +799,12 @@ static void GraphicsOptionsScreen_InitWidgets(struct MenuOptionsScreen* s) {
 			GrO_GetSmooth,     GrO_SetSmooth,
 			"&eSmooth lighting smooths lighting and adds a minor glow to bright blocks.\n" \
 			"&cNote: &eThis setting may reduce performance.");
+		MenuOptionsScreen_AddBool(s, "Greedy meshing",
+			GrO_GetGreedy,     GrO_SetGreedy,
+			"&eMerges neighbouring faces that look the same into larger faces,\n" \
+			"    so that fewer vertices need to be drawn.\n" \
+			"&eHas no effect when smooth lighting is on.\n" \
+			GREEDY_MESHING_NOTE);
 		MenuOptionsScreen_AddEnum(s, "Lighting mode", LightingMode_Names, LIGHTING_MODE_COUNT,
 			GrO_GetLighting,   GrO_SetLighting,
 			"&eClassic: &fTwo levels of light, sun and shadow.\n" \
@@ -1362,12 +1362,22 @@ static void SaveLevelScreen_RemoveOverwrites(struct SaveLevelScreen* s) {
 static cc_result DoSaveMap(const cc_string* path, struct GZipState* state) {
 	static const cc_string schematic = String_FromConst(".schematic");
 	static const cc_string mine      = String_FromConst(".mine");
+	static const cc_string region    = String_FromConst(".ccrgn");
+	int level = Options_GetInt(OPT_MAP_COMPRESSION, DEFLATE_LEVEL_FAST, DEFLATE_LEVEL_MAX, DEFLATE_LEVEL_DEFAULT);
 	struct Stream stream, compStream;
 	cc_result res;
 
+	/* Region maps are written in place, so that only changed chunks need to be rewritten */
+	if (String_CaselessEnds(path, &region)) {
+		res = Region_Save(path, level);
+		if (res) Logger_SysWarn2(res, "saving", path);
+		return res;
+	}
+
 	res = Stream_CreateFile(&stream, path);
 	if (res) { Logger_SysWarn2(res, "creating", path); return res; }
-	GZip_MakeStream(&compStream, state, &stream);
+	GZip_MakeParallelStream(&compStream, state, &stream, level,
+		Options_GetInt(OPT_MAP_SAVE_THREADS, 0, GZIP_PARALLEL_MAX_WORKERS, 4), true);
 
 	if (String_CaselessEnds(path, &schematic)) {
 		res = Schematic_Save(&compStream);
@@ -1378,6 +1388,8 @@ static cc_result DoSaveMap(const cc_string* path, struct GZipState* state) {
 	}
 
 	if (res) {
+		/* Still need to close compressor, so that any worker threads are stopped */
+		(void)compStream.Close(&compStream);
 		stream.Close(&stream);
 		Logger_SysWarn2(res, "encoding", path); return res;
 	}
@@ -1449,10 +1461,10 @@ static void SaveLevelScreen_UploadCallback(const cc_string* path) {
 
 static void SaveLevelScreen_File(void* screen, void* b) {
 	static const char* const titles[] = {
-		"ClassiCube map", "Minecraft schematic", "Minecraft classic map", NULL
+		"ClassiCube map", "Minecraft schematic", "Minecraft classic map", "ClassiCube region map", NULL
 	};
 	static const char* const filters[] = {
-		".cw", ".schematic", ".mine", NULL
+		".cw", ".schematic", ".mine", ".ccrgn", NULL
 	};
 	struct SaveLevelScreen* s = (struct SaveLevelScreen*)screen;
 	struct SaveFileDialogArgs args;
@@ -1852,7 +1864,7 @@ static void LoadLevelScreen_LoadEntries(struct ListScreen* s) {
 static void LoadLevelScreen_UploadCallback(const cc_string* path) { Map_LoadFrom(path); }
 static void LoadLevelScreen_ActionFunc(void* s, void* w) {
 	static const char* const filters[] = { 
-		".cw", ".dat", ".lvl", ".mine", ".fcm", ".mclevel", NULL 
+		".cw", ".dat", ".lvl", ".mine", ".fcm", ".mclevel", ".ccraw", ".ccrgn", NULL 
 	}; /* TODO not hardcode list */
 	static struct OpenFileDialogArgs args = {
 		"Classic map files", filters,
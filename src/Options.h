@@ -25,7 +25,9 @@ Copyright 2014-2025 ClassiCube | Licensed under BSD-3
 #define OPT_ENTITY_SHADOW "entityshadow"
 #define OPT_RENDER_TYPE "normal"
 #define OPT_SMOOTH_LIGHTING "gfx-smoothlighting"
+#define OPT_GREEDY_MESHING "gfx-greedymeshing"
 #define OPT_LIGHTING_MODE "gfx-lightingmode"
+#define OPT_LIGHTING_THREADS "gfx-lightingthreads"
 #define OPT_MIPMAPS "gfx-mipmaps"
 #define OPT_CHAT_LOGGING "chat-logging"
 #define OPT_WINDOW_WIDTH "window-width"
@@ -72,6 +74,11 @@ Copyright 2014-2025 ClassiCube | Licensed under BSD-3
 #define OPT_CLASSIC_CHAT "nostalgia-classicchat"
 #define OPT_CLASSIC_INVENTORY "nostalgia-classicinventory"
 #define OPT_MAX_CHUNK_UPDATES "gfx-maxchunkupdates"
+#define OPT_CAVE_CULLING "gfx-caveculling"
+#define OPT_BUILDER_THREADS "gfx-builderthreads"
+#define OPT_LOD_DISTANCE "gfx-loddistance"
+#define OPT_MESH_CACHE_SIZE "gfx-meshcachesize"
+#define OPT_EAGER_HEIGHTMAP "gfx-eagerheightmap"
 #define OPT_CAMERA_MASS "cameramass"
 #define OPT_CAMERA_SMOOTH "camera-smooth"
 #define OPT_GRAB_CURSOR "win-grab-cursor"
@@ -86,6 +93,10 @@ Copyright 2014-2025 ClassiCube | Licensed under BSD-3
 #define OPT_GAME_VERSION "game-version"
 #define OPT_INV_SCROLLBAR_SCALE "inv-scrollbar-scale"
 #define OPT_ANAGLYPH3D "anaglyph-3d"
+#define OPT_MAP_COMPRESSION "map-compressionlevel"
+#define OPT_MAP_SAVE_THREADS "map-savethreads"
+#define OPT_MAP_LOAD_THREADS "map-loadthreads"
+#define OPT_NET_RECORD "net-record"
 
 #define OPT_SELECTED_BLOCK_OUTLINE_COLOR "selected-block-outline-color"
 #define OPT_SELECTED_BLOCK_OUTLINE_OPACITY "selected-block-outline-opacity"
@@ -293,6 +293,13 @@ cc_result File_Seek(cc_file file, int offset, int seekType);
 cc_result File_Position(cc_file file, cc_uint32* pos);
 /* Attempts to retrieve the length of the given file. */
 cc_result File_Length(cc_file file, cc_uint32* len);
+#ifdef CC_BUILD_MMAP
+/* Attempts to map the entire contents of the given file into memory. */
+/* Mapped memory is copy-on-write, so changes to it are NOT written back to the file. */
+/* NOTE: The file can be closed afterwards, the mapping remains valid until File_Unmap */
+cc_result File_Map(cc_file file, void** data, cc_uint32* len);
+void File_Unmap(void* data, cc_uint32 len);
+#endif
 
 
 /*########################################################################################################################*
@@ -373,6 +380,11 @@ extern const cc_result ReturnCode_SocketDropped;
 cc_result Socket_CheckReadable(cc_socket s, cc_bool* readable);
 /* Checks if the given socket is currently writable (i.e. has finished connecting) */
 cc_result Socket_CheckWritable(cc_socket s, cc_bool* writable);
+#ifdef CC_BUILD_NETTHREAD
+/* Waits up to the given number of milliseconds for the socket to become readable */
+/* NOTE: A closed socket is also considered readable */
+cc_result Socket_WaitReadable(cc_socket s, cc_uint32 milliseconds, cc_bool* readable);
+#endif
 /* If the input represents an IP address, then parses the input into a single IP address */
 /* Otherwise, attempts to resolve the input via DNS into one or more IP addresses */
 cc_result Socket_ParseAddress(const cc_string* address, int port, cc_sockaddr* addrs, int* numValidAddrs);
@@ -29,6 +29,9 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/time.h>
+#ifdef CC_BUILD_MMAP
+#include <sys/mman.h>
+#endif
 #include <netdb.h>
 
 const cc_result ReturnCode_FileShareViolation = 1000000000; /* TODO: not used apparently */
@@ -439,6 +442,23 @@ cc_result File_Length(cc_file file, cc_uint32* len) {
 	*len = st.st_size; return 0;
 }
 
+#ifdef CC_BUILD_MMAP
+cc_result File_Map(cc_file file, void** data, cc_uint32* len) {
+	cc_result res;
+	if ((res = File_Length(file, len))) return res;
+	/* mmap fails with 0 length */
+	if (!(*len)) return ERR_END_OF_STREAM;
+
+	/* MAP_PRIVATE means that any writes are copy-on-write */
+	*data = mmap(NULL, *len, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+	return *data != MAP_FAILED ? 0 : errno;
+}
+
+void File_Unmap(void* data, cc_uint32 len) {
+	munmap(data, len);
+}
+#endif
+
 
 /*########################################################################################################################*
 *--------------------------------------------------------Threading--------------------------------------------------------*
@@ -834,11 +854,13 @@ void Socket_Close(cc_socket s) {
 #if defined CC_BUILD_DARWIN || defined CC_BUILD_BEOS
 /* poll is broken on old OSX apparently https://daniel.haxx.se/docs/poll-vs-select.html */
 /* BeOS lacks support for poll */
-static cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
+static cc_result Socket_Poll(cc_socket s, int mode, int timeout, cc_bool* success) {
 	fd_set set;
-	struct timeval time = { 0 };
+	struct timeval time;
 	int selectCount;
 
+	time.tv_sec  = timeout / 1000;
+	time.tv_usec = (timeout % 1000) * 1000;
 	FD_ZERO(&set);
 	FD_SET(s, &set);
 
@@ -853,13 +875,13 @@ static cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
 }
 #else
 #include <poll.h>
-static cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
+static cc_result Socket_Poll(cc_socket s, int mode, int timeout, cc_bool* success) {
 	struct pollfd pfd;
 	int flags;
 
 	pfd.fd     = s;
 	pfd.events = mode == SOCKET_POLL_READ ? POLLIN : POLLOUT;
-	if (poll(&pfd, 1, 0) == -1) { *success = false; return errno; }
+	if (poll(&pfd, 1, timeout) == -1) { *success = false; return errno; }
 	
 	/* to match select, closed socket still counts as readable */
 	flags    = mode == SOCKET_POLL_READ ? (POLLIN | POLLHUP) : POLLOUT;
@@ -869,12 +891,21 @@ static cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
 #endif
 
 cc_result Socket_CheckReadable(cc_socket s, cc_bool* readable) {
-	return Socket_Poll(s, SOCKET_POLL_READ, readable);
+	return Socket_Poll(s, SOCKET_POLL_READ, 0, readable);
+}
+
+#ifdef CC_BUILD_NETTHREAD
+cc_result Socket_WaitReadable(cc_socket s, cc_uint32 milliseconds, cc_bool* readable) {
+	cc_result res = Socket_Poll(s, SOCKET_POLL_READ, milliseconds, readable);
+	/* Being interrupted by a signal isn't an error, it just means nothing was received yet */
+	if (res == EINTR) { *readable = false; return 0; }
+	return res;
 }
+#endif
 
 cc_result Socket_CheckWritable(cc_socket s, cc_bool* writable) {
 	socklen_t resultSize = sizeof(socklen_t);
-	cc_result res = Socket_Poll(s, SOCKET_POLL_WRITE, writable);
+	cc_result res = Socket_Poll(s, SOCKET_POLL_WRITE, 0, writable);
 	if (res || *writable) return res;
 
 	/* https://stackoverflow.com/questions/29479953/so-error-value-after-successful-socket-operation */
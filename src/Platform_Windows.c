@@ -442,6 +442,30 @@ cc_result File_Length(cc_file file, cc_uint32* len) {
 	return *len != INVALID_FILE_SIZE ? 0 : GetLastError();
 }
 
+#ifdef CC_BUILD_MMAP
+cc_result File_Map(cc_file file, void** data, cc_uint32* len) {
+	HANDLE mapping;
+	cc_result res;
+	if ((res = File_Length(file, len))) return res;
+	/* CreateFileMapping fails with 0 length */
+	if (!(*len)) return ERR_END_OF_STREAM;
+
+	/* PAGE_WRITECOPY/FILE_MAP_COPY means that any writes are copy-on-write */
+	mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	if (!mapping) return GetLastError();
+
+	*data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+	res   = *data ? 0 : GetLastError();
+	/* Mapped view keeps the mapping object alive */
+	CloseHandle(mapping);
+	return res;
+}
+
+void File_Unmap(void* data, cc_uint32 len) {
+	UnmapViewOfFile(data);
+}
+#endif
+
 
 /*########################################################################################################################*
 *--------------------------------------------------------Threading--------------------------------------------------------*
@@ -726,11 +750,14 @@ void Socket_Close(cc_socket s) {
 	_closesocket(s);
 }
 
-static cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
+static cc_result Socket_Poll(cc_socket s, int mode, int timeout, cc_bool* success) {
 	fd_set set;
-	struct timeval time = { 0 };
+	struct timeval time;
 	int selectCount;
 
+	time.tv_sec  = timeout / 1000;
+	time.tv_usec = (timeout % 1000) * 1000;
+
 	set.fd_count    = 1;
 	set.fd_array[0] = s;
 
@@ -746,12 +773,18 @@ static cc_result Socket_Poll(cc_socket s, int mode, cc_bool* success) {
 }
 
 cc_result Socket_CheckReadable(cc_socket s, cc_bool* readable) {
-	return Socket_Poll(s, SOCKET_POLL_READ, readable);
+	return Socket_Poll(s, SOCKET_POLL_READ, 0, readable);
 }
 
+#ifdef CC_BUILD_NETTHREAD
+cc_result Socket_WaitReadable(cc_socket s, cc_uint32 milliseconds, cc_bool* readable) {
+	return Socket_Poll(s, SOCKET_POLL_READ, milliseconds, readable);
+}
+#endif
+
 cc_result Socket_CheckWritable(cc_socket s, cc_bool* writable) {
 	int resultSize = sizeof(cc_result);
-	cc_result res  = Socket_Poll(s, SOCKET_POLL_WRITE, writable);
+	cc_result res  = Socket_Poll(s, SOCKET_POLL_WRITE, 0, writable);
 	if (res || *writable) return res;
 
 	/* https://stackoverflow.com/questions/29479953/so-error-value-after-successful-socket-operation */
@@ -46,6 +46,8 @@ static cc_bool map_begunLoading;
 static cc_uint64 map_receiveBeg;
 static struct Stream map_part;
 static int map_volume;
+/* Total microseconds spent decompressing the map */
+static cc_uint64 map_inflateTime;
 
 /*########################################################################################################################*
 *-----------------------------------------------------CPE extensions------------------------------------------------------*
@@ -385,7 +387,9 @@ static CC_INLINE void MapState_SkipHeader(struct MapState* m) {
 	m->sizeIndex     = MAP_SIZE_LEN;
 }
 
+static void MapInflater_Abort(void);
 static void FreeMapStates(void) {
+	MapInflater_Abort();
 	Mem_Free(map1.blocks);
 	map1.blocks = NULL;
 #ifdef EXTENDED_BLOCKS
@@ -415,11 +419,7 @@ static cc_result MapState_Read(struct MapState* m) {
 	if (!m->blocks) {
 		m->blocks = (BlockRaw*)Mem_TryAlloc(map_volume, 1);
 		/* unlikely but possible */
-		if (!m->blocks) {
-			Window_ShowDialog("Out of memory", "Not enough free memory to join that map.\nTry joining a different map.");
-			m->allocFailed = true;
-			return 0;
-		}
+		if (!m->blocks) { m->allocFailed = true; return 0; }
 	}
 
 	left = map_volume - m->index;
@@ -429,6 +429,184 @@ static cc_result MapState_Read(struct MapState* m) {
 	return res;
 }
 
+/* Decompresses a chunk of map data received from the server */
+static cc_result MapState_Inflate(struct MapState* m, cc_uint8* data, int length) {
+	cc_uint64 beg = Stopwatch_Measure();
+	cc_result res = 0;
+
+	map_part.meta.mem.cur    = data;
+	map_part.meta.mem.base   = data;
+	map_part.meta.mem.left   = length;
+	map_part.meta.mem.length = length;
+
+	if (!m->gzHeader.done) {
+		res = GZipHeader_Read(&map_part, &m->gzHeader);
+		if (res == ERR_END_OF_STREAM) res = 0;
+	}
+	if (!res && m->gzHeader.done) res = MapState_Read(m);
+
+	map_inflateTime += Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+	return res;
+}
+
+#ifdef CC_BUILD_NETTHREAD
+/* Map data is decompressed on a background thread, so that packets keep being received meanwhile */
+/*  (otherwise on slower devices, decompressing can take longer than receiving the map data) */
+#define MAP_INFLATE_CHUNKS 256
+
+struct MapChunk {
+	struct MapState* state;
+	int length;
+	cc_uint8 data[1024];
+};
+
+static struct MapInflaterState {
+	struct MapChunk* chunks;
+	void* thread;
+	void* mutex;
+	void* chunkAdded;
+	void* chunkDone;
+	/* Number of chunks submitted to/decompressed by the background thread */
+	int submitted, inflated;
+	/* Whether to stop once all submitted chunks are decompressed, or immediately */
+	cc_bool stop, discard;
+	cc_result result;
+	/* Copy of how much of the map has been decompressed, for the main thread to report progress with */
+	int index, volume;
+} mapInflater;
+
+static void MapInflater_Loop(void) {
+	struct MapInflaterState* s = &mapInflater;
+	struct MapChunk* chunk;
+	cc_bool stop;
+	cc_result res;
+
+	for (;;) {
+		chunk = NULL;
+		Mutex_Lock(s->mutex);
+		if (s->inflated < s->submitted && !s->discard) chunk = &s->chunks[s->inflated % MAP_INFLATE_CHUNKS];
+		stop = s->stop;
+		Mutex_Unlock(s->mutex);
+
+		if (!chunk) {
+			if (stop) return;
+			/* Waitable_Wait may return spuriously, so always recheck */
+			Waitable_Wait(s->chunkAdded); continue;
+		}
+		/* No point decompressing the rest of the map data after an error */
+		res = s->result ? 0 : MapState_Inflate(chunk->state, chunk->data, chunk->length);
+
+		Mutex_Lock(s->mutex);
+		if (res) s->result = res;
+		s->inflated++;
+		s->index  = map1.index;
+		s->volume = map_volume;
+		Mutex_Unlock(s->mutex);
+		Waitable_Signal(s->chunkDone);
+	}
+}
+
+static void MapInflater_Start(void) {
+	struct MapInflaterState* s = &mapInflater;
+	s->chunks = (struct MapChunk*)Mem_TryAlloc(MAP_INFLATE_CHUNKS, sizeof(struct MapChunk));
+	/* Just decompress on the main thread instead then */
+	if (!s->chunks) return;
+
+	s->mutex      = Mutex_Create("Map inflater");
+	s->chunkAdded = Waitable_Create("Map chunk added");
+	s->chunkDone  = Waitable_Create("Map chunk done");
+	s->submitted  = 0;
+	s->inflated   = 0;
+	s->stop       = false;
+	s->discard    = false;
+	s->result     = 0;
+	s->index      = 0;
+	s->volume     = 0;
+	Thread_Run(&s->thread, MapInflater_Loop, 128 * 1024, "Map inflater");
+}
+
+/* Stops the background thread, returning the first error that occurred while decompressing */
+static cc_result MapInflater_Stop(cc_bool discard) {
+	struct MapInflaterState* s = &mapInflater;
+	if (!s->thread) return 0;
+
+	Mutex_Lock(s->mutex);
+	s->stop    = true;
+	s->discard = discard;
+	Mutex_Unlock(s->mutex);
+
+	Waitable_Signal(s->chunkAdded);
+	Thread_Join(s->thread);
+
+	Waitable_Free(s->chunkAdded);
+	Waitable_Free(s->chunkDone);
+	Mutex_Free(s->mutex);
+	Mem_Free(s->chunks);
+
+	s->thread = NULL;
+	s->chunks = NULL;
+	return s->result;
+}
+
+static cc_result MapInflater_Submit(struct MapState* m, cc_uint8* data, int length) {
+	struct MapInflaterState* s = &mapInflater;
+	struct MapChunk* chunk;
+	cc_bool full;
+	cc_result res;
+	if (!s->thread) return MapState_Inflate(m, data, length);
+
+	for (;;) {
+		Mutex_Lock(s->mutex);
+		full = s->submitted - s->inflated == MAP_INFLATE_CHUNKS;
+		res  = s->result;
+		Mutex_Unlock(s->mutex);
+
+		if (res)   return res;
+		if (!full) break;
+		Waitable_Wait(s->chunkDone);
+	}
+
+	/* Chunk isn't used by the background thread until submitted count is incremented */
+	chunk = &s->chunks[s->submitted % MAP_INFLATE_CHUNKS];
+	chunk->state  = m;
+	chunk->length = length;
+	Mem_Copy(chunk->data, data, length);
+
+	Mutex_Lock(s->mutex);
+	s->submitted++;
+	Mutex_Unlock(s->mutex);
+	Waitable_Signal(s->chunkAdded);
+	return 0;
+}
+
+static float MapInflater_Progress(void) {
+	struct MapInflaterState* s = &mapInflater;
+	int index, volume;
+	if (!s->thread) return !map_volume ? 0.0f : (float)map1.index / map_volume;
+
+	Mutex_Lock(s->mutex);
+	index  = s->index;
+	volume = s->volume;
+	Mutex_Unlock(s->mutex);
+	return !volume ? 0.0f : (float)index / volume;
+}
+
+static cc_result MapInflater_Finish(void) { return MapInflater_Stop(false); }
+static void MapInflater_Abort(void)       { MapInflater_Stop(true); }
+#else
+static void MapInflater_Start(void) { }
+static void MapInflater_Abort(void) { }
+static cc_result MapInflater_Finish(void) { return 0; }
+
+static cc_result MapInflater_Submit(struct MapState* m, cc_uint8* data, int length) {
+	return MapState_Inflate(m, data, length);
+}
+
+static float MapInflater_Progress(void) {
+	return !map_volume ? 0.0f : (float)map1.index / map_volume;
+}
+#endif
+
 
 /*########################################################################################################################*
 *----------------------------------------------------Classic protocol-----------------------------------------------------*
@@ -538,11 +716,13 @@ static void Classic_StartLoading(void) {
 	map_begunLoading = true;
 	map_receiveBeg   = Stopwatch_Measure();
 	map_volume       = 0;
+	map_inflateTime  = 0;
 
 	MapState_Init(&map1);
 #ifdef EXTENDED_BLOCKS
 	MapState_Init(&map2);
 #endif
+	MapInflater_Start();
 }
 
 static void Classic_LevelInit(cc_uint8* data) {
@@ -570,11 +750,6 @@ static void Classic_LevelDataChunk(cc_uint8* data) {
 	if (!map_begunLoading) Classic_StartLoading();
 	usedLength = Stream_GetU16_BE(data);
 
-	map_part.meta.mem.cur    = data + 2;
-	map_part.meta.mem.base   = data + 2;
-	map_part.meta.mem.left   = usedLength;
-	map_part.meta.mem.length = usedLength;
-
 #ifndef EXTENDED_BLOCKS
 	m = &map1;
 #else
@@ -586,33 +761,36 @@ static void Classic_LevelDataChunk(cc_uint8* data) {
 	}
 #endif
 
-	if (!m->gzHeader.done) {
-		res = GZipHeader_Read(&map_part, &m->gzHeader);
-		if (res && res != ERR_END_OF_STREAM) { DisconnectInvalidMap(res); return; }
-	}
-
-	if (m->gzHeader.done) {
-		res = MapState_Read(m);
-		if (res) { DisconnectInvalidMap(res); return; }
-	}
+	/* NOTE: Errors from decompressing on the background thread are only reported when later chunks are submitted */
+	res = MapInflater_Submit(m, data + 2, usedLength);
+	if (res) { DisconnectInvalidMap(res); return; }
 
-	progress = !map_volume ? 0.0f : (float)map1.index / map_volume;
+	progress = MapInflater_Progress();
 	Event_RaiseFloat(&WorldEvents.Loading, progress);
 }
 
 static void Classic_LevelFinalise(cc_uint8* data) {
 	int width, height, length, volume;
-	cc_uint64 end;
-	int delta;
+	int receiveTime, waitTime, inflateTime, setupTime;
+	cc_uint64 beg, end;
+	cc_result res;
+
+	/* Any remaining map data must finish being decompressed first */
+	beg = Stopwatch_Measure();
+	res = MapInflater_Finish();
+	end = Stopwatch_Measure();
 
-	end   = Stopwatch_Measure();
-	delta = Stopwatch_ElapsedMS(map_receiveBeg, end);
-	Platform_Log1("map loading took: %i", &delta);
+	receiveTime = Stopwatch_ElapsedMS(map_receiveBeg, beg);
+	waitTime    = Stopwatch_ElapsedMS(beg, end);
 	map_begunLoading = false;
 	WoM_CheckSendWomID();
+	if (res) { DisconnectInvalidMap(res); return; }
 
 #ifdef EXTENDED_BLOCKS
-	if (map2.allocFailed) FreeMapStates();
+	if (map2.allocFailed) {
+		Window_ShowDialog("Out of memory", "Not enough free memory to join that map.\nTry joining a different map.");
+		FreeMapStates();
+	}
 #endif
 
 	width  = Stream_GetU16_BE(data + 0);
@@ -621,6 +799,7 @@ static void Classic_LevelFinalise(cc_uint8* data) {
 	volume = width * height * length;
 
 	if (map1.allocFailed) {
+		Window_ShowDialog("Out of memory", "Not enough free memory to join that map.\nTry joining a different map.");
 		Chat_AddRaw("&cFailed to load map, try joining a different map");
 		Chat_AddRaw("   &cNot enough free memory to load the map");
 	} else if (!map1.blocks) {
@@ -645,6 +824,23 @@ static void Classic_LevelFinalise(cc_uint8* data) {
 #endif
 	World_SetNewMap(map1.blocks, width, height, length);
 	map1.blocks  = NULL;
+
+	setupTime   = Stopwatch_ElapsedMS(end, Stopwatch_Measure());
+	inflateTime = (int)(map_inflateTime / 1000);
+	Platform_Log4("map loading took: %i ms receiving, %i ms decompressing, %i ms waiting for decompression, %i ms setting up world",
+		&receiveTime, &inflateTime, &waitTime, &setupTime);
+}
+
+/* Consecutive SetBlock packets are applied together, as applying many block changes at once is much faster */
+#define SETBLOCK_MAX_BATCH 256
+static cc_int32 setBlock_indices[SETBLOCK_MAX_BATCH];
+static BlockID  setBlock_blocks[SETBLOCK_MAX_BATCH];
+static int setBlock_count;
+
+void Protocol_FlushBlockUpdates(void) {
+	if (!setBlock_count) return;
+	Game_UpdateBlocks(setBlock_indices, setBlock_blocks, setBlock_count);
+	setBlock_count = 0;
 }
 
 static void Classic_SetBlock(cc_uint8* data) {
@@ -657,9 +853,12 @@ static void Classic_SetBlock(cc_uint8* data) {
 	data += 6;
 
 	ReadBlock(data, block);
-	if (World_Contains(x, y, z)) {
-		Game_UpdateBlock(x, y, z, block);
-	}
+	if (!World_Contains(x, y, z)) return;
+
+	if (setBlock_count == SETBLOCK_MAX_BATCH) Protocol_FlushBlockUpdates();
+	setBlock_indices[setBlock_count] = World_Pack(x, y, z);
+	setBlock_blocks[setBlock_count]  = block;
+	setBlock_count++;
 }
 
 static void Classic_AddEntity(cc_uint8* data) {
@@ -1288,8 +1487,7 @@ static void CPE_ExtAddEntity2(cc_uint8* data) {
 static void CPE_BulkBlockUpdate(cc_uint8* data) {
 	cc_int32 indices[BULK_MAX_BLOCKS];
 	BlockID blocks[BULK_MAX_BLOCKS];
-	int index, i;
-	int x, y, z;
+	int index, i, valid;
 	int count = 1 + *data++;
 
 	for (i = 0; i < count; i++) {
@@ -1313,17 +1511,20 @@ static void CPE_BulkBlockUpdate(cc_uint8* data) {
 		data += BULK_MAX_BLOCKS / 4;
 	}
 
-	for (i = 0; i < count; i++) {
+	/* Remove any blocks outside the map */
+	for (i = 0, valid = 0; i < count; i++) {
 		index = indices[i];
 		if (index < 0 || index >= World.Volume) continue;
-		World_Unpack(index, x, y, z);
 
+		indices[valid] = index;
 #ifdef EXTENDED_BLOCKS
-		Game_UpdateBlock(x, y, z, blocks[i] % BLOCK_COUNT);
+		blocks[valid]  = blocks[i] % BLOCK_COUNT;
 #else
-		Game_UpdateBlock(x, y, z, blocks[i]);
+		blocks[valid]  = blocks[i];
 #endif
+		valid++;
 	}
+	Game_UpdateBlocks(indices, blocks, valid);
 }
 
 static void CPE_SetTextColor(cc_uint8* data) {
@@ -1590,8 +1791,9 @@ static void CPE_LightingMode(cc_uint8* data) {
 		return;
 	}
 	/* Convert from Network mode (0 = no change, 1 = classic, 2 = fancy) to client mode (0 = classic, 1 = fancy) */
+	/* (sky lighting mode is client only, as the LightingMode extension does not define it) */
 	mode--;
-	if (mode >= LIGHTING_MODE_COUNT) return;
+	if (mode > LIGHTING_MODE_FANCY) return;
 
 	if (!Lighting_ModeSetByServer) Lighting_ModeUserCached = Lighting_Mode;
 	Lighting_ModeLockedByServer = locked;
@@ -1817,12 +2019,6 @@ static void CustomModels_Reset(void) { }
 /*########################################################################################################################*
 *------------------------------------------------------Custom blocks------------------------------------------------------*
 *#########################################################################################################################*/
-static void BlockDefs_OnBlocksLightPropertyUpdated(BlockID block, cc_bool oldProp) {
-	if (!World.Loaded) return;
-	/* Need to refresh lighting when a block's light blocking state changes */
-	if (Blocks.BlocksLight[block] != oldProp) Lighting.Refresh();
-}
-
 static void BlockDefs_OnBrightnessPropertyUpdated(BlockID block, cc_uint8 oldProp) {
 	if (!World.Loaded) return;
 	if (Lighting_Mode == LIGHTING_MODE_CLASSIC) return;
@@ -1846,14 +2042,12 @@ static TextureLoc BlockDefs_Tex(cc_uint8** ptr) {
 static BlockID BlockDefs_DefineBlockCommonStart(cc_uint8** ptr, cc_bool uniqueSideTexs) {
 	cc_string name;
 	BlockID block;
-	cc_bool oldBlocksLight;
 	cc_uint8 oldBrightness;
 	float speedLog2;
 	cc_uint8 sound;
 	cc_uint8* data = *ptr;
 
 	ReadBlock(data, block);
-	oldBlocksLight = Blocks.BlocksLight[block];
 	oldBrightness = Blocks.Brightness[block];
 	Block_ResetProps(block);
 	
@@ -1875,8 +2069,8 @@ static BlockID BlockDefs_DefineBlockCommonStart(cc_uint8** ptr, cc_bool uniqueSi
 	}
 	Block_Tex(block, FACE_YMIN) = BlockDefs_Tex(&data);
 
+	/* Lighting is refreshed by BlockDefChanged when a block's light blocking state changes */
 	Blocks.BlocksLight[block] = *data++ == 0;
-	BlockDefs_OnBlocksLightPropertyUpdated(block, oldBlocksLight);
 
 	sound = *data++;
 	Blocks.StepSounds[block] = sound;
@@ -1915,13 +2109,8 @@ static void BlockDefs_DefineBlock(cc_uint8* data) {
 
 static void BlockDefs_UndefineBlock(cc_uint8* data) {
 	BlockID block;
-	cc_bool didBlockLight;
-
 	ReadBlock(data, block);
-	didBlockLight = Blocks.BlocksLight[block];
-
 	Block_UndefineCustom(block);
-	BlockDefs_OnBlocksLightPropertyUpdated(block, didBlockLight);
 }
 
 static void BlockDefs_DefineBlockExt(cc_uint8* data) {
@@ -1964,10 +2153,13 @@ static void Protocol_Reset(void) {
 
 void Protocol_Tick(void) {
 	cc_uint8 tmp[256];
-	cc_uint8* data = tmp;
+	cc_uint8* data;
+
+	/* Position is sent separately, so it can replace an older position still waiting to be sent */
+	data = Classic_Tick(tmp);
+	if (data != tmp) Server_SendPosition(tmp, (cc_uint32)(data - tmp));
 
-	data = Classic_Tick(data);
-	data = CPE_Tick(data);
+	data = CPE_Tick(tmp);
 	WoM_Tick();
 
 	/* Have any packets been written? */
@@ -1985,6 +2177,7 @@ static void OnReset(void) {
 	Mem_Set(&Protocol, 0, sizeof(Protocol));
 	Protocol_Reset();
 	FreeMapStates();
+	setBlock_count = 0;
 }
 #else
 void CPE_SendPlayerClick(int button, cc_bool pressed, cc_uint8 targetId, struct RayTracer* t) { }
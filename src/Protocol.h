@@ -71,6 +71,8 @@ struct IGameComponent;
 extern struct IGameComponent Protocol_Component;
 
 void Protocol_Tick(void);
+/* Applies any block changes from SetBlock packets that are still waiting to be applied */
+void Protocol_FlushBlockUpdates(void);
 
 extern cc_bool cpe_needD3Fix;
 void Classic_SendChat(const cc_string* text, cc_bool partial);
@@ -24,6 +24,8 @@
 #include "Options.h"
 #include "InputHandler.h"
 #include "Protocol.h"
+#include "Builder.h"
+#include "Lighting.h"
 
 #define CHAT_MAX_STATUS Array_Elems(Chat_Status)
 #define CHAT_MAX_BOTTOMRIGHT Array_Elems(Chat_BottomRight)
@@ -89,7 +91,8 @@ static struct HUDScreen {
 
 static void HUDScreen_RemakeLine1(struct HUDScreen* s) {
 	cc_string status; char statusBuffer[STRING_SIZE * 2];
-	int indices, ping, fps;
+	int indices, ping, fps, saved;
+	int buffered, latency;
 	float real_fps;
 
 	String_InitArray(status, statusBuffer);
@@ -114,12 +117,38 @@ static void HUDScreen_RemakeLine1(struct HUDScreen* s) {
 		if (Game.ChunkUpdates) {
 			String_Format1(&status, "%i chunks/s, ", &Game.ChunkUpdates);
 		}
+		if (Builder_PatchedChunks) {
+			String_Format1(&status, "%i patched/s, ", &Builder_PatchedChunks);
+		}
+		if (Builder_CachedChunks) {
+			String_Format1(&status, "%i cached/s, ", &Builder_CachedChunks);
+		}
+		if (FancyLighting_NodesProcessed) {
+			String_Format1(&status, "%i light nodes/s, ", &FancyLighting_NodesProcessed);
+		}
+		if (Builder_GreedyMeshing && Game.ChunkUpdates) {
+			saved = (Builder_UnmergedVertices - Builder_MeshVertices) / Game.ChunkUpdates;
+			String_Format1(&status, "%i verts saved/chunk, ", &saved);
+		}
 
 		indices = ICOUNT(Game_Vertices);
-		String_Format1(&status, "%i vertices", &indices);
+		String_Format2(&status, "%i vertices, %i draws", &indices, &Game_DrawCalls);
 
 		ping = Ping_AveragePingMS();
 		if (ping) String_Format1(&status, ", ping %i ms", &ping);
+
+		if (Net_BufferedBytes) {
+			buffered = Net_BufferedBytes / 1024;
+			String_Format1(&status, ", %i KB net buffered", &buffered);
+		}
+		if (Net_SendQueued) {
+			buffered = Net_SendQueued / 1024;
+			String_Format1(&status, ", %i KB net queued", &buffered);
+		}
+		if (Net_DispatchCount) {
+			latency = Net_DispatchLatency / Net_DispatchCount;
+			String_Format1(&status, ", %i us net dispatch", &latency);
+		}
 	}
 	TextWidget_Set(&s->line1, &status, &s->font);
 	s->dirty = true;
@@ -332,6 +361,13 @@ static void HUDScreen_UpdateFPS(struct HUDScreen* s, float delta) {
 	s->accumulator    = 0.0f;
 	s->frames         = 0;
 	Game.ChunkUpdates = 0;
+	Builder_MeshVertices     = 0;
+	Builder_UnmergedVertices = 0;
+	Builder_PatchedChunks    = 0;
+	Builder_CachedChunks     = 0;
+	FancyLighting_NodesProcessed = 0;
+	Net_DispatchLatency = 0;
+	Net_DispatchCount   = 0;
 }
 
 static void HUDScreen_Update(void* screen, float delta) {
@@ -25,6 +25,9 @@
 #include "Input.h"
 #include "Errors.h"
 #include "Options.h"
+#include "Stream.h"
+#include "Utils.h"
+#include "Window.h"
 
 static char nameBuffer[STRING_SIZE];
 static char motdBuffer[STRING_SIZE];
@@ -233,6 +236,11 @@ static void SPConnection_Init(void) {
 static cc_socket net_socket = -1;
 static cc_result net_writeFailure;
 static void OnClose(void);
+int Net_BufferedBytes, Net_SendQueued;
+int Net_DispatchLatency, Net_DispatchCount;
+static char replayBuffer[FILENAME_SIZE];
+cc_string Replay_Path = String_FromArray(replayBuffer);
+cc_bool Replay_RealTime;
 
 #ifdef CC_BUILD_NETWORKING
 static cc_uint8  net_readBuffer[4096 * 5];
@@ -244,6 +252,331 @@ static cc_bool net_connecting;
 static float net_connectElapsed;
 #define NET_TIMEOUT_SECS 15
 
+#ifdef CC_BUILD_NETTHREAD
+#if defined __GNUC__
+#define NetRecv_Barrier() __sync_synchronize()
+#else
+#include <intrin.h>
+/* x86 doesn't reorder stores with other stores, so only the compiler needs to be stopped from doing so */
+#define NetRecv_Barrier() _ReadWriteBarrier()
+#endif
+
+/* Received data is written into a single producer/single consumer ring by the receive thread, */
+/*  which the game thread then dispatches to packet handlers from without needing any locks */
+#define NET_RING_SIZE (512 * 1024) /* must be a power of two */
+#define NET_RING_MASK (NET_RING_SIZE - 1)
+static cc_uint8 net_ring[NET_RING_SIZE];
+/* Total number of bytes written to/read from the ring. Only changed by receive/game thread respectively */
+static volatile cc_uint32 net_ringHead, net_ringTail;
+
+/* Time each receive completed at, for measuring how long data waits before being dispatched */
+#define NET_STAMPS_SIZE 256
+static struct NetRecvStamp { cc_uint32 end; cc_uint64 time; } net_stamps[NET_STAMPS_SIZE];
+static volatile cc_uint32 net_stampsHead, net_stampsTail;
+
+static void* net_recvThread;
+static void* net_recvWaitable;
+static volatile cc_bool net_recvStop;
+static volatile cc_result net_recvError;
+/* Whether the socket has returned 0 bytes from a read, which usually means it was closed */
+static volatile cc_bool net_recvEmpty;
+
+static void NetRecv_Stamp(cc_uint32 end) {
+	cc_uint32 head = net_stampsHead;
+	struct NetRecvStamp* stamp;
+	/* When game thread is far behind, later receives just get measured with the next stamp */
+	if (head - net_stampsTail >= NET_STAMPS_SIZE) return;
+
+	stamp = &net_stamps[head & (NET_STAMPS_SIZE - 1)];
+	stamp->end  = end;
+	stamp->time = Stopwatch_Measure();
+
+	NetRecv_Barrier();
+	net_stampsHead = head + 1;
+}
+
+static void NetRecv_Loop(void) {
+	cc_uint32 head = net_ringHead, space, read;
+	cc_bool readable;
+	cc_result res;
+
+	while (!net_recvStop) {
+		/* When ring is full, wait for game thread to dispatch some of the data */
+		space = NET_RING_SIZE - (head - net_ringTail);
+		if (!space) { Waitable_WaitFor(net_recvWaitable, 100); continue; }
+
+		res = Socket_WaitReadable(net_socket, 100, &readable);
+		if (res) { net_recvError = res; return; }
+		if (!readable) continue;
+
+		/* Only read up to end of the ring, the rest is read into start of the ring next time around */
+		space = min(space, NET_RING_SIZE - (head & NET_RING_MASK));
+		res   = Socket_Read(net_socket, &net_ring[head & NET_RING_MASK], space, &read);
+
+		if (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock) continue;
+		if (res) { net_recvError = res; return; }
+
+		if (!read) {
+			/* Closed sockets are always readable, so avoid spinning */
+			net_recvEmpty = true;
+			Waitable_WaitFor(net_recvWaitable, 100);
+			continue;
+		}
+
+		/* Data must be visible to game thread before the head that covers it */
+		NetRecv_Barrier();
+		head += read;
+		net_ringHead = head;
+		NetRecv_Stamp(head);
+	}
+}
+
+static void NetRecv_Start(void) {
+	net_ringHead   = 0; net_ringTail   = 0;
+	net_stampsHead = 0; net_stampsTail = 0;
+	net_recvStop   = false;
+	net_recvError  = 0;
+	net_recvEmpty  = false;
+
+	if (!net_recvWaitable) net_recvWaitable = Waitable_Create("Network receive");
+	Thread_Run(&net_recvThread, NetRecv_Loop, 64 * 1024, "Network receive");
+}
+
+static void NetRecv_Stop(void) {
+	if (!net_recvThread) return;
+	net_recvStop = true;
+	Waitable_Signal(net_recvWaitable);
+
+	Thread_Join(net_recvThread);
+	net_recvThread = NULL;
+}
+
+static void NetRecv_MeasureLatency(cc_uint32 tail) {
+	cc_uint64 now = Stopwatch_Measure();
+	cc_uint32 head;
+	struct NetRecvStamp* stamp;
+
+	for (head = net_stampsHead; net_stampsTail != head; net_stampsTail++) 
+	{
+		NetRecv_Barrier();
+		stamp = &net_stamps[net_stampsTail & (NET_STAMPS_SIZE - 1)];
+		/* Only part of the data from this receive has been dispatched so far */
+		if ((int)(stamp->end - tail) > 0) break;
+
+		Net_DispatchLatency += (int)Stopwatch_ElapsedMicroseconds(stamp->time, now);
+		Net_DispatchCount++;
+	}
+}
+
+/* Copies up to count bytes of data from the receive ring */
+static cc_result MPConnection_Read(cc_uint8* data, cc_uint32 count, cc_uint32* read) {
+	cc_uint32 tail  = net_ringTail;
+	cc_uint32 avail = net_ringHead - tail;
+	cc_uint32 offset, part;
+	*read = 0;
+
+	if (!avail) {
+		if (net_recvError) return net_recvError;
+		return net_recvEmpty ? 0 : ReturnCode_SocketWouldBlock;
+	}
+	/* Data covered by the head must only be read after the head itself */
+	NetRecv_Barrier();
+
+	count  = min(count, avail);
+	offset = tail & NET_RING_MASK;
+	part   = min(count, NET_RING_SIZE - offset);
+
+	Mem_Copy(data, &net_ring[offset], part);
+	Mem_Copy(data + part, net_ring, count - part);
+
+	/* Data must be fully copied out before receive thread can overwrite it */
+	NetRecv_Barrier();
+	tail += count;
+	net_ringTail = tail;
+
+	Net_BufferedBytes = (int)(net_ringHead - tail);
+	NetRecv_MeasureLatency(tail);
+	if (avail == NET_RING_SIZE) Waitable_Signal(net_recvWaitable);
+
+	*read = count;
+	return 0;
+}
+#else
+static void NetRecv_Start(void) { }
+static void NetRecv_Stop(void)  { }
+
+static cc_result MPConnection_Read(cc_uint8* data, cc_uint32 count, cc_uint32* read) {
+	return Socket_Read(net_socket, data, count, read);
+}
+#endif
+
+/*########################################################################################################################*
+*----------------------------------------------------Session recording----------------------------------------------------*
+*#########################################################################################################################*/
+/* Replay files contain all the data received from a server, so the session can be played back later */
+/* Format: "CCREPLAY", version byte, then [milliseconds since connecting (u32 BE)][length (u32 BE)][data] for each read */
+#define REPLAY_VERSION 1
+static const cc_uint8 replay_identifier[8] = { 'C','C','R','E','P','L','A','Y' };
+/* When recording or playing back started */
+static cc_uint64 replay_beg;
+static struct Stream record_stream;
+static cc_bool record_active;
+
+static void NetRecord_Start(void) {
+	cc_string path; char pathBuffer[FILENAME_SIZE];
+	struct cc_datetime now;
+	cc_uint8 header[9];
+	cc_result res;
+	if (!Options_GetBool(OPT_NET_RECORD, false)) return;
+	if (!Utils_EnsureDirectory("replays")) return;
+
+	DateTime_CurrentLocal(&now);
+	String_InitArray(path, pathBuffer);
+	String_Format3(&path, "replays/replay_%p4-%p2-%p2", &now.year, &now.month, &now.day);
+	String_Format3(&path, "-%p2-%p2-%p2.ccreplay", &now.hour, &now.minute, &now.second);
+
+	res = Stream_CreateFile(&record_stream, &path);
+	if (res) { Logger_SysWarn2(res, "creating", &path); return; }
+
+	Mem_Copy(header, replay_identifier, 8);
+	header[8] = REPLAY_VERSION;
+
+	res = Stream_Write(&record_stream, header, sizeof(header));
+	if (res) {
+		Logger_SysWarn2(res, "writing", &path);
+		record_stream.Close(&record_stream); return;
+	}
+
+	record_active = true;
+	replay_beg    = Stopwatch_Measure();
+	Chat_Add1("&eRecording session to %s", &path);
+}
+
+static void NetRecord_Stop(void) {
+	cc_result res;
+	if (!record_active) return;
+	record_active = false;
+
+	res = record_stream.Close(&record_stream);
+	if (res) Logger_SysWarn(res, "closing replay");
+}
+
+static void NetRecord_Write(const cc_uint8* data, cc_uint32 len) {
+	cc_uint8 header[8];
+	cc_uint32 time;
+	cc_result res;
+	if (!record_active) return;
+
+	time = (cc_uint32)Stopwatch_ElapsedMS(replay_beg, Stopwatch_Measure());
+	Stream_SetU32_BE(header + 0, time);
+	Stream_SetU32_BE(header + 4, len);
+
+	res = Stream_Write(&record_stream, header, sizeof(header));
+	if (!res) res = Stream_Write(&record_stream, data, len);
+	if (!res) return;
+
+	Logger_SysWarn(res, "writing replay");
+	NetRecord_Stop();
+}
+
+
+/*########################################################################################################################*
+*--------------------------------------------------------Send queue-------------------------------------------------------*
+*#########################################################################################################################*/
+/* Data that couldn't be written to the socket without blocking, which is sent in later ticks instead */
+#define NET_SEND_MAX_QUEUED (4 * 1024 * 1024)
+static cc_uint8* net_sendQueue;
+static cc_uint32 net_sendCapacity;
+static double net_lastSent;
+/* Offset in the queue of the position packet that hasn't been sent yet, or -1 if there isn't one */
+static int net_positionOffset = -1;
+static cc_uint32 net_positionLen;
+
+static void NetSend_Reset(void) {
+	Net_SendQueued     = 0;
+	net_positionOffset = -1;
+}
+
+static void NetSend_Free(void) {
+	NetSend_Reset();
+	Mem_Free(net_sendQueue);
+	net_sendQueue    = NULL;
+	net_sendCapacity = 0;
+}
+
+/* Adds data to the end of the queue, returning its offset in the queue (or -1 on failure) */
+static int NetSend_Enqueue(const cc_uint8* data, cc_uint32 len) {
+	cc_uint32 needed = Net_SendQueued + len, capacity;
+	cc_uint8* queue;
+	int offset;
+
+	if (needed > net_sendCapacity) {
+		/* Server hasn't been accepting any data for a long time, so connection is probably dead */
+		if (needed > NET_SEND_MAX_QUEUED) { net_writeFailure = ERR_OUT_OF_MEMORY; return -1; }
+
+		capacity = max(needed, max(net_sendCapacity * 2, 4096));
+		queue    = (cc_uint8*)Mem_TryRealloc(net_sendQueue, capacity, 1);
+		if (!queue) { net_writeFailure = ERR_OUT_OF_MEMORY; return -1; }
+
+		net_sendQueue    = queue;
+		net_sendCapacity = capacity;
+	}
+
+	offset = Net_SendQueued;
+	Mem_Copy(net_sendQueue + offset, data, len);
+	Net_SendQueued += len;
+	return offset;
+}
+
+/* Writes as much data to the socket as possible without blocking, returning number of bytes written */
+static cc_uint32 NetSend_WriteSocket(const cc_uint8* data, cc_uint32 len) {
+	cc_uint32 wrote, total = 0;
+	cc_result res;
+
+	while (total < len) {
+		res = Socket_Write(net_socket, data + total, len - total, &wrote);
+		if (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock) break;
+
+		/* NOTE: Not immediately disconnecting here, as otherwise we sometimes miss out on kick messages */
+		if (res)    { net_writeFailure = res;                  break; }
+		if (!wrote) { net_writeFailure = ERR_INVALID_ARGUMENT; break; }
+		total += wrote;
+	}
+
+	if (total) net_lastSent = Game.Time;
+	return total;
+}
+
+static void NetSend_Flush(void) {
+	cc_uint32 sent;
+	if (!Net_SendQueued) return;
+
+	sent = NetSend_WriteSocket(net_sendQueue, Net_SendQueued);
+	if (!sent) return;
+
+	Net_SendQueued -= sent;
+	Mem_Move(net_sendQueue, net_sendQueue + sent, Net_SendQueued);
+	/* Position packet can't be replaced anymore once any of it has been sent */
+	net_positionOffset = net_positionOffset >= (int)sent ? net_positionOffset - (int)sent : -1;
+}
+
+/* Sends data to the server, queueing whatever can't be sent right now without blocking */
+/* Returns the offset in the queue the data was entirely queued at, or -1 if any of it was sent */
+static int NetSend_Write(const cc_uint8* data, cc_uint32 len) {
+	cc_uint32 sent;
+	if (Server.Disconnected) return -1;
+
+	/* Data must arrive in order, so can only write directly when nothing is still waiting to be sent */
+	NetSend_Flush();
+	if (Net_SendQueued) return NetSend_Enqueue(data, len);
+
+	sent = NetSend_WriteSocket(data, len);
+	if (sent == len || net_writeFailure) return -1;
+
+	if (sent) { NetSend_Enqueue(data + sent, len - sent); return -1; }
+	return NetSend_Enqueue(data, len);
+}
+
 static void MPConnection_FinishConnect(void) {
 	net_connecting = false;
 	Event_RaiseVoid(&NetEvents.Connected);
@@ -251,6 +584,10 @@ static void MPConnection_FinishConnect(void) {
 
 	net_readCurrent = net_readBuffer;
 	net_lastPacket  = Game.Time;
+	net_lastSent    = Game.Time;
+	NetSend_Reset();
+	NetRecv_Start();
+	NetRecord_Start();
 	Classic_SendLogin();
 }
 
@@ -293,6 +630,16 @@ static void MPConnection_TickConnect(struct ScheduledTask* task) {
 	}
 }
 
+/* Default block permissions (in case server supports SetBlockPermissions but doesn't send) */
+static void MPConnection_ResetPermissions(void) {
+	Blocks.CanPlace[BLOCK_AIR] = false;
+	Blocks.CanPlace[BLOCK_LAVA] = false;        Blocks.CanDelete[BLOCK_LAVA] = false;
+	Blocks.CanPlace[BLOCK_WATER] = false;       Blocks.CanDelete[BLOCK_WATER] = false;
+	Blocks.CanPlace[BLOCK_STILL_LAVA] = false;  Blocks.CanDelete[BLOCK_STILL_LAVA] = false;
+	Blocks.CanPlace[BLOCK_STILL_WATER] = false; Blocks.CanDelete[BLOCK_STILL_WATER] = false;
+	Blocks.CanPlace[BLOCK_BEDROCK] = false;     Blocks.CanDelete[BLOCK_BEDROCK] = false;
+}
+
 static void MPConnection_BeginConnect(void) {
 	static const cc_string invalid_reason = String_FromConst("Invalid IP address");
 	cc_string title; char titleBuffer[STRING_SIZE];
@@ -300,15 +647,8 @@ static void MPConnection_BeginConnect(void) {
 	int numValidAddrs;
 	cc_result res;
 	String_InitArray(title, titleBuffer);
+	MPConnection_ResetPermissions();
 
-	/* Default block permissions (in case server supports SetBlockPermissions but doesn't send) */
-	Blocks.CanPlace[BLOCK_AIR] = false;
-	Blocks.CanPlace[BLOCK_LAVA] = false;        Blocks.CanDelete[BLOCK_LAVA] = false;
-	Blocks.CanPlace[BLOCK_WATER] = false;       Blocks.CanDelete[BLOCK_WATER] = false;
-	Blocks.CanPlace[BLOCK_STILL_LAVA] = false;  Blocks.CanDelete[BLOCK_STILL_LAVA] = false;
-	Blocks.CanPlace[BLOCK_STILL_WATER] = false; Blocks.CanDelete[BLOCK_STILL_WATER] = false;
-	Blocks.CanPlace[BLOCK_BEDROCK] = false;     Blocks.CanDelete[BLOCK_BEDROCK] = false;
-	
 	res = Socket_ParseAddress(&Server.Address, Server.Port, addrs, &numValidAddrs);
 	if (res == ERR_INVALID_ARGUMENT) {
 		MPConnection_Fail(&invalid_reason); return;
@@ -377,65 +717,94 @@ static void DisconnectInvalidOpcode(cc_uint8 opcode) {
 	Game_Disconnect(&title, &tmp); return;
 }
 
-static void MPConnection_Tick(struct ScheduledTask* task) {
+/* Dispatches all complete packets in the read buffer to their handlers */
+static cc_bool MPConnection_Dispatch(cc_uint8* readEnd) {
+	cc_uint8* readCur = net_readBuffer;
 	Net_Handler handler;
-	cc_uint8* readEnd;
-	cc_uint8* readCur;
-	cc_uint32 read;
 	int i, remaining;
-	cc_result res;
 
-	if (Server.Disconnected) return;
-	if (net_connecting) { MPConnection_TickConnect(task); return; }
+	while (readCur < readEnd) {
+		cc_uint8 opcode = readCur[0];
 
-	/* NOTE: using a read call that is a multiple of 4096 (appears to?) improve read performance */	
-	res = Socket_Read(net_socket, net_readCurrent, 4096 * 4, &read);
-	
-	if (res) {
-		/* 'no data available for non-blocking read' is an expected error */
-		if (res == ReturnCode_SocketInProgess)  res = 0;
-		if (res == ReturnCode_SocketWouldBlock) res = 0;
-
-		if (res) { DisconnectReadFailed(res); return; }
-	} else if (read == 0) {
-		/* recv only returns 0 read when socket is closed.. probably? */
-		/* Over 30 seconds since last packet, connection probably dropped */
-		/* TODO: Should this be checked unconditonally instead of just when read = 0 ? */
-		if (net_lastPacket + 30 < Game.Time) { MPConnection_Disconnect(); return; }
-	} else {
-		readCur        = net_readBuffer;
-		readEnd        = net_readCurrent + read;
-		net_lastPacket = Game.Time;
+		/* Workaround for older D3 servers which wrote one byte too many for HackControl packets */
+		if (cpe_needD3Fix && lastOpcode == OPCODE_HACK_CONTROL && (opcode == 0x00 || opcode == 0xFF)) {
+			Platform_LogConst("Skipping invalid HackControl byte from D3 server");
+			readCur++;
+			LocalPlayer_ResetJumpVelocity(Entities.CurPlayer);
+			continue;
+		}
 
-		while (readCur < readEnd) {
-			cc_uint8 opcode = readCur[0];
+		if (readCur + Protocol.Sizes[opcode] > readEnd) break;
+		handler = Protocol.Handlers[opcode];
+		if (!handler) { DisconnectInvalidOpcode(opcode); return false; }
 
-			/* Workaround for older D3 servers which wrote one byte too many for HackControl packets */
-			if (cpe_needD3Fix && lastOpcode == OPCODE_HACK_CONTROL && (opcode == 0x00 || opcode == 0xFF)) {
-				Platform_LogConst("Skipping invalid HackControl byte from D3 server");
-				readCur++;
-				LocalPlayer_ResetJumpVelocity(Entities.CurPlayer);
-				continue;
-			}
+		lastOpcode = opcode;
+		/* SetBlock packets are batched, so those must be applied before any other packet is handled */
+		if (opcode != OPCODE_SET_BLOCK) Protocol_FlushBlockUpdates();
 
-			if (readCur + Protocol.Sizes[opcode] > readEnd) break;
-			handler = Protocol.Handlers[opcode];
-			if (!handler) { DisconnectInvalidOpcode(opcode); return; }
+		handler(readCur + 1); /* skip opcode */
+		readCur += Protocol.Sizes[opcode];
+	}
+	Protocol_FlushBlockUpdates();
 
-			lastOpcode = opcode;
-			handler(readCur + 1); /* skip opcode */
-			readCur += Protocol.Sizes[opcode];
-		}
+	/* Protocol packets might be split up across TCP packets */
+	/* If so, copy last few unprocessed bytes back to beginning of buffer */
+	/* These bytes are then later combined with subsequently read TCP packet data */
+	remaining = (int)(readEnd - readCur);
+	for (i = 0; i < remaining; i++) 
+	{
+		net_readBuffer[i] = readCur[i];
+	}
+	net_readCurrent = net_readBuffer + remaining;
+	return true;
+}
+
+static void MPConnection_Tick(struct ScheduledTask* task) {
+	cc_uint32 read, total = 0;
+	cc_result res;
+
+	if (Server.Disconnected) return;
+	if (net_connecting) { MPConnection_TickConnect(task); return; }
 
-		/* Protocol packets might be split up across TCP packets */
-		/* If so, copy last few unprocessed bytes back to beginning of buffer */
-		/* These bytes are then later combined with subsequently read TCP packet data */
-		remaining = (int)(readEnd - readCur);
-		for (i = 0; i < remaining; i++) 
-		{
-			net_readBuffer[i] = readCur[i];
+	NetSend_Flush();
+	/* Over 30 seconds since server accepted any data, connection probably dropped */
+	if (Net_SendQueued && net_lastSent + 30 < Game.Time) {
+		net_writeFailure = ReturnCode_SocketWouldBlock;
+	}
+
+	for (;;) {
+		/* NOTE: using a read call that is a multiple of 4096 (appears to?) improve read performance */	
+		res = MPConnection_Read(net_readCurrent, 4096 * 4, &read);
+	
+		if (res) {
+			/* 'no data available for non-blocking read' is an expected error */
+			if (res == ReturnCode_SocketInProgess)  res = 0;
+			if (res == ReturnCode_SocketWouldBlock) res = 0;
+
+			if (res) { DisconnectReadFailed(res); return; }
+			break;
+		} else if (read == 0) {
+			/* recv only returns 0 read when socket is closed.. probably? */
+			/* Over 30 seconds since last packet, connection probably dropped */
+			/* TODO: Should this be checked unconditonally instead of just when read = 0 ? */
+			if (net_lastPacket + 30 < Game.Time) { MPConnection_Disconnect(); return; }
+			break;
 		}
-		net_readCurrent = net_readBuffer + remaining;
+
+		net_lastPacket = Game.Time;
+		NetRecord_Write(net_readCurrent, read);
+		if (!MPConnection_Dispatch(net_readCurrent + read)) return;
+		if (Server.Disconnected) return;
+		total += read;
+
+#ifdef CC_BUILD_NETTHREAD
+		/* Keep dispatching until everything received so far has been handled, */
+		/*  but still give the rest of the game a chance to run during huge floods */
+		if (total >= NET_RING_SIZE) break;
+#else
+		/* Only read from the socket once per tick */
+		break;
+#endif
 	}
 
 	if (net_writeFailure) {
@@ -451,27 +820,21 @@ static void MPConnection_Tick(struct ScheduledTask* task) {
 }
 
 static void MPConnection_SendData(const cc_uint8* data, cc_uint32 len) {
-	cc_uint32 wrote;
-	cc_result res;
-	int tries = 0;
-	if (Server.Disconnected) return;
-
-	while (len) {
-		res = Socket_Write(net_socket, data, len, &wrote);
-		/* If sending would block (send buffer full), retry for a bit up to 10 seconds */
-		/* TODO: Avoid doing this and manually buffer data when this happens */
-		if (res && tries < 1000 && (res == ReturnCode_SocketInProgess || res == ReturnCode_SocketWouldBlock)) {
-			Thread_Sleep(10);
-			tries++;
-			continue;
-		}
-
-		/* NOTE: Not immediately disconnecting here, as otherwise we sometimes miss out on kick messages */
-		if (res)    { net_writeFailure = res;                  return; }
-		if (!wrote) { net_writeFailure = ERR_INVALID_ARGUMENT; return; }
+	NetSend_Write(data, len);
+}
 
-		data += wrote; len -= wrote;
+static void MPConnection_SendPosition(const cc_uint8* data, cc_uint32 len) {
+	/* Previous position is out of date now, so just replace it if it's still waiting to be sent */
+	/* (but only when nothing else was queued after it, as otherwise the server would receive */
+	/*  the new position before actions the player performed at the old position) */
+	if (net_positionOffset >= 0 && net_positionLen == len
+		&& net_positionOffset + (int)len == Net_SendQueued) {
+		Mem_Copy(net_sendQueue + net_positionOffset, data, len);
+		return;
 	}
+
+	net_positionOffset = NetSend_Write(data, len);
+	net_positionLen    = len;
 }
 
 static void MPConnection_Init(void) {
@@ -485,9 +848,163 @@ static void MPConnection_Init(void) {
 	Server.SendData     = MPConnection_SendData;
 	net_readCurrent     = net_readBuffer;
 }
+
+
+/*########################################################################################################################*
+*----------------------------------------------------Replay connection----------------------------------------------------*
+*#########################################################################################################################*/
+/* Plays back a recorded session, by dispatching the recorded data to packet handlers instead of reading from a socket */
+/* Since nothing is actually sent or received, this doubles as an offline benchmark of packet handling */
+/* Maximum amount of recorded data dispatched per tick, when playing back as fast as possible */
+#define REPLAY_FAST_BYTES (1024 * 1024)
+static struct Stream replay_file, replay_stream;
+static cc_uint8 replay_buffer[16384];
+static cc_bool replay_active, replay_hasNext;
+/* Time and length of the next recorded data to dispatch */
+static cc_uint32 replay_time, replay_len;
+static cc_uint64 replay_dispatchTime, replay_bytes;
+
+static void ReplayConnection_Close(void) {
+	if (!replay_active) return;
+	replay_active = false;
+	replay_file.Close(&replay_file);
+}
+
+static void ReplayConnection_Fail(const char* action, cc_result res) {
+	static const cc_string title = String_FromConst("Failed to play back replay");
+	cc_string msg; char msgBuffer[STRING_SIZE * 2];
+	String_InitArray(msg, msgBuffer);
+
+	String_Format3(&msg, "Error %c %s: %e", action, &Replay_Path, &res);
+	Platform_Log(msg.buffer, msg.length);
+	Game_Disconnect(&title, &msg);
+
+	/* Don't leave a benchmark waiting forever on the disconnected screen */
+	if (!Replay_RealTime) Window_RequestClose();
+}
+
+/* Reads the header of the next recorded data, if there is any left */
+static cc_result ReplayConnection_ReadNext(void) {
+	cc_uint8 header[8];
+	cc_result res = Stream_Read(&replay_stream, header, sizeof(header));
+
+	/* Recording may have been cut short by the game exiting, so a truncated header just counts as the end */
+	replay_hasNext = res == 0;
+	if (res == ERR_END_OF_STREAM) return 0;
+	if (res) return res;
+
+	replay_time = Stream_GetU32_BE(header + 0);
+	replay_len  = Stream_GetU32_BE(header + 4);
+	return 0;
+}
+
+static void ReplayConnection_Finish(void) {
+	int elapsed  = Stopwatch_ElapsedMS(replay_beg, Stopwatch_Measure());
+	int dispatch = (int)(replay_dispatchTime / 1000);
+	int size     = (int)(replay_bytes / 1024);
+
+	Platform_Log3("replay finished: %i KB played back in %i ms, %i ms handling packets", &size, &elapsed, &dispatch);
+	ReplayConnection_Close();
+
+	/* Playing back as fast as possible is for benchmarking, so exit once done */
+	if (Replay_RealTime) {
+		Chat_AddRaw("&eReplay finished");
+	} else {
+		Window_RequestClose();
+	}
+}
+
+static void ReplayConnection_BeginConnect(void) {
+	cc_uint8 header[9];
+	cc_result res;
+	MPConnection_ResetPermissions();
+
+	res = Stream_OpenFile(&replay_file, &Replay_Path);
+	if (res) { ReplayConnection_Fail("opening", res); return; }
+
+	Stream_ReadonlyBuffered(&replay_stream, &replay_file, replay_buffer, sizeof(replay_buffer));
+	replay_active       = true;
+	Server.Disconnected = false;
+
+	res = Stream_Read(&replay_stream, header, sizeof(header));
+	if (!res && !Mem_Equal(header, replay_identifier, 8)) res = REPLAY_ERR_IDENTIFIER;
+	if (!res && header[8] != REPLAY_VERSION)             res = REPLAY_ERR_VERSION;
+	if (!res) res = ReplayConnection_ReadNext();
+	if (res) { ReplayConnection_Fail("reading", res); return; }
+
+	Event_RaiseVoid(&NetEvents.Connected);
+	Event_RaiseFloat(&WorldEvents.Loading, 0.0f);
+
+	net_readCurrent     = net_readBuffer;
+	replay_beg          = Stopwatch_Measure();
+	replay_dispatchTime = 0;
+	replay_bytes        = 0;
+}
+
+static void ReplayConnection_Tick(struct ScheduledTask* task) {
+	cc_uint32 space, total = 0;
+	cc_uint64 beg;
+	cc_result res;
+	int elapsed;
+	if (Server.Disconnected || !replay_active) return;
+	elapsed = Stopwatch_ElapsedMS(replay_beg, Stopwatch_Measure());
+
+	while (replay_hasNext) {
+		if (Replay_RealTime && replay_time > (cc_uint32)elapsed) return;
+		if (!Replay_RealTime && total >= REPLAY_FAST_BYTES)      return;
+
+		/* Recorded data was read into the same buffer, so should always fit */
+		space = (cc_uint32)(net_readBuffer + sizeof(net_readBuffer) - net_readCurrent);
+		res   = replay_len > space ? REPLAY_ERR_DATA_SIZE : Stream_Read(&replay_stream, net_readCurrent, replay_len);
+		if (res) { ReplayConnection_Fail("reading", res); return; }
+
+		beg = Stopwatch_Measure();
+		if (!MPConnection_Dispatch(net_readCurrent + replay_len)) return;
+		replay_dispatchTime += Stopwatch_ElapsedMicroseconds(beg, Stopwatch_Measure());
+		if (Server.Disconnected) return;
+
+		replay_bytes += replay_len;
+		total        += replay_len;
+
+		res = ReplayConnection_ReadNext();
+		if (res) { ReplayConnection_Fail("reading", res); return; }
+	}
+	ReplayConnection_Finish();
+}
+
+static void ReplayConnection_SendBlock(int x, int y, int z, BlockID old, BlockID now) { }
+static void ReplayConnection_SendChat(const cc_string* text) { }
+static void ReplayConnection_SendData(const cc_uint8* data, cc_uint32 len) { }
+
+static void ReplayConnection_Init(void) {
+	MPConnection_Init();
+	Server.BeginConnect = ReplayConnection_BeginConnect;
+	Server.Tick         = ReplayConnection_Tick;
+	Server.SendBlock    = ReplayConnection_SendBlock;
+	Server.SendChat     = ReplayConnection_SendChat;
+	Server.SendData     = ReplayConnection_SendData;
+}
+
+static void MPConnection_Close(void) {
+	NetRecord_Stop();
+	if (replay_active) { ReplayConnection_Close(); return; }
+
+	NetRecv_Stop();
+	Socket_Close(net_socket);
+}
 #else
-static void MPConnection_Init(void) { SPConnection_Init(); }
+static void MPConnection_Init(void)     { SPConnection_Init(); }
+static void ReplayConnection_Init(void) { SPConnection_Init(); }
+static void MPConnection_Close(void) { }
+static void NetSend_Free(void) { }
+#endif
+
+void Server_SendPosition(const cc_uint8* data, cc_uint32 len) {
+#ifdef CC_BUILD_NETWORKING
+	if (Server.SendData == MPConnection_SendData) { MPConnection_SendPosition(data, len); return; }
 #endif
+	Server.SendData(data, len);
+}
 
 
 /*########################################################################################################################*
@@ -509,7 +1026,9 @@ static void OnInit(void) {
 	String_InitArray(Server.MOTD,    motdBuffer);
 	String_InitArray(Server.AppName, appBuffer);
 
-	if (!Server.Address.length) {
+	if (Replay_Path.length) {
+		ReplayConnection_Init();
+	} else if (!Server.Address.length) {
 		SPConnection_Init();
 	} else {
 		MPConnection_Init();
@@ -535,6 +1054,7 @@ static void OnReset(void) {
 static void OnFree(void) {
 	Server.Address.length = 0;
 	OnClose();
+	NetSend_Free();
 }
 
 static void OnClose(void) {
@@ -544,7 +1064,7 @@ static void OnClose(void) {
 		Ping_Reset();
 		if (Server.Disconnected) return;
 
-		Socket_Close(net_socket);
+		MPConnection_Close();
 		Server.Disconnected = true;
 	}
 }
@@ -18,6 +18,17 @@ int Ping_NextPingId(void);
 void Ping_Update(int id);
 /* Calculates average ping time based on most recent ping entries */
 int Ping_AveragePingMS(void);
+/* Sends a position update packet to the server */
+/* NOTE: If the previous position update is still waiting to be sent, it is replaced instead */
+void Server_SendPosition(const cc_uint8* data, cc_uint32 len);
+
+/* Number of bytes received from the server that are still waiting to be dispatched */
+extern int Net_BufferedBytes;
+/* Number of bytes waiting to be sent to the server, because the server isn't accepting data fast enough */
+extern int Net_SendQueued;
+/* Total microseconds that received data waited before being dispatched, and number of receives measured */
+/* NOTE: Only measured when data is received on a dedicated thread */
+extern int Net_DispatchLatency, Net_DispatchCount;
 
 /* Data for currently active connection to a server */
 CC_VAR extern struct _ServerConnectionData {
@@ -76,6 +87,10 @@ void Server_RetrieveTexturePack(const cc_string* url);
 
 /* Path of map to automatically load in singleplayer */
 extern cc_string SP_AutoloadMap;
+/* Path of recorded session to play back, instead of connecting to a server */
+extern cc_string Replay_Path;
+/* Whether to play back the recorded session in real time, instead of as fast as possible */
+extern cc_bool Replay_RealTime;
 
 CC_END_HEADER
 #endif
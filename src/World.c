@@ -10,9 +10,19 @@
 #include "Game.h"
 #include "TexturePack.h"
 #include "Window.h"
+#include "Lighting.h"
+#include "Builder.h"
+#include "Errors.h"
 
 struct _WorldData World;
 static char nameBuffer[STRING_SIZE];
+#ifdef CC_BUILD_MMAP
+static cc_uint8* mapped_data;
+static cc_uint32 mapped_len;
+#define World_IsMapped(blocks) ((blocks) >= mapped_data && (blocks) < mapped_data + mapped_len)
+#else
+#define World_IsMapped(blocks) false
+#endif
 /*########################################################################################################################*
 *----------------------------------------------------------World----------------------------------------------------------*
 *#########################################################################################################################*/
@@ -38,13 +48,20 @@ static void GenerateNewUuid(void) {
 }
 
 void World_Reset(void) {
+	Lighting_StopBackground();
+	Builder_StopBackground();
 #ifdef EXTENDED_BLOCKS
-	if (World.Blocks != World.Blocks2) Mem_Free(World.Blocks2);
+	if (World.Blocks != World.Blocks2 && !World_IsMapped(World.Blocks2)) Mem_Free(World.Blocks2);
 	World.Blocks2 = NULL;
 	World.IDMask  = 0xFF;
 #endif
-	Mem_Free(World.Blocks);
+	if (!World_IsMapped(World.Blocks)) Mem_Free(World.Blocks);
 	World.Blocks = NULL;
+#ifdef CC_BUILD_MMAP
+	if (mapped_data) File_Unmap(mapped_data, mapped_len);
+	mapped_data = NULL;
+	mapped_len  = 0;
+#endif
 	String_InitArray(World.Name, nameBuffer);
 
 	World_SetDimensions(0, 0, 0);
@@ -107,6 +124,47 @@ void World_SetMapUpper(BlockRaw* blocks) {
 }
 #endif
 
+#ifdef CC_BUILD_MMAP
+void World_SetMapping(void* data, cc_uint32 len) {
+	mapped_data = (cc_uint8*)data;
+	mapped_len  = len;
+}
+
+static BlockRaw* CopyMapped(BlockRaw* blocks) {
+	BlockRaw* copy;
+	if (!World_IsMapped(blocks)) return blocks;
+
+	copy = (BlockRaw*)Mem_TryAlloc(World.Volume, 1);
+	if (copy) Mem_Copy(copy, blocks, World.Volume);
+	return copy;
+}
+
+cc_result World_Unmap(void) {
+	BlockRaw* blocks;
+#ifdef EXTENDED_BLOCKS
+	BlockRaw* blocks2;
+#endif
+	if (!mapped_data) return 0;
+	/* Background work may still be reading from the mapped blocks */
+	Lighting_StopBackground();
+	Builder_StopBackground();
+
+	blocks = CopyMapped(World.Blocks);
+	if (!blocks) return ERR_OUT_OF_MEMORY;
+#ifdef EXTENDED_BLOCKS
+	blocks2 = World.Blocks2 == World.Blocks ? blocks : CopyMapped(World.Blocks2);
+	if (!blocks2) { Mem_Free(blocks); return ERR_OUT_OF_MEMORY; }
+	World.Blocks2 = blocks2;
+#endif
+	World.Blocks  = blocks;
+
+	File_Unmap(mapped_data, mapped_len);
+	mapped_data = NULL;
+	mapped_len  = 0;
+	return 0;
+}
+#endif
+
 void World_OutOfMemory(void) {
 	Window_ShowDialog("Out of memory", "Not enough free memory to load the map.\nTry joining a different map.");
 	World_Reset();
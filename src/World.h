@@ -74,6 +74,14 @@ CC_API void World_SetNewMap(BlockRaw* blocks, int width, int height, int length)
 /* NOTE: This is an internal API. Use World_SetNewMap instead. */
 CC_NOINLINE void World_SetDimensions(int width, int height, int length);
 void World_OutOfMemory(void);
+#ifdef CC_BUILD_MMAP
+/* Sets the memory mapped file that World.Blocks (and World.Blocks2) point into */
+/* NOTE: The file is unmapped instead of the blocks being freed in World_Reset */
+void World_SetMapping(void* data, cc_uint32 len);
+/* Copies the blocks out of the memory mapped file (if any) into memory, and then unmaps the file */
+/* NOTE: Must be called before the mapped file is overwritten */
+cc_result World_Unmap(void);
+#endif
 
 #ifdef EXTENDED_BLOCKS
 /* Sets World.Blocks2 and updates internal state for more than 256 blocks. */
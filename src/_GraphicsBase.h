@@ -15,7 +15,7 @@ struct _GfxData Gfx;
 static GfxResourceID Gfx_quadVb, Gfx_texVb;
 const cc_string Gfx_LowPerfMessage = String_FromConst("&eRunning in reduced performance mode (game minimised or hidden)");
 
-static const int strideSizes[] = { SIZEOF_VERTEX_COLOURED, SIZEOF_VERTEX_TEXTURED };
+static const int strideSizes[] = { SIZEOF_VERTEX_COLOURED, SIZEOF_VERTEX_TEXTURED, SIZEOF_VERTEX_TERRAIN };
 /* Whether mipmaps must be created for all dimensions down to 1x1 or not */
 static cc_bool customMipmapsLevels;
 /* Current format and size of vertices */
@@ -496,6 +496,19 @@ void Gfx_SetDynamicVbData(GfxResourceID vb, void* vertices, int vCount) {
 }
 #endif
 
+#ifdef CC_BUILD_CHUNKARENA
+/* Multi draw implementations are defined in the backends */
+#else
+int Gfx_DrawIndexedTris_T2fC4b_Multi(int numRanges, const int* verticesCounts, const int* startVertices) {
+	int i;
+	for (i = 0; i < numRanges; i++)
+	{
+		Gfx_DrawIndexedTris_T2fC4b(verticesCounts[i], startVertices[i]);
+	}
+	return numRanges;
+}
+#endif
+
 
 /*########################################################################################################################*
 *----------------------------------------------------Graphics component---------------------------------------------------*
@@ -8,6 +8,8 @@ CC_BEGIN_HEADER
 
 #define DEFAULT_SINGLEPLAYER_ARG "--singleplayer"
 #define DEFAULT_RESUME_ARG       "--resume"
+#define DEFAULT_REPLAY_ARG       "--replay"
+#define DEFAULT_REPLAY_REALTIME_ARG "--replay-realtime"
 
 struct ResumeInfo {
 	cc_string user, ip, port, server, mppass;
@@ -205,6 +205,16 @@ cc_string args[GAME_MAX_CMDARGS];
 		return ARG_RESULT_RUN_GAME;
 	}
 
+	/* --replay [file path] - play back a recorded session as fast as possible, then exit */
+	/* --replay-realtime [file path] - play back a recorded session at the speed it was recorded */
+	if (argsCount == 2 && (String_CaselessEqualsConst(&args[0], DEFAULT_REPLAY_ARG) ||
+						   String_CaselessEqualsConst(&args[0], DEFAULT_REPLAY_REALTIME_ARG))) {
+		Replay_RealTime = String_CaselessEqualsConst(&args[0], DEFAULT_REPLAY_REALTIME_ARG);
+		Options_Get(LOPT_USERNAME, &Game_Username, DEFAULT_USERNAME);
+		String_Copy(&Replay_Path, &args[1]);
+		return ARG_RESULT_RUN_GAME;
+	}
+
 	/* [file path] - run singleplayer with auto loaded map */
 	if (argsCount == 1 && IsOpenableFile(&args[0])) {
 		Options_Get(LOPT_USERNAME, &Game_Username, DEFAULT_USERNAME);